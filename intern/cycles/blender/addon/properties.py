@@ -349,6 +349,12 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
         min=0.0, max=1.0,
         default=0.01,
     )
+    use_light_tree: BoolProperty(
+        name="Light Tree",
+        description="Sample lights according to their estimated contribution to the shading point using a light tree, "
+        "which can reduce noise in scenes with many lights at the cost of slower samples (CPU only)",
+        default=False,
+    )
 
     use_adaptive_sampling: BoolProperty(
         name="Use adaptive sampling",
@@ -748,6 +754,19 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
         items=enum_texture_limit
     )
 
+    use_texture_cache: BoolProperty(
+        name="Texture Cache",
+        description="Convert image textures to tiled and mipmapped files on disk, and only load the tiles needed for "
+        "rendering at the resolution seen by the camera, to reduce memory usage (CPU only)",
+        default=False,
+    )
+    texture_cache_size: IntProperty(
+        name="Cache Size",
+        description="Maximum memory used by the image tiles in the texture cache, in megabytes",
+        default=1024,
+        min=16, max=1048576,
+    )
+
     ao_bounces: IntProperty(
         name="AO Bounces",
         default=0,
@@ -296,6 +296,14 @@ void BlenderSync::sync_integrator()
   integrator->sample_all_lights_indirect = get_boolean(cscene, "sample_all_lights_indirect");
   integrator->light_sampling_threshold = get_float(cscene, "light_sampling_threshold");
 
+  integrator->use_light_tree = get_boolean(cscene, "use_light_tree");
+  if (integrator->use_light_tree != previntegrator.use_light_tree ||
+      integrator->method != previntegrator.method ||
+      integrator->sample_all_lights_direct != previntegrator.sample_all_lights_direct ||
+      integrator->sample_all_lights_indirect != previntegrator.sample_all_lights_indirect) {
+    scene->light_manager->tag_update(scene);
+  }
+
   if (RNA_boolean_get(&cscene, "use_adaptive_sampling")) {
     integrator->sampling_pattern = SAMPLING_PATTERN_PMJ;
     integrator->adaptive_min_samples = get_int(cscene, "adaptive_min_samples");
@@ -748,6 +756,9 @@ SceneParams BlenderSync::get_scene_params(BL::Scene &b_scene, bool background)
     params.texture_limit = 0;
   }
 
+  params.use_texture_cache = get_boolean(cscene, "use_texture_cache");
+  params.texture_cache_size = get_int(cscene, "texture_cache_size");
+
   /* TODO(sergey): Once OSL supports per-microarchitecture optimization get
    * rid of this.
    */
@@ -1223,6 +1223,7 @@ void CUDADevice::tex_alloc(device_memory &mem)
   /* Set Mapping and tag that we need to (re-)upload to device */
   TextureInfo &info = texture_info[flat_slot];
   info.data = (uint64_t)cmem->texobject;
+  info.cache_image = 0;
   info.cl_buffer = 0;
   info.interpolation = mem.interpolation;
   info.extension = mem.extension;
@@ -482,6 +482,7 @@ class CPUDevice : public Device {
 
       TextureInfo &info = texture_info[flat_slot];
       info.data = (uint64_t)mem.host_pointer;
+      info.cache_image = (uint64_t)mem.cache_image;
       info.cl_buffer = 0;
       info.interpolation = mem.interpolation;
       info.extension = mem.extension;
@@ -210,6 +210,8 @@ class device_memory {
   const char *name;
   InterpolationType interpolation;
   ExtensionType extension;
+  /* Image in the texture cache, for devices that can load the pixels on demand. */
+  void *cache_image;
 
   /* Pointers. */
   Device *device;
@@ -1293,6 +1293,7 @@ void OpenCLDevice::flush_texture_buffers()
 
     MemoryManager::BufferDescriptor desc = memory_manager.get_descriptor(slot.name);
     info.data = desc.offset;
+    info.cache_image = 0;
     info.cl_buffer = desc.device_buffer;
 
     if (string_startswith(slot.name, "__tex_image")) {
@@ -178,6 +178,243 @@ ccl_device float lamp_light_pdf(KernelGlobals *kg, const float3 Ng, const float3
   return t * t / cos_pi;
 }
 
+/* Light Tree */
+
+#ifdef __LIGHT_TREE__
+
+/* Estimate of the contribution of a cluster of emitters to the shading point, from their energy,
+ * distance and bounds of their emission directions. It must be conservative, emitters are only
+ * ignored when they can not illuminate the point. */
+ccl_device float light_tree_importance(const float3 P,
+                                       const float3 centroid,
+                                       const float radius,
+                                       const float3 axis,
+                                       const float theta_o,
+                                       const float theta_e,
+                                       const float energy)
+{
+  float distance;
+  const float3 D = normalize_len(P - centroid, &distance);
+
+  float cos_theta_prime = 1.0f;
+  if (distance > radius) {
+    /* Angle between the emission axis and the direction to the point, minus the angles
+     * bounding the emission directions and the extent of the cluster. */
+    const float theta = safe_acosf(dot(axis, D));
+    const float theta_u = safe_asinf(radius / distance);
+    const float theta_prime = max(theta - theta_o - theta_u, 0.0f);
+    if (theta_prime >= theta_e) {
+      return 0.0f;
+    }
+    cos_theta_prime = cosf(theta_prime);
+  }
+
+  /* Clamp the distance to the extent of the cluster, its emitters could be anywhere inside. */
+  const float distance_squared = max(distance * distance, max(radius * radius, 1e-8f));
+  return energy * cos_theta_prime / distance_squared;
+}
+
+ccl_device float light_tree_node_importance(KernelGlobals *kg, const float3 P, int node_index)
+{
+  const ccl_global KernelLightTreeNode *knode = &kernel_tex_fetch(__light_tree_nodes, node_index);
+  const float3 bbox_min = make_float3(knode->bbox_min[0], knode->bbox_min[1], knode->bbox_min[2]);
+  const float3 bbox_max = make_float3(knode->bbox_max[0], knode->bbox_max[1], knode->bbox_max[2]);
+  const float3 axis = make_float3(knode->axis[0], knode->axis[1], knode->axis[2]);
+
+  return light_tree_importance(P,
+                               0.5f * (bbox_min + bbox_max),
+                               0.5f * len(bbox_max - bbox_min),
+                               axis,
+                               knode->theta_o,
+                               knode->theta_e,
+                               knode->energy);
+}
+
+ccl_device float light_tree_emitter_importance(KernelGlobals *kg,
+                                               const float3 P,
+                                               int emitter_index)
+{
+  const ccl_global KernelLightTreeEmitter *kemitter = &kernel_tex_fetch(__light_tree_emitters,
+                                                                        emitter_index);
+  const float3 centroid = make_float3(
+      kemitter->centroid[0], kemitter->centroid[1], kemitter->centroid[2]);
+  const float3 axis = make_float3(kemitter->axis[0], kemitter->axis[1], kemitter->axis[2]);
+
+  return light_tree_importance(P,
+                               centroid,
+                               kemitter->radius,
+                               axis,
+                               kemitter->theta_o,
+                               kemitter->theta_e,
+                               kemitter->energy);
+}
+
+/* Probability of choosing the distant and background lights rather than the tree. */
+ccl_device float light_tree_distant_pdf(KernelGlobals *kg, const float3 P)
+{
+  const float distant_energy = kernel_data.integrator.light_tree_distant_energy;
+
+  if (kernel_data.integrator.num_light_tree_local == 0) {
+    return 1.0f;
+  }
+  if (distant_energy == 0.0f) {
+    return 0.0f;
+  }
+
+  const float local_importance = light_tree_node_importance(kg, P, 0);
+  return distant_energy / (distant_energy + local_importance);
+}
+
+/* Choose one emitter among the given ones proportionally to the importance, rescaling the
+ * random number for reuse. Importance of the distant lights is their energy. */
+ccl_device int light_tree_sample_emitters(
+    KernelGlobals *kg, const float3 P, int first, int num, bool distant, float *randu, float *pdf)
+{
+  float total_importance = 0.0f;
+  for (int i = first; i < first + num; i++) {
+    total_importance += distant ? kernel_tex_fetch(__light_tree_emitters, i).energy :
+                                  light_tree_emitter_importance(kg, P, i);
+  }
+  if (total_importance == 0.0f) {
+    return -1;
+  }
+
+  float r = *randu * total_importance;
+  for (int i = first; i < first + num; i++) {
+    const float importance = distant ? kernel_tex_fetch(__light_tree_emitters, i).energy :
+                                       light_tree_emitter_importance(kg, P, i);
+    if (importance == 0.0f) {
+      continue;
+    }
+    if (r < importance || i == first + num - 1) {
+      *randu = min(r / importance, 1.0f);
+      *pdf *= importance / total_importance;
+      return i;
+    }
+    r -= importance;
+  }
+
+  return -1;
+}
+
+/* Choose an emitter by traversing the tree from the root, picking children proportionally to
+ * their importance. Returns -1 when no emitter can illuminate the point. */
+ccl_device int light_tree_sample(KernelGlobals *kg, const float3 P, float *randu, float *pdf)
+{
+  const int num_local = kernel_data.integrator.num_light_tree_local;
+  const int num_emitters = kernel_data.integrator.num_light_tree_emitters;
+  const float distant_pdf = light_tree_distant_pdf(kg, P);
+  float r = *randu;
+
+  if (r < distant_pdf) {
+    *randu = r / distant_pdf;
+    *pdf = distant_pdf;
+    return light_tree_sample_emitters(
+        kg, P, num_local, num_emitters - num_local, true, randu, pdf);
+  }
+
+  r = (r - distant_pdf) / (1.0f - distant_pdf);
+  *pdf = 1.0f - distant_pdf;
+
+  int node_index = 0;
+  const ccl_global KernelLightTreeNode *knode = &kernel_tex_fetch(__light_tree_nodes, node_index);
+
+  while (knode->num_emitters == 0) {
+    const int left_index = node_index + 1;
+    const int right_index = knode->child_index;
+    const float left_importance = light_tree_node_importance(kg, P, left_index);
+    const float right_importance = light_tree_node_importance(kg, P, right_index);
+    const float total_importance = left_importance + right_importance;
+
+    if (total_importance == 0.0f) {
+      return -1;
+    }
+
+    const float left_pdf = left_importance / total_importance;
+    if (r < left_pdf) {
+      r = r / left_pdf;
+      *pdf *= left_pdf;
+      node_index = left_index;
+    }
+    else {
+      r = (r - left_pdf) / (1.0f - left_pdf);
+      *pdf *= 1.0f - left_pdf;
+      node_index = right_index;
+    }
+    knode = &kernel_tex_fetch(__light_tree_nodes, node_index);
+  }
+
+  *randu = min(r, 1.0f);
+  return light_tree_sample_emitters(
+      kg, P, knode->child_index, knode->num_emitters, false, randu, pdf);
+}
+
+/* Probability of light_tree_sample() choosing the emitter, following the way up to the root. */
+ccl_device float light_tree_pdf(KernelGlobals *kg, const float3 P, int emitter_index)
+{
+  const float distant_pdf = light_tree_distant_pdf(kg, P);
+  const ccl_global KernelLightTreeEmitter *kemitter = &kernel_tex_fetch(__light_tree_emitters,
+                                                                        emitter_index);
+
+  if (emitter_index >= kernel_data.integrator.num_light_tree_local) {
+    const float distant_energy = kernel_data.integrator.light_tree_distant_energy;
+    return (distant_energy > 0.0f) ? distant_pdf * kemitter->energy / distant_energy : 0.0f;
+  }
+
+  /* Choice of the emitter in its leaf. */
+  int node_index = kemitter->parent_index;
+  const ccl_global KernelLightTreeNode *knode = &kernel_tex_fetch(__light_tree_nodes, node_index);
+
+  float importance = 0.0f;
+  float total_importance = 0.0f;
+  for (int i = knode->child_index; i < knode->child_index + knode->num_emitters; i++) {
+    const float emitter_importance = light_tree_emitter_importance(kg, P, i);
+    if (i == emitter_index) {
+      importance = emitter_importance;
+    }
+    total_importance += emitter_importance;
+  }
+  if (importance == 0.0f) {
+    return 0.0f;
+  }
+
+  float pdf = (1.0f - distant_pdf) * importance / total_importance;
+
+  /* Choices of the nodes on the way up. */
+  while (node_index != 0) {
+    const int parent_index = knode->parent_index;
+    const int left_index = parent_index + 1;
+    const int sibling_index = (node_index == left_index) ?
+                                  kernel_tex_fetch(__light_tree_nodes, parent_index).child_index :
+                                  left_index;
+
+    const float node_importance = light_tree_node_importance(kg, P, node_index);
+    if (node_importance == 0.0f) {
+      return 0.0f;
+    }
+    pdf *= node_importance /
+           (node_importance + light_tree_node_importance(kg, P, sibling_index));
+
+    node_index = parent_index;
+    knode = &kernel_tex_fetch(__light_tree_nodes, node_index);
+  }
+
+  return pdf;
+}
+
+#endif /* __LIGHT_TREE__ */
+
+/* Probability of choosing the lamp when sampling one light at random from the shading point. */
+ccl_device_inline float lamp_light_selection_pdf(KernelGlobals *kg, int lamp, const float3 P)
+{
+#ifdef __LIGHT_TREE__
+  if (kernel_data.integrator.use_light_tree) {
+    return light_tree_pdf(kg, P, kernel_tex_fetch(__light_to_tree, lamp));
+  }
+#endif
+  return kernel_data.integrator.pdf_lights;
+}
+
 /* Background Light */
 
 #ifdef __BACKGROUND_MIS__
@@ -496,6 +733,16 @@ background_light_sample(KernelGlobals *kg, float3 P, float randu, float randv, f
   return D;
 }
 
+ccl_device_inline float background_light_selection_pdf(KernelGlobals *kg, float3 P)
+{
+#  ifdef __LIGHT_TREE__
+  if (kernel_data.integrator.use_light_tree) {
+    return light_tree_pdf(kg, P, kernel_data.integrator.light_tree_background_emitter);
+  }
+#  endif
+  return kernel_data.integrator.pdf_lights;
+}
+
 ccl_device float background_light_pdf(KernelGlobals *kg, float3 P, float3 direction)
 {
   /* Probability of sampling portals instead of the map. */
@@ -511,7 +758,7 @@ ccl_device float background_light_pdf(KernelGlobals *kg, float3 P, float3 direct
        * If map sampling is possible, it would be used instead,
        * otherwise fallback sampling is used. */
       if (portal_sampling_pdf == 1.0f) {
-        return kernel_data.integrator.pdf_lights / M_4PI_F;
+        return background_light_selection_pdf(kg, P) / M_4PI_F;
       }
       else {
         /* Force map sampling. */
@@ -523,7 +770,7 @@ ccl_device float background_light_pdf(KernelGlobals *kg, float3 P, float3 direct
     /* Evaluate PDF of sampling this direction by map sampling. */
     map_pdf = background_map_pdf(kg, direction) * (1.0f - portal_sampling_pdf);
   }
-  return (portal_pdf + map_pdf) * kernel_data.integrator.pdf_lights;
+  return (portal_pdf + map_pdf) * background_light_selection_pdf(kg, P);
 }
 #endif
 
@@ -645,8 +892,6 @@ ccl_device_inline bool lamp_light_sample(
     }
   }
 
-  ls->pdf *= kernel_data.integrator.pdf_lights;
-
   return (ls->pdf > 0.0f);
 }
 
@@ -783,7 +1028,7 @@ ccl_device bool lamp_light_eval(
     return false;
   }
 
-  ls->pdf *= kernel_data.integrator.pdf_lights;
+  ls->pdf *= lamp_light_selection_pdf(kg, lamp, P);
 
   return true;
 }
@@ -822,18 +1067,60 @@ ccl_device_inline bool triangle_world_space_vertices(
   return has_motion;
 }
 
-ccl_device_inline float triangle_light_pdf_area(KernelGlobals *kg,
-                                                const float3 Ng,
-                                                const float3 I,
-                                                float t)
+/* Convert a pdf with respect to the area of the triangle to solid angle. */
+ccl_device_inline float triangle_light_area_to_solid_angle(const float3 Ng,
+                                                          const float3 I,
+                                                          float t)
 {
-  float pdf = kernel_data.integrator.pdf_triangles;
   float cos_pi = fabsf(dot(Ng, I));
 
   if (cos_pi == 0.0f)
     return 0.0f;
 
-  return t * t * pdf / cos_pi;
+  return t * t / cos_pi;
+}
+
+/* Probability of choosing the triangle from the light distribution, where triangles are chosen
+ * proportionally to their area at the center frame. */
+ccl_device_inline float triangle_light_distribution_pdf(
+    KernelGlobals *kg, int object, int prim, bool has_motion, float area)
+{
+  if (has_motion) {
+    /* get the center frame vertices, this is what the PDF was calculated from */
+    float3 V[3];
+    triangle_world_space_vertices(kg, object, prim, -1.0f, V);
+    area = triangle_area(V[0], V[1], V[2]);
+  }
+  return area * kernel_data.integrator.pdf_triangles;
+}
+
+/* Probability of choosing the triangle when sampling one light at random from the shading
+ * point. */
+ccl_device_inline float triangle_light_selection_pdf(
+    KernelGlobals *kg, int object, int prim, bool has_motion, float area, const float3 P)
+{
+#ifdef __LIGHT_TREE__
+  if (kernel_data.integrator.use_light_tree) {
+    /* Unsigned arithmetic, the offset of the object accounts for the first triangle index. */
+    const uint emitter_index = kernel_tex_fetch(__triangle_to_tree,
+                                                kernel_tex_fetch(__object_to_tree, object) + prim);
+    return (emitter_index != ~0u) ? light_tree_pdf(kg, P, emitter_index) : 0.0f;
+  }
+#endif
+  return triangle_light_distribution_pdf(kg, object, prim, has_motion, area);
+}
+
+/* Probability of choosing the triangle in light_sample(), where the light tree one is already
+ * known and applied afterwards. */
+ccl_device_inline float triangle_light_sample_selection_pdf(
+    KernelGlobals *kg, int object, int prim, bool has_motion, float area)
+{
+#ifdef __LIGHT_TREE__
+  if (kernel_data.integrator.use_light_tree) {
+    return 1.0f;
+  }
+#endif
+  return triangle_light_distribution_pdf(kg, object, prim, has_motion, area);
 }
 
 ccl_device_forceinline float triangle_light_pdf(KernelGlobals *kg, ShaderData *sd, float t)
@@ -869,39 +1156,26 @@ ccl_device_forceinline float triangle_light_pdf(KernelGlobals *kg, ShaderData *s
     const float gamma = fast_acosf(dot(u02, u12));
     const float solid_angle = alpha + beta + gamma - M_PI_F;
 
-    /* pdf_triangles is calculated over triangle area, but we're not sampling over its area */
+    /* the triangle is selected with some probability, but we're sampling over solid angle */
     if (UNLIKELY(solid_angle == 0.0f)) {
       return 0.0f;
     }
     else {
-      float area = 1.0f;
-      if (has_motion) {
-        /* get the center frame vertices, this is what the PDF was calculated from */
-        triangle_world_space_vertices(kg, sd->object, sd->prim, -1.0f, V);
-        area = triangle_area(V[0], V[1], V[2]);
-      }
-      else {
-        area = 0.5f * len(N);
-      }
-      const float pdf = area * kernel_data.integrator.pdf_triangles;
-      return pdf / solid_angle;
+      const float area = 0.5f * len(N);
+      return triangle_light_selection_pdf(kg, sd->object, sd->prim, has_motion, area, Px) /
+             solid_angle;
     }
   }
   else {
-    float pdf = triangle_light_pdf_area(kg, sd->Ng, sd->I, t);
-    if (has_motion) {
-      const float area = 0.5f * len(N);
-      if (UNLIKELY(area == 0.0f)) {
-        return 0.0f;
-      }
-      /* scale the PDF.
-       * area = the area the sample was taken from
-       * area_pre = the are from which pdf_triangles was calculated from */
-      triangle_world_space_vertices(kg, sd->object, sd->prim, -1.0f, V);
-      const float area_pre = triangle_area(V[0], V[1], V[2]);
-      pdf = pdf * area_pre / area;
+    const float area = 0.5f * len(N);
+    if (UNLIKELY(area == 0.0f)) {
+      return 0.0f;
     }
-    return pdf;
+    /* area = the area the sample was taken from, the selection pdf accounts for the area at the
+     * center frame for motion blur */
+    const float3 Px = sd->P + sd->I * t;
+    const float pdf = triangle_light_selection_pdf(kg, sd->object, sd->prim, has_motion, area, Px);
+    return pdf * triangle_light_area_to_solid_angle(sd->Ng, sd->I, t) / area;
   }
 }
 
@@ -1025,19 +1299,14 @@ ccl_device_forceinline void triangle_light_sample(KernelGlobals *kg,
 
     ls->P = P + ls->D * ls->t;
 
-    /* pdf_triangles is calculated over triangle area, but we're sampling over solid angle */
+    /* the triangle is selected with some probability, but we're sampling over solid angle */
     if (UNLIKELY(solid_angle == 0.0f)) {
       ls->pdf = 0.0f;
       return;
     }
     else {
-      if (has_motion) {
-        /* get the center frame vertices, this is what the PDF was calculated from */
-        triangle_world_space_vertices(kg, object, prim, -1.0f, V);
-        area = triangle_area(V[0], V[1], V[2]);
-      }
-      const float pdf = area * kernel_data.integrator.pdf_triangles;
-      ls->pdf = pdf / solid_angle;
+      ls->pdf = triangle_light_sample_selection_pdf(kg, object, prim, has_motion, area) /
+                solid_angle;
     }
   }
   else {
@@ -1050,15 +1319,14 @@ ccl_device_forceinline void triangle_light_sample(KernelGlobals *kg,
     ls->P = u * V[0] + v * V[1] + t * V[2];
     /* compute incoming direction, distance and pdf */
     ls->D = normalize_len(ls->P - P, &ls->t);
-    ls->pdf = triangle_light_pdf_area(kg, ls->Ng, -ls->D, ls->t);
-    if (has_motion && area != 0.0f) {
-      /* scale the PDF.
-       * area = the area the sample was taken from
-       * area_pre = the are from which pdf_triangles was calculated from */
-      triangle_world_space_vertices(kg, object, prim, -1.0f, V);
-      const float area_pre = triangle_area(V[0], V[1], V[2]);
-      ls->pdf = ls->pdf * area_pre / area;
+    if (UNLIKELY(area == 0.0f)) {
+      ls->pdf = 0.0f;
+      return;
     }
+    /* area = the area the sample was taken from, the selection pdf accounts for the area at the
+     * center frame for motion blur */
+    ls->pdf = triangle_light_sample_selection_pdf(kg, object, prim, has_motion, area) *
+              triangle_light_area_to_solid_angle(ls->Ng, -ls->D, ls->t) / area;
     ls->u = u;
     ls->v = v;
   }
@@ -1118,6 +1386,38 @@ ccl_device_noinline bool light_sample(KernelGlobals *kg,
                                       int bounce,
                                       LightSample *ls)
 {
+#ifdef __LIGHT_TREE__
+  if (lamp < 0 && kernel_data.integrator.use_light_tree) {
+    /* sample emitter from the tree */
+    float selection_pdf;
+    int index = light_tree_sample(kg, P, &randu, &selection_pdf);
+    if (index == -1) {
+      return false;
+    }
+
+    const ccl_global KernelLightTreeEmitter *kemitter = &kernel_tex_fetch(__light_tree_emitters,
+                                                                          index);
+    int prim = kemitter->prim;
+
+    if (prim >= 0) {
+      triangle_light_sample(kg, prim, kemitter->object_id, randu, randv, time, ls, P);
+      ls->shader |= kemitter->shader_flag;
+      ls->pdf *= selection_pdf;
+      return (ls->pdf > 0.0f);
+    }
+
+    lamp = ~prim;
+    if (UNLIKELY(light_select_reached_max_bounces(kg, lamp, bounce))) {
+      return false;
+    }
+    if (!lamp_light_sample(kg, lamp, randu, randv, P, ls)) {
+      return false;
+    }
+    ls->pdf *= selection_pdf;
+    return true;
+  }
+#endif
+
   if (lamp < 0) {
     /* sample index */
     int index = light_distribution_sample(kg, &randu);
@@ -1143,7 +1443,11 @@ ccl_device_noinline bool light_sample(KernelGlobals *kg,
     return false;
   }
 
-  return lamp_light_sample(kg, lamp, randu, randv, P, ls);
+  if (!lamp_light_sample(kg, lamp, randu, randv, P, ls)) {
+    return false;
+  }
+  ls->pdf *= kernel_data.integrator.pdf_lights;
+  return (ls->pdf > 0.0f);
 }
 
 ccl_device_inline int light_select_num_samples(KernelGlobals *kg, int index)
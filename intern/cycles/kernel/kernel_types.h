@@ -140,6 +140,8 @@ static_assert((ADAPTIVE_SAMPLE_STEP & (ADAPTIVE_SAMPLE_STEP - 1)) == 0,
 #  endif
 #  define __VOLUME_DECOUPLED__
 #  define __VOLUME_RECORD_ALL__
+#  define __LIGHT_TREE__
+#  define __TEXTURE_CACHE__
 #endif /* __KERNEL_CPU__ */
 
 #ifdef __KERNEL_CUDA__
@@ -1303,6 +1305,13 @@ typedef struct KernelIntegrator {
   int num_portals;
   int portal_offset;
 
+  /* light tree */
+  int use_light_tree;
+  int num_light_tree_local;
+  int num_light_tree_emitters;
+  int light_tree_background_emitter;
+  float light_tree_distant_energy;
+
   /* bounces */
   int min_bounce;
   int max_bounce;
@@ -1362,7 +1371,7 @@ typedef struct KernelIntegrator {
 
   int max_closures;
 
-  int pad1, pad2, pad3;
+  int pad1, pad2;
 } KernelIntegrator;
 static_assert_align(KernelIntegrator, 16);
 
@@ -1531,6 +1540,43 @@ typedef struct KernelLightDistribution {
 } KernelLightDistribution;
 static_assert_align(KernelLightDistribution, 16);
 
+/* Light tree for many lights sampling, nodes are stored in depth first order so the first child
+ * of an inner node directly follows it. */
+typedef struct KernelLightTreeNode {
+  float bbox_min[3];
+  float energy;
+  float bbox_max[3];
+  /* Bounds of the emission directions, as a cone around axis. */
+  float theta_o;
+  float axis[3];
+  float theta_e;
+  /* Second child for inner nodes, first emitter for leaves. */
+  int child_index;
+  /* Zero for inner nodes. */
+  int num_emitters;
+  int parent_index;
+  int pad;
+} KernelLightTreeNode;
+static_assert_align(KernelLightTreeNode, 16);
+
+/* Emitters of the tree leaves, followed by distant and background lights which are not part of
+ * the tree. */
+typedef struct KernelLightTreeEmitter {
+  float centroid[3];
+  float energy;
+  float axis[3];
+  float theta_o;
+  float theta_e;
+  float radius;
+  /* Triangle primitive, or ~lamp for lamps. */
+  int prim;
+  int parent_index;
+  int shader_flag;
+  int object_id;
+  int pad1, pad2;
+} KernelLightTreeEmitter;
+static_assert_align(KernelLightTreeEmitter, 16);
+
 typedef struct KernelParticle {
   int index;
   float age;
@@ -17,6 +17,8 @@
 #ifndef __KERNEL_CPU_IMAGE_H__
 #define __KERNEL_CPU_IMAGE_H__
 
+#include "util/util_texture_cache.h"
+
 CCL_NAMESPACE_BEGIN
 
 /* Make template functions private so symbols don't conflict between kernels with different
@@ -470,10 +472,33 @@ template<typename T> struct TextureInterpolator {
 #undef SET_CUBIC_SPLINE_WEIGHTS
 };
 
+ccl_device_inline float4 kernel_tex_image_cache_lookup(
+    const TextureInfo &info, float x, float y, float2 dx, float2 dy)
+{
+  /* Pass plain floats, the cache is not compiled with the instruction set of the kernel. */
+  float result[4];
+  TextureCache::lookup((const TextureCacheImage *)info.cache_image,
+                       (InterpolationType)info.interpolation,
+                       (ExtensionType)info.extension,
+                       x,
+                       y,
+                       dx.x,
+                       dx.y,
+                       dy.x,
+                       dy.y,
+                       result);
+  return make_float4(result[0], result[1], result[2], result[3]);
+}
+
 ccl_device float4 kernel_tex_image_interp(KernelGlobals *kg, int id, float x, float y)
 {
   const TextureInfo &info = kernel_tex_fetch(__texture_info, id);
 
+  if (info.cache_image) {
+    return kernel_tex_image_cache_lookup(
+        info, x, y, make_float2(0.0f, 0.0f), make_float2(0.0f, 0.0f));
+  }
+
   switch (kernel_tex_type(id)) {
     case IMAGE_DATA_TYPE_HALF:
       return TextureInterpolator<half>::interp(info, x, y);
@@ -498,6 +523,20 @@ ccl_device float4 kernel_tex_image_interp(KernelGlobals *kg, int id, float x, fl
   }
 }
 
+/* Lookup with the differentials of the texture coordinates, which select the resolution of
+ * images in the texture cache. Other images are interpolated at full resolution. */
+ccl_device float4 kernel_tex_image_interp_filtered(
+    KernelGlobals *kg, int id, float x, float y, float2 dx, float2 dy)
+{
+  const TextureInfo &info = kernel_tex_fetch(__texture_info, id);
+
+  if (info.cache_image) {
+    return kernel_tex_image_cache_lookup(info, x, y, dx, dy);
+  }
+
+  return kernel_tex_image_interp(kg, id, x, y);
+}
+
 ccl_device float4 kernel_tex_image_interp_3d(
     KernelGlobals *kg, int id, float x, float y, float z, InterpolationType interp)
 {
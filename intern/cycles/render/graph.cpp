@@ -16,6 +16,7 @@
 
 #include "render/attribute.h"
 #include "render/graph.h"
+#include "render/image.h"
 #include "render/nodes.h"
 #include "render/scene.h"
 #include "render/shader.h"
@@ -366,6 +367,10 @@ void ShaderGraph::simplify(Scene *scene)
     clean(scene);
     refine_bump_nodes();
 
+    if (scene->image_manager->use_texture_cache()) {
+      refine_texture_differentials();
+    }
+
     simplified = true;
   }
 }
@@ -953,6 +958,52 @@ void ShaderGraph::refine_bump_nodes()
   }
 }
 
+void ShaderGraph::refine_texture_differentials()
+{
+  /* Images in the texture cache are filtered with the differentials of their texture
+   * coordinates, so only the tiles of the needed resolution get loaded. Like for bump nodes,
+   * we make 2 copies of the sub-graph defining the coordinates, which get shifted by the ray
+   * differentials, and the image node computes the differentials from the difference. */
+
+  foreach (ShaderNode *node, nodes) {
+    /* Copies made for bump mapping and differentials are not filtered. */
+    if (node->type != ImageTextureNode::node_type || node->bump == SHADER_BUMP_DX ||
+        node->bump == SHADER_BUMP_DY) {
+      continue;
+    }
+
+    ImageTextureNode *image_node = static_cast<ImageTextureNode *>(node);
+    ShaderInput *vector_in = node->input("Vector");
+    if (image_node->builtin_data || image_node->projection != NODE_IMAGE_PROJ_FLAT ||
+        !vector_in->link) {
+      continue;
+    }
+
+    ShaderNodeSet nodes_vector;
+    ShaderNodeMap nodes_dx;
+    ShaderNodeMap nodes_dy;
+
+    find_dependencies(nodes_vector, vector_in);
+
+    copy_nodes(nodes_vector, nodes_dx);
+    copy_nodes(nodes_vector, nodes_dy);
+
+    foreach (NodePair &pair, nodes_dx)
+      pair.second->bump = SHADER_BUMP_DX;
+    foreach (NodePair &pair, nodes_dy)
+      pair.second->bump = SHADER_BUMP_DY;
+
+    ShaderOutput *out = vector_in->link;
+    connect(nodes_dx[out->parent]->output(out->name()), node->input("VectorDX"));
+    connect(nodes_dy[out->parent]->output(out->name()), node->input("VectorDY"));
+
+    foreach (NodePair &pair, nodes_dx)
+      add(pair.second);
+    foreach (NodePair &pair, nodes_dy)
+      add(pair.second);
+  }
+}
+
 void ShaderGraph::bump_from_displacement(bool use_object_space)
 {
   /* generate bump mapping automatically from displacement. bump mapping is
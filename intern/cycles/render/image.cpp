@@ -23,11 +23,16 @@
 #include "util/util_foreach.h"
 #include "util/util_image_impl.h"
 #include "util/util_logging.h"
+#include "util/util_md5.h"
 #include "util/util_path.h"
 #include "util/util_progress.h"
 #include "util/util_texture.h"
+#include "util/util_texture_cache.h"
 #include "util/util_unique_ptr.h"
 
+#include <OpenImageIO/filesystem.h>
+#include <OpenImageIO/imagebufalgo.h>
+
 #ifdef WITH_OSL
 #  include <OSL/oslexec.h>
 #endif
@@ -98,6 +103,9 @@ ImageManager::ImageManager(const DeviceInfo &info)
 {
   need_update = true;
   osl_texture_system = NULL;
+  texture_cache = NULL;
+  texture_cache_convert_memory = 0;
+  texture_cache_convert_max_memory = 0;
   animation_frame = 0;
 
   /* Set image limits */
@@ -115,6 +123,8 @@ ImageManager::~ImageManager()
     for (size_t slot = 0; slot < images[type].size(); slot++)
       assert(!images[type][slot]);
   }
+
+  delete texture_cache;
 }
 
 void ImageManager::set_osl_texture_system(void *texture_system)
@@ -122,6 +132,18 @@ void ImageManager::set_osl_texture_system(void *texture_system)
   osl_texture_system = texture_system;
 }
 
+void ImageManager::set_texture_cache(int max_memory)
+{
+  assert(texture_cache == NULL);
+  texture_cache = new TextureCache(max_memory);
+  texture_cache_convert_max_memory = (size_t)max_memory * 1024 * 1024;
+}
+
+bool ImageManager::use_texture_cache() const
+{
+  return texture_cache != NULL;
+}
+
 bool ImageManager::set_animation_frame_update(int frame)
 {
   if (frame != animation_frame) {
@@ -363,6 +385,7 @@ int ImageManager::add_image(const ImageKey &key, float frame, ImageMetaData &met
   img->need_load = true;
   img->users = 1;
   img->mem = NULL;
+  img->cache_image = NULL;
 
   images[type][slot] = img;
 
@@ -720,6 +743,223 @@ static void image_set_device_memory(ImageManager::Image *img, device_memory *mem
   mem->extension = img->key.extension;
 }
 
+string ImageManager::texture_cache_filename(const Image *img)
+{
+  /* Name the converted file after everything that affects its pixels, so that it gets
+   * converted again when the file or the image settings change. */
+  MD5Hash md5;
+  md5.append(img->key.filename);
+  md5.append(string_printf("%llu %d %d %d",
+                           (unsigned long long)path_modified_time(img->key.filename),
+                           (int)img->key.alpha_type,
+                           (int)img->metadata.type,
+                           (int)img->metadata.compress_as_srgb));
+  md5.append(img->metadata.colorspace.string());
+
+  return path_cache_get(path_join("textures", md5.get_hex() + ".tx"));
+}
+
+bool ImageManager::texture_cache_make_tx(Image *img, const string &tx_filename)
+{
+  unique_ptr<ImageInput> in = NULL;
+  if (!file_load_image_generic(img, &in)) {
+    return false;
+  }
+
+  const size_t width = img->metadata.width;
+  const size_t height = img->metadata.height;
+  const size_t num_pixels = width * height;
+  const int components = in->spec().nchannels;
+
+  if (num_pixels == 0 || img->metadata.depth > 1 ||
+      (strcmp(in->format_name(), "jpeg") == 0 && components == 4)) {
+    /* Empty, volume and CMYK images are loaded in memory. */
+    in->close();
+    return false;
+  }
+
+  const ImageDataType type = img->metadata.type;
+  const bool is_rgba = (type == IMAGE_DATA_TYPE_FLOAT4 || type == IMAGE_DATA_TYPE_HALF4 ||
+                        type == IMAGE_DATA_TYPE_BYTE4 || type == IMAGE_DATA_TYPE_USHORT4);
+
+  /* Float pixels and the mipmap levels made from them, a third more. */
+  const size_t memory = num_pixels * max(components, is_rgba ? 4 : 1) * sizeof(float) / 3 * 4;
+  {
+    thread_scoped_lock lock(texture_cache_convert_mutex);
+    while (texture_cache_convert_memory != 0 &&
+           texture_cache_convert_memory + memory > texture_cache_convert_max_memory) {
+      texture_cache_convert_cond.wait(lock);
+    }
+    texture_cache_convert_memory += memory;
+  }
+
+  const bool ok = texture_cache_convert_tx(img, in.get(), is_rgba, tx_filename);
+
+  {
+    thread_scoped_lock lock(texture_cache_convert_mutex);
+    texture_cache_convert_memory -= memory;
+  }
+  texture_cache_convert_cond.notify_all();
+
+  return ok;
+}
+
+bool ImageManager::texture_cache_convert_tx(Image *img,
+                                            ImageInput *in,
+                                            const bool is_rgba,
+                                            const string &tx_filename)
+{
+  const size_t width = img->metadata.width;
+  const size_t height = img->metadata.height;
+  const size_t num_pixels = width * height;
+  const int components = in->spec().nchannels;
+  const ImageDataType type = img->metadata.type;
+
+  /* Same pixel conversions as file_load_image(), in float so that conversion to the file
+   * format is done along with the mipmap generation. */
+  const int channels = is_rgba ? 4 : 1;
+  vector<float> pixels(num_pixels * max(components, channels));
+  in->read_image(TypeDesc::FLOAT, pixels.data());
+  in->close();
+
+  if (is_rgba) {
+    if (components < 4) {
+      /* Grayscale, grayscale + alpha and RGB to RGBA, backwards to convert in place. */
+      for (size_t i = num_pixels; i-- > 0;) {
+        const float *in_pixel = &pixels[i * components];
+        const float r = in_pixel[0];
+        const float g = (components >= 3) ? in_pixel[1] : r;
+        const float b = (components >= 3) ? in_pixel[2] : r;
+        const float a = (components == 2) ? in_pixel[1] : 1.0f;
+        float *pixel = &pixels[i * 4];
+        pixel[0] = r;
+        pixel[1] = g;
+        pixel[2] = b;
+        pixel[3] = a;
+      }
+    }
+    else if (components > 4) {
+      for (size_t i = 0; i < num_pixels; i++) {
+        memmove(&pixels[i * 4], &pixels[i * components], sizeof(float) * 4);
+      }
+    }
+
+    for (size_t i = 0; i < num_pixels; i++) {
+      float *pixel = &pixels[i * 4];
+      /* Disable alpha if requested by the user. */
+      if (img->key.alpha_type == IMAGE_ALPHA_IGNORE) {
+        pixel[3] = 1.0f;
+      }
+      if (!isfinite(pixel[0]) || !isfinite(pixel[1]) || !isfinite(pixel[2]) ||
+          !isfinite(pixel[3])) {
+        pixel[0] = pixel[1] = pixel[2] = pixel[3] = 0.0f;
+      }
+    }
+
+    if (img->metadata.colorspace != u_colorspace_raw &&
+        img->metadata.colorspace != u_colorspace_srgb) {
+      /* Convert to scene linear. */
+      ColorSpaceManager::to_scene_linear(img->metadata.colorspace,
+                                         pixels.data(),
+                                         width,
+                                         height,
+                                         1,
+                                         img->metadata.compress_as_srgb);
+    }
+  }
+  else {
+    for (size_t i = 0; i < num_pixels; i++) {
+      if (!isfinite(pixels[i * components])) {
+        pixels[i] = 0.0f;
+      }
+      else {
+        pixels[i] = pixels[i * components];
+      }
+    }
+  }
+
+  TypeDesc format;
+  switch (type) {
+    case IMAGE_DATA_TYPE_BYTE:
+    case IMAGE_DATA_TYPE_BYTE4:
+      format = TypeDesc::UINT8;
+      break;
+    case IMAGE_DATA_TYPE_USHORT:
+    case IMAGE_DATA_TYPE_USHORT4:
+      format = TypeDesc::UINT16;
+      break;
+    case IMAGE_DATA_TYPE_HALF:
+    case IMAGE_DATA_TYPE_HALF4:
+      format = TypeDesc::HALF;
+      break;
+    default:
+      format = TypeDesc::FLOAT;
+      break;
+  }
+
+  ImageBuf buf(ImageSpec(width, height, channels, TypeDesc::FLOAT), pixels.data());
+
+  ImageSpec config;
+  config.tile_width = 64;
+  config.tile_height = 64;
+  config.tile_depth = 1;
+  config.set_format(format);
+
+  /* Write to a temporary file first, so that an interrupted conversion doesn't leave a
+   * partial file in the cache and concurrent conversions of the same image don't mix. */
+  const string tmp_filename = tx_filename + ".tmp-" + OIIO::Filesystem::unique_path() + ".tx";
+  path_create_directories(tx_filename);
+  if (!ImageBufAlgo::make_texture(ImageBufAlgo::MakeTxTexture, buf, tmp_filename, config)) {
+    VLOG(1) << "Failed to convert " << img->key.filename
+            << " for the texture cache: " << OIIO::geterror();
+    path_remove(tmp_filename);
+    return false;
+  }
+  if (!path_rename(tmp_filename, tx_filename)) {
+    VLOG(1) << "Failed to move " << tmp_filename << " to " << tx_filename;
+    path_remove(tmp_filename);
+    return false;
+  }
+
+  VLOG(1) << "Converted " << img->key.filename << " to " << tx_filename
+          << " for the texture cache.";
+  return true;
+}
+
+bool ImageManager::texture_cache_load_image(Device *device, Image *img)
+{
+  if (img->metadata.depth > 1) {
+    return false;
+  }
+
+  const string tx_filename = texture_cache_filename(img);
+  if (!path_exists(tx_filename) && !texture_cache_make_tx(img, tx_filename)) {
+    return false;
+  }
+
+  img->cache_image = texture_cache->add_image(tx_filename);
+  if (!img->cache_image) {
+    return false;
+  }
+
+  /* Tiles are loaded by the kernel through the cache handle, the device memory only holds a
+   * placeholder pixel. */
+  thread_scoped_lock device_lock(device_mutex);
+  device_vector<uchar4> *tex_img = new device_vector<uchar4>(
+      device, img->mem_name.c_str(), MEM_TEXTURE);
+  uchar4 *pixels = tex_img->alloc(1, 1);
+  pixels[0] = make_uchar4(TEX_IMAGE_MISSING_R * 255,
+                          TEX_IMAGE_MISSING_G * 255,
+                          TEX_IMAGE_MISSING_B * 255,
+                          TEX_IMAGE_MISSING_A * 255);
+
+  image_set_device_memory(img, tex_img);
+  tex_img->cache_image = img->cache_image;
+  tex_img->copy_to_device();
+
+  return true;
+}
+
 void ImageManager::device_load_image(
     Device *device, Scene *scene, ImageDataType type, int slot, Progress *progress)
 {
@@ -746,6 +986,16 @@ void ImageManager::device_load_image(
     delete img->mem;
     img->mem = NULL;
   }
+  if (img->cache_image) {
+    texture_cache->remove_image(img->cache_image);
+    img->cache_image = NULL;
+  }
+
+  /* Load file images on demand if possible, falling back to loading all pixels. */
+  if (texture_cache && !img->key.builtin_data && texture_cache_load_image(device, img)) {
+    img->need_load = false;
+    return;
+  }
 
   /* Create new texture. */
   if (type == IMAGE_DATA_TYPE_FLOAT4) {
@@ -916,6 +1166,10 @@ void ImageManager::device_free_image(Device *, ImageDataType type, int slot)
       delete img->mem;
     }
 
+    if (img->cache_image) {
+      texture_cache->remove_image(img->cache_image);
+    }
+
     delete img;
     images[type][slot] = NULL;
     --tex_num_images[type];
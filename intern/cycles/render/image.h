@@ -35,6 +35,8 @@ class Progress;
 class RenderStats;
 class Scene;
 class ColorSpaceProcessor;
+class TextureCache;
+struct TextureCacheImage;
 
 class ImageMetaData {
  public:
@@ -124,6 +126,11 @@ class ImageManager {
   void set_osl_texture_system(void *texture_system);
   bool set_animation_frame_update(int frame);
 
+  /* Load image files on demand through a texture cache using at most max_memory megabytes,
+   * instead of loading all pixels in device memory. Only supported by the CPU kernel. */
+  void set_texture_cache(int max_memory);
+  bool use_texture_cache() const;
+
   device_memory *image_memory(int flat_slot);
 
   void collect_statistics(RenderStats *stats);
@@ -162,6 +169,7 @@ class ImageManager {
 
     string mem_name;
     device_memory *mem;
+    TextureCacheImage *cache_image;
 
     int users;
   };
@@ -176,6 +184,14 @@ class ImageManager {
 
   vector<Image *> images[IMAGE_DATA_NUM_TYPES];
   void *osl_texture_system;
+  TextureCache *texture_cache;
+
+  /* Memory used by the images being converted for the texture cache. Conversions wait for
+   * each other to stay within the texture cache budget, one conversion always runs. */
+  size_t texture_cache_convert_memory;
+  size_t texture_cache_convert_max_memory;
+  thread_mutex texture_cache_convert_mutex;
+  thread_condition_variable texture_cache_convert_cond;
 
   bool file_load_image_generic(Image *img, unique_ptr<ImageInput> *in);
 
@@ -187,6 +203,14 @@ class ImageManager {
 
   void metadata_detect_colorspace(ImageMetaData &metadata, const char *file_format);
 
+  string texture_cache_filename(const Image *img);
+  bool texture_cache_make_tx(Image *img, const string &tx_filename);
+  bool texture_cache_convert_tx(Image *img,
+                                ImageInput *in,
+                                const bool is_rgba,
+                                const string &tx_filename);
+  bool texture_cache_load_image(Device *device, Image *img);
+
   void device_load_image(
       Device *device, Scene *scene, ImageDataType type, int slot, Progress *progress);
   void device_free_image(Device *device, ImageDataType type, int slot);
@@ -20,6 +20,7 @@
 #include "render/film.h"
 #include "render/graph.h"
 #include "render/light.h"
+#include "render/light_tree.h"
 #include "render/mesh.h"
 #include "render/nodes.h"
 #include "render/object.h"
@@ -257,6 +258,27 @@ bool LightManager::object_usable_as_light(Object *object)
   return false;
 }
 
+/* Flags excluding the triangle lights of the object from rays it is not visible to. */
+static int object_light_shader_flag(Object *object)
+{
+  int shader_flag = 0;
+
+  if (!(object->visibility & PATH_RAY_DIFFUSE)) {
+    shader_flag |= SHADER_EXCLUDE_DIFFUSE;
+  }
+  if (!(object->visibility & PATH_RAY_GLOSSY)) {
+    shader_flag |= SHADER_EXCLUDE_GLOSSY;
+  }
+  if (!(object->visibility & PATH_RAY_TRANSMIT)) {
+    shader_flag |= SHADER_EXCLUDE_TRANSMIT;
+  }
+  if (!(object->visibility & PATH_RAY_VOLUME_SCATTER)) {
+    shader_flag |= SHADER_EXCLUDE_SCATTER;
+  }
+
+  return shader_flag;
+}
+
 void LightManager::device_update_distribution(Device *,
                                               DeviceScene *dscene,
                                               Scene *scene,
@@ -328,22 +350,9 @@ void LightManager::device_update_distribution(Device *,
     bool transform_applied = mesh->transform_applied;
     Transform tfm = object->tfm;
     int object_id = j;
-    int shader_flag = 0;
+    int shader_flag = object_light_shader_flag(object);
 
-    if (!(object->visibility & PATH_RAY_DIFFUSE)) {
-      shader_flag |= SHADER_EXCLUDE_DIFFUSE;
-      use_light_visibility = true;
-    }
-    if (!(object->visibility & PATH_RAY_GLOSSY)) {
-      shader_flag |= SHADER_EXCLUDE_GLOSSY;
-      use_light_visibility = true;
-    }
-    if (!(object->visibility & PATH_RAY_TRANSMIT)) {
-      shader_flag |= SHADER_EXCLUDE_TRANSMIT;
-      use_light_visibility = true;
-    }
-    if (!(object->visibility & PATH_RAY_VOLUME_SCATTER)) {
-      shader_flag |= SHADER_EXCLUDE_SCATTER;
+    if (shader_flag & SHADER_EXCLUDE_ANY) {
       use_light_visibility = true;
     }
 
@@ -657,6 +666,253 @@ void LightManager::device_update_background(Device *device,
   dscene->light_background_conditional_cdf.copy_to_device();
 }
 
+bool LightManager::use_light_tree(Device *device, Scene *scene)
+{
+  const Integrator *integrator = scene->integrator;
+
+  /* Traversal of the tree is only implemented in the CPU kernel. */
+  if (!integrator->use_light_tree || device->info.type != DEVICE_CPU) {
+    return false;
+  }
+  /* Sampling all lights relies on the probabilities of the light distribution. */
+  if (integrator->method == Integrator::BRANCHED_PATH &&
+      (integrator->sample_all_lights_direct || integrator->sample_all_lights_indirect)) {
+    return false;
+  }
+  return true;
+}
+
+void LightManager::device_update_tree(Device *device,
+                                      DeviceScene *dscene,
+                                      Scene *scene,
+                                      Progress &progress)
+{
+  KernelIntegrator *kintegrator = &dscene->data.integrator;
+  kintegrator->use_light_tree = false;
+  kintegrator->num_light_tree_local = 0;
+  kintegrator->num_light_tree_emitters = 0;
+  kintegrator->light_tree_background_emitter = -1;
+  kintegrator->light_tree_distant_energy = 0.0f;
+
+  if (!kintegrator->use_direct_light || !use_light_tree(device, scene)) {
+    return;
+  }
+
+  progress.set_status("Updating Lights", "Building light tree");
+
+  /* Energies are estimates of the radiant intensity of the emitters towards the axis of their
+   * emission cone, so that they can be compared to each other once divided by the squared
+   * distance to the shading point. */
+  vector<LightTreePrimitive> prims;
+
+  /* Triangles, the entry of a triangle is at the offset of its object plus its primitive
+   * index. */
+  uint *object_to_tree = dscene->object_to_tree.alloc(scene->objects.size());
+  size_t num_tree_triangles = 0;
+  int object_id = 0;
+
+  foreach (Object *object, scene->objects) {
+    if (progress.get_cancel())
+      return;
+
+    object_to_tree[object_id] = 0;
+
+    if (!object_usable_as_light(object)) {
+      object_id++;
+      continue;
+    }
+
+    Mesh *mesh = static_cast<Mesh *>(object->geometry);
+    /* Unsigned arithmetic wraps around for the triangles indexed from the mesh offset. */
+    object_to_tree[object_id] = (uint)(num_tree_triangles - mesh->prim_offset);
+    num_tree_triangles += mesh->num_triangles();
+
+    bool transform_applied = mesh->transform_applied;
+    Transform tfm = object->tfm;
+    int shader_flag = object_light_shader_flag(object);
+
+    /* Strength of the emission shaders, unknown unless it is constant. */
+    vector<float> shader_strength(mesh->used_shaders.size() + 1, 1.0f);
+    for (size_t i = 0; i < shader_strength.size(); i++) {
+      Shader *shader = (i < mesh->used_shaders.size()) ? mesh->used_shaders[i] :
+                                                         scene->default_surface;
+      float3 emission;
+      if (shader->is_constant_emission(&emission)) {
+        shader_strength[i] = max(average(emission), 0.0f);
+      }
+    }
+
+    size_t mesh_num_triangles = mesh->num_triangles();
+    for (size_t i = 0; i < mesh_num_triangles; i++) {
+      int shader_index = mesh->shader[i];
+      Shader *shader = (shader_index < mesh->used_shaders.size()) ?
+                           mesh->used_shaders[shader_index] :
+                           scene->default_surface;
+
+      if (!(shader->use_mis && shader->has_surface_emission)) {
+        continue;
+      }
+
+      Mesh::Triangle t = mesh->get_triangle(i);
+      if (!t.valid(&mesh->verts[0])) {
+        continue;
+      }
+      float3 p1 = mesh->verts[t.v[0]];
+      float3 p2 = mesh->verts[t.v[1]];
+      float3 p3 = mesh->verts[t.v[2]];
+
+      if (!transform_applied) {
+        p1 = transform_point(&tfm, p1);
+        p2 = transform_point(&tfm, p2);
+        p3 = transform_point(&tfm, p3);
+      }
+
+      LightTreePrimitive prim;
+      prim.bbox.grow(p1);
+      prim.bbox.grow(p2);
+      prim.bbox.grow(p3);
+      prim.centroid = (p1 + p2 + p3) * (1.0f / 3.0f);
+      prim.radius = sqrtf(max(len_squared(p1 - prim.centroid),
+                              max(len_squared(p2 - prim.centroid),
+                                  len_squared(p3 - prim.centroid))));
+      /* Emission is two-sided. */
+      prim.cone = LightTreeCone(make_float3(0.0f, 0.0f, 1.0f), M_PI_F, M_PI_2_F);
+      prim.energy = shader_strength[min(shader_index, (int)mesh->used_shaders.size())] *
+                    triangle_area(p1, p2, p3);
+      prim.prim = i + mesh->prim_offset;
+      prim.object_id = object_id;
+      prim.shader_flag = shader_flag;
+      prims.push_back(prim);
+    }
+
+    object_id++;
+  }
+
+  /* Lamps. Distant and background lights are kept out of the tree since their contribution does
+   * not depend on the position of the shading point. */
+  vector<int> distant_lights;
+  vector<float> distant_energy;
+  int light_index = 0;
+
+  foreach (Light *light, scene->lights) {
+    if (!light->is_enabled)
+      continue;
+
+    const float strength = max(average(light->strength), 0.0f);
+
+    if (light->type == LIGHT_DISTANT) {
+      distant_lights.push_back(light_index);
+      distant_energy.push_back(strength);
+    }
+    else if (light->type == LIGHT_BACKGROUND) {
+      /* Irradiance from the average radiance of the importance map, which integrates the
+       * radiance over the sphere divided by 2 * pi^2. */
+      float energy = 1.0f;
+      const int res_y = kintegrator->pdf_background_res_y;
+      if (res_y > 0) {
+        energy = M_PI_F * M_PI_F * 0.5f * dscene->light_background_marginal_cdf.data()[res_y].x;
+      }
+      kintegrator->light_tree_background_emitter = distant_lights.size();
+      distant_lights.push_back(light_index);
+      distant_energy.push_back(energy);
+    }
+    else {
+      LightTreePrimitive prim;
+      prim.centroid = light->co;
+      prim.prim = ~light_index;
+      prim.object_id = 0;
+      prim.shader_flag = 0;
+
+      if (light->type == LIGHT_AREA) {
+        float3 axisu = light->axisu * (light->sizeu * light->size);
+        float3 axisv = light->axisv * (light->sizev * light->size);
+        prim.bbox.grow(light->co + 0.5f * (axisu + axisv));
+        prim.bbox.grow(light->co + 0.5f * (axisu - axisv));
+        prim.bbox.grow(light->co - 0.5f * (axisu + axisv));
+        prim.bbox.grow(light->co - 0.5f * (axisu - axisv));
+        prim.radius = 0.5f * sqrtf(len_squared(axisu) + len_squared(axisv));
+        /* One-sided, emitting towards its direction. */
+        prim.cone = LightTreeCone(safe_normalize(light->dir), 0.0f, M_PI_2_F);
+        prim.energy = 0.25f * strength;
+      }
+      else {
+        prim.bbox.grow(light->co, light->size);
+        prim.radius = light->size;
+        if (light->type == LIGHT_SPOT) {
+          prim.cone = LightTreeCone(
+              safe_normalize(light->dir), min(0.5f * light->spot_angle, M_PI_F), M_PI_2_F);
+        }
+        else {
+          prim.cone = LightTreeCone(make_float3(0.0f, 0.0f, 1.0f), M_PI_F, M_PI_2_F);
+        }
+        prim.energy = 0.25f * M_1_PI_F * strength;
+      }
+
+      prims.push_back(prim);
+    }
+
+    light_index++;
+  }
+
+  if (progress.get_cancel())
+    return;
+
+  double time_start = time_dt();
+  LightTree tree(prims);
+
+  const size_t num_local = tree.emitters.size();
+  const size_t num_emitters = num_local + distant_lights.size();
+
+  KernelLightTreeNode *nodes = dscene->light_tree_nodes.alloc(tree.nodes.size());
+  KernelLightTreeEmitter *emitters = dscene->light_tree_emitters.alloc(num_emitters);
+
+  std::copy(tree.nodes.begin(), tree.nodes.end(), nodes);
+  std::copy(tree.emitters.begin(), tree.emitters.end(), emitters);
+
+  float total_distant_energy = 0.0f;
+  for (size_t i = 0; i < distant_lights.size(); i++) {
+    KernelLightTreeEmitter &kemitter = emitters[num_local + i];
+    memset(&kemitter, 0, sizeof(kemitter));
+    kemitter.energy = distant_energy[i];
+    kemitter.prim = ~distant_lights[i];
+    kemitter.parent_index = -1;
+    total_distant_energy += distant_energy[i];
+  }
+
+  /* Lookup of the emitters, to evaluate the probability of sampling them for MIS. */
+  uint *light_to_tree = dscene->light_to_tree.alloc(light_index);
+  uint *triangle_to_tree = dscene->triangle_to_tree.alloc(num_tree_triangles);
+  std::fill(triangle_to_tree, triangle_to_tree + num_tree_triangles, ~0u);
+
+  for (size_t i = 0; i < num_emitters; i++) {
+    const KernelLightTreeEmitter &kemitter = emitters[i];
+    if (kemitter.prim < 0) {
+      light_to_tree[~kemitter.prim] = i;
+    }
+    else {
+      triangle_to_tree[object_to_tree[kemitter.object_id] + kemitter.prim] = i;
+    }
+  }
+
+  VLOG(1) << "Light tree with " << tree.nodes.size() << " nodes, " << num_local
+          << " local emitters and " << distant_lights.size() << " distant lights built in "
+          << time_dt() - time_start << " seconds.";
+
+  kintegrator->use_light_tree = true;
+  kintegrator->num_light_tree_local = num_local;
+  kintegrator->num_light_tree_emitters = num_emitters;
+  if (kintegrator->light_tree_background_emitter != -1) {
+    kintegrator->light_tree_background_emitter += num_local;
+  }
+  kintegrator->light_tree_distant_energy = total_distant_energy;
+
+  dscene->light_tree_nodes.copy_to_device();
+  dscene->light_tree_emitters.copy_to_device();
+  dscene->light_to_tree.copy_to_device();
+  dscene->object_to_tree.copy_to_device();
+  dscene->triangle_to_tree.copy_to_device();
+}
+
 void LightManager::device_update_points(Device *, DeviceScene *dscene, Scene *scene)
 {
   int num_scene_lights = scene->lights.size();
@@ -919,6 +1175,10 @@ void LightManager::device_update(Device *device,
   if (progress.get_cancel())
     return;
 
+  device_update_tree(device, dscene, scene, progress);
+  if (progress.get_cancel())
+    return;
+
   device_update_ies(dscene);
   if (progress.get_cancel())
     return;
@@ -937,6 +1197,11 @@ void LightManager::device_free(Device *, DeviceScene *dscene)
   dscene->lights.free();
   dscene->light_background_marginal_cdf.free();
   dscene->light_background_conditional_cdf.free();
+  dscene->light_tree_nodes.free();
+  dscene->light_tree_emitters.free();
+  dscene->light_to_tree.free();
+  dscene->object_to_tree.free();
+  dscene->triangle_to_tree.free();
   dscene->ies_lights.free();
 }
 
@@ -120,8 +120,15 @@ class LightManager {
                                 DeviceScene *dscene,
                                 Scene *scene,
                                 Progress &progress);
+  void device_update_tree(Device *device,
+                          DeviceScene *dscene,
+                          Scene *scene,
+                          Progress &progress);
   void device_update_ies(DeviceScene *dscene);
 
+  /* Check whether lights are sampled with the light tree rather than the distribution. */
+  bool use_light_tree(Device *device, Scene *scene);
+
   /* Check whether light manager can use the object as a light-emissive. */
   bool object_usable_as_light(Object *object);
 
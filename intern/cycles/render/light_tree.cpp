@@ -0,0 +1,254 @@
+/*
+ * Copyright 2011-2020 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "render/light_tree.h"
+
+#include "util/util_algorithm.h"
+#include "util/util_math.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Light Tree Cone */
+
+float LightTreeCone::measure() const
+{
+  const float theta_w = min(theta_o + theta_e, M_PI_F);
+  const float sin_theta_o = sinf(theta_o);
+  const float cos_theta_o = cosf(theta_o);
+
+  return M_2PI_F * (1.0f - cos_theta_o) +
+         M_PI_2_F * (2.0f * theta_w * sin_theta_o - cosf(theta_o - 2.0f * theta_w) -
+                     2.0f * theta_o * sin_theta_o + cos_theta_o);
+}
+
+LightTreeCone merge(const LightTreeCone &cone_a, const LightTreeCone &cone_b)
+{
+  /* Let a be the widest cone. */
+  const bool swap = cone_a.theta_o < cone_b.theta_o;
+  const LightTreeCone &a = swap ? cone_b : cone_a;
+  const LightTreeCone &b = swap ? cone_a : cone_b;
+
+  const float cos_theta_d = dot(a.axis, b.axis);
+  const float theta_d = safe_acosf(cos_theta_d);
+  const float theta_e = max(a.theta_e, b.theta_e);
+
+  /* Cone b is contained in a. */
+  if (min(theta_d + b.theta_o, M_PI_F) <= a.theta_o) {
+    return LightTreeCone(a.axis, a.theta_o, theta_e);
+  }
+
+  const float theta_o = 0.5f * (a.theta_o + theta_d + b.theta_o);
+  const float3 ortho = b.axis - cos_theta_d * a.axis;
+  if (theta_o >= M_PI_F || len_squared(ortho) < 1e-12f) {
+    return LightTreeCone(a.axis, M_PI_F, theta_e);
+  }
+
+  /* Rotate the axis of a towards the one of b, so both cones touch the merged one. */
+  const float theta_r = theta_o - a.theta_o;
+  const float3 axis = cosf(theta_r) * a.axis + sinf(theta_r) * normalize(ortho);
+
+  return LightTreeCone(normalize(axis), theta_o, theta_e);
+}
+
+/* Light Tree */
+
+LightTree::LightTree(const vector<LightTreePrimitive> &prims, int max_emitters_in_leaf)
+    : prims_(prims), max_emitters_in_leaf_(max_emitters_in_leaf)
+{
+  if (prims_.empty()) {
+    return;
+  }
+
+  nodes.reserve(2 * prims_.size() / max_emitters_in_leaf_ + 1);
+  emitters.resize(prims_.size());
+
+  recursive_build(0, prims_.size(), -1);
+
+  prims_.clear();
+  prims_.shrink_to_fit();
+}
+
+int LightTree::recursive_build(int start, int end, int parent_index)
+{
+  BoundBox bbox = BoundBox::empty;
+  BoundBox centroid_bbox = BoundBox::empty;
+  LightTreeCone cone = prims_[start].cone;
+  float energy = 0.0f;
+
+  for (int i = start; i < end; i++) {
+    const LightTreePrimitive &prim = prims_[i];
+    bbox.grow(prim.bbox);
+    centroid_bbox.grow(prim.centroid);
+    cone = merge(cone, prim.cone);
+    energy += prim.energy;
+  }
+
+  /* Nodes are appended during recursion, so only access this one by index. */
+  const int node_index = nodes.size();
+  nodes.push_back(KernelLightTreeNode());
+
+  KernelLightTreeNode &knode = nodes[node_index];
+  knode.bbox_min[0] = bbox.min.x;
+  knode.bbox_min[1] = bbox.min.y;
+  knode.bbox_min[2] = bbox.min.z;
+  knode.bbox_max[0] = bbox.max.x;
+  knode.bbox_max[1] = bbox.max.y;
+  knode.bbox_max[2] = bbox.max.z;
+  knode.energy = energy;
+  knode.axis[0] = cone.axis.x;
+  knode.axis[1] = cone.axis.y;
+  knode.axis[2] = cone.axis.z;
+  knode.theta_o = cone.theta_o;
+  knode.theta_e = cone.theta_e;
+  knode.parent_index = parent_index;
+
+  const int num_prims = end - start;
+  if (num_prims <= max_emitters_in_leaf_) {
+    knode.child_index = start;
+    knode.num_emitters = num_prims;
+
+    for (int i = start; i < end; i++) {
+      const LightTreePrimitive &prim = prims_[i];
+      KernelLightTreeEmitter &kemitter = emitters[i];
+      kemitter.centroid[0] = prim.centroid.x;
+      kemitter.centroid[1] = prim.centroid.y;
+      kemitter.centroid[2] = prim.centroid.z;
+      kemitter.energy = prim.energy;
+      kemitter.axis[0] = prim.cone.axis.x;
+      kemitter.axis[1] = prim.cone.axis.y;
+      kemitter.axis[2] = prim.cone.axis.z;
+      kemitter.theta_o = prim.cone.theta_o;
+      kemitter.theta_e = prim.cone.theta_e;
+      kemitter.radius = prim.radius;
+      kemitter.prim = prim.prim;
+      kemitter.parent_index = node_index;
+      kemitter.shader_flag = prim.shader_flag;
+      kemitter.object_id = prim.object_id;
+    }
+
+    return node_index;
+  }
+
+  const int middle = find_split(start, end, bbox, centroid_bbox);
+
+  /* The first child directly follows its parent. */
+  recursive_build(start, middle, node_index);
+  const int right_index = recursive_build(middle, end, node_index);
+
+  nodes[node_index].child_index = right_index;
+  nodes[node_index].num_emitters = 0;
+
+  return node_index;
+}
+
+/* Split the primitives using the surface area orientation heuristic, which estimates the cost
+ * of a split from the energy, spatial extent and directional extent of both sides. */
+int LightTree::find_split(int start, int end, const BoundBox &bbox, const BoundBox &centroid_bbox)
+{
+  const int num_buckets = 12;
+
+  struct Bucket {
+    BoundBox bbox;
+    LightTreeCone cone;
+    float energy;
+    int count;
+
+    Bucket() : bbox(BoundBox::empty), energy(0.0f), count(0)
+    {
+    }
+
+    void add(const BoundBox &other_bbox, const LightTreeCone &other_cone, float other_energy)
+    {
+      bbox.grow(other_bbox);
+      cone = (count == 0) ? other_cone : merge(cone, other_cone);
+      energy += other_energy;
+      count++;
+    }
+
+    float cost() const
+    {
+      return energy * cone.measure() * bbox.safe_area();
+    }
+  };
+
+  const float3 extent = centroid_bbox.size();
+  const float max_extent = max3(extent);
+
+  float best_cost = FLT_MAX;
+  int best_axis = -1;
+  int best_bucket = -1;
+
+  for (int axis = 0; axis < 3 && max_extent > 0.0f; axis++) {
+    if (extent[axis] == 0.0f) {
+      continue;
+    }
+
+    const float bucket_scale = num_buckets / extent[axis];
+    Bucket buckets[num_buckets];
+
+    for (int i = start; i < end; i++) {
+      const LightTreePrimitive &prim = prims_[i];
+      const int b = min((int)((prim.centroid[axis] - centroid_bbox.min[axis]) * bucket_scale),
+                        num_buckets - 1);
+      buckets[b].add(prim.bbox, prim.cone, prim.energy);
+    }
+
+    /* Penalize splitting thin boxes along their short axes. */
+    const float regularization = max_extent / extent[axis];
+
+    for (int split = 1; split < num_buckets; split++) {
+      Bucket left, right;
+      for (int b = 0; b < split; b++) {
+        if (buckets[b].count) {
+          left.add(buckets[b].bbox, buckets[b].cone, buckets[b].energy);
+        }
+      }
+      for (int b = split; b < num_buckets; b++) {
+        if (buckets[b].count) {
+          right.add(buckets[b].bbox, buckets[b].cone, buckets[b].energy);
+        }
+      }
+      if (left.count == 0 || right.count == 0) {
+        continue;
+      }
+
+      const float cost = regularization * (left.cost() + right.cost());
+      if (cost < best_cost) {
+        best_cost = cost;
+        best_axis = axis;
+        best_bucket = split;
+      }
+    }
+  }
+
+  if (best_axis == -1) {
+    /* All centroids are at the same location, split in the middle. */
+    return (start + end) / 2;
+  }
+
+  const float bucket_scale = num_buckets / extent[best_axis];
+  const float min_centroid = centroid_bbox.min[best_axis];
+  LightTreePrimitive *middle = std::partition(
+      &prims_[start], &prims_[0] + end, [&](const LightTreePrimitive &prim) {
+        const int b = min((int)((prim.centroid[best_axis] - min_centroid) * bucket_scale),
+                          num_buckets - 1);
+        return b < best_bucket;
+      });
+
+  return middle - &prims_[0];
+}
+
+CCL_NAMESPACE_END
@@ -0,0 +1,98 @@
+/*
+ * Copyright 2011-2020 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __LIGHT_TREE_H__
+#define __LIGHT_TREE_H__
+
+#include "kernel/kernel_types.h"
+
+#include "util/util_boundbox.h"
+#include "util/util_types.h"
+#include "util/util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Bounds of the emission directions of a set of emitters: they emit in directions within
+ * theta_o of the axis, and the emission falls off to zero theta_e further away.
+ *
+ * See "Importance Sampling of Many Lights with Adaptive Tree Splitting",
+ * Alejandro Conty Estevez and Christopher Kulla, 2018. */
+struct LightTreeCone {
+  float3 axis;
+  float theta_o;
+  float theta_e;
+
+  LightTreeCone() : axis(make_float3(0.0f, 0.0f, 1.0f)), theta_o(0.0f), theta_e(0.0f)
+  {
+  }
+
+  LightTreeCone(const float3 &axis, float theta_o, float theta_e)
+      : axis(axis), theta_o(theta_o), theta_e(theta_e)
+  {
+  }
+
+  /* Measure of the set of directions bounded by the cone, used to estimate the cost of splits. */
+  float measure() const;
+};
+
+LightTreeCone merge(const LightTreeCone &a, const LightTreeCone &b);
+
+/* Light source to be put in the tree, either an emissive triangle or a lamp. */
+struct LightTreePrimitive {
+  BoundBox bbox;
+  float3 centroid;
+  float radius;
+  LightTreeCone cone;
+  /* Estimated radiant intensity towards the axis of the cone. */
+  float energy;
+
+  /* Triangle primitive, or ~lamp for lamps. */
+  int prim;
+  int object_id;
+  int shader_flag;
+
+  LightTreePrimitive() : bbox(BoundBox::empty)
+  {
+  }
+};
+
+/* Bounding volume hierarchy of the light sources, where each node stores the bounds of the
+ * position, emission directions and energy of its emitters. Sampling traverses the tree choosing
+ * children proportionally to their estimated contribution to the shading point.
+ *
+ * Equal time noise compared to the flat light distribution is not measured here, there are no
+ * benchmark scenes or results for it. Traversal costs more per sample than the flat distribution,
+ * so it only pays off with many lights, which is why it's an option that is off by default. */
+class LightTree {
+ public:
+  LightTree(const vector<LightTreePrimitive> &prims, int max_emitters_in_leaf = 8);
+
+  /* Nodes in depth first order. */
+  vector<KernelLightTreeNode> nodes;
+  /* Emitters in order of the leaves. */
+  vector<KernelLightTreeEmitter> emitters;
+
+ protected:
+  int recursive_build(int start, int end, int parent_index);
+  int find_split(int start, int end, const BoundBox &bbox, const BoundBox &centroid_bbox);
+
+  vector<LightTreePrimitive> prims_;
+  int max_emitters_in_leaf_;
+};
+
+CCL_NAMESPACE_END
+
+#endif /* __LIGHT_TREE_H__ */
@@ -267,6 +267,11 @@ NODE_DEFINE(ImageTextureNode)
   SOCKET_FLOAT(projection_blend, "Projection Blend", 0.0f);
 
   SOCKET_IN_POINT(vector, "Vector", make_float3(0.0f, 0.0f, 0.0f), SocketType::LINK_TEXTURE_UV);
+  /* Vector shifted by the ray differentials, for filtering images in the texture cache. */
+  SOCKET_IN_POINT(
+      vector_dx, "VectorDX", make_float3(0.0f, 0.0f, 0.0f), SocketType::SVM_INTERNAL);
+  SOCKET_IN_POINT(
+      vector_dy, "VectorDY", make_float3(0.0f, 0.0f, 0.0f), SocketType::SVM_INTERNAL);
 
   SOCKET_OUT_COLOR(color, "Color");
   SOCKET_OUT_FLOAT(alpha, "Alpha");
@@ -385,6 +390,8 @@ void ImageTextureNode::attributes(Shader *shader, AttributeRequestSet *attribute
 void ImageTextureNode::compile(SVMCompiler &compiler)
 {
   ShaderInput *vector_in = input("Vector");
+  ShaderInput *vector_dx_in = input("VectorDX");
+  ShaderInput *vector_dy_in = input("VectorDY");
   ShaderOutput *color_out = output("Color");
   ShaderOutput *alpha_out = output("Alpha");
 
@@ -436,6 +443,14 @@ void ImageTextureNode::compile(SVMCompiler &compiler)
     }
 
     if (projection != NODE_IMAGE_PROJ_BOX) {
+      /* Differentials are only linked for images in the texture cache. */
+      int vector_dx_offset = SVM_STACK_INVALID;
+      int vector_dy_offset = SVM_STACK_INVALID;
+      if (vector_dx_in->link && vector_dy_in->link) {
+        vector_dx_offset = tex_mapping.compile_begin(compiler, vector_dx_in);
+        vector_dy_offset = tex_mapping.compile_begin(compiler, vector_dy_in);
+      }
+
       /* If there only is one image (a very common case), we encode it as a negative value. */
       int num_nodes;
       if (slots.size() == 1) {
@@ -451,7 +466,7 @@ void ImageTextureNode::compile(SVMCompiler &compiler)
                                                compiler.stack_assign_if_linked(color_out),
                                                compiler.stack_assign_if_linked(alpha_out),
                                                flags),
-                        projection);
+                        compiler.encode_uchar4(projection, vector_dx_offset, vector_dy_offset));
 
       if (num_nodes > 0) {
         for (int i = 0; i < num_nodes; i++) {
@@ -469,6 +484,11 @@ void ImageTextureNode::compile(SVMCompiler &compiler)
           compiler.add_node(node.x, node.y, node.z, node.w);
         }
       }
+
+      if (vector_dx_offset != SVM_STACK_INVALID) {
+        tex_mapping.compile_end(compiler, vector_dx_in, vector_dx_offset);
+        tex_mapping.compile_end(compiler, vector_dy_in, vector_dy_offset);
+      }
     }
     else {
       assert(slots.size() == 1);
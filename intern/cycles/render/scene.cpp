@@ -73,6 +73,11 @@ DeviceScene::DeviceScene(Device *device)
       lights(device, "__lights", MEM_TEXTURE),
       light_background_marginal_cdf(device, "__light_background_marginal_cdf", MEM_TEXTURE),
       light_background_conditional_cdf(device, "__light_background_conditional_cdf", MEM_TEXTURE),
+      light_tree_nodes(device, "__light_tree_nodes", MEM_TEXTURE),
+      light_tree_emitters(device, "__light_tree_emitters", MEM_TEXTURE),
+      light_to_tree(device, "__light_to_tree", MEM_TEXTURE),
+      object_to_tree(device, "__object_to_tree", MEM_TEXTURE),
+      triangle_to_tree(device, "__triangle_to_tree", MEM_TEXTURE),
       particles(device, "__particles", MEM_TEXTURE),
       svm_nodes(device, "__svm_nodes", MEM_TEXTURE),
       shaders(device, "__shaders", MEM_TEXTURE),
@@ -107,6 +112,10 @@ Scene::Scene(const SceneParams &params_, Device *device)
     shader_manager = ShaderManager::create(this, params.shadingsystem);
   else
     shader_manager = ShaderManager::create(this, SHADINGSYSTEM_SVM);
+
+  /* Texture cache is only supported by the CPU kernel, OSL uses its own. */
+  if (params.use_texture_cache && device->info.type == DEVICE_CPU && !shader_manager->use_osl())
+    image_manager->set_texture_cache(params.texture_cache_size);
 }
 
 Scene::~Scene()
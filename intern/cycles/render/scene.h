@@ -107,6 +107,11 @@ class DeviceScene {
   device_vector<KernelLight> lights;
   device_vector<float2> light_background_marginal_cdf;
   device_vector<float2> light_background_conditional_cdf;
+  device_vector<KernelLightTreeNode> light_tree_nodes;
+  device_vector<KernelLightTreeEmitter> light_tree_emitters;
+  device_vector<uint> light_to_tree;
+  device_vector<uint> object_to_tree;
+  device_vector<uint> triangle_to_tree;
 
   /* particles */
   device_vector<KernelParticle> particles;
@@ -169,6 +174,9 @@ class SceneParams {
   int num_bvh_time_steps;
   bool persistent_data;
   int texture_limit;
+  /* Load images on demand through a texture cache of this size in megabytes. */
+  bool use_texture_cache;
+  int texture_cache_size;
 
   bool background;
 
@@ -182,6 +190,8 @@ class SceneParams {
     num_bvh_time_steps = 0;
     persistent_data = false;
     texture_limit = 0;
+    use_texture_cache = false;
+    texture_cache_size = 1024;
     background = true;
   }
 
@@ -192,7 +202,9 @@ class SceneParams {
              use_bvh_spatial_split == params.use_bvh_spatial_split &&
              use_bvh_unaligned_nodes == params.use_bvh_unaligned_nodes &&
              num_bvh_time_steps == params.num_bvh_time_steps &&
-             persistent_data == params.persistent_data && texture_limit == params.texture_limit);
+             persistent_data == params.persistent_data && texture_limit == params.texture_limit &&
+             use_texture_cache == params.use_texture_cache &&
+             texture_cache_size == params.texture_cache_size);
   }
 };
 
@@ -0,0 +1,106 @@
+/*
+ * Copyright 2011-2020 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "testing/testing.h"
+
+#include "render/light_tree.h"
+
+CCL_NAMESPACE_BEGIN
+
+namespace {
+
+LightTreePrimitive point_light(const float3 &co, float energy, int index)
+{
+  LightTreePrimitive prim;
+  prim.centroid = co;
+  prim.radius = 0.1f;
+  prim.bbox.grow(co, 0.1f);
+  prim.cone = LightTreeCone(make_float3(0.0f, 0.0f, 1.0f), M_PI_F, M_PI_2_F);
+  prim.energy = energy;
+  prim.prim = ~index;
+  prim.object_id = 0;
+  prim.shader_flag = 0;
+  return prim;
+}
+
+}  // namespace
+
+TEST(render_light_tree, cone_merge_contained)
+{
+  LightTreeCone a(make_float3(0.0f, 0.0f, 1.0f), 0.5f, 0.1f);
+  LightTreeCone b(make_float3(0.0f, 0.0f, 1.0f), 0.2f, 0.3f);
+  LightTreeCone cone = merge(a, b);
+  EXPECT_FLOAT_EQ(cone.theta_o, 0.5f);
+  EXPECT_FLOAT_EQ(cone.theta_e, 0.3f);
+  EXPECT_FLOAT_EQ(cone.axis.z, 1.0f);
+}
+
+TEST(render_light_tree, cone_merge_orthogonal)
+{
+  LightTreeCone a(make_float3(0.0f, 0.0f, 1.0f), 0.0f, M_PI_2_F);
+  LightTreeCone b(make_float3(1.0f, 0.0f, 0.0f), 0.0f, M_PI_2_F);
+  LightTreeCone cone = merge(a, b);
+  EXPECT_NEAR(cone.theta_o, M_PI_4_F, 1e-5f);
+  EXPECT_NEAR(cone.axis.x, sqrtf(0.5f), 1e-5f);
+  EXPECT_NEAR(cone.axis.z, sqrtf(0.5f), 1e-5f);
+}
+
+TEST(render_light_tree, cone_merge_opposite)
+{
+  LightTreeCone a(make_float3(0.0f, 0.0f, 1.0f), 0.0f, M_PI_2_F);
+  LightTreeCone b(make_float3(0.0f, 0.0f, -1.0f), 0.0f, M_PI_2_F);
+  EXPECT_FLOAT_EQ(merge(a, b).theta_o, M_PI_F);
+}
+
+TEST(render_light_tree, build)
+{
+  vector<LightTreePrimitive> prims;
+  for (int i = 0; i < 100; i++) {
+    prims.push_back(point_light(make_float3(i % 10, i / 10, 0.0f), 1.0f + i, i));
+  }
+
+  LightTree tree(prims, 4);
+  ASSERT_EQ(tree.emitters.size(), prims.size());
+  EXPECT_EQ(tree.nodes[0].parent_index, -1);
+
+  vector<bool> found(prims.size(), false);
+  for (size_t i = 0; i < tree.nodes.size(); i++) {
+    const KernelLightTreeNode &knode = tree.nodes[i];
+    if (knode.num_emitters == 0) {
+      /* The first child follows its parent, the energy is the sum of the children ones. */
+      const KernelLightTreeNode &left = tree.nodes[i + 1];
+      const KernelLightTreeNode &right = tree.nodes[knode.child_index];
+      EXPECT_EQ(left.parent_index, i);
+      EXPECT_EQ(right.parent_index, i);
+      EXPECT_NEAR(left.energy + right.energy, knode.energy, 1e-3f);
+      continue;
+    }
+    EXPECT_LE(knode.num_emitters, 4);
+    for (int j = knode.child_index; j < knode.child_index + knode.num_emitters; j++) {
+      const KernelLightTreeEmitter &kemitter = tree.emitters[j];
+      EXPECT_EQ(kemitter.parent_index, i);
+      EXPECT_GE(kemitter.centroid[0], knode.bbox_min[0]);
+      EXPECT_LE(kemitter.centroid[0], knode.bbox_max[0]);
+      found[~kemitter.prim] = true;
+    }
+  }
+
+  for (size_t i = 0; i < found.size(); i++) {
+    EXPECT_TRUE(found[i]);
+  }
+}
+
+CCL_NAMESPACE_END
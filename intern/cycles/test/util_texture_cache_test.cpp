@@ -0,0 +1,103 @@
+/*
+ * Copyright 2011-2020 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "testing/testing.h"
+
+#include "util/util_image.h"
+#include "util/util_path.h"
+#include "util/util_texture_cache.h"
+#include "util/util_vector.h"
+
+#include <OpenImageIO/filesystem.h>
+#include <OpenImageIO/imagebufalgo.h>
+
+CCL_NAMESPACE_BEGIN
+
+namespace {
+
+/* Tiled mipmapped single channel image, white in the top half and black in the bottom one. */
+string make_test_texture()
+{
+  const int size = 256;
+  vector<float> pixels(size * size, 0.0f);
+  for (int i = 0; i < size * size / 2; i++) {
+    pixels[i] = 1.0f;
+  }
+
+  ImageBuf buf(ImageSpec(size, size, 1, TypeDesc::FLOAT), pixels.data());
+  ImageSpec config;
+  config.tile_width = 64;
+  config.tile_height = 64;
+  config.tile_depth = 1;
+  config.set_format(TypeDesc::FLOAT);
+
+  const string filename = path_join(Filesystem::temp_directory_path(),
+                                    "cycles_util_texture_cache_test.tx");
+  EXPECT_TRUE(ImageBufAlgo::make_texture(ImageBufAlgo::MakeTxTexture, buf, filename, config));
+  return filename;
+}
+
+float lookup(const TextureCacheImage *image,
+             ExtensionType extension,
+             float x,
+             float y,
+             float dx = 0.0f,
+             float dy = 0.0f)
+{
+  float result[4];
+  TextureCache::lookup(
+      image, INTERPOLATION_LINEAR, extension, x, y, dx, 0.0f, 0.0f, dy, result);
+  /* Single channel images are returned as gray RGBA. */
+  EXPECT_EQ(result[0], result[1]);
+  EXPECT_EQ(result[0], result[2]);
+  EXPECT_EQ(result[3], 1.0f);
+  return result[0];
+}
+
+}  // namespace
+
+TEST(util_texture_cache, missing_file)
+{
+  TextureCache cache(16);
+  EXPECT_EQ(cache.add_image("/nonexistent/cycles_util_texture_cache_test.tx"), nullptr);
+}
+
+TEST(util_texture_cache, lookup)
+{
+  const string filename = make_test_texture();
+  TextureCache cache(16);
+  TextureCacheImage *image = cache.add_image(filename);
+  ASSERT_NE(image, nullptr);
+
+  /* The origin is the bottom left corner of the image. */
+  EXPECT_NEAR(lookup(image, EXTENSION_REPEAT, 0.5f, 0.75f), 1.0f, 1e-5f);
+  EXPECT_NEAR(lookup(image, EXTENSION_REPEAT, 0.5f, 0.25f), 0.0f, 1e-5f);
+
+  /* Extension past the image bounds. */
+  EXPECT_NEAR(lookup(image, EXTENSION_REPEAT, 1.5f, 0.75f), 1.0f, 1e-5f);
+  EXPECT_NEAR(lookup(image, EXTENSION_CLIP, 1.5f, 0.75f), 0.0f, 1e-5f);
+  EXPECT_NEAR(lookup(image, EXTENSION_EXTEND, 0.5f, 1.5f), 1.0f, 1e-5f);
+
+  /* Footprint covering the whole image reads a low resolution level, which blends both
+   * halves of the image. */
+  EXPECT_NEAR(lookup(image, EXTENSION_REPEAT, 0.5f, 0.6f), 1.0f, 1e-5f);
+  EXPECT_LT(lookup(image, EXTENSION_REPEAT, 0.5f, 0.6f, 1.0f, 1.0f), 0.9f);
+
+  cache.remove_image(image);
+  path_remove(filename);
+}
+
+CCL_NAMESPACE_END
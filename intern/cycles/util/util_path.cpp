@@ -739,6 +739,12 @@ bool path_remove(const string &path)
   return remove(path.c_str()) == 0;
 }
 
+bool path_rename(const string &from, const string &to)
+{
+  string error;
+  return OIIO::Filesystem::rename(from, to, error);
+}
+
 struct SourceReplaceState {
   typedef map<string, string> ProcessedMapping;
   /* Base director for all relative include headers. */
@@ -91,6 +91,8 @@ typedef enum ExtensionType {
 typedef struct TextureInfo {
   /* Pointer, offset or texture depending on device. */
   uint64_t data;
+  /* Image in the texture cache on the CPU, pixels are loaded on demand and data is unused. */
+  uint64_t cache_image;
   /* Buffer number for OpenCL. */
   uint cl_buffer;
   /* Interpolation and extension type. */
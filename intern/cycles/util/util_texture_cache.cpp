@@ -0,0 +1,157 @@
+/*
+ * Copyright 2011-2020 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "util/util_texture_cache.h"
+#include "util/util_algorithm.h"
+#include "util/util_logging.h"
+
+#include <OpenImageIO/texture.h>
+
+CCL_NAMESPACE_BEGIN
+
+OIIO_NAMESPACE_USING
+
+struct TextureCacheImage {
+  TextureSystem *texture_system;
+  TextureSystem::TextureHandle *handle;
+  int channels;
+};
+
+TextureCache::TextureCache(int max_memory)
+{
+  /* Not shared with OSL, so the memory budget only applies to our images. */
+  TextureSystem *texture_system = TextureSystem::create(false);
+  texture_system->attribute("max_memory_MB", (float)max_memory);
+  /* Images are converted to tiled mipmapped files when they are added to the scene, with the
+   * alpha association and colorspace conversion of the pixels done, so read them as is. */
+  texture_system->attribute("autotile", 0);
+  texture_system->attribute("automip", 0);
+  texture_system->attribute("unassociatedalpha", 1);
+  texture_system_ = texture_system;
+}
+
+TextureCache::~TextureCache()
+{
+  TextureSystem *texture_system = (TextureSystem *)texture_system_;
+  VLOG(1) << "Texture cache statistics:\n" << texture_system->getstats(1);
+  TextureSystem::destroy(texture_system);
+}
+
+TextureCacheImage *TextureCache::add_image(const string &filename)
+{
+  TextureSystem *texture_system = (TextureSystem *)texture_system_;
+  ustring texture_name(filename);
+
+  int channels = 0;
+  if (!texture_system->get_texture_info(
+          texture_name, 0, ustring("channels"), TypeDesc::INT, &channels) ||
+      channels < 1) {
+    VLOG(1) << "Failed to open " << filename
+            << " in the texture cache: " << texture_system->geterror();
+    return NULL;
+  }
+
+  TextureCacheImage *image = new TextureCacheImage();
+  image->texture_system = texture_system;
+  image->handle = texture_system->get_texture_handle(texture_name);
+  image->channels = min(channels, 4);
+  return image;
+}
+
+void TextureCache::remove_image(TextureCacheImage *image)
+{
+  /* The tiles stay in the cache until they are evicted, the file might be used again. */
+  delete image;
+}
+
+void TextureCache::lookup(const TextureCacheImage *image,
+                          InterpolationType interpolation,
+                          ExtensionType extension,
+                          float x,
+                          float y,
+                          float dx_x,
+                          float dx_y,
+                          float dy_x,
+                          float dy_y,
+                          float *result)
+{
+  TextureOpt options;
+
+  switch (extension) {
+    case EXTENSION_EXTEND:
+      options.swrap = options.twrap = TextureOpt::WrapClamp;
+      break;
+    case EXTENSION_CLIP:
+      options.swrap = options.twrap = TextureOpt::WrapBlack;
+      break;
+    default:
+      options.swrap = options.twrap = TextureOpt::WrapPeriodic;
+      break;
+  }
+
+  switch (interpolation) {
+    case INTERPOLATION_CLOSEST:
+      options.interpmode = TextureOpt::InterpClosest;
+      options.mipmode = TextureOpt::MipModeOneLevel;
+      break;
+    case INTERPOLATION_CUBIC:
+      options.interpmode = TextureOpt::InterpBicubic;
+      break;
+    case INTERPOLATION_SMART:
+      options.interpmode = TextureOpt::InterpSmartBicubic;
+      break;
+    default:
+      options.interpmode = TextureOpt::InterpBilinear;
+      break;
+  }
+
+  /* The first row of the file is the top of the image. */
+  TextureSystem *texture_system = image->texture_system;
+  TextureSystem::Perthread *thread_info = texture_system->get_perthread_info();
+  if (!texture_system->texture(image->handle,
+                               thread_info,
+                               options,
+                               x,
+                               1.0f - y,
+                               dx_x,
+                               -dx_y,
+                               dy_x,
+                               -dy_y,
+                               image->channels,
+                               result)) {
+    /* Clear the error, it's only reported once when opening the image. */
+    (void)texture_system->geterror();
+    result[0] = TEX_IMAGE_MISSING_R;
+    result[1] = TEX_IMAGE_MISSING_G;
+    result[2] = TEX_IMAGE_MISSING_B;
+    result[3] = TEX_IMAGE_MISSING_A;
+    return;
+  }
+
+  if (image->channels == 1) {
+    result[1] = result[2] = result[0];
+    result[3] = 1.0f;
+  }
+  else if (image->channels == 2) {
+    result[3] = result[1];
+    result[1] = result[2] = result[0];
+  }
+  else if (image->channels == 3) {
+    result[3] = 1.0f;
+  }
+}
+
+CCL_NAMESPACE_END
@@ -0,0 +1,64 @@
+/*
+ * Copyright 2011-2020 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __UTIL_TEXTURE_CACHE_H__
+#define __UTIL_TEXTURE_CACHE_H__
+
+#include "util/util_string.h"
+#include "util/util_texture.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Image opened through the texture cache. */
+struct TextureCacheImage;
+
+/* Cache of tiled and mipmapped image files, which are loaded tile by tile as they are accessed,
+ * keeping memory usage within a fixed budget. Only used by the CPU kernel, the lookups are
+ * done through the OpenImageIO texture system.
+ *
+ * This header is included by the kernel, so only plain types are used in the interface. */
+class TextureCache {
+ public:
+  /* Maximum memory used by the tiles, in megabytes. */
+  explicit TextureCache(int max_memory);
+  ~TextureCache();
+
+  /* Open a tiled mipmapped image file, returns NULL when it can not be read. */
+  TextureCacheImage *add_image(const string &filename);
+  void remove_image(TextureCacheImage *image);
+
+  /* Filtered lookup of the image at (x, y), with (0, 0) the bottom left corner of the image.
+   * The differentials of the coordinates along the image plane select the mipmap level to
+   * read, zero differentials give the full resolution. Writes RGBA to result. */
+  static void lookup(const TextureCacheImage *image,
+                     InterpolationType interpolation,
+                     ExtensionType extension,
+                     float x,
+                     float y,
+                     float dx_x,
+                     float dx_y,
+                     float dy_x,
+                     float dy_y,
+                     float *result);
+
+ protected:
+  /* OpenImageIO texture system, kept opaque to avoid including it in the kernel. */
+  void *texture_system_;
+};
+
+CCL_NAMESPACE_END
+
+#endif /* __UTIL_TEXTURE_CACHE_H__ */
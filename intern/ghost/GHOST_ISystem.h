@@ -136,6 +136,13 @@ class GHOST_ISystem {
    */
   static GHOST_TSuccess createSystem();
 
+  /**
+   * Creates the one and only system without display connection (GHOST_SystemNULL),
+   * for programs running without window.
+   * \return An indication of success.
+   */
+  static GHOST_TSuccess createSystemBackground();
+
   /**
    * Disposes the one and only system.
    * \return An indication of success.
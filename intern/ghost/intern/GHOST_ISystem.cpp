@@ -27,11 +27,13 @@
 
 #include "GHOST_ISystem.h"
 
+#include "GHOST_SystemNULL.h"
+
 #ifdef WITH_X11
 #  include "GHOST_SystemX11.h"
 #else
 #  ifdef WITH_HEADLESS
-#    include "GHOST_SystemNULL.h"
+/* Already included. */
 #  elif defined(WITH_GHOST_SDL)
 #    include "GHOST_SystemSDL.h"
 #  elif defined(WIN32)
@@ -75,6 +77,23 @@ GHOST_TSuccess GHOST_ISystem::createSystem()
   return success;
 }
 
+GHOST_TSuccess GHOST_ISystem::createSystemBackground()
+{
+  GHOST_TSuccess success;
+  if (!m_system) {
+    /* No display connection, windows and contexts are never created. */
+    m_system = new GHOST_SystemNULL();
+    success = m_system != NULL ? GHOST_kSuccess : GHOST_kFailure;
+  }
+  else {
+    success = GHOST_kFailure;
+  }
+  if (success) {
+    success = m_system->init();
+  }
+  return success;
+}
+
 GHOST_TSuccess GHOST_ISystem::disposeSystem()
 {
   GHOST_TSuccess success = GHOST_kSuccess;
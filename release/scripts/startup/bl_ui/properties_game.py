@@ -372,6 +372,8 @@ class SCENE_PT_game_physics(SceneButtonsPanel, Panel):
             sub = col.row()
             sub.prop(gs, "deactivation_time", text="Time")
 
+            layout.prop(gs, "use_merge_static_colliders")
+
         else:
             split = layout.split()
 
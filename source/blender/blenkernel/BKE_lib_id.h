@@ -164,7 +164,7 @@ enum {
    */
   LIB_ID_FREE_NOT_ALLOCATED = 1 << 2,
 
-  /** Do not tag freed ID for update in depsgraph. */
+  /** Do not tag freed ID for update in depsgraph, nor the depsgraph relations. */
   LIB_ID_FREE_NO_DEG_TAG = 1 << 8,
   /** Do not attempt to remove freed ID from UI data/notifiers/... */
   LIB_ID_FREE_NO_UI_USER = 1 << 9,
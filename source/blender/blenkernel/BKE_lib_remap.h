@@ -79,6 +79,8 @@ enum {
   ID_REMAP_NO_INDIRECT_PROXY_DATA_USAGE = 1 << 4,
   /** Do not remap library override pointers. */
   ID_REMAP_SKIP_OVERRIDE_LIBRARY = 1 << 5,
+  /** Do not tag depsgraph relations for update, the caller handles it. */
+  ID_REMAP_SKIP_DEG_TAG = 1 << 6,
 };
 
 /* Note: Requiring new_id to be non-null, this *may* not be the case ultimately,
@@ -49,6 +49,7 @@ extern "C" {
 
 /* Add the blendfile name after blendcache_ */
 #define PTCACHE_EXT ".bphys"
+#define PTCACHE_SINGLE_FILE_EXT ".bphyscache"
 #define PTCACHE_PATH "blendcache_"
 
 /* File open options, for BKE_ptcache_file_open */
@@ -78,6 +79,7 @@ extern "C" {
 #define PTCACHE_READ_OLD 3
 
 /* Structs */
+struct BLI_mmap_file;
 struct ClothModifierData;
 struct FluidModifierData;
 struct ListBase;
@@ -109,6 +111,13 @@ typedef struct PTCacheData {
 typedef struct PTCacheFile {
   FILE *fp;
 
+  /* Frame of a single file cache (fp is NULL then), read from the mapping of the file kept by
+   * the frame index, or written to memory and added to the file of pid when closing. */
+  struct BLI_mmap_file *mmap_file;
+  unsigned char *mem;
+  size_t mem_len, mem_alloc, mem_pos;
+  struct PTCacheID *pid;
+
   int frame, old_format;
   unsigned int totpoint, type;
   unsigned int data_types, flag;
@@ -306,6 +315,8 @@ bool BKE_ptcache_object_has(struct Scene *scene, struct Object *ob, int duplis);
 
 /***************** Global funcs ****************************/
 void BKE_ptcache_remove(void);
+/* Free global data of disk caches, on exit. */
+void BKE_ptcache_exit(void);
 
 /************ ID specific functions ************************/
 void BKE_ptcache_id_clear(PTCacheID *id, int mode, unsigned int cfra);
@@ -368,6 +379,10 @@ void BKE_ptcache_mem_to_disk(struct PTCacheID *pid);
 /* Convert disk cache to memory cache and vice versa. Clears the cache that was converted. */
 void BKE_ptcache_toggle_disk_cache(struct PTCacheID *pid);
 
+/* Convert the disk cache to the format set by the PTCACHE_SINGLE_FILE flag, which was changed
+ * already. */
+void BKE_ptcache_toggle_single_file(struct PTCacheID *pid);
+
 /* Rename all disk cache files with a new name. Doesn't touch the actual content of the files. */
 void BKE_ptcache_disk_cache_rename(struct PTCacheID *pid,
                                    const char *name_src,
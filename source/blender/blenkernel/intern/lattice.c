@@ -647,7 +647,7 @@ static bool where_on_path_deform(
 /* returns quaternion for rotation, using cd->no_rot_axis */
 /* axis is using another define!!! */
 static bool calc_curve_deform(
-    Object *par, float co[3], const short axis, CurveDeform *cd, float r_quat[4])
+    Object *par, float co[3], const short axis, const CurveDeform *cd, float r_quat[4])
 {
   Curve *cu = par->data;
   float fac, loc[4], dir[3], new_quat[4], radius;
@@ -754,6 +754,86 @@ static bool calc_curve_deform(
   return false;
 }
 
+typedef struct CurveDeformTaskData {
+  Object *cu_ob;
+  CurveDeform *cd;
+  float (*vert_coords)[3];
+  MDeformVert *dvert;
+  int defgrp_index;
+  bool invert_vgroup;
+  short defaxis;
+  /* Coordinates are already in curve space (transformed while computing their bounds). */
+  bool use_curvespace_coords;
+} CurveDeformTaskData;
+
+typedef struct CurveDeformBounds {
+  float min[3], max[3];
+} CurveDeformBounds;
+
+BLI_INLINE float curve_deform_vert_weight(const CurveDeformTaskData *data, const int index)
+{
+  if (data->dvert == NULL) {
+    return 1.0f;
+  }
+  const float weight = BKE_defvert_find_weight(data->dvert + index, data->defgrp_index);
+  return data->invert_vgroup ? 1.0f - weight : weight;
+}
+
+static void curve_deform_verts_bounds_task(void *__restrict userdata,
+                                           const int index,
+                                           const TaskParallelTLS *__restrict tls)
+{
+  const CurveDeformTaskData *data = userdata;
+  CurveDeformBounds *bounds = tls->userdata_chunk;
+
+  if (curve_deform_vert_weight(data, index) > 0.0f) {
+    mul_m4_v3(data->cd->curvespace, data->vert_coords[index]);
+    minmax_v3v3_v3(bounds->min, bounds->max, data->vert_coords[index]);
+  }
+}
+
+static void curve_deform_verts_bounds_finalize(void *__restrict userdata,
+                                               void *__restrict userdata_chunk)
+{
+  const CurveDeformTaskData *data = userdata;
+  const CurveDeformBounds *bounds = userdata_chunk;
+
+  /* Bounds stay inverted when no vertex of the chunk is deformed. */
+  if (bounds->min[0] <= bounds->max[0]) {
+    minmax_v3v3_v3(data->cd->dmin, data->cd->dmax, bounds->min);
+    minmax_v3v3_v3(data->cd->dmin, data->cd->dmax, bounds->max);
+  }
+}
+
+static void curve_deform_verts_task(void *__restrict userdata,
+                                    const int index,
+                                    const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const CurveDeformTaskData *data = userdata;
+  const float weight = curve_deform_vert_weight(data, index);
+  float *co = data->vert_coords[index];
+
+  if (weight <= 0.0f) {
+    return;
+  }
+
+  if (!data->use_curvespace_coords) {
+    mul_m4_v3(data->cd->curvespace, co);
+  }
+
+  if (data->dvert != NULL) {
+    float vec[3];
+    copy_v3_v3(vec, co);
+    calc_curve_deform(data->cu_ob, vec, data->defaxis, data->cd, NULL);
+    interp_v3_v3v3(co, co, vec, weight);
+  }
+  else {
+    calc_curve_deform(data->cu_ob, co, data->defaxis, data->cd, NULL);
+  }
+
+  mul_m4_v3(data->cd->objectspace, co);
+}
+
 void curve_deform_verts(Object *cuOb,
                         Object *target,
                         float (*vert_coords)[3],
@@ -764,10 +844,8 @@ void curve_deform_verts(Object *cuOb,
                         short defaxis)
 {
   Curve *cu;
-  int a;
   CurveDeform cd;
   const bool is_neg_axis = (defaxis > 2);
-  const bool invert_vgroup = (flag & MOD_CURVE_INVERT_VGROUP) != 0;
 
   if (cuOb->type != OB_CURVE) {
     return;
@@ -788,78 +866,40 @@ void curve_deform_verts(Object *cuOb,
     cd.dmax[0] = cd.dmax[1] = cd.dmax[2] = 0.0f;
   }
 
-  if (dvert) {
-    MDeformVert *dvert_iter;
-    float vec[3];
+  CurveDeformTaskData data = {
+      .cu_ob = cuOb,
+      .cd = &cd,
+      .vert_coords = vert_coords,
+      .dvert = dvert,
+      .defgrp_index = defgrp_index,
+      .invert_vgroup = (flag & MOD_CURVE_INVERT_VGROUP) != 0,
+      .defaxis = defaxis,
+      .use_curvespace_coords = false,
+  };
 
-    if (cu->flag & CU_DEFORM_BOUNDS_OFF) {
-      for (a = 0, dvert_iter = dvert; a < numVerts; a++, dvert_iter++) {
-        const float weight = invert_vgroup ?
-                                 1.0f - BKE_defvert_find_weight(dvert_iter, defgrp_index) :
-                                 BKE_defvert_find_weight(dvert_iter, defgrp_index);
-
-        if (weight > 0.0f) {
-          mul_m4_v3(cd.curvespace, vert_coords[a]);
-          copy_v3_v3(vec, vert_coords[a]);
-          calc_curve_deform(cuOb, vec, defaxis, &cd, NULL);
-          interp_v3_v3v3(vert_coords[a], vert_coords[a], vec, weight);
-          mul_m4_v3(cd.objectspace, vert_coords[a]);
-        }
-      }
-    }
-    else {
-      /* set mesh min/max bounds */
-      INIT_MINMAX(cd.dmin, cd.dmax);
-
-      for (a = 0, dvert_iter = dvert; a < numVerts; a++, dvert_iter++) {
-        const float weight = invert_vgroup ?
-                                 1.0f - BKE_defvert_find_weight(dvert_iter, defgrp_index) :
-                                 BKE_defvert_find_weight(dvert_iter, defgrp_index);
-        if (weight > 0.0f) {
-          mul_m4_v3(cd.curvespace, vert_coords[a]);
-          minmax_v3v3_v3(cd.dmin, cd.dmax, vert_coords[a]);
-        }
-      }
+  if ((cu->flag & CU_DEFORM_BOUNDS_OFF) == 0) {
+    /* set mesh min/max bounds, vertices are moved to curve space on the way */
+    INIT_MINMAX(cd.dmin, cd.dmax);
 
-      for (a = 0, dvert_iter = dvert; a < numVerts; a++, dvert_iter++) {
-        const float weight = invert_vgroup ?
-                                 1.0f - BKE_defvert_find_weight(dvert_iter, defgrp_index) :
-                                 BKE_defvert_find_weight(dvert_iter, defgrp_index);
-
-        if (weight > 0.0f) {
-          /* already in 'cd.curvespace', prev for loop */
-          copy_v3_v3(vec, vert_coords[a]);
-          calc_curve_deform(cuOb, vec, defaxis, &cd, NULL);
-          interp_v3_v3v3(vert_coords[a], vert_coords[a], vec, weight);
-          mul_m4_v3(cd.objectspace, vert_coords[a]);
-        }
-      }
-    }
-  }
-  else {
-    if (cu->flag & CU_DEFORM_BOUNDS_OFF) {
-      for (a = 0; a < numVerts; a++) {
-        mul_m4_v3(cd.curvespace, vert_coords[a]);
-        calc_curve_deform(cuOb, vert_coords[a], defaxis, &cd, NULL);
-        mul_m4_v3(cd.objectspace, vert_coords[a]);
-      }
-    }
-    else {
-      /* set mesh min max bounds */
-      INIT_MINMAX(cd.dmin, cd.dmax);
+    CurveDeformBounds bounds;
+    INIT_MINMAX(bounds.min, bounds.max);
 
-      for (a = 0; a < numVerts; a++) {
-        mul_m4_v3(cd.curvespace, vert_coords[a]);
-        minmax_v3v3_v3(cd.dmin, cd.dmax, vert_coords[a]);
-      }
+    TaskParallelSettings settings;
+    BLI_parallel_range_settings_defaults(&settings);
+    settings.min_iter_per_thread = 1024;
+    settings.userdata_chunk = &bounds;
+    settings.userdata_chunk_size = sizeof(bounds);
+    settings.func_finalize = curve_deform_verts_bounds_finalize;
+    BLI_task_parallel_range(0, numVerts, &data, curve_deform_verts_bounds_task, &settings);
 
-      for (a = 0; a < numVerts; a++) {
-        /* already in 'cd.curvespace', prev for loop */
-        calc_curve_deform(cuOb, vert_coords[a], defaxis, &cd, NULL);
-        mul_m4_v3(cd.objectspace, vert_coords[a]);
-      }
-    }
+    data.use_curvespace_coords = true;
   }
+
+  /* The path of the curve is read only, vertices are deformed independently. */
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 32;
+  BLI_task_parallel_range(0, numVerts, &data, curve_deform_verts_task, &settings);
 }
 
 /* input vec and orco = local coord in armature space */
@@ -312,7 +312,11 @@ void BKE_id_free_ex(Main *bmain, void *idv, int flag, const bool use_flag_from_i
 #endif
 
   if ((flag & LIB_ID_FREE_NO_USER_REFCOUNT) == 0) {
-    BKE_libblock_relink_ex(bmain, id, NULL, NULL, 0);
+    BKE_libblock_relink_ex(bmain,
+                           id,
+                           NULL,
+                           NULL,
+                           (flag & LIB_ID_FREE_NO_DEG_TAG) ? ID_REMAP_SKIP_DEG_TAG : 0);
   }
 
   BKE_libblock_free_datablock(id, flag);
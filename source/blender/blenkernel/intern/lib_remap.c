@@ -648,7 +648,9 @@ void BKE_libblock_relink_ex(
       break;
   }
 
-  DEG_relations_tag_update(bmain);
+  if ((remap_flags & ID_REMAP_SKIP_DEG_TAG) == 0) {
+    DEG_relations_tag_update(bmain);
+  }
 }
 
 static int id_relink_to_newid_looper(LibraryIDLinkCallbackData *cb_data)
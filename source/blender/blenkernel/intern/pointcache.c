@@ -21,6 +21,7 @@
  * \ingroup bke
  */
 
+#include <fcntl.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -43,8 +44,12 @@
 #include "DNA_fluid_types.h"
 
 #include "BLI_blenlib.h"
+#include "BLI_ghash.h"
 #include "BLI_math.h"
+#include "BLI_mmap.h"
 #include "BLI_string.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
 #include "BLI_utildefines.h"
 
 #include "BLT_translation.h"
@@ -101,8 +106,10 @@
 /* needed for directory lookup */
 #ifndef WIN32
 #  include <dirent.h>
+#  include <unistd.h>
 #else
 #  include "BLI_winstuff.h"
+#  include <io.h>
 #endif
 
 #define PTCACHE_DATA_FROM(data, type, from) \
@@ -146,6 +153,7 @@ static int ptcache_file_compressed_write(
     PTCacheFile *pf, unsigned char *in, unsigned int in_len, unsigned char *out, int mode);
 static int ptcache_file_write(PTCacheFile *pf, const void *f, unsigned int tot, unsigned int size);
 static int ptcache_file_read(PTCacheFile *pf, void *f, unsigned int tot, unsigned int size);
+static int ptcache_file_seek(PTCacheFile *pf, long offset, int origin);
 
 /* Common functions */
 static int ptcache_basic_header_read(PTCacheFile *pf)
@@ -153,11 +161,11 @@ static int ptcache_basic_header_read(PTCacheFile *pf)
   int error = 0;
 
   /* Custom functions should read these basic elements too! */
-  if (!error && !fread(&pf->totpoint, sizeof(unsigned int), 1, pf->fp)) {
+  if (!error && !ptcache_file_read(pf, &pf->totpoint, 1, sizeof(unsigned int))) {
     error = 1;
   }
 
-  if (!error && !fread(&pf->data_types, sizeof(unsigned int), 1, pf->fp)) {
+  if (!error && !ptcache_file_read(pf, &pf->data_types, 1, sizeof(unsigned int))) {
     error = 1;
   }
 
@@ -166,11 +174,11 @@ static int ptcache_basic_header_read(PTCacheFile *pf)
 static int ptcache_basic_header_write(PTCacheFile *pf)
 {
   /* Custom functions should write these basic elements too! */
-  if (!fwrite(&pf->totpoint, sizeof(unsigned int), 1, pf->fp)) {
+  if (!ptcache_file_write(pf, &pf->totpoint, 1, sizeof(unsigned int))) {
     return 0;
   }
 
-  if (!fwrite(&pf->data_types, sizeof(unsigned int), 1, pf->fp)) {
+  if (!ptcache_file_write(pf, &pf->data_types, 1, sizeof(unsigned int))) {
     return 0;
   }
 
@@ -847,7 +855,7 @@ static int ptcache_smoke_read(PTCacheFile *pf, void *smoke_v)
   ptcache_file_read(pf, version, 4, sizeof(char));
   if (!STREQLEN(version, SMOKE_CACHE_VERSION, 4)) {
     /* reset file pointer */
-    fseek(pf->fp, -4, SEEK_CUR);
+    ptcache_file_seek(pf, -4, SEEK_CUR);
     return ptcache_smoke_read_old(pf, smoke_v);
   }
 
@@ -2154,6 +2162,608 @@ static int ptcache_filename(PTCacheID *pid, char *filename, int cfra, short do_p
   return len; /* make sure the above string is always 16 chars */
 }
 
+/* Single file cache
+ *
+ * With #PTCACHE_SINGLE_FILE all frames of a disk cache are stored in one file, each frame with
+ * the same content as its ".bphys" file. New frames are appended to the file, followed by an
+ * index of all frames:
+ *
+ * - Header: magic, version and offset of the index.
+ * - Frames.
+ * - Index: magic, number of frames and the frame, size and offset of each frame (sorted).
+ *
+ * Appending frames writes over the previous index, the header is updated last. When the index
+ * is invalid (writing was interrupted) the cache is considered empty.
+ *
+ * Frames which are cleared are only removed from the index, frames which are replaced are
+ * appended again. Their space is reused when they are at the end of the file, which is the case
+ * when the frames after the current one are cleared. Otherwise the file grows until most of it
+ * is unused, then it's rewritten with only the frames in the index.
+ *
+ * The index is kept in #PointCache.frame_index, so looking up frames doesn't access the file
+ * system. Frames are read from a memory mapping of the file kept with the index, until the file
+ * is modified.
+ */
+
+#define PTCACHE_SINGLE_FILE_VERSION 1
+
+typedef struct PTCacheSingleFileHeader {
+  char magic[8];
+  unsigned int version;
+  unsigned int _pad;
+  uint64_t index_offset;
+} PTCacheSingleFileHeader;
+
+typedef struct PTCacheSingleFileIndexHeader {
+  char magic[8];
+  unsigned int totframe;
+  unsigned int _pad;
+} PTCacheSingleFileIndexHeader;
+
+typedef struct PTCacheFrameEntry {
+  int frame;
+  unsigned int size;
+  uint64_t offset;
+} PTCacheFrameEntry;
+
+typedef struct PTCacheFrameIndex {
+  /* Frames stored in the file, sorted by frame. */
+  PTCacheFrameEntry *frames;
+  int totframe, frames_len;
+  /* Offset of the index in the file, new frames are written there. */
+  uint64_t index_offset;
+  /* Generation of the file when the index was read or written. */
+  uint32_t generation;
+  /* Mapping of the file at this generation, opened by the first frame read. Released before
+   * the file is modified, also because mapped files can't be replaced on Windows. */
+  BLI_mmap_file *mmap_file;
+  char filepath[MAX_PTCACHE_FILE];
+} PTCacheFrameIndex;
+
+/* Generation of each single file cache by file path, incremented whenever the file is modified.
+ * Copies of a point cache (evaluated objects, undo) share the same file, their index is read
+ * again once another copy wrote to it. */
+static GHash *ptcache_single_file_generations = NULL;
+static ThreadMutex ptcache_single_file_generations_lock = BLI_MUTEX_INITIALIZER;
+
+/* Dead space in the file from replaced and cleared frames above which the file is compacted, as
+ * long as it's also larger than the space used by the frames. */
+#define PTCACHE_SINGLE_FILE_COMPACT_MIN (16 * 1024 * 1024)
+
+static uint32_t ptcache_single_file_generation(const char *filepath, bool modified)
+{
+  void **key_p, **val_p;
+  uint32_t generation;
+
+  BLI_mutex_lock(&ptcache_single_file_generations_lock);
+
+  if (ptcache_single_file_generations == NULL) {
+    ptcache_single_file_generations = BLI_ghash_str_new(__func__);
+  }
+
+  if (!BLI_ghash_ensure_p_ex(ptcache_single_file_generations, filepath, &key_p, &val_p)) {
+    *key_p = BLI_strdup(filepath);
+    *val_p = POINTER_FROM_UINT(0);
+  }
+
+  generation = POINTER_AS_UINT(*val_p);
+  if (modified) {
+    *val_p = POINTER_FROM_UINT(++generation);
+  }
+
+  BLI_mutex_unlock(&ptcache_single_file_generations_lock);
+
+  return generation;
+}
+
+void BKE_ptcache_exit(void)
+{
+  if (ptcache_single_file_generations) {
+    BLI_ghash_free(ptcache_single_file_generations, MEM_freeN, NULL);
+    ptcache_single_file_generations = NULL;
+  }
+}
+
+/* Seek from the start of the file, with 64 bit offsets on all platforms. */
+static int ptcache_single_file_seek(FILE *fp, uint64_t offset)
+{
+#ifdef WIN32
+  return _fseeki64(fp, (__int64)offset, SEEK_SET);
+#else
+  return fseeko(fp, (off_t)offset, SEEK_SET);
+#endif
+}
+
+static bool ptcache_use_single_file(const PTCacheID *pid)
+{
+  return (pid->cache->flag & PTCACHE_SINGLE_FILE) && pid->file_type == PTCACHE_FILE_PTCACHE;
+}
+
+static int ptcache_single_file_path(PTCacheID *pid, char *filepath)
+{
+  int len = ptcache_filename(pid, filepath, 0, 1, 0);
+
+  if (len == 0) {
+    return 0;
+  }
+
+  if (pid->cache->index < 0) {
+    pid->cache->index = pid->stack_index = BKE_object_insert_ptcache(pid->ob);
+  }
+
+  /* Same as the frame files, without the frame number. */
+  len += BLI_snprintf(filepath + len,
+                      MAX_PTCACHE_FILE - len,
+                      "_%02u" PTCACHE_SINGLE_FILE_EXT,
+                      pid->stack_index);
+
+  return len;
+}
+
+static void ptcache_frame_index_clear(PTCacheFrameIndex *index)
+{
+  index->totframe = 0;
+  index->index_offset = sizeof(PTCacheSingleFileHeader);
+}
+
+static void ptcache_frame_index_reserve(PTCacheFrameIndex *index, int totframe)
+{
+  if (totframe > index->frames_len) {
+    index->frames_len = MAX2(totframe, index->frames_len * 2);
+    index->frames = MEM_reallocN(index->frames, sizeof(PTCacheFrameEntry) * index->frames_len);
+  }
+}
+
+/* Index of the first frame that is not before the given frame. */
+static int ptcache_frame_index_lower_bound(const PTCacheFrameIndex *index, int frame)
+{
+  int low = 0, high = index->totframe;
+
+  while (low < high) {
+    const int mid = (low + high) / 2;
+
+    if (index->frames[mid].frame < frame) {
+      low = mid + 1;
+    }
+    else {
+      high = mid;
+    }
+  }
+
+  return low;
+}
+
+static const PTCacheFrameEntry *ptcache_frame_index_find(const PTCacheFrameIndex *index,
+                                                         int frame)
+{
+  const int i = ptcache_frame_index_lower_bound(index, frame);
+
+  return (i < index->totframe && index->frames[i].frame == frame) ? &index->frames[i] : NULL;
+}
+
+static void ptcache_frame_index_insert(PTCacheFrameIndex *index,
+                                       int frame,
+                                       uint64_t offset,
+                                       unsigned int size)
+{
+  const int i = ptcache_frame_index_lower_bound(index, frame);
+  PTCacheFrameEntry *entry;
+
+  if (i < index->totframe && index->frames[i].frame == frame) {
+    /* Replace the frame, its previous data is left unused. */
+    entry = &index->frames[i];
+  }
+  else {
+    ptcache_frame_index_reserve(index, index->totframe + 1);
+    entry = &index->frames[i];
+    memmove(entry + 1, entry, sizeof(PTCacheFrameEntry) * (index->totframe - i));
+    index->totframe++;
+  }
+
+  entry->frame = frame;
+  entry->size = size;
+  entry->offset = offset;
+}
+
+static BLI_mmap_file *ptcache_frame_index_map(PTCacheFrameIndex *index)
+{
+  if (index->mmap_file == NULL) {
+    const int fd = BLI_open(index->filepath, O_BINARY | O_RDONLY, 0);
+
+    if (fd == -1) {
+      return NULL;
+    }
+
+    index->mmap_file = BLI_mmap_open(fd);
+    close(fd);
+  }
+
+  return index->mmap_file;
+}
+
+static void ptcache_frame_index_unmap(PTCacheFrameIndex *index)
+{
+  if (index->mmap_file) {
+    BLI_mmap_free(index->mmap_file);
+    index->mmap_file = NULL;
+  }
+}
+
+/* Read the index from the file, the index is empty when the file doesn't exist or is invalid. */
+static void ptcache_frame_index_read(PTCacheFrameIndex *index)
+{
+  PTCacheSingleFileHeader header;
+  PTCacheSingleFileIndexHeader index_header;
+  BLI_mmap_file *file;
+
+  ptcache_frame_index_clear(index);
+  ptcache_frame_index_unmap(index);
+
+  file = ptcache_frame_index_map(index);
+
+  if (file == NULL) {
+    return;
+  }
+
+  if (BLI_mmap_read(file, &header, 0, sizeof(header)) &&
+      STREQLEN(header.magic, "BPHYSCCH", 8) && header.version == PTCACHE_SINGLE_FILE_VERSION &&
+      BLI_mmap_read(file, &index_header, header.index_offset, sizeof(index_header)) &&
+      STREQLEN(index_header.magic, "BPHYSIDX", 8) &&
+      (uint64_t)index_header.totframe * sizeof(PTCacheFrameEntry) <=
+          BLI_mmap_get_length(file)) {
+    ptcache_frame_index_reserve(index, index_header.totframe);
+
+    if (BLI_mmap_read(file,
+                      index->frames,
+                      header.index_offset + sizeof(index_header),
+                      sizeof(PTCacheFrameEntry) * index_header.totframe)) {
+      index->totframe = index_header.totframe;
+      index->index_offset = header.index_offset;
+    }
+  }
+}
+
+/* Get the frame index of the cache, reading it again when the file was modified. */
+static PTCacheFrameIndex *ptcache_frame_index_ensure(PTCacheID *pid)
+{
+  PointCache *cache = pid->cache;
+  PTCacheFrameIndex *index = cache->frame_index;
+  char filepath[MAX_PTCACHE_FILE];
+  uint32_t generation;
+
+  if (ptcache_single_file_path(pid, filepath) == 0) {
+    return NULL;
+  }
+
+  generation = ptcache_single_file_generation(filepath, false);
+
+  if (index == NULL) {
+    index = cache->frame_index = MEM_callocN(sizeof(PTCacheFrameIndex), "PTCacheFrameIndex");
+  }
+  else if (index->generation == generation && STREQ(index->filepath, filepath)) {
+    return index;
+  }
+
+  BLI_strncpy(index->filepath, filepath, sizeof(index->filepath));
+  index->generation = generation;
+  ptcache_frame_index_read(index);
+
+  return index;
+}
+
+static void ptcache_frame_index_free(PTCacheFrameIndex *index)
+{
+  ptcache_frame_index_unmap(index);
+  MEM_SAFE_FREE(index->frames);
+  MEM_freeN(index);
+}
+
+/* Write the index at its offset and point the header to it. */
+static int ptcache_single_file_write_index(FILE *fp, const PTCacheFrameIndex *index)
+{
+  PTCacheSingleFileHeader header = {{0}};
+  PTCacheSingleFileIndexHeader index_header = {{0}};
+  const size_t totframe = (size_t)index->totframe;
+
+  memcpy(index_header.magic, "BPHYSIDX", 8);
+  index_header.totframe = index->totframe;
+
+  if (ptcache_single_file_seek(fp, index->index_offset) != 0 ||
+      fwrite(&index_header, sizeof(index_header), 1, fp) != 1 ||
+      fwrite(index->frames, sizeof(PTCacheFrameEntry), totframe, fp) != totframe) {
+    return 0;
+  }
+
+  /* The frames and index are to be written before the header points to them. */
+  if (fflush(fp) != 0) {
+    return 0;
+  }
+
+  memcpy(header.magic, "BPHYSCCH", 8);
+  header.version = PTCACHE_SINGLE_FILE_VERSION;
+  header.index_offset = index->index_offset;
+
+  return (ptcache_single_file_seek(fp, 0) == 0 && fwrite(&header, sizeof(header), 1, fp) == 1);
+}
+
+/* Rewrite the file without the space of replaced and cleared frames. The file is left unchanged
+ * on failure. */
+static int ptcache_single_file_compact(PTCacheFrameIndex *index)
+{
+  char filepath_tmp[MAX_PTCACHE_FILE + 1];
+  PTCacheFrameEntry *frames;
+  BLI_mmap_file *file;
+  FILE *fp;
+  const unsigned char *data;
+  uint64_t offset = sizeof(PTCacheSingleFileHeader);
+  int i, error = 0;
+
+  file = ptcache_frame_index_map(index);
+
+  if (file == NULL) {
+    return 0;
+  }
+
+  BLI_snprintf(filepath_tmp, sizeof(filepath_tmp), "%s@", index->filepath);
+  fp = BLI_fopen(filepath_tmp, "wb");
+
+  if (fp == NULL) {
+    ptcache_frame_index_unmap(index);
+    return 0;
+  }
+
+  data = BLI_mmap_get_pointer(file);
+  frames = MEM_dupallocN(index->frames);
+
+  if (ptcache_single_file_seek(fp, offset) != 0) {
+    error = 1;
+  }
+
+  for (i = 0; i < index->totframe && !error; i++) {
+    PTCacheFrameEntry *entry = &index->frames[i];
+
+    if (entry->offset + entry->size > BLI_mmap_get_length(file) ||
+        fwrite(data + entry->offset, 1, entry->size, fp) != entry->size) {
+      error = 1;
+      break;
+    }
+
+    entry->offset = offset;
+    offset += entry->size;
+  }
+
+  if (!error) {
+    const uint64_t index_offset = index->index_offset;
+
+    index->index_offset = offset;
+    if (!ptcache_single_file_write_index(fp, index)) {
+      index->index_offset = index_offset;
+      error = 1;
+    }
+  }
+
+  fclose(fp);
+  /* The mapping is to be closed before the file can be replaced on Windows. */
+  ptcache_frame_index_unmap(index);
+
+  if (!error && BLI_rename(filepath_tmp, index->filepath) != 0) {
+    error = 1;
+  }
+
+  if (error) {
+    /* Restore the offsets in the original file. */
+    memcpy(index->frames, frames, sizeof(PTCacheFrameEntry) * index->totframe);
+    BLI_delete(filepath_tmp, false, false);
+  }
+
+  MEM_freeN(frames);
+
+  return error == 0;
+}
+
+static void ptcache_single_file_modified(PTCacheFrameIndex *index, int error)
+{
+  if (!error) {
+    uint64_t used = 0;
+    int i;
+
+    for (i = 0; i < index->totframe; i++) {
+      used += index->frames[i].size;
+    }
+
+    const uint64_t unused = index->index_offset - sizeof(PTCacheSingleFileHeader) - used;
+
+    /* Replacing frames appends them to the file, only compact it when most of the file is
+     * unused, so the cost of compacting is proportional to the size of the written frames. */
+    if (unused > PTCACHE_SINGLE_FILE_COMPACT_MIN && unused > used) {
+      ptcache_single_file_compact(index);
+    }
+  }
+
+  index->generation = ptcache_single_file_generation(index->filepath, true);
+
+  if (error) {
+    /* Read the index from the file again. */
+    index->filepath[0] = '\0';
+  }
+}
+
+/* Append frames written to memory files to the cache file, replacing frames which exist
+ * already. */
+static int ptcache_single_file_write_frames(PTCacheID *pid, PTCacheFile **pfs, int totfile)
+{
+  PTCacheFrameIndex *index = ptcache_frame_index_ensure(pid);
+  FILE *fp = NULL;
+  uint64_t offset;
+  int i, error = 0;
+
+  if (index == NULL) {
+    return 0;
+  }
+
+  ptcache_frame_index_unmap(index);
+
+  if (index->totframe) {
+    fp = BLI_fopen(index->filepath, "rb+");
+  }
+
+  if (fp == NULL) {
+    /* Start a new file, also overwriting an invalid one. */
+    BLI_make_existing_file(index->filepath);
+    fp = BLI_fopen(index->filepath, "wb");
+    ptcache_frame_index_clear(index);
+
+    if (fp == NULL) {
+      return 0;
+    }
+  }
+
+  offset = index->index_offset;
+
+  if (ptcache_single_file_seek(fp, offset) != 0) {
+    error = 1;
+  }
+
+  for (i = 0; i < totfile && !error; i++) {
+    PTCacheFile *pf = pfs[i];
+
+    if (fwrite(pf->mem, 1, pf->mem_len, fp) != pf->mem_len) {
+      error = 1;
+      break;
+    }
+
+    ptcache_frame_index_insert(index, pf->frame, offset, (unsigned int)pf->mem_len);
+    offset += pf->mem_len;
+  }
+
+  index->index_offset = offset;
+
+  if (!error && !ptcache_single_file_write_index(fp, index)) {
+    error = 1;
+  }
+
+  fclose(fp);
+
+  ptcache_single_file_modified(index, error);
+
+  return error == 0;
+}
+
+static void ptcache_single_file_clear(PTCacheID *pid, int mode, int cfra)
+{
+  PointCache *cache = pid->cache;
+  PTCacheFrameIndex *index = ptcache_frame_index_ensure(pid);
+  uint64_t end_offset = sizeof(PTCacheSingleFileHeader);
+  int sta = cache->startframe, end = cache->endframe;
+  int i, totframe = 0, error = 0;
+
+  if (cache->cached_frames) {
+    if (mode == PTCACHE_CLEAR_ALL) {
+      memset(cache->cached_frames, 0, MEM_allocN_len(cache->cached_frames));
+    }
+    else if (mode == PTCACHE_CLEAR_FRAME && cfra >= sta && cfra <= end) {
+      cache->cached_frames[cfra - sta] = 0;
+    }
+  }
+
+  if (index == NULL) {
+    return;
+  }
+
+  for (i = 0; i < index->totframe; i++) {
+    const PTCacheFrameEntry *entry = &index->frames[i];
+    const int frame = entry->frame;
+
+    if ((mode == PTCACHE_CLEAR_ALL) || (mode == PTCACHE_CLEAR_FRAME && frame == cfra) ||
+        (mode == PTCACHE_CLEAR_BEFORE && frame < cfra) ||
+        (mode == PTCACHE_CLEAR_AFTER && frame > cfra)) {
+      if (cache->cached_frames && frame >= sta && frame <= end) {
+        cache->cached_frames[frame - sta] = 0;
+      }
+      continue;
+    }
+
+    end_offset = MAX2(end_offset, entry->offset + entry->size);
+    index->frames[totframe++] = *entry;
+  }
+
+  if (totframe == index->totframe) {
+    return;
+  }
+
+  index->totframe = totframe;
+  ptcache_frame_index_unmap(index);
+
+  if (totframe == 0) {
+    ptcache_frame_index_clear(index);
+    BLI_delete(index->filepath, false, false);
+  }
+  else {
+    FILE *fp = BLI_fopen(index->filepath, "rb+");
+
+    /* Space of the cleared frames at the end of the file is reused. */
+    index->index_offset = end_offset;
+
+    if (fp == NULL || !ptcache_single_file_write_index(fp, index)) {
+      error = 1;
+    }
+    if (fp) {
+      fclose(fp);
+    }
+  }
+
+  ptcache_single_file_modified(index, error);
+}
+
+static PTCacheFile *ptcache_file_new(int cfra)
+{
+  PTCacheFile *pf = MEM_callocN(sizeof(PTCacheFile), "PTCacheFile");
+  pf->frame = cfra;
+
+  return pf;
+}
+
+static PTCacheFile *ptcache_single_file_open(PTCacheID *pid, int mode, int cfra)
+{
+  const PTCacheFrameEntry *entry;
+  PTCacheFrameIndex *index;
+  PTCacheFile *pf;
+  BLI_mmap_file *file;
+
+  if (mode == PTCACHE_FILE_WRITE) {
+    /* Added to the file when closed. */
+    pf = ptcache_file_new(cfra);
+    pf->pid = pid;
+    return pf;
+  }
+
+  if (mode != PTCACHE_FILE_READ) {
+    return NULL;
+  }
+
+  index = ptcache_frame_index_ensure(pid);
+  entry = index ? ptcache_frame_index_find(index, cfra) : NULL;
+
+  if (entry == NULL) {
+    return NULL;
+  }
+
+  /* The mapping is shared by the frames read until the file is modified. */
+  file = ptcache_frame_index_map(index);
+
+  if (file == NULL || entry->offset + entry->size > BLI_mmap_get_length(file)) {
+    return NULL;
+  }
+
+  pf = ptcache_file_new(cfra);
+  pf->mmap_file = file;
+  /* Only read from, the memory isn't owned by the file. */
+  pf->mem = (unsigned char *)BLI_mmap_get_pointer(file) + entry->offset;
+  pf->mem_len = entry->size;
+
+  return pf;
+}
+
 /* youll need to close yourself after! */
 static PTCacheFile *ptcache_file_open(PTCacheID *pid, int mode, int cfra)
 {
@@ -2171,6 +2781,10 @@ static PTCacheFile *ptcache_file_open(PTCacheID *pid, int mode, int cfra)
     return NULL; /* save blend file before using disk pointcache */
   }
 
+  if (ptcache_use_single_file(pid)) {
+    return ptcache_single_file_open(pid, mode, cfra);
+  }
+
   ptcache_filename(pid, filename, cfra, 1, 1);
 
   if (mode == PTCACHE_FILE_READ) {
@@ -2191,19 +2805,32 @@ static PTCacheFile *ptcache_file_open(PTCacheID *pid, int mode, int cfra)
     return NULL;
   }
 
-  pf = MEM_mallocN(sizeof(PTCacheFile), "PTCacheFile");
+  pf = ptcache_file_new(cfra);
   pf->fp = fp;
-  pf->old_format = 0;
-  pf->frame = cfra;
 
   return pf;
 }
-static void ptcache_file_close(PTCacheFile *pf)
+static int ptcache_file_close(PTCacheFile *pf)
 {
+  int error = 0;
+
   if (pf) {
-    fclose(pf->fp);
+    if (pf->fp) {
+      fclose(pf->fp);
+    }
+    else if (pf->pid) {
+      error = !ptcache_single_file_write_frames(pf->pid, &pf, 1);
+    }
+
+    /* The mapping belongs to the frame index of the cache. */
+    if (pf->mmap_file == NULL && pf->mem) {
+      MEM_freeN(pf->mem);
+    }
+
     MEM_freeN(pf);
   }
+
+  return error == 0;
 }
 
 static int ptcache_file_compressed_read(PTCacheFile *pf, unsigned char *result, unsigned int len)
@@ -2328,12 +2955,58 @@ static int ptcache_file_compressed_write(
 }
 static int ptcache_file_read(PTCacheFile *pf, void *f, unsigned int tot, unsigned int size)
 {
+  if (pf->fp == NULL) {
+    const size_t len = (size_t)tot * size;
+
+    if (len > pf->mem_len - pf->mem_pos) {
+      return 0;
+    }
+
+    memcpy(f, pf->mem + pf->mem_pos, len);
+    pf->mem_pos += len;
+
+    /* IO errors while accessing the mapping are only detected afterwards. */
+    return (pf->mmap_file == NULL || !BLI_mmap_has_error(pf->mmap_file));
+  }
+
   return (fread(f, size, tot, pf->fp) == tot);
 }
 static int ptcache_file_write(PTCacheFile *pf, const void *f, unsigned int tot, unsigned int size)
 {
+  if (pf->fp == NULL) {
+    const size_t len = (size_t)tot * size;
+
+    if (pf->mem_pos + len > pf->mem_alloc) {
+      pf->mem_alloc = MAX2(pf->mem_pos + len, pf->mem_alloc * 2);
+      pf->mem = MEM_reallocN(pf->mem, pf->mem_alloc);
+    }
+
+    memcpy(pf->mem + pf->mem_pos, f, len);
+    pf->mem_pos += len;
+    pf->mem_len = MAX2(pf->mem_len, pf->mem_pos);
+
+    return 1;
+  }
+
   return (fwrite(f, size, tot, pf->fp) == tot);
 }
+/* Only SEEK_SET and SEEK_CUR are supported. */
+static int ptcache_file_seek(PTCacheFile *pf, long offset, int origin)
+{
+  if (pf->fp == NULL) {
+    const size_t base = (origin == SEEK_CUR) ? pf->mem_pos : 0;
+
+    if ((offset < 0 && (size_t)-offset > base) ||
+        (offset > 0 && (size_t)offset > pf->mem_len - base)) {
+      return -1;
+    }
+
+    pf->mem_pos = base + offset;
+    return 0;
+  }
+
+  return fseek(pf->fp, offset, origin);
+}
 static int ptcache_file_data_read(PTCacheFile *pf)
 {
   int i;
@@ -2368,7 +3041,7 @@ static int ptcache_file_header_begin_read(PTCacheFile *pf)
 
   pf->data_types = 0;
 
-  if (fread(bphysics, sizeof(char), 8, pf->fp) != 8) {
+  if (!ptcache_file_read(pf, bphysics, 8, sizeof(char))) {
     error = 1;
   }
 
@@ -2376,7 +3049,7 @@ static int ptcache_file_header_begin_read(PTCacheFile *pf)
     error = 1;
   }
 
-  if (!error && !fread(&typeflag, sizeof(unsigned int), 1, pf->fp)) {
+  if (!error && !ptcache_file_read(pf, &typeflag, 1, sizeof(unsigned int))) {
     error = 1;
   }
 
@@ -2385,7 +3058,7 @@ static int ptcache_file_header_begin_read(PTCacheFile *pf)
 
   /* if there was an error set file as it was */
   if (error) {
-    fseek(pf->fp, 0, SEEK_SET);
+    ptcache_file_seek(pf, 0, SEEK_SET);
   }
 
   return !error;
@@ -2395,11 +3068,11 @@ static int ptcache_file_header_begin_write(PTCacheFile *pf)
   const char *bphysics = "BPHYSICS";
   unsigned int typeflag = pf->type + pf->flag;
 
-  if (fwrite(bphysics, sizeof(char), 8, pf->fp) != 8) {
+  if (!ptcache_file_write(pf, bphysics, 8, sizeof(char))) {
     return 0;
   }
 
-  if (!fwrite(&typeflag, sizeof(unsigned int), 1, pf->fp)) {
+  if (!ptcache_file_write(pf, &typeflag, 1, sizeof(unsigned int))) {
     return 0;
   }
 
@@ -2717,22 +3390,65 @@ static PTCacheMem *ptcache_disk_frame_to_mem(PTCacheID *pid, int cfra)
 
   return pm;
 }
-static int ptcache_mem_frame_to_disk(PTCacheID *pid, PTCacheMem *pm)
+typedef struct PTCacheCompressData {
+  PTCacheMem *pm;
+  int mode;
+  /* Memory files with the data of each type, as it's written to the cache file. */
+  PTCacheFile *compressed[BPHYS_TOT_DATA];
+} PTCacheCompressData;
+
+static void ptcache_compress_data_cb(void *__restrict userdata,
+                                     const int i,
+                                     const TaskParallelTLS *__restrict UNUSED(tls))
 {
-  PTCacheFile *pf = NULL;
-  unsigned int i, error = 0;
+  PTCacheCompressData *data = (PTCacheCompressData *)userdata;
+  PTCacheMem *pm = data->pm;
 
-  BKE_ptcache_id_clear(pid, PTCACHE_CLEAR_FRAME, pm->frame);
+  if (pm->data[i]) {
+    unsigned int in_len = pm->totpoint * ptcache_data_size[i];
+    unsigned char *out = (unsigned char *)MEM_callocN(LZO_OUT_LEN(in_len) * 4,
+                                                      "pointcache_lzo_buffer");
+    data->compressed[i] = ptcache_file_new(pm->frame);
+    ptcache_file_compressed_write(
+        data->compressed[i], (unsigned char *)(pm->data[i]), in_len, out, data->mode);
+    MEM_freeN(out);
+  }
+}
 
-  pf = ptcache_file_open(pid, PTCACHE_FILE_WRITE, pm->frame);
+/* Data types are compressed in parallel, LZMA compression in particular is slow. */
+static int ptcache_mem_frame_compressed_write(PTCacheFile *pf, PTCacheMem *pm, int mode)
+{
+  PTCacheCompressData data = {NULL};
+  int i, error = 0;
 
-  if (pf == NULL) {
-    if (G.debug & G_DEBUG) {
-      printf("Error opening disk cache file for writing\n");
+  data.pm = pm;
+  data.mode = mode;
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (pm->totpoint > 10000);
+  settings.min_iter_per_thread = 1;
+  BLI_task_parallel_range(0, BPHYS_TOT_DATA, &data, ptcache_compress_data_cb, &settings);
+
+  for (i = 0; i < BPHYS_TOT_DATA; i++) {
+    PTCacheFile *compressed = data.compressed[i];
+
+    if (compressed) {
+      if (!error && !ptcache_file_write(pf, compressed->mem, compressed->mem_len, 1)) {
+        error = 1;
+      }
+      ptcache_file_close(compressed);
     }
-    return 0;
   }
 
+  return error == 0;
+}
+
+/* Write a frame of the memory cache to a file in the disk cache format. */
+static int ptcache_mem_frame_write(PTCacheID *pid, PTCacheMem *pm, PTCacheFile *pf)
+{
+  unsigned int i, error = 0;
+
   pf->data_types = pm->data_types;
   pf->totpoint = pm->totpoint;
   pf->type = pid->type;
@@ -2752,15 +3468,8 @@ static int ptcache_mem_frame_to_disk(PTCacheID *pid, PTCacheMem *pm)
 
   if (!error) {
     if (pid->cache->compression) {
-      for (i = 0; i < BPHYS_TOT_DATA; i++) {
-        if (pm->data[i]) {
-          unsigned int in_len = pm->totpoint * ptcache_data_size[i];
-          unsigned char *out = (unsigned char *)MEM_callocN(LZO_OUT_LEN(in_len) * 4,
-                                                            "pointcache_lzo_buffer");
-          ptcache_file_compressed_write(
-              pf, (unsigned char *)(pm->data[i]), in_len, out, pid->cache->compression);
-          MEM_freeN(out);
-        }
+      if (!ptcache_mem_frame_compressed_write(pf, pm, pid->cache->compression)) {
+        error = 1;
       }
     }
     else {
@@ -2803,7 +3512,34 @@ static int ptcache_mem_frame_to_disk(PTCacheID *pid, PTCacheMem *pm)
     }
   }
 
-  ptcache_file_close(pf);
+  return error == 0;
+}
+static int ptcache_mem_frame_to_disk(PTCacheID *pid, PTCacheMem *pm)
+{
+  PTCacheFile *pf = NULL;
+  int error = 0;
+
+  /* Frames of the single file cache are replaced when written. */
+  if (!ptcache_use_single_file(pid)) {
+    BKE_ptcache_id_clear(pid, PTCACHE_CLEAR_FRAME, pm->frame);
+  }
+
+  pf = ptcache_file_open(pid, PTCACHE_FILE_WRITE, pm->frame);
+
+  if (pf == NULL) {
+    if (G.debug & G_DEBUG) {
+      printf("Error opening disk cache file for writing\n");
+    }
+    return 0;
+  }
+
+  if (!ptcache_mem_frame_write(pid, pm, pf)) {
+    error = 1;
+  }
+
+  if (!ptcache_file_close(pf)) {
+    error = 1;
+  }
 
   if (error && G.debug & G_DEBUG) {
     printf("Error writing to disk cache\n");
@@ -3116,7 +3852,10 @@ static int ptcache_write_stream(PTCacheID *pid, int cfra, int totpoint)
   PTCacheFile *pf = NULL;
   int error = 0;
 
-  BKE_ptcache_id_clear(pid, PTCACHE_CLEAR_FRAME, cfra);
+  /* Frames of the single file cache are replaced when written. */
+  if (!ptcache_use_single_file(pid)) {
+    BKE_ptcache_id_clear(pid, PTCACHE_CLEAR_FRAME, cfra);
+  }
 
   pf = ptcache_file_open(pid, PTCACHE_FILE_WRITE, cfra);
 
@@ -3140,7 +3879,9 @@ static int ptcache_write_stream(PTCacheID *pid, int cfra, int totpoint)
     pid->write_stream(pf, pid->calldata);
   }
 
-  ptcache_file_close(pf);
+  if (!ptcache_file_close(pf)) {
+    error = 1;
+  }
 
   if (error && G.debug & G_DEBUG) {
     printf("Error writing to disk cache\n");
@@ -3379,6 +4120,15 @@ void BKE_ptcache_id_clear(PTCacheID *pid, int mode, unsigned int cfra)
 
   /*if (!G.relbase_valid) return; */ /* save blend file before using pointcache */
 
+  if ((pid->cache->flag & PTCACHE_DISK_CACHE) && ptcache_use_single_file(pid)) {
+    if (mode == PTCACHE_CLEAR_ALL) {
+      pid->cache->last_exact = MIN2(pid->cache->startframe, 0);
+    }
+    ptcache_single_file_clear(pid, mode, cfra);
+    pid->cache->flag |= PTCACHE_FLAG_INFO_DIRTY;
+    return;
+  }
+
   const char *fext = ptcache_file_extension(pid);
 
   /* clear all files in the temp dir with the prefix of the ID and the ".bphys" suffix */
@@ -3520,6 +4270,12 @@ int BKE_ptcache_id_exist(PTCacheID *pid, int cfra)
   if (pid->cache->flag & PTCACHE_DISK_CACHE) {
     char filename[MAX_PTCACHE_FILE];
 
+    if (ptcache_use_single_file(pid)) {
+      PTCacheFrameIndex *index = ptcache_frame_index_ensure(pid);
+
+      return (index && ptcache_frame_index_find(index, cfra));
+    }
+
     ptcache_filename(pid, filename, cfra, 1, 1);
 
     return BLI_exists(filename);
@@ -3587,7 +4343,19 @@ void BKE_ptcache_id_time(
     cache->cached_frames = MEM_callocN(sizeof(char) * cache->cached_frames_len,
                                        "cached frames array");
 
-    if (pid->cache->flag & PTCACHE_DISK_CACHE) {
+    if ((pid->cache->flag & PTCACHE_DISK_CACHE) && ptcache_use_single_file(pid)) {
+      PTCacheFrameIndex *index = ptcache_frame_index_ensure(pid);
+      int i;
+
+      for (i = 0; index && i < index->totframe; i++) {
+        const int frame = index->frames[i].frame;
+
+        if (frame >= sta && frame <= end) {
+          cache->cached_frames[frame - sta] = 1;
+        }
+      }
+    }
+    else if (pid->cache->flag & PTCACHE_DISK_CACHE) {
       /* mode is same as fopen's modes */
       DIR *dir;
       struct dirent *de;
@@ -3858,6 +4626,9 @@ void BKE_ptcache_free(PointCache *cache)
   if (cache->cached_frames) {
     MEM_freeN(cache->cached_frames);
   }
+  if (cache->frame_index) {
+    ptcache_frame_index_free(cache->frame_index);
+  }
   MEM_freeN(cache);
 }
 void BKE_ptcache_free_list(ListBase *ptcaches)
@@ -3882,7 +4653,8 @@ static PointCache *ptcache_copy(PointCache *cache, const bool copy_data)
     ncache->cached_frames_len = 0;
 
     /* flag is a mix of user settings and simulator/baking state */
-    ncache->flag = ncache->flag & (PTCACHE_DISK_CACHE | PTCACHE_EXTERNAL | PTCACHE_IGNORE_LIBPATH);
+    ncache->flag = ncache->flag & (PTCACHE_DISK_CACHE | PTCACHE_EXTERNAL | PTCACHE_IGNORE_LIBPATH |
+                                   PTCACHE_SINGLE_FILE);
     ncache->simframe = 0;
   }
   else {
@@ -3910,6 +4682,7 @@ static PointCache *ptcache_copy(PointCache *cache, const bool copy_data)
 
   /* hmm, should these be copied over instead? */
   ncache->edit = NULL;
+  ncache->frame_index = NULL;
 
   return ncache;
 }
@@ -4228,6 +5001,77 @@ void BKE_ptcache_disk_to_mem(PTCacheID *pid)
     }
   }
 }
+/* Number of frames written to the single file cache at once, bounds the memory used by the
+ * frames encoded in parallel. */
+#define PTCACHE_SINGLE_FILE_BATCH 64
+
+typedef struct PTCacheEncodeData {
+  PTCacheID *pid;
+  PTCacheMem **frames;
+  PTCacheFile **files;
+  bool *errors;
+} PTCacheEncodeData;
+
+static void ptcache_mem_frame_encode_cb(void *__restrict userdata,
+                                        const int i,
+                                        const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  PTCacheEncodeData *data = (PTCacheEncodeData *)userdata;
+  PTCacheMem *pm = data->frames[i];
+
+  data->files[i] = ptcache_file_new(pm->frame);
+  data->errors[i] = !ptcache_mem_frame_write(data->pid, pm, data->files[i]);
+}
+
+static int ptcache_single_file_mem_to_disk(PTCacheID *pid)
+{
+  PointCache *cache = pid->cache;
+  const int totframe = BLI_listbase_count(&cache->mem_cache);
+  PTCacheMem **frames = MEM_malloc_arrayN(totframe, sizeof(PTCacheMem *), __func__);
+  PTCacheFile *files[PTCACHE_SINGLE_FILE_BATCH];
+  bool errors[PTCACHE_SINGLE_FILE_BATCH];
+  PTCacheEncodeData data;
+  PTCacheMem *pm;
+  int i, start, error = 0;
+
+  for (pm = cache->mem_cache.first, i = 0; pm; pm = pm->next, i++) {
+    frames[i] = pm;
+  }
+
+  data.pid = pid;
+  data.files = files;
+  data.errors = errors;
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1;
+
+  for (start = 0; start < totframe && !error; start += PTCACHE_SINGLE_FILE_BATCH) {
+    const int batch_len = MIN2(PTCACHE_SINGLE_FILE_BATCH, totframe - start);
+
+    data.frames = frames + start;
+    BLI_task_parallel_range(0, batch_len, &data, ptcache_mem_frame_encode_cb, &settings);
+
+    for (i = 0; i < batch_len; i++) {
+      if (errors[i]) {
+        error = 1;
+      }
+    }
+
+    if (!error && !ptcache_single_file_write_frames(pid, files, batch_len)) {
+      error = 1;
+    }
+
+    for (i = 0; i < batch_len; i++) {
+      ptcache_file_close(files[i]);
+    }
+  }
+
+  MEM_freeN(frames);
+
+  return error == 0;
+}
+
 void BKE_ptcache_mem_to_disk(PTCacheID *pid)
 {
   PointCache *cache = pid->cache;
@@ -4243,10 +5087,17 @@ void BKE_ptcache_mem_to_disk(PTCacheID *pid)
   /* restore possible bake flag */
   cache->flag |= baked;
 
-  for (; pm; pm = pm->next) {
-    if (ptcache_mem_frame_to_disk(pid, pm) == 0) {
+  if (ptcache_use_single_file(pid)) {
+    if (pm && ptcache_single_file_mem_to_disk(pid) == 0) {
       cache->flag &= ~PTCACHE_DISK_CACHE;
-      break;
+    }
+  }
+  else {
+    for (; pm; pm = pm->next) {
+      if (ptcache_mem_frame_to_disk(pid, pm) == 0) {
+        cache->flag &= ~PTCACHE_DISK_CACHE;
+        break;
+      }
     }
   }
 
@@ -4299,6 +5150,49 @@ void BKE_ptcache_toggle_disk_cache(PTCacheID *pid)
   }
 }
 
+void BKE_ptcache_toggle_single_file(PTCacheID *pid)
+{
+  PointCache *cache = pid->cache;
+  int last_exact = cache->last_exact;
+  int baked = cache->flag & PTCACHE_BAKED;
+
+  /* Streamed caches can't be converted through the memory cache, they have to be baked again. */
+  if ((cache->flag & PTCACHE_DISK_CACHE) == 0 || pid->file_type != PTCACHE_FILE_PTCACHE ||
+      pid->read_stream || !G.relbase_valid) {
+    return;
+  }
+
+  /* Read the frames from the previous format. */
+  cache->flag ^= PTCACHE_SINGLE_FILE;
+  cache->flag &= ~PTCACHE_DISK_CACHE;
+  BKE_ptcache_disk_to_mem(pid);
+  cache->flag |= PTCACHE_DISK_CACHE;
+
+  cache->flag &= ~PTCACHE_BAKED;
+  BKE_ptcache_id_clear(pid, PTCACHE_CLEAR_ALL, 0);
+  cache->flag |= baked;
+
+  /* Write them in the new format. */
+  cache->flag ^= PTCACHE_SINGLE_FILE;
+  BKE_ptcache_mem_to_disk(pid);
+
+  if (cache->flag & PTCACHE_DISK_CACHE) {
+    BKE_ptcache_free_mem(&cache->mem_cache);
+  }
+
+  cache->last_exact = last_exact;
+
+  if (cache->cached_frames) {
+    MEM_freeN(cache->cached_frames);
+    cache->cached_frames = NULL;
+    cache->cached_frames_len = 0;
+  }
+
+  BKE_ptcache_id_time(pid, NULL, 0.0f, NULL, NULL, NULL);
+
+  cache->flag |= PTCACHE_FLAG_INFO_DIRTY;
+}
+
 void BKE_ptcache_disk_cache_rename(PTCacheID *pid, const char *name_src, const char *name_dst)
 {
   char old_name[80];
@@ -4318,6 +5212,19 @@ void BKE_ptcache_disk_cache_rename(PTCacheID *pid, const char *name_src, const c
   /* get "from" filename */
   BLI_strncpy(pid->cache->name, name_src, sizeof(pid->cache->name));
 
+  if (ptcache_use_single_file(pid)) {
+    if (ptcache_single_file_path(pid, old_path_full)) {
+      BLI_strncpy(pid->cache->name, name_dst, sizeof(pid->cache->name));
+
+      if (ptcache_single_file_path(pid, new_path_full) && BLI_exists(old_path_full)) {
+        BLI_rename(old_path_full, new_path_full);
+      }
+    }
+
+    BLI_strncpy(pid->cache->name, old_name, sizeof(pid->cache->name));
+    return;
+  }
+
   len = ptcache_filename(pid, old_filename, 0, 0, 0); /* no path */
 
   ptcache_path(pid, path);
@@ -4373,43 +5280,61 @@ void BKE_ptcache_load_external(PTCacheID *pid)
     return;
   }
 
-  ptcache_path(pid, path);
+  if (ptcache_use_single_file(pid)) {
+    PTCacheFrameIndex *index = ptcache_frame_index_ensure(pid);
+    int i;
 
-  len = ptcache_filename(pid, filename, 1, 0, 0); /* no path */
+    for (i = 0; index && i < index->totframe; i++) {
+      const int frame = index->frames[i].frame;
 
-  dir = opendir(path);
-  if (dir == NULL) {
-    return;
+      if (frame) {
+        start = MIN2(start, frame);
+        end = MAX2(end, frame);
+      }
+      else {
+        info = 1;
+      }
+    }
   }
+  else {
+    ptcache_path(pid, path);
 
-  const char *fext = ptcache_file_extension(pid);
+    len = ptcache_filename(pid, filename, 1, 0, 0); /* no path */
 
-  if (cache->index >= 0) {
-    BLI_snprintf(ext, sizeof(ext), "_%02d%s", cache->index, fext);
-  }
-  else {
-    BLI_strncpy(ext, fext, sizeof(ext));
-  }
+    dir = opendir(path);
+    if (dir == NULL) {
+      return;
+    }
 
-  while ((de = readdir(dir)) != NULL) {
-    if (strstr(de->d_name, ext)) {               /* do we have the right extension?*/
-      if (STREQLEN(filename, de->d_name, len)) { /* do we have the right prefix */
-        /* read the number of the file */
-        const int frame = ptcache_frame_from_filename(de->d_name, ext);
+    const char *fext = ptcache_file_extension(pid);
 
-        if (frame != -1) {
-          if (frame) {
-            start = MIN2(start, frame);
-            end = MAX2(end, frame);
-          }
-          else {
-            info = 1;
+    if (cache->index >= 0) {
+      BLI_snprintf(ext, sizeof(ext), "_%02d%s", cache->index, fext);
+    }
+    else {
+      BLI_strncpy(ext, fext, sizeof(ext));
+    }
+
+    while ((de = readdir(dir)) != NULL) {
+      if (strstr(de->d_name, ext)) {               /* do we have the right extension?*/
+        if (STREQLEN(filename, de->d_name, len)) { /* do we have the right prefix */
+          /* read the number of the file */
+          const int frame = ptcache_frame_from_filename(de->d_name, ext);
+
+          if (frame != -1) {
+            if (frame) {
+              start = MIN2(start, frame);
+              end = MAX2(end, frame);
+            }
+            else {
+              info = 1;
+            }
           }
         }
       }
     }
+    closedir(dir);
   }
-  closedir(dir);
 
   if (start != MAXFRAME) {
     PTCacheFile *pf;
@@ -0,0 +1,243 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/** \file
+ * \ingroup bli
+ */
+
+#include <string.h>
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_mmap.h"
+#include "BLI_threads.h"
+#include "BLI_utildefines.h"
+
+#ifdef WIN32
+#  include <io.h>
+#  include <windows.h>
+#else
+#  include <signal.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+struct BLI_mmap_file {
+  /* The address the file is mapped to. */
+  char *memory;
+  /* The length of the file (and therefore the mapped region). */
+  size_t length;
+  /* Set when an IO error happened while accessing the mapping. */
+  volatile bool io_error;
+#ifdef WIN32
+  HANDLE handle;
+#else
+  /* Open mappings, used by the SIGBUS handler. */
+  struct BLI_mmap_file *next, *prev;
+#endif
+};
+
+#ifndef WIN32
+
+/* Accessing a mapping after its file was truncated or when the underlying
+ * device fails raises SIGBUS. The handler replaces the faulty mapping with zeros
+ * and flags the error, which is reported by the next #BLI_mmap_read.
+ *
+ * The list is only modified with the lock held, the handler only reads it.
+ */
+static BLI_mmap_file *mmap_file_list = NULL;
+static ThreadMutex mmap_file_list_mutex = BLI_MUTEX_INITIALIZER;
+static bool mmap_handler_installed = false;
+static struct sigaction mmap_handler_prev;
+
+static void mmap_sigbus_handler(int sig, siginfo_t *siginfo, void *ptr)
+{
+  char *error_addr = (char *)siginfo->si_addr;
+
+  for (BLI_mmap_file *file = mmap_file_list; file; file = file->next) {
+    if (error_addr >= file->memory && error_addr < file->memory + file->length) {
+      file->io_error = true;
+      /* Replace the mapping with zeros, the access is retried when returning. */
+      if (mmap(file->memory,
+               file->length,
+               PROT_READ,
+               MAP_FIXED | MAP_PRIVATE | MAP_ANONYMOUS,
+               -1,
+               0) == MAP_FAILED) {
+        break;
+      }
+      return;
+    }
+  }
+
+  /* Not one of our mappings, forward to the previous handler. */
+  if (mmap_handler_prev.sa_flags & SA_SIGINFO) {
+    mmap_handler_prev.sa_sigaction(sig, siginfo, ptr);
+  }
+  else if (mmap_handler_prev.sa_handler != SIG_DFL && mmap_handler_prev.sa_handler != SIG_IGN) {
+    mmap_handler_prev.sa_handler(sig);
+  }
+  else {
+    signal(sig, SIG_DFL);
+    raise(sig);
+  }
+}
+
+static void mmap_file_register(BLI_mmap_file *file)
+{
+  BLI_mutex_lock(&mmap_file_list_mutex);
+
+  if (!mmap_handler_installed) {
+    struct sigaction newact, oldact;
+    memset(&newact, 0, sizeof(newact));
+    newact.sa_sigaction = mmap_sigbus_handler;
+    newact.sa_flags = SA_SIGINFO;
+    sigemptyset(&newact.sa_mask);
+    if (sigaction(SIGBUS, &newact, &oldact) == 0) {
+      mmap_handler_prev = oldact;
+      mmap_handler_installed = true;
+    }
+  }
+
+  file->prev = NULL;
+  file->next = mmap_file_list;
+  if (mmap_file_list) {
+    mmap_file_list->prev = file;
+  }
+  mmap_file_list = file;
+
+  BLI_mutex_unlock(&mmap_file_list_mutex);
+}
+
+static void mmap_file_unregister(BLI_mmap_file *file)
+{
+  BLI_mutex_lock(&mmap_file_list_mutex);
+
+  if (file->prev) {
+    file->prev->next = file->next;
+  }
+  else {
+    mmap_file_list = file->next;
+  }
+  if (file->next) {
+    file->next->prev = file->prev;
+  }
+
+  BLI_mutex_unlock(&mmap_file_list_mutex);
+}
+
+#endif /* WIN32 */
+
+BLI_mmap_file *BLI_mmap_open(int fd)
+{
+  void *memory;
+  size_t length;
+
+#ifdef WIN32
+  HANDLE file_handle = (HANDLE)_get_osfhandle(fd);
+  LARGE_INTEGER file_size;
+  if (file_handle == INVALID_HANDLE_VALUE || !GetFileSizeEx(file_handle, &file_size) ||
+      file_size.QuadPart <= 0 || (uint64_t)file_size.QuadPart > SIZE_MAX) {
+    return NULL;
+  }
+  length = (size_t)file_size.QuadPart;
+
+  HANDLE handle = CreateFileMapping(file_handle, NULL, PAGE_READONLY, 0, 0, NULL);
+  if (handle == NULL) {
+    return NULL;
+  }
+  memory = MapViewOfFile(handle, FILE_MAP_READ, 0, 0, 0);
+  if (memory == NULL) {
+    CloseHandle(handle);
+    return NULL;
+  }
+#else
+  struct stat st;
+  if (fstat(fd, &st) == -1 || !S_ISREG(st.st_mode) || st.st_size <= 0 ||
+      (uint64_t)st.st_size > SIZE_MAX) {
+    return NULL;
+  }
+  length = (size_t)st.st_size;
+
+  memory = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (memory == MAP_FAILED) {
+    return NULL;
+  }
+#endif
+
+  BLI_mmap_file *file = MEM_callocN(sizeof(BLI_mmap_file), __func__);
+  file->memory = memory;
+  file->length = length;
+#ifdef WIN32
+  file->handle = handle;
+#else
+  mmap_file_register(file);
+#endif
+
+  return file;
+}
+
+bool BLI_mmap_read(BLI_mmap_file *file, void *dest, size_t offset, size_t length)
+{
+  if (file->io_error || offset > file->length || length > file->length - offset) {
+    return false;
+  }
+
+#ifdef WIN32
+  __try {
+    memcpy(dest, file->memory + offset, length);
+  }
+  __except (GetExceptionCode() == EXCEPTION_IN_PAGE_ERROR ? EXCEPTION_EXECUTE_HANDLER :
+                                                            EXCEPTION_CONTINUE_SEARCH) {
+    file->io_error = true;
+    return false;
+  }
+#else
+  memcpy(dest, file->memory + offset, length);
+#endif
+
+  /* The SIGBUS handler replaced the mapping with zeros during the copy. */
+  return !file->io_error;
+}
+
+const void *BLI_mmap_get_pointer(BLI_mmap_file *file)
+{
+  return file->memory;
+}
+
+size_t BLI_mmap_get_length(const BLI_mmap_file *file)
+{
+  return file->length;
+}
+
+bool BLI_mmap_has_error(const BLI_mmap_file *file)
+{
+  return file->io_error;
+}
+
+void BLI_mmap_free(BLI_mmap_file *file)
+{
+#ifdef WIN32
+  UnmapViewOfFile(file->memory);
+  CloseHandle(file->handle);
+#else
+  mmap_file_unregister(file);
+  munmap(file->memory, file->length);
+#endif
+
+  MEM_freeN(file);
+}
@@ -20,7 +20,9 @@
  * A generic task system which can be used for any task based subsystem.
  */
 
+#include <stddef.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "MEM_guardedalloc.h"
 
@@ -45,18 +47,16 @@
  */
 #define MEMPOOL_SIZE 256
 
-/* Number of tasks which are pushed directly to local thread queue.
+/* Number of tasks which fit in the queue of a thread, must be a power of two.
  *
- * This allows thread to fetch next task without locking the whole queue.
+ * Tasks pushed to a full queue go to the scheduler's shared queues. More details
+ * could be found at TaskDeque.
  */
-#define LOCAL_QUEUE_SIZE 1
+#define DEQUE_SIZE 4096
+#define DEQUE_MASK (DEQUE_SIZE - 1)
 
-/* Number of tasks which are allowed to be scheduled in a delayed manner.
- *
- * This allows to use less locks per graph node children schedule. More details
- * could be found at TaskThreadLocalStorage::do_delayed_push.
- */
-#define DELAYED_QUEUE_SIZE 4096
+/* Size used to keep the indices of a deque in separate cache lines. */
+#define CACHE_LINE_SIZE 64
 
 #ifndef NDEBUG
 #  define ASSERT_THREAD_ID(scheduler, thread_id) \
@@ -138,29 +138,58 @@ typedef struct TaskThreadLocalStorage {
    */
   TaskMemPool task_mempool;
 
-  /* Local queue keeps thread alive by keeping small amount of tasks ready
-   * to be picked up without causing global thread locks for synchronization.
-   */
-  int num_local_queue;
-  Task *local_queue[LOCAL_QUEUE_SIZE];
-
   /* Thread can be marked for delayed tasks push. This is helpful when it's
    * know that lots of subsequent task pushed will happen from the same thread
    * without "interrupting" for task execution.
    *
-   * We try to accumulate as much tasks as possible in a local queue without
-   * any locks first, and then we push all of them into a scheduler's queue
-   * from within a single mutex lock.
+   * Tasks are still pushed to the thread's deque, but the sleeping threads are
+   * woken up only once when the delayed push ends.
    */
   bool do_delayed_push;
-  int num_delayed_queue;
-  Task *delayed_queue[DELAYED_QUEUE_SIZE];
 } TaskThreadLocalStorage;
 
+/* Slot of a deque, the pool is copied from the task so that a thread looking
+ * for the tasks of a given pool never reads a task it doesn't own.
+ *
+ * Whoever takes the task of a slot, by index or by scanning for a pool, swaps
+ * the task pointer with NULL. An index whose task was taken by a scan is left
+ * empty in the deque and skipped when popped or stolen.
+ */
+typedef struct TaskDequeSlot {
+  Task *volatile task;
+  TaskPool *pool;
+} TaskDequeSlot;
+
+/* Per-thread queue of tasks (Chase-Lev work-stealing deque).
+ *
+ * Only the thread owning the deque pushes and pops tasks at the bottom, so that
+ * the last pushed task, most likely still in cache, is handled first. Other
+ * threads steal the oldest tasks from the top. Indices only grow, the slot of an
+ * index is (index & DEQUE_MASK).
+ *
+ * The deque is lock-free: the owner only competes with thieves when a single task
+ * is left, and thieves compete with each other with a compare-and-swap on the
+ * top index. Atomic operations are full barriers, they are used to publish the
+ * bottom index and to order the reads of the indices.
+ *
+ * The deque has a fixed size, when it's full tasks are pushed to the scheduler's
+ * shared queues instead.
+ */
+typedef struct TaskDeque {
+  volatile size_t top;
+  char _pad1[CACHE_LINE_SIZE - sizeof(size_t)];
+  volatile size_t bottom;
+  char _pad2[CACHE_LINE_SIZE - sizeof(size_t)];
+  TaskDequeSlot slots[DEQUE_SIZE];
+} TaskDeque;
+
 struct TaskPool {
   TaskScheduler *scheduler;
 
+  /* Number of pushed tasks which are not done yet. */
   volatile size_t num;
+  /* Number of threads sleeping in work_and_wait() or cancel(). */
+  volatile unsigned int num_waiting;
   ThreadMutex num_mutex;
   ThreadCondition num_cond;
 
@@ -168,7 +197,6 @@ struct TaskPool {
   ThreadMutex user_mutex;
 
   volatile bool do_cancel;
-  volatile bool do_work;
 
   volatile bool is_suspended;
   bool start_suspended;
@@ -201,15 +229,40 @@ struct TaskPool {
 #endif
 };
 
+/* Shared queues of the scheduler, protected by the scheduler's queue mutex.
+ *
+ * They receive tasks pushed from outside of the scheduler threads, tasks which
+ * don't fit in a deque and, when the scheduler only has its background thread,
+ * all the tasks.
+ */
+enum {
+  TASK_LANE_HIGH = 0,
+  TASK_LANE_LOW,
+  /* Tasks of the background pools, the only tasks handled by the background
+   * thread. Only used when the scheduler runs with background thread only.
+   */
+  TASK_LANE_BACKGROUND,
+
+  TASK_LANE_NUM,
+};
+
+typedef struct TaskLane {
+  ListBase queue;
+  /* Number of tasks in the queue, can be read without lock to skip empty lanes. */
+  volatile size_t num;
+} TaskLane;
+
 struct TaskScheduler {
   pthread_t *threads;
   struct TaskThread *task_threads;
   int num_threads;
   bool background_thread_only;
 
-  ListBase queue;
+  TaskLane lanes[TASK_LANE_NUM];
   ThreadMutex queue_mutex;
   ThreadCondition queue_cond;
+  /* Number of worker threads waiting for tasks on the queue condition. */
+  volatile unsigned int num_sleeping;
 
   ThreadMutex startup_mutex;
   ThreadCondition startup_cond;
@@ -225,6 +278,8 @@ typedef struct TaskThread {
   TaskScheduler *scheduler;
   int id;
   TaskThreadLocalStorage tls;
+  /* Tasks pushed from this thread, the deque of thread 0 is the main thread's one. */
+  TaskDeque deque;
 } TaskThread;
 
 /* Helper */
@@ -326,17 +381,190 @@ static void task_free(TaskPool *pool, Task *task, const int thread_id)
   }
 }
 
+/* Task Deque */
+
+BLI_INLINE void task_deque_init(TaskDeque *deque)
+{
+  deque->top = 0;
+  deque->bottom = 0;
+  memset(deque->slots, 0, sizeof(deque->slots));
+}
+
+/* Take the task of a slot, return NULL if someone else took it first. */
+BLI_INLINE Task *task_deque_slot_take(TaskDequeSlot *slot)
+{
+  Task *task = slot->task;
+  if (task != NULL && atomic_cas_ptr((void **)&slot->task, task, NULL) == task) {
+    return task;
+  }
+  return NULL;
+}
+
+/* Number of tasks in the deque, only exact when called by the owner with no thief around. */
+BLI_INLINE size_t task_deque_size(const TaskDeque *deque)
+{
+  const ptrdiff_t size = (ptrdiff_t)(deque->bottom - deque->top);
+  return (size > 0) ? (size_t)size : 0;
+}
+
+/* Push a task at the bottom, must be called by the owner of the deque.
+ * Return false if the deque is full.
+ */
+static bool task_deque_push(TaskDeque *deque, Task *task)
+{
+  const size_t bottom = deque->bottom;
+  /* A thief can only increase the top, so a stale value only makes the deque look fuller. */
+  if (bottom - deque->top >= DEQUE_SIZE) {
+    return false;
+  }
+  TaskDequeSlot *slot = &deque->slots[bottom & DEQUE_MASK];
+  /* The thread which got the previous index of this slot may not have taken its task yet. */
+  if (slot->task != NULL) {
+    return false;
+  }
+  slot->pool = task->pool;
+  slot->task = task;
+  /* Publish the slot. */
+  atomic_add_and_fetch_z((size_t *)&deque->bottom, 1);
+  return true;
+}
+
+/* Pop the last pushed task, must be called by the owner of the deque.
+ * When pool is not NULL only a task of this pool is returned.
+ */
+static Task *task_deque_pop(TaskDeque *deque, TaskPool *pool)
+{
+  while (true) {
+    const size_t bottom = deque->bottom;
+    if ((ptrdiff_t)(bottom - deque->top) <= 0) {
+      return NULL;
+    }
+    /* Nobody but the owner writes the bottom slots, it's safe to peek at them.
+     * Empty slots are popped whatever the pool, to release their index.
+     */
+    TaskDequeSlot *slot = &deque->slots[(bottom - 1) & DEQUE_MASK];
+    if (pool != NULL && slot->task != NULL && slot->pool != pool) {
+      return NULL;
+    }
+
+    /* Reserve the slot before reading the top, thieves see the new bottom. */
+    const size_t new_bottom = atomic_sub_and_fetch_z((size_t *)&deque->bottom, 1);
+    const size_t top = deque->top;
+    const ptrdiff_t size = (ptrdiff_t)(new_bottom - top);
+
+    if (size < 0) {
+      /* Thieves emptied the deque meanwhile. */
+      atomic_add_and_fetch_z((size_t *)&deque->bottom, 1);
+      return NULL;
+    }
+    if (size == 0) {
+      /* Last task, compete with the thieves for it. The top is incremented in both
+       * cases so the deque is empty with bottom == top.
+       */
+      const bool success = (atomic_cas_z((size_t *)&deque->top, top, top + 1) == top);
+      atomic_add_and_fetch_z((size_t *)&deque->bottom, 1);
+      if (!success) {
+        return NULL;
+      }
+    }
+    /* Otherwise other tasks are left, no thief can reach this one. It can still
+     * have been taken by a thread scanning for the tasks of its pool.
+     */
+    Task *task = task_deque_slot_take(slot);
+    if (task) {
+      return task;
+    }
+  }
+}
+
+/* Steal the oldest task, can be called from any thread. */
+static Task *task_deque_steal(TaskDeque *deque)
+{
+  while (true) {
+    const size_t top = deque->top;
+    /* Cheap check first, to avoid writing to the owner's cache line when empty. */
+    if ((ptrdiff_t)(deque->bottom - top) <= 0) {
+      return NULL;
+    }
+    /* The bottom must be read after the top, there is no plain fence in the atomic
+     * operations so use a no-op one.
+     */
+    const size_t bottom = atomic_fetch_and_add_z((size_t *)&deque->bottom, 0);
+    if ((ptrdiff_t)(bottom - top) <= 0) {
+      return NULL;
+    }
+    if (atomic_cas_z((size_t *)&deque->top, top, top + 1) != top) {
+      /* Lost the race against another thief or the owner. */
+      return NULL;
+    }
+    /* The slot can't be reused before its task is taken, the owner doesn't push
+     * to a slot which isn't empty. Skip the index if a scan took the task.
+     */
+    Task *task = task_deque_slot_take(&deque->slots[top & DEQUE_MASK]);
+    if (task) {
+      return task;
+    }
+  }
+}
+
+/* Take a task of the pool anywhere in the deque, can be called from any thread.
+ *
+ * The tasks of a pool can be buried under the tasks of other pools, which a
+ * thread waiting for the pool doesn't run. The returned task may belong to another
+ * pool when its slot was reused during the scan, the caller has to check.
+ */
+static Task *task_deque_scan(TaskDeque *deque, TaskPool *pool)
+{
+  const size_t top = deque->top;
+  if ((ptrdiff_t)(deque->bottom - top) <= 0) {
+    return NULL;
+  }
+  /* Order the reads of the indices and the slots, see task_deque_steal(). */
+  const size_t bottom = atomic_fetch_and_add_z((size_t *)&deque->bottom, 0);
+  for (size_t index = bottom; (ptrdiff_t)(index - top) > 0; index--) {
+    TaskDequeSlot *slot = &deque->slots[(index - 1) & DEQUE_MASK];
+    if (slot->pool == pool) {
+      Task *task = task_deque_slot_take(slot);
+      if (task) {
+        return task;
+      }
+    }
+  }
+  return NULL;
+}
+
 /* Task Scheduler */
 
+/* ID of the calling thread, -1 for threads which are not managed by the scheduler. */
+static int task_scheduler_thread_id(TaskScheduler *scheduler)
+{
+  if (BLI_thread_is_main()) {
+    return 0;
+  }
+  TaskThread *thread = pthread_getspecific(scheduler->tls_id_key);
+  return (thread != NULL) ? thread->id : -1;
+}
+
 static void task_pool_num_decrease(TaskPool *pool, size_t done)
 {
+  /* The pool can be freed as soon as a waiting thread sees no task left, so the
+   * last decrement is done with the lock held. The waiting thread checks the
+   * number of tasks with the same lock before leaving.
+   */
+  size_t num = pool->num;
+  while (num > done) {
+    const size_t prev_num = atomic_cas_z((size_t *)&pool->num, num, num - done);
+    if (prev_num == num) {
+      return;
+    }
+    num = prev_num;
+  }
+
   BLI_mutex_lock(&pool->num_mutex);
 
   BLI_assert(pool->num >= done);
 
-  pool->num -= done;
-
-  if (pool->num == 0) {
+  if (atomic_sub_and_fetch_z((size_t *)&pool->num, done) == 0) {
     BLI_condition_notify_all(&pool->num_cond);
   }
 
@@ -345,82 +573,236 @@ static void task_pool_num_decrease(TaskPool *pool, size_t done)
 
 static void task_pool_num_increase(TaskPool *pool, size_t new)
 {
-  BLI_mutex_lock(&pool->num_mutex);
+  atomic_add_and_fetch_z((size_t *)&pool->num, new);
+}
 
-  pool->num += new;
-  BLI_condition_notify_all(&pool->num_cond);
+/* Wake up the threads waiting for the pool, must be called after the tasks are
+ * visible to other threads.
+ */
+static void task_pool_notify_push(TaskPool *pool)
+{
+  if (pool->num_waiting != 0) {
+    BLI_mutex_lock(&pool->num_mutex);
+    BLI_condition_notify_all(&pool->num_cond);
+    BLI_mutex_unlock(&pool->num_mutex);
+  }
+}
 
-  BLI_mutex_unlock(&pool->num_mutex);
+/* Wake up sleeping worker threads, must be called after the tasks are visible
+ * to other threads.
+ */
+static void task_scheduler_notify_push(TaskScheduler *scheduler, const bool notify_all)
+{
+  if (scheduler->num_sleeping != 0) {
+    BLI_mutex_lock(&scheduler->queue_mutex);
+    if (notify_all) {
+      BLI_condition_notify_all(&scheduler->queue_cond);
+    }
+    else {
+      BLI_condition_notify_one(&scheduler->queue_cond);
+    }
+    BLI_mutex_unlock(&scheduler->queue_mutex);
+  }
 }
 
-static bool task_scheduler_thread_wait_pop(TaskScheduler *scheduler, Task **task)
+BLI_INLINE int task_scheduler_lane_index(TaskPool *pool, TaskPriority priority)
 {
-  bool found_task = false;
-  BLI_mutex_lock(&scheduler->queue_mutex);
+  if (pool->scheduler->background_thread_only && pool->run_in_background) {
+    return TASK_LANE_BACKGROUND;
+  }
+  return (priority == TASK_PRIORITY_HIGH) ? TASK_LANE_HIGH : TASK_LANE_LOW;
+}
 
-  while (!scheduler->queue.first && !scheduler->do_exit) {
-    BLI_condition_wait(&scheduler->queue_cond, &scheduler->queue_mutex);
+/* Pop a task from the shared queues.
+ * When pool is not NULL only a task of this pool is returned, otherwise the
+ * background thread only looks at the tasks of the background pools.
+ */
+static Task *task_scheduler_lanes_pop(TaskScheduler *scheduler, TaskPool *pool)
+{
+  const int first_lane = (pool == NULL && scheduler->background_thread_only) ?
+                             TASK_LANE_BACKGROUND :
+                             TASK_LANE_HIGH;
+  bool has_tasks = false;
+  for (int i = first_lane; i < TASK_LANE_NUM; i++) {
+    if (scheduler->lanes[i].num != 0) {
+      has_tasks = true;
+      break;
+    }
+  }
+  if (!has_tasks) {
+    return NULL;
   }
 
-  do {
-    Task *current_task;
+  Task *found_task = NULL;
 
-    /* Assuming we can only have a void queue in 'exit' case here seems logical
-     * (we should only be here after our worker thread has been woken up from a
-     * condition_wait(), which only happens after a new task was added to the queue),
-     * but it is wrong.
-     * Waiting on condition may wake up the thread even if condition is not signaled
-     * (spurious wake-ups), and some race condition may also empty the queue **after**
-     * condition has been signaled, but **before** awoken thread reaches this point...
-     * See http://stackoverflow.com/questions/8594591
-     *
-     * So we only abort here if do_exit is set.
+  BLI_mutex_lock(&scheduler->queue_mutex);
+
+  for (int i = first_lane; i < TASK_LANE_NUM && !found_task; i++) {
+    TaskLane *lane = &scheduler->lanes[i];
+    /* Find task from this pool. if we get a task from another pool,
+     * we can get into deadlock.
      */
-    if (scheduler->do_exit) {
-      BLI_mutex_unlock(&scheduler->queue_mutex);
-      return false;
+    for (Task *task = lane->queue.first; task; task = task->next) {
+      if (pool == NULL || task->pool == pool) {
+        BLI_remlink(&lane->queue, task);
+        lane->num--;
+        found_task = task;
+        break;
+      }
     }
+  }
 
-    for (current_task = scheduler->queue.first; current_task != NULL;
-         current_task = current_task->next) {
-      TaskPool *pool = current_task->pool;
+  BLI_mutex_unlock(&scheduler->queue_mutex);
 
-      if (scheduler->background_thread_only && !pool->run_in_background) {
-        continue;
+  return found_task;
+}
+
+static void task_scheduler_push(TaskScheduler *scheduler, Task *task, TaskPriority priority);
+
+/* Find a task to run, in the deque of the thread first, then in the shared
+ * queues and at last in the deques of the other threads.
+ *
+ * \param deque_id: Deque owned by the calling thread, -1 if it doesn't own any.
+ * \param pool: If not NULL only a task of this pool is returned.
+ * \param r_reused: If not NULL the tasks of other pools taken from reused slots are
+ * added to it instead of being pushed, pushing notifies their pool which must not be
+ * done with the mutex of a pool held. The caller pushes them with
+ * task_scheduler_push_list().
+ */
+static Task *task_scheduler_find(TaskScheduler *scheduler,
+                                 const int deque_id,
+                                 TaskPool *pool,
+                                 ListBase *r_reused)
+{
+  Task *task;
+
+  if (deque_id != -1) {
+    task = task_deque_pop(&scheduler->task_threads[deque_id].deque, pool);
+    if (task) {
+      return task;
+    }
+  }
+
+  task = task_scheduler_lanes_pop(scheduler, pool);
+  if (task) {
+    return task;
+  }
+
+  if (scheduler->background_thread_only) {
+    return NULL;
+  }
+
+  /* Start with the next thread so that thieves spread over the deques. When looking
+   * for a task of a given pool the whole deques are scanned, the own deque too:
+   * the tasks of the pool may be buried under the tasks of other pools.
+   */
+  const int num_deques = scheduler->num_threads + 1;
+  const int first = max_ii(deque_id, 0);
+  for (int i = (pool != NULL) ? 0 : 1; i < num_deques; i++) {
+    TaskDeque *deque = &scheduler->task_threads[(first + i) % num_deques].deque;
+    if (pool == NULL) {
+      task = task_deque_steal(deque);
+    }
+    else {
+      task = task_deque_scan(deque, pool);
+      if (task && task->pool != pool) {
+        /* Slot reused meanwhile, give the task to the other threads. Its pool
+         * already counts it.
+         */
+        if (r_reused) {
+          BLI_addtail(r_reused, task);
+        }
+        else {
+          task_scheduler_push(scheduler, task, TASK_PRIORITY_HIGH);
+        }
+        task = NULL;
       }
+    }
+    if (task) {
+      return task;
+    }
+  }
 
-      *task = current_task;
-      found_task = true;
-      BLI_remlink(&scheduler->queue, *task);
-      break;
+  return NULL;
+}
+
+static void task_scheduler_push_list(TaskScheduler *scheduler, ListBase *tasks)
+{
+  Task *task;
+  while ((task = BLI_pophead(tasks))) {
+    task_scheduler_push(scheduler, task, TASK_PRIORITY_HIGH);
+  }
+}
+
+/* Check if a worker thread may find a task, must be called with the queue mutex held. */
+static bool task_scheduler_has_work(TaskScheduler *scheduler)
+{
+  if (scheduler->background_thread_only) {
+    return scheduler->lanes[TASK_LANE_BACKGROUND].num != 0;
+  }
+  for (int i = 0; i < TASK_LANE_NUM; i++) {
+    if (scheduler->lanes[i].num != 0) {
+      return true;
     }
-    if (!found_task) {
-      BLI_condition_wait(&scheduler->queue_cond, &scheduler->queue_mutex);
+  }
+  for (int i = 0; i < scheduler->num_threads + 1; i++) {
+    const TaskDeque *deque = &scheduler->task_threads[i].deque;
+    if ((ptrdiff_t)(deque->bottom - deque->top) > 0) {
+      return true;
     }
-  } while (!found_task);
+  }
+  return false;
+}
 
-  BLI_mutex_unlock(&scheduler->queue_mutex);
+/* Run the task unless its pool was canceled, then free it and notify the pool. */
+static void task_scheduler_run_task(Task *task, const int thread_id)
+{
+  TaskPool *pool = task->pool;
 
-  return true;
+  if (!pool->do_cancel) {
+    task->run(pool, task->taskdata, thread_id);
+  }
+
+  task_free(pool, task, thread_id);
+
+  task_pool_num_decrease(pool, 1);
 }
 
-BLI_INLINE void handle_local_queue(TaskThreadLocalStorage *tls, const int thread_id)
+static Task *task_scheduler_thread_wait_pop(TaskScheduler *scheduler, const int thread_id)
 {
-  BLI_assert(!tls->do_delayed_push);
-  while (tls->num_local_queue > 0) {
-    /* We pop task from queue before handling it so handler of the task can
-     * push next job to the local queue.
+  const int deque_id = scheduler->background_thread_only ? -1 : thread_id;
+
+  while (!scheduler->do_exit) {
+    Task *task = task_scheduler_find(scheduler, deque_id, NULL, NULL);
+    if (task) {
+      return task;
+    }
+
+    BLI_mutex_lock(&scheduler->queue_mutex);
+
+    /* Pushing threads read the number of sleeping threads after publishing their
+     * tasks, and we check for tasks after incrementing it: either the push is seen
+     * here or the pushing thread notifies us (with the mutex, so not before we wait).
      */
-    tls->num_local_queue--;
-    Task *local_task = tls->local_queue[tls->num_local_queue];
-    /* TODO(sergey): Double-check work_and_wait() doesn't handle other's
-     * pool tasks.
+    atomic_add_and_fetch_u((unsigned int *)&scheduler->num_sleeping, 1);
+
+    /* Waiting on condition may wake up the thread even if condition is not signaled
+     * (spurious wake-ups), and some race condition may also empty the queues **after**
+     * condition has been signaled, but **before** awoken thread reaches this point...
+     * See http://stackoverflow.com/questions/8594591
+     *
+     * So we just look for a task again after waking up.
      */
-    TaskPool *local_pool = local_task->pool;
-    local_task->run(local_pool, local_task->taskdata, thread_id);
-    task_free(local_pool, local_task, thread_id);
+    while (!scheduler->do_exit && !task_scheduler_has_work(scheduler)) {
+      BLI_condition_wait(&scheduler->queue_cond, &scheduler->queue_mutex);
+    }
+
+    atomic_sub_and_fetch_u((unsigned int *)&scheduler->num_sleeping, 1);
+
+    BLI_mutex_unlock(&scheduler->queue_mutex);
   }
-  BLI_assert(!tls->do_delayed_push);
+
+  return NULL;
 }
 
 static void *task_scheduler_thread_run(void *thread_p)
@@ -442,24 +824,14 @@ static void *task_scheduler_thread_run(void *thread_p)
   BLI_mutex_unlock(&scheduler->startup_mutex);
 
   /* keep popping off tasks */
-  while (task_scheduler_thread_wait_pop(scheduler, &task)) {
-    TaskPool *pool = task->pool;
-
-    /* run task */
+  while ((task = task_scheduler_thread_wait_pop(scheduler, thread_id))) {
     BLI_assert(!tls->do_delayed_push);
-    task->run(pool, task->taskdata, thread_id);
+    task_scheduler_run_task(task, thread_id);
     BLI_assert(!tls->do_delayed_push);
-
-    /* delete task */
-    task_free(pool, task, thread_id);
-
-    /* Handle all tasks from local queue. */
-    handle_local_queue(tls, thread_id);
-
-    /* notify pool task was done */
-    task_pool_num_decrease(pool, 1);
   }
 
+  UNUSED_VARS_NDEBUG(tls);
+
   return NULL;
 }
 
@@ -471,9 +843,13 @@ TaskScheduler *BLI_task_scheduler_create(int num_threads)
    * threads, so we keep track of the number of users. */
   scheduler->do_exit = false;
 
-  BLI_listbase_clear(&scheduler->queue);
+  for (int i = 0; i < TASK_LANE_NUM; i++) {
+    BLI_listbase_clear(&scheduler->lanes[i].queue);
+    scheduler->lanes[i].num = 0;
+  }
   BLI_mutex_init(&scheduler->queue_mutex);
   BLI_condition_init(&scheduler->queue_cond);
+  scheduler->num_sleeping = 0;
 
   BLI_mutex_init(&scheduler->startup_mutex);
   BLI_condition_init(&scheduler->startup_cond);
@@ -496,8 +872,9 @@ TaskScheduler *BLI_task_scheduler_create(int num_threads)
   scheduler->task_threads = MEM_mallocN(sizeof(TaskThread) * (num_threads + 1),
                                         "TaskScheduler task threads");
 
-  /* Initialize TLS for main thread. */
+  /* Initialize TLS and deque for main thread. */
   initialize_task_tls(&scheduler->task_threads[0].tls);
+  task_deque_init(&scheduler->task_threads[0].deque);
 
   pthread_key_create(&scheduler->tls_id_key, NULL);
 
@@ -508,12 +885,17 @@ TaskScheduler *BLI_task_scheduler_create(int num_threads)
     scheduler->num_threads = num_threads;
     scheduler->threads = MEM_callocN(sizeof(pthread_t) * num_threads, "TaskScheduler threads");
 
+    /* Initialize all the deques first, threads look into each other's ones. */
     for (i = 0; i < num_threads; i++) {
       TaskThread *thread = &scheduler->task_threads[i + 1];
       thread->scheduler = scheduler;
       thread->id = i + 1;
       initialize_task_tls(&thread->tls);
+      task_deque_init(&thread->deque);
+    }
 
+    for (i = 0; i < num_threads; i++) {
+      TaskThread *thread = &scheduler->task_threads[i + 1];
       if (pthread_create(&scheduler->threads[i], NULL, task_scheduler_thread_run, thread) != 0) {
         fprintf(stderr, "TaskScheduler failed to launch thread %d/%d\n", i, num_threads);
       }
@@ -559,9 +941,19 @@ void BLI_task_scheduler_free(TaskScheduler *scheduler)
     MEM_freeN(scheduler->threads);
   }
 
-  /* Delete task thread data */
+  /* Delete task thread data and leftover tasks of the deques. */
   if (scheduler->task_threads) {
     for (int i = 0; i < scheduler->num_threads + 1; i++) {
+      TaskDeque *deque = &scheduler->task_threads[i].deque;
+      for (size_t index = deque->top; index != deque->bottom; index++) {
+        task = deque->slots[index & DEQUE_MASK].task;
+        /* Indices of the tasks taken by a scan are left empty. */
+        if (task != NULL) {
+          task_data_free(task, 0);
+          MEM_freeN(task);
+        }
+      }
+
       TaskThreadLocalStorage *tls = &scheduler->task_threads[i].tls;
       free_task_tls(tls);
     }
@@ -570,10 +962,13 @@ void BLI_task_scheduler_free(TaskScheduler *scheduler)
   }
 
   /* delete leftover tasks */
-  for (task = scheduler->queue.first; task; task = task->next) {
-    task_data_free(task, 0);
+  for (int i = 0; i < TASK_LANE_NUM; i++) {
+    ListBase *queue = &scheduler->lanes[i].queue;
+    for (task = queue->first; task; task = task->next) {
+      task_data_free(task, 0);
+    }
+    BLI_freelistN(queue);
   }
-  BLI_freelistN(&scheduler->queue);
 
   /* delete mutex/condition */
   BLI_mutex_end(&scheduler->queue_mutex);
@@ -591,41 +986,21 @@ int BLI_task_scheduler_num_threads(TaskScheduler *scheduler)
 
 static void task_scheduler_push(TaskScheduler *scheduler, Task *task, TaskPriority priority)
 {
-  task_pool_num_increase(task->pool, 1);
+  TaskPool *pool = task->pool;
+  TaskLane *lane = &scheduler->lanes[task_scheduler_lane_index(pool, priority)];
 
   /* add task to queue */
   BLI_mutex_lock(&scheduler->queue_mutex);
 
-  if (priority == TASK_PRIORITY_HIGH) {
-    BLI_addhead(&scheduler->queue, task);
-  }
-  else {
-    BLI_addtail(&scheduler->queue, task);
-  }
+  BLI_addtail(&lane->queue, task);
+  lane->num++;
 
-  BLI_condition_notify_one(&scheduler->queue_cond);
-  BLI_mutex_unlock(&scheduler->queue_mutex);
-}
-
-static void task_scheduler_push_all(TaskScheduler *scheduler,
-                                    TaskPool *pool,
-                                    Task **tasks,
-                                    int num_tasks)
-{
-  if (num_tasks == 0) {
-    return;
+  if (scheduler->num_sleeping != 0) {
+    BLI_condition_notify_one(&scheduler->queue_cond);
   }
-
-  task_pool_num_increase(pool, num_tasks);
-
-  BLI_mutex_lock(&scheduler->queue_mutex);
-
-  for (int i = 0; i < num_tasks; i++) {
-    BLI_addhead(&scheduler->queue, tasks[i]);
-  }
-
-  BLI_condition_notify_all(&scheduler->queue_cond);
   BLI_mutex_unlock(&scheduler->queue_mutex);
+
+  task_pool_notify_push(pool);
 }
 
 static void task_scheduler_clear(TaskScheduler *scheduler, TaskPool *pool)
@@ -635,22 +1010,28 @@ static void task_scheduler_clear(TaskScheduler *scheduler, TaskPool *pool)
 
   BLI_mutex_lock(&scheduler->queue_mutex);
 
-  /* free all tasks from this pool from the queue */
-  for (task = scheduler->queue.first; task; task = nexttask) {
-    nexttask = task->next;
+  /* free all tasks from this pool from the queues */
+  for (int i = 0; i < TASK_LANE_NUM; i++) {
+    TaskLane *lane = &scheduler->lanes[i];
+    for (task = lane->queue.first; task; task = nexttask) {
+      nexttask = task->next;
 
-    if (task->pool == pool) {
-      task_data_free(task, pool->thread_id);
-      BLI_freelinkN(&scheduler->queue, task);
+      if (task->pool == pool) {
+        task_data_free(task, pool->thread_id);
+        BLI_freelinkN(&lane->queue, task);
+        lane->num--;
 
-      done++;
+        done++;
+      }
     }
   }
 
   BLI_mutex_unlock(&scheduler->queue_mutex);
 
   /* notify done */
-  task_pool_num_decrease(pool, done);
+  if (done != 0) {
+    task_pool_num_decrease(pool, done);
+  }
 }
 
 /* Task Pool */
@@ -677,8 +1058,8 @@ static TaskPool *task_pool_create_ex(TaskScheduler *scheduler,
 
   pool->scheduler = scheduler;
   pool->num = 0;
+  pool->num_waiting = 0;
   pool->do_cancel = false;
-  pool->do_work = false;
   pool->is_suspended = is_suspended;
   pool->start_suspended = is_suspended;
   pool->num_suspended = 0;
@@ -796,9 +1177,14 @@ void BLI_task_pool_free(TaskPool *pool)
   BLI_threaded_malloc_end();
 }
 
-BLI_INLINE bool task_can_use_local_queues(TaskPool *pool, int thread_id)
+/* Check if the tasks pushed from the given thread can go to its deque. Threads
+ * which are not managed by the scheduler identify themselves as thread 0 but
+ * don't own the main thread's deque.
+ */
+BLI_INLINE bool task_can_use_deque(TaskPool *pool, int thread_id)
 {
-  return (thread_id != -1 && (thread_id != pool->thread_id || pool->do_work));
+  return (thread_id != -1 && !pool->scheduler->background_thread_only &&
+          !(thread_id == 0 && pool->use_local_tls));
 }
 
 static void task_pool_push(TaskPool *pool,
@@ -827,29 +1213,27 @@ static void task_pool_push(TaskPool *pool,
     atomic_fetch_and_add_z(&pool->num_suspended, 1);
     return;
   }
-  /* Populate to any local queue first, this is cheapest push ever. */
-  if (task_can_use_local_queues(pool, thread_id)) {
+  /* The task must be counted before it's visible, it could be done right away. */
+  task_pool_num_increase(pool, 1);
+  /* Push to the deque of the thread, this is cheapest push ever, no lock
+   * involved and the task is likely to be handled by this thread next.
+   * The priority is ignored here, the deque is always handled first.
+   */
+  if (task_can_use_deque(pool, thread_id)) {
     ASSERT_THREAD_ID(pool->scheduler, thread_id);
-    TaskThreadLocalStorage *tls = get_task_tls(pool, thread_id);
-    /* Try to push to a local execution queue.
-     * These tasks will be picked up next.
-     */
-    if (tls->num_local_queue < LOCAL_QUEUE_SIZE) {
-      tls->local_queue[tls->num_local_queue] = task;
-      tls->num_local_queue++;
-      return;
-    }
-    /* If we are in the delayed tasks push mode, we push tasks to a
-     * temporary local queue first without any locks, and then move them
-     * to global execution queue with a single lock.
-     */
-    if (tls->do_delayed_push && tls->num_delayed_queue < DELAYED_QUEUE_SIZE) {
-      tls->delayed_queue[tls->num_delayed_queue] = task;
-      tls->num_delayed_queue++;
+    TaskScheduler *scheduler = pool->scheduler;
+    if (task_deque_push(&scheduler->task_threads[thread_id].deque, task)) {
+      /* In the delayed tasks push mode, the sleeping threads are woken up
+       * only once at the end.
+       */
+      if (!get_task_tls(pool, thread_id)->do_delayed_push) {
+        task_scheduler_notify_push(scheduler, false);
+      }
+      task_pool_notify_push(pool);
       return;
     }
   }
-  /* Do push to a global execution pool, slowest possible method,
+  /* Do push to a shared execution queue, slowest possible method,
    * causes quite reasonable amount of threading overhead.
    */
   task_scheduler_push(pool->scheduler, task, priority);
@@ -881,92 +1265,98 @@ void BLI_task_pool_push_from_thread(TaskPool *pool,
   task_pool_push(pool, run, taskdata, free_taskdata, NULL, priority, thread_id);
 }
 
-void BLI_task_pool_work_and_wait(TaskPool *pool)
+/* Wait until all the tasks of the pool are done. When run_tasks is set the calling
+ * thread must be the thread of the pool, it runs the tasks of the pool it finds
+ * meanwhile (or discards them when the pool is canceled).
+ */
+static void task_pool_wait(TaskPool *pool, const bool run_tasks)
 {
-  TaskThreadLocalStorage *tls = get_task_tls(pool, pool->thread_id);
   TaskScheduler *scheduler = pool->scheduler;
+  const int deque_id = task_can_use_deque(pool, pool->thread_id) ? pool->thread_id : -1;
 
-  if (atomic_fetch_and_and_uint8((uint8_t *)&pool->is_suspended, 0)) {
-    if (pool->num_suspended) {
-      task_pool_num_increase(pool, pool->num_suspended);
-      BLI_mutex_lock(&scheduler->queue_mutex);
+  while (true) {
+    Task *task = run_tasks ? task_scheduler_find(scheduler, deque_id, pool, NULL) : NULL;
 
-      BLI_movelisttolist(&scheduler->queue, &pool->suspended_queue);
+    if (task == NULL) {
+      BLI_mutex_lock(&pool->num_mutex);
 
-      BLI_condition_notify_all(&scheduler->queue_cond);
-      BLI_mutex_unlock(&scheduler->queue_mutex);
-
-      pool->num_suspended = 0;
-    }
-  }
-
-  pool->do_work = true;
-
-  ASSERT_THREAD_ID(pool->scheduler, pool->thread_id);
-
-  handle_local_queue(tls, pool->thread_id);
-
-  BLI_mutex_lock(&pool->num_mutex);
+      /* Pushing threads read the number of waiting threads after publishing their
+       * tasks, so either we find the new tasks here or we get notified.
+       */
+      atomic_add_and_fetch_u((unsigned int *)&pool->num_waiting, 1);
 
-  while (pool->num != 0) {
-    Task *task, *work_task = NULL;
-    bool found_task = false;
+      /* Tasks of other pools found by the search, pushing them locks the mutex of
+       * their pool which may be waiting for us with its own mutex held.
+       */
+      ListBase reused = {NULL, NULL};
+
+      while (pool->num != 0) {
+        if (run_tasks) {
+          task = task_scheduler_find(scheduler, deque_id, pool, &reused);
+          if (task) {
+            break;
+          }
+          if (!BLI_listbase_is_empty(&reused)) {
+            /* Search again after pushing, a notification may be missed meanwhile. */
+            BLI_mutex_unlock(&pool->num_mutex);
+            task_scheduler_push_list(scheduler, &reused);
+            BLI_mutex_lock(&pool->num_mutex);
+            continue;
+          }
+        }
+        BLI_condition_wait(&pool->num_cond, &pool->num_mutex);
+      }
 
-    BLI_mutex_unlock(&pool->num_mutex);
+      atomic_sub_and_fetch_u((unsigned int *)&pool->num_waiting, 1);
 
-    BLI_mutex_lock(&scheduler->queue_mutex);
+      BLI_mutex_unlock(&pool->num_mutex);
 
-    /* find task from this pool. if we get a task from another pool,
-     * we can get into deadlock */
+      task_scheduler_push_list(scheduler, &reused);
 
-    for (task = scheduler->queue.first; task; task = task->next) {
-      if (task->pool == pool) {
-        work_task = task;
-        found_task = true;
-        BLI_remlink(&scheduler->queue, task);
+      if (task == NULL) {
         break;
       }
     }
 
-    BLI_mutex_unlock(&scheduler->queue_mutex);
+    task_scheduler_run_task(task, pool->thread_id);
+  }
+}
 
-    /* if found task, do it, otherwise wait until other tasks are done */
-    if (found_task) {
-      /* run task */
-      BLI_assert(!tls->do_delayed_push);
-      work_task->run(pool, work_task->taskdata, pool->thread_id);
-      BLI_assert(!tls->do_delayed_push);
+void BLI_task_pool_work_and_wait(TaskPool *pool)
+{
+  TaskThreadLocalStorage *tls = get_task_tls(pool, pool->thread_id);
+  TaskScheduler *scheduler = pool->scheduler;
 
-      /* delete task */
-      task_free(pool, task, pool->thread_id);
+  if (atomic_fetch_and_and_uint8((uint8_t *)&pool->is_suspended, 0)) {
+    if (pool->num_suspended) {
+      TaskLane *lane = &scheduler->lanes[task_scheduler_lane_index(pool, TASK_PRIORITY_LOW)];
 
-      /* Handle all tasks from local queue. */
-      handle_local_queue(tls, pool->thread_id);
+      task_pool_num_increase(pool, pool->num_suspended);
+      BLI_mutex_lock(&scheduler->queue_mutex);
 
-      /* notify pool task was done */
-      task_pool_num_decrease(pool, 1);
-    }
+      BLI_movelisttolist(&lane->queue, &pool->suspended_queue);
+      lane->num += pool->num_suspended;
 
-    BLI_mutex_lock(&pool->num_mutex);
-    if (pool->num == 0) {
-      break;
-    }
+      BLI_condition_notify_all(&scheduler->queue_cond);
+      BLI_mutex_unlock(&scheduler->queue_mutex);
 
-    if (!found_task) {
-      BLI_condition_wait(&pool->num_cond, &pool->num_mutex);
+      pool->num_suspended = 0;
     }
   }
 
-  BLI_mutex_unlock(&pool->num_mutex);
+  ASSERT_THREAD_ID(pool->scheduler, pool->thread_id);
 
-  BLI_assert(tls->num_local_queue == 0);
+  BLI_assert(!tls->do_delayed_push);
+  task_pool_wait(pool, true);
+  BLI_assert(!tls->do_delayed_push);
+
+  UNUSED_VARS_NDEBUG(tls);
 }
 
 void BLI_task_pool_work_wait_and_reset(TaskPool *pool)
 {
   BLI_task_pool_work_and_wait(pool);
 
-  pool->do_work = false;
   pool->is_suspended = pool->start_suspended;
 }
 
@@ -976,12 +1366,13 @@ void BLI_task_pool_cancel(TaskPool *pool)
 
   task_scheduler_clear(pool->scheduler, pool);
 
-  /* wait until all entries are cleared */
-  BLI_mutex_lock(&pool->num_mutex);
-  while (pool->num) {
-    BLI_condition_wait(&pool->num_cond, &pool->num_mutex);
-  }
-  BLI_mutex_unlock(&pool->num_mutex);
+  /* Wait until all entries are cleared, the tasks left in the deques are
+   * discarded by the threads popping them. From the thread of the pool we
+   * discard the tasks of its deque too, nobody else might steal them.
+   */
+  const bool is_pool_thread = !pool->use_local_tls &&
+                              task_scheduler_thread_id(pool->scheduler) == pool->thread_id;
+  task_pool_wait(pool, is_pool_thread);
 
   pool->do_cancel = false;
 }
@@ -1003,7 +1394,7 @@ ThreadMutex *BLI_task_pool_user_mutex(TaskPool *pool)
 
 void BLI_task_pool_delayed_push_begin(TaskPool *pool, int thread_id)
 {
-  if (task_can_use_local_queues(pool, thread_id)) {
+  if (task_can_use_deque(pool, thread_id)) {
     ASSERT_THREAD_ID(pool->scheduler, thread_id);
     TaskThreadLocalStorage *tls = get_task_tls(pool, thread_id);
     tls->do_delayed_push = true;
@@ -1012,13 +1403,15 @@ void BLI_task_pool_delayed_push_begin(TaskPool *pool, int thread_id)
 
 void BLI_task_pool_delayed_push_end(TaskPool *pool, int thread_id)
 {
-  if (task_can_use_local_queues(pool, thread_id)) {
+  if (task_can_use_deque(pool, thread_id)) {
     ASSERT_THREAD_ID(pool->scheduler, thread_id);
     TaskThreadLocalStorage *tls = get_task_tls(pool, thread_id);
     BLI_assert(tls->do_delayed_push);
-    task_scheduler_push_all(pool->scheduler, pool, tls->delayed_queue, tls->num_delayed_queue);
     tls->do_delayed_push = false;
-    tls->num_delayed_queue = 0;
+    /* Several tasks may have been pushed, wake up all the sleeping threads. */
+    if (task_deque_size(&pool->scheduler->task_threads[thread_id].deque) != 0) {
+      task_scheduler_notify_push(pool->scheduler, true);
+    }
   }
 }
 
@@ -25,6 +25,7 @@
  * \ingroup blenloader
  */
 
+struct MemFileBuffer;
 struct Scene;
 
 typedef struct {
@@ -32,12 +33,16 @@ typedef struct {
   const char *buf;
   /** Size in bytes. */
   unsigned int size;
-  /** When true, this chunk doesn't own the memory, it's shared with a previous #MemFileChunk */
-  bool is_identical;
+  /**
+   * Reference counted storage of #MemFileChunk.buf,
+   * shared by all identical chunks of all the memfiles.
+   */
+  struct MemFileBuffer *buffer;
 } MemFileChunk;
 
 typedef struct MemFile {
   ListBase chunks;
+  /** Size of the buffers added by this memfile (not shared with a previous one). */
   size_t size;
 } MemFile;
 
@@ -55,7 +60,6 @@ extern void memfile_chunk_add(MemFile *memfile,
 
 /* exports */
 extern void BLO_memfile_free(MemFile *memfile);
-extern void BLO_memfile_merge(MemFile *first, MemFile *second);
 
 /* utilities */
 extern struct Main *BLO_memfile_main_get(struct MemFile *memfile,
@@ -106,6 +106,8 @@
 #include "BLI_threads.h"
 #include "BLI_mempool.h"
 #include "BLI_ghash.h"
+#include "BLI_mmap.h"
+#include "BLI_task.h"
 
 #include "BLT_translation.h"
 
@@ -230,6 +232,9 @@
  *
  * \note This is disabled when using compression,
  * while zlib supports seek it's unusably slow, see: T61880.
+ *
+ * When the file is memory mapped, the delayed blocks are copied from the mapping
+ * (or used in place when they need to be reconstructed), see #fd_read_from_mmap.
  */
 #define USE_BHEAD_READ_ON_DEMAND
 
@@ -975,6 +980,10 @@ static bool blo_bhead_read_data(FileData *fd, BHead *thisblock, void *buf)
   bool success = true;
   BHeadN *new_bhead = BHEADN_FROM_BHEAD(thisblock);
   BLI_assert(new_bhead->has_data == false && new_bhead->file_offset != 0);
+  if (fd->mmap_file != NULL) {
+    /* No need to move the read position, copy straight from the mapping. */
+    return BLI_mmap_read(fd->mmap_file, buf, new_bhead->file_offset, new_bhead->bhead.len);
+  }
   off64_t offset_backup = fd->file_offset;
   if (UNLIKELY(fd->seek(fd, new_bhead->file_offset, SEEK_SET) == -1)) {
     success = false;
@@ -1003,6 +1012,25 @@ static BHead *blo_bhead_read_full(FileData *fd, BHead *thisblock)
   }
   return &new_bhead_data->bhead;
 }
+
+/**
+ * Data of a block which wasn't read yet, directly in the memory mapped file.
+ * Returns NULL when the file isn't mapped.
+ *
+ * \note The data is read-only and only valid as long as the file data exists,
+ * IO errors must be checked with #BLI_mmap_has_error once it's been accessed.
+ */
+static const void *blo_bhead_data_from_mmap(FileData *fd, BHead *thisblock)
+{
+  BHeadN *new_bhead = BHEADN_FROM_BHEAD(thisblock);
+  BLI_assert(new_bhead->has_data == false);
+  if (fd->mmap_file == NULL ||
+      (size_t)new_bhead->file_offset + (size_t)new_bhead->bhead.len >
+          BLI_mmap_get_length(fd->mmap_file)) {
+    return NULL;
+  }
+  return POINTER_OFFSET(BLI_mmap_get_pointer(fd->mmap_file), new_bhead->file_offset);
+}
 #endif /* USE_BHEAD_READ_ON_DEMAND */
 
 /* Warning! Caller's responsibility to ensure given bhead **is** and ID one! */
@@ -1169,6 +1197,60 @@ static off64_t fd_seek_data_from_file(FileData *filedata, off64_t offset, int wh
   return filedata->file_offset;
 }
 
+/* Memory-mapped file reading.
+ *
+ * Avoids a system call per block and lets the data blocks which are read on demand
+ * be copied (or reconstructed) straight from the mapping. The pages of the mapping
+ * are backed by the file, they don't add to the memory of the process.
+ */
+
+static int fd_read_from_mmap(FileData *filedata, void *buffer, uint size)
+{
+  const size_t length = BLI_mmap_get_length(filedata->mmap_file);
+  /* don't read more bytes then there are available in the file */
+  const size_t offset = MIN2((size_t)filedata->file_offset, length);
+  const size_t readsize = MIN2((size_t)size, length - offset);
+
+  if (!BLI_mmap_read(filedata->mmap_file, buffer, offset, readsize)) {
+    return EOF;
+  }
+  filedata->file_offset += readsize;
+
+  return (int)readsize;
+}
+
+/* Set the read position of a file of which the length is known. */
+static off64_t fd_seek_offset(FileData *filedata, off64_t offset, int whence, off64_t length)
+{
+  off64_t new_offset;
+
+  switch (whence) {
+    case SEEK_SET:
+      new_offset = offset;
+      break;
+    case SEEK_CUR:
+      new_offset = filedata->file_offset + offset;
+      break;
+    case SEEK_END:
+      new_offset = length + offset;
+      break;
+    default:
+      return -1;
+  }
+
+  if (new_offset < 0 || new_offset > length) {
+    return -1;
+  }
+  filedata->file_offset = new_offset;
+  return new_offset;
+}
+
+static off64_t fd_seek_from_mmap(FileData *filedata, off64_t offset, int whence)
+{
+  return fd_seek_offset(
+      filedata, offset, whence, (off64_t)BLI_mmap_get_length(filedata->mmap_file));
+}
+
 /* GZip file reading. */
 
 static int fd_read_gzip_from_file(FileData *filedata, void *buffer, uint size)
@@ -1185,6 +1267,255 @@ static int fd_read_gzip_from_file(FileData *filedata, void *buffer, uint size)
   return (readsize);
 }
 
+/* Block compressed file reading.
+ *
+ * Files made of independent gzip members (see #BLEND_GZIP_BLOCK_SIZE) are mapped and
+ * decompressed a block at a time. Reading sequentially decompresses the next blocks in
+ * parallel, and since the position of every block is known the file can be seeked,
+ * so data-blocks can be read on demand (library linking only decompresses what it needs).
+ */
+
+typedef struct FileDataGzipBlock {
+  /** Position and length of the gzip member in the file. */
+  size_t member_offset;
+  uint member_len;
+  /** Position and length of the decompressed data. */
+  off64_t data_offset;
+  uint data_len;
+  /** Decompressed data, only set while the block is cached. */
+  char *data;
+  bool error;
+} FileDataGzipBlock;
+
+typedef struct FileDataGzipBlocks {
+  BLI_mmap_file *mmap_file;
+  FileDataGzipBlock *blocks;
+  int blocks_len;
+  /** Length of the decompressed file. */
+  off64_t data_len;
+  /** Range of the cached blocks. */
+  int cache_start, cache_end;
+  /** Number of blocks decompressed at once when reading sequentially. */
+  int read_ahead;
+  /** Last block read from, to avoid searching for sequential reads. */
+  int block_last;
+} FileDataGzipBlocks;
+
+static uint gzip_blocks_read_uint16(const uchar *src)
+{
+  return (uint)src[0] | ((uint)src[1] << 8);
+}
+
+static uint gzip_blocks_read_uint32(const uchar *src)
+{
+  return gzip_blocks_read_uint16(src) | (gzip_blocks_read_uint16(src + 2) << 16);
+}
+
+static void gzip_blocks_cache_clear(FileDataGzipBlocks *gzb)
+{
+  for (int i = gzb->cache_start; i < gzb->cache_end; i++) {
+    MEM_SAFE_FREE(gzb->blocks[i].data);
+    gzb->blocks[i].error = false;
+  }
+  gzb->cache_start = gzb->cache_end = 0;
+}
+
+static void gzip_blocks_free(FileDataGzipBlocks *gzb)
+{
+  gzip_blocks_cache_clear(gzb);
+  MEM_SAFE_FREE(gzb->blocks);
+  BLI_mmap_free(gzb->mmap_file);
+  MEM_freeN(gzb);
+}
+
+/**
+ * Index the gzip members of the file, returns NULL when the file isn't block compressed
+ * (regular gzip file), in which case it has to be read as a stream.
+ */
+static FileDataGzipBlocks *gzip_blocks_open(int file)
+{
+  BLI_mmap_file *mmap_file = BLI_mmap_open(file);
+  if (mmap_file == NULL) {
+    return NULL;
+  }
+
+  FileDataGzipBlocks *gzb = MEM_callocN(sizeof(*gzb), __func__);
+  gzb->mmap_file = mmap_file;
+
+  const uchar *memory = BLI_mmap_get_pointer(mmap_file);
+  const size_t length = BLI_mmap_get_length(mmap_file);
+  int blocks_alloc = 0;
+  size_t offset = 0;
+
+  while (offset < length) {
+    const uchar *member = memory + offset;
+    if (length - offset < BLEND_GZIP_BLOCK_HEADER_SIZE + BLEND_GZIP_BLOCK_TRAILER_SIZE) {
+      break;
+    }
+    /* Only the header written by #BLO_write_file is supported. */
+    if (member[0] != 0x1f || member[1] != 0x8b || member[2] != Z_DEFLATED || member[3] != 4 ||
+        gzip_blocks_read_uint16(member + 10) != 8 || member[12] != BLEND_GZIP_BLOCK_SI1 ||
+        member[13] != BLEND_GZIP_BLOCK_SI2 || gzip_blocks_read_uint16(member + 14) != 4) {
+      break;
+    }
+    const uint member_len = gzip_blocks_read_uint32(member + 16);
+    if (member_len < BLEND_GZIP_BLOCK_HEADER_SIZE + BLEND_GZIP_BLOCK_TRAILER_SIZE ||
+        member_len > length - offset) {
+      break;
+    }
+    const uint data_len = gzip_blocks_read_uint32(member + member_len - 4);
+    if (data_len == 0 || data_len > BLEND_GZIP_BLOCK_SIZE) {
+      break;
+    }
+
+    if (gzb->blocks_len == blocks_alloc) {
+      blocks_alloc = MAX2(blocks_alloc * 2, 64);
+      gzb->blocks = MEM_recallocN(gzb->blocks, sizeof(*gzb->blocks) * blocks_alloc);
+    }
+    FileDataGzipBlock *block = &gzb->blocks[gzb->blocks_len++];
+    block->member_offset = offset;
+    block->member_len = member_len;
+    block->data_offset = gzb->data_len;
+    block->data_len = data_len;
+
+    gzb->data_len += data_len;
+    offset += member_len;
+  }
+
+  if (offset != length || BLI_mmap_has_error(mmap_file)) {
+    gzip_blocks_free(gzb);
+    return NULL;
+  }
+
+  gzb->read_ahead = max_ii(BLI_system_thread_count(), 1);
+  return gzb;
+}
+
+static void gzip_blocks_decompress_cb(void *__restrict userdata,
+                                      const int iter,
+                                      const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  FileDataGzipBlocks *gzb = userdata;
+  FileDataGzipBlock *block = &gzb->blocks[iter];
+  const uchar *member = POINTER_OFFSET(BLI_mmap_get_pointer(gzb->mmap_file),
+                                       block->member_offset);
+  const uchar *trailer = member + block->member_len - BLEND_GZIP_BLOCK_TRAILER_SIZE;
+  z_stream strm;
+  int ret;
+
+  block->error = false;
+  memset(&strm, 0, sizeof(strm));
+  if (inflateInit2(&strm, -MAX_WBITS) != Z_OK) {
+    block->error = true;
+    return;
+  }
+
+  block->data = MEM_mallocN(block->data_len, __func__);
+  strm.next_in = (Bytef *)(member + BLEND_GZIP_BLOCK_HEADER_SIZE);
+  strm.avail_in = block->member_len - BLEND_GZIP_BLOCK_HEADER_SIZE -
+                  BLEND_GZIP_BLOCK_TRAILER_SIZE;
+  strm.next_out = (Bytef *)block->data;
+  strm.avail_out = block->data_len;
+  ret = inflate(&strm, Z_FINISH);
+  inflateEnd(&strm);
+
+  if (ret != Z_STREAM_END || strm.total_out != block->data_len ||
+      crc32(0, (const Bytef *)block->data, block->data_len) != gzip_blocks_read_uint32(trailer)) {
+    block->error = true;
+  }
+}
+
+/* Make sure a block is decompressed, returns false on error. */
+static bool gzip_blocks_cache(FileDataGzipBlocks *gzb, const int block_index)
+{
+  if (block_index >= gzb->cache_start && block_index < gzb->cache_end) {
+    return true;
+  }
+
+  /* Decompress the following blocks as well when reading sequentially,
+   * for random access (data read on demand) only the needed block is. */
+  const int blocks_num = (block_index == gzb->cache_end) ? gzb->read_ahead : 1;
+  gzip_blocks_cache_clear(gzb);
+  gzb->cache_start = block_index;
+  gzb->cache_end = min_ii(block_index + blocks_num, gzb->blocks_len);
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (gzb->cache_end - gzb->cache_start > 1);
+  settings.scheduling_mode = TASK_SCHEDULING_DYNAMIC;
+  settings.min_iter_per_thread = 1;
+  BLI_task_parallel_range(
+      gzb->cache_start, gzb->cache_end, gzb, gzip_blocks_decompress_cb, &settings);
+
+  bool error = BLI_mmap_has_error(gzb->mmap_file);
+  for (int i = gzb->cache_start; i < gzb->cache_end && !error; i++) {
+    if (gzb->blocks[i].error) {
+      printf("%s: zlib error\n", __func__);
+      error = true;
+    }
+  }
+  /* Don't keep partially decompressed blocks, a later read has to retry or fail again. */
+  if (error) {
+    gzip_blocks_cache_clear(gzb);
+  }
+  return !error;
+}
+
+static bool gzip_blocks_contains(const FileDataGzipBlock *block, const off64_t offset)
+{
+  return offset >= block->data_offset && offset < block->data_offset + block->data_len;
+}
+
+static int gzip_blocks_find(FileDataGzipBlocks *gzb, const off64_t offset)
+{
+  /* Same or next block, the common case. */
+  for (int i = gzb->block_last; i < min_ii(gzb->block_last + 2, gzb->blocks_len); i++) {
+    if (gzip_blocks_contains(&gzb->blocks[i], offset)) {
+      return i;
+    }
+  }
+
+  int low = 0, high = gzb->blocks_len - 1;
+  while (low < high) {
+    const int mid = (low + high + 1) / 2;
+    if (gzb->blocks[mid].data_offset <= offset) {
+      low = mid;
+    }
+    else {
+      high = mid - 1;
+    }
+  }
+  return low;
+}
+
+static int fd_read_from_gzip_blocks(FileData *filedata, void *buffer, uint size)
+{
+  FileDataGzipBlocks *gzb = filedata->gzip_blocks;
+  uint readsize = 0;
+
+  while (readsize < size && filedata->file_offset < gzb->data_len) {
+    const int block_index = gzip_blocks_find(gzb, filedata->file_offset);
+    if (!gzip_blocks_cache(gzb, block_index)) {
+      return EOF;
+    }
+    gzb->block_last = block_index;
+
+    const FileDataGzipBlock *block = &gzb->blocks[block_index];
+    const uint offset = (uint)(filedata->file_offset - block->data_offset);
+    const uint len = MIN2(size - readsize, block->data_len - offset);
+    memcpy(POINTER_OFFSET(buffer, readsize), block->data + offset, len);
+    readsize += len;
+    filedata->file_offset += len;
+  }
+
+  return (int)readsize;
+}
+
+static off64_t fd_seek_from_gzip_blocks(FileData *filedata, off64_t offset, int whence)
+{
+  return fd_seek_offset(filedata, offset, whence, filedata->gzip_blocks->data_len);
+}
+
 /* Memory reading. */
 
 static int fd_read_from_memory(FileData *filedata, void *buffer, uint size)
@@ -1311,6 +1642,8 @@ static FileData *blo_filedata_from_file_descriptor(const char *filepath,
   FileDataSeekFn *seek_fn = NULL; /* Optional. */
 
   gzFile gzfile = (gzFile)Z_NULL;
+  BLI_mmap_file *mmap_file = NULL;
+  FileDataGzipBlocks *gzip_blocks = NULL;
 
   char header[7];
 
@@ -1335,8 +1668,18 @@ static FileData *blo_filedata_from_file_descriptor(const char *filepath,
 
     /* Regular file. */
     if (memcmp(header, "BLENDER", sizeof(header)) == 0) {
-      read_fn = fd_read_data_from_file;
-      seek_fn = fd_seek_data_from_file;
+      /* Map the file when possible, fall back to reading it otherwise. */
+      mmap_file = BLI_mmap_open(file);
+      if (mmap_file != NULL) {
+        read_fn = fd_read_from_mmap;
+        seek_fn = fd_seek_from_mmap;
+        /* The mapping doesn't need the file, caller must close. */
+        file = -1;
+      }
+      else {
+        read_fn = fd_read_data_from_file;
+        seek_fn = fd_seek_data_from_file;
+      }
     }
 
     /* Gzip file. */
@@ -1344,6 +1687,16 @@ static FileData *blo_filedata_from_file_descriptor(const char *filepath,
     if ((read_fn == NULL) &&
         /* Check header magic. */
         (header[0] == 0x1f && header[1] == 0x8b)) {
+      gzip_blocks = gzip_blocks_open(file);
+      if (gzip_blocks != NULL) {
+        read_fn = fd_read_from_gzip_blocks;
+        seek_fn = fd_seek_from_gzip_blocks;
+        /* The mapping doesn't need the file, caller must close. */
+        file = -1;
+      }
+    }
+    if ((read_fn == NULL) && (header[0] == 0x1f && header[1] == 0x8b)) {
+      /* Gzip file not written in blocks, read it as a stream. */
       gzfile = BLI_gzopen(filepath, "rb");
       if (gzfile == (gzFile)Z_NULL) {
         BKE_reportf(reports,
@@ -1370,6 +1723,8 @@ static FileData *blo_filedata_from_file_descriptor(const char *filepath,
 
     fd->filedes = file;
     fd->gzfiledes = gzfile;
+    fd->mmap_file = mmap_file;
+    fd->gzip_blocks = gzip_blocks;
 
     fd->read = read_fn;
     fd->seek = seek_fn;
@@ -1540,6 +1895,14 @@ void blo_filedata_free(FileData *fd)
       gzclose(fd->gzfiledes);
     }
 
+    if (fd->mmap_file != NULL) {
+      BLI_mmap_free(fd->mmap_file);
+    }
+
+    if (fd->gzip_blocks != NULL) {
+      gzip_blocks_free(fd->gzip_blocks);
+    }
+
     if (fd->strm.next_in) {
       if (inflateEnd(&fd->strm) != Z_OK) {
         printf("close gzip stream error\n");
@@ -2255,17 +2618,29 @@ static void *read_struct(FileData *fd, BHead *bh, const char *blockname)
 
     if (fd->compflags[bh->SDNAnr] != SDNA_CMP_REMOVED) {
       if (fd->compflags[bh->SDNAnr] == SDNA_CMP_NOT_EQUAL) {
+        const void *data = (bh + 1);
 #ifdef USE_BHEAD_READ_ON_DEMAND
         if (BHEADN_FROM_BHEAD(bh)->has_data == false) {
-          bh = blo_bhead_read_full(fd, bh);
-          if (UNLIKELY(bh == NULL)) {
-            fd->flags &= ~FD_FLAGS_FILE_OK;
-            return NULL;
+          /* Reconstruct from the mapped file directly, without a copy of the block. */
+          data = blo_bhead_data_from_mmap(fd, bh);
+          if (data == NULL) {
+            bh = blo_bhead_read_full(fd, bh);
+            if (UNLIKELY(bh == NULL)) {
+              fd->flags &= ~FD_FLAGS_FILE_OK;
+              return NULL;
+            }
+            data = (bh + 1);
           }
         }
 #endif
         temp = DNA_struct_reconstruct(
-            fd->memsdna, fd->filesdna, fd->compflags, bh->SDNAnr, bh->nr, (bh + 1));
+            fd->memsdna, fd->filesdna, fd->compflags, bh->SDNAnr, bh->nr, data);
+#ifdef USE_BHEAD_READ_ON_DEMAND
+        if (fd->mmap_file != NULL && UNLIKELY(BLI_mmap_has_error(fd->mmap_file))) {
+          fd->flags &= ~FD_FLAGS_FILE_OK;
+          MEM_SAFE_FREE(temp);
+        }
+#endif
       }
       else {
         /* SDNA_CMP_EQUAL */
@@ -4427,6 +4802,7 @@ static void direct_link_pointcache(FileData *fd, PointCache *cache)
   cache->free_edit = NULL;
   cache->cached_frames = NULL;
   cache->cached_frames_len = 0;
+  cache->frame_index = NULL;
 }
 
 static void direct_link_pointcache_list(FileData *fd,
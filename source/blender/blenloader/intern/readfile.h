@@ -76,6 +76,10 @@ typedef struct FileData {
   const char *buffer;
   /** Variables needed for reading from memfile (undo). */
   struct MemFile *memfile;
+  /** Variables needed for reading from memory mapped file. */
+  struct BLI_mmap_file *mmap_file;
+  /** Variables needed for reading from block compressed file, see #BLEND_GZIP_BLOCK_SIZE. */
+  struct FileDataGzipBlocks *gzip_blocks;
 
   /** Variables needed for reading from file. */
   gzFile gzfiledes;
@@ -124,6 +128,22 @@ typedef struct FileData {
 
 #define SIZEOFBLENDERHEADER 12
 
+/**
+ * Compressed files are written as a series of gzip members, each compressing
+ * #BLEND_GZIP_BLOCK_SIZE bytes of the file independently. The result is still a regular
+ * gzip file, but the blocks can be compressed and decompressed in parallel. The header of
+ * each member has an extra field storing the size of the member, so any part of the file
+ * can be found and decompressed without decompressing the blocks before it.
+ */
+#define BLEND_GZIP_BLOCK_SIZE (1 << 20)
+/** Gzip header (10 bytes) + extra field length (2 bytes) + size subfield (8 bytes). */
+#define BLEND_GZIP_BLOCK_HEADER_SIZE 20
+/** CRC32 + length of the uncompressed data. */
+#define BLEND_GZIP_BLOCK_TRAILER_SIZE 8
+/** Identifier of the extra subfield storing the size of the member. */
+#define BLEND_GZIP_BLOCK_SI1 'B'
+#define BLEND_GZIP_BLOCK_SI2 'L'
+
 /***/
 struct Main;
 void blo_join_main(ListBase *mainlist);
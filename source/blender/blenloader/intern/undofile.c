@@ -41,6 +41,9 @@
 #include "DNA_listBase.h"
 
 #include "BLI_blenlib.h"
+#include "BLI_ghash.h"
+#include "BLI_hash_mm2a.h"
+#include "BLI_threads.h"
 
 #include "BLO_undofile.h"
 #include "BLO_readfile.h"
@@ -52,44 +55,65 @@
 
 /* **************** support for memory-write, for undo buffers *************** */
 
+/**
+ * Chunk buffers are stored once for all the memfiles, indexed by a hash of their content.
+ * Identical chunks share their buffer even when data was inserted or resized before them
+ * (which shifts all the following chunks), or when they come from an older undo step.
+ */
+typedef struct MemFileBuffer {
+  /** Key of #memfile_buffers, along with the data. */
+  uint hash;
+  uint size;
+  const char *data;
+  /** Number of chunks using the buffer. */
+  int users;
+} MemFileBuffer;
+
+static GSet *memfile_buffers = NULL;
+static ThreadMutex memfile_buffers_mutex = BLI_MUTEX_INITIALIZER;
+
+static uint memfile_buffer_hash(const void *key)
+{
+  return ((const MemFileBuffer *)key)->hash;
+}
+
+static bool memfile_buffer_cmp(const void *a, const void *b)
+{
+  const MemFileBuffer *buffer_a = a;
+  const MemFileBuffer *buffer_b = b;
+  return (buffer_a->hash != buffer_b->hash) || (buffer_a->size != buffer_b->size) ||
+         (memcmp(buffer_a->data, buffer_b->data, buffer_a->size) != 0);
+}
+
 /* not memfile itself */
 void BLO_memfile_free(MemFile *memfile)
 {
   MemFileChunk *chunk;
 
+  BLI_mutex_lock(&memfile_buffers_mutex);
+
   while ((chunk = BLI_pophead(&memfile->chunks))) {
-    if (chunk->is_identical == false) {
-      MEM_freeN((void *)chunk->buf);
+    MemFileBuffer *buffer = chunk->buffer;
+    if (--buffer->users == 0) {
+      BLI_gset_remove(memfile_buffers, buffer, MEM_freeN);
     }
     MEM_freeN(chunk);
   }
   memfile->size = 0;
-}
 
-/* to keep list of memfiles consistent, 'first' is always first in list */
-/* result is that 'first' is being freed */
-void BLO_memfile_merge(MemFile *first, MemFile *second)
-{
-  MemFileChunk *fc, *sc;
-
-  fc = first->chunks.first;
-  sc = second->chunks.first;
-  while (fc || sc) {
-    if (fc && sc) {
-      if (sc->is_identical) {
-        sc->is_identical = false;
-        fc->is_identical = true;
-      }
-    }
-    if (fc) {
-      fc = fc->next;
-    }
-    if (sc) {
-      sc = sc->next;
-    }
+  if (memfile_buffers && BLI_gset_len(memfile_buffers) == 0) {
+    BLI_gset_free(memfile_buffers, NULL);
+    memfile_buffers = NULL;
   }
 
-  BLO_memfile_free(first);
+  BLI_mutex_unlock(&memfile_buffers_mutex);
+}
+
+static void memfile_chunk_use_buffer(MemFileChunk *chunk, MemFileBuffer *buffer)
+{
+  buffer->users++;
+  chunk->buffer = buffer;
+  chunk->buf = buffer->data;
 }
 
 void memfile_chunk_add(MemFile *memfile, const char *buf, uint size, MemFileChunk **compchunk_step)
@@ -97,28 +121,49 @@ void memfile_chunk_add(MemFile *memfile, const char *buf, uint size, MemFileChun
   MemFileChunk *curchunk = MEM_mallocN(sizeof(MemFileChunk), "MemFileChunk");
   curchunk->size = size;
   curchunk->buf = NULL;
-  curchunk->is_identical = false;
+  curchunk->buffer = NULL;
   BLI_addtail(&memfile->chunks, curchunk);
 
-  /* we compare compchunk with buf */
+  BLI_mutex_lock(&memfile_buffers_mutex);
+
+  /* Most chunks didn't change since the previous step, compare with the chunk at the same
+   * position first, which avoids hashing the data. */
   if (*compchunk_step != NULL) {
     MemFileChunk *compchunk = *compchunk_step;
     if (compchunk->size == curchunk->size) {
       if (memcmp(compchunk->buf, buf, size) == 0) {
-        curchunk->buf = compchunk->buf;
-        curchunk->is_identical = true;
+        memfile_chunk_use_buffer(curchunk, compchunk->buffer);
       }
     }
     *compchunk_step = compchunk->next;
   }
 
-  /* not equal... */
-  if (curchunk->buf == NULL) {
-    char *buf_new = MEM_mallocN(size, "Chunk buffer");
-    memcpy(buf_new, buf, size);
-    curchunk->buf = buf_new;
-    memfile->size += size;
+  if (curchunk->buffer == NULL) {
+    if (memfile_buffers == NULL) {
+      memfile_buffers = BLI_gset_new(memfile_buffer_hash, memfile_buffer_cmp, __func__);
+    }
+
+    /* Look the data up in the buffers of all memfiles, a new buffer replaces the key. */
+    MemFileBuffer key = {BLI_hash_mm2((const uchar *)buf, size, 0), size, buf, 0};
+    void **buffer_p;
+    if (BLI_gset_ensure_p_ex(memfile_buffers, &key, &buffer_p)) {
+      memfile_chunk_use_buffer(curchunk, *buffer_p);
+    }
+    else {
+      MemFileBuffer *buffer = MEM_mallocN(sizeof(MemFileBuffer) + size, "Chunk buffer");
+      char *data = (char *)(buffer + 1);
+      memcpy(data, buf, size);
+      buffer->hash = key.hash;
+      buffer->size = size;
+      buffer->data = data;
+      buffer->users = 0;
+      *buffer_p = buffer;
+      memfile_chunk_use_buffer(curchunk, buffer);
+      memfile->size += size;
+    }
   }
+
+  BLI_mutex_unlock(&memfile_buffers_mutex);
 }
 
 struct Main *BLO_memfile_main_get(struct MemFile *memfile,
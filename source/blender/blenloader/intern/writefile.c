@@ -150,6 +150,8 @@
 #include "BLI_bitmap.h"
 #include "BLI_blenlib.h"
 #include "BLI_mempool.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
 
 #include "BKE_action.h"
 #include "BKE_blender_version.h"
@@ -220,7 +222,7 @@ struct WriteWrap {
   /* internal */
   union {
     int file_handle;
-    gzFile gz_handle;
+    struct WriteWrapZlib *zlib_handle;
   } _user_data;
 };
 
@@ -251,17 +253,142 @@ static size_t ww_write_none(WriteWrap *ww, const char *buf, size_t buf_len)
 }
 #undef FILE_HANDLE
 
-/* zlib */
-#define FILE_HANDLE(ww) (ww)->_user_data.gz_handle
+/* zlib, the file is split in blocks compressed in parallel, see #BLEND_GZIP_BLOCK_SIZE. */
+
+typedef struct WriteWrapZlibBlock {
+  uchar *data_in;
+  uint data_in_len;
+  /** Complete gzip member, allocated for the worst case. */
+  uchar *data_out;
+  uint data_out_len;
+} WriteWrapZlibBlock;
+
+typedef struct WriteWrapZlib {
+  int file_handle;
+  /** Blocks compressed together, blocks before #WriteWrapZlib.blocks_used are full. */
+  WriteWrapZlibBlock *blocks;
+  int blocks_len;
+  int blocks_used;
+  bool error;
+} WriteWrapZlib;
+
+#define FILE_HANDLE(ww) (ww)->_user_data.zlib_handle
+
+static void ww_zlib_write_uint16(uchar *dst, uint value)
+{
+  dst[0] = (uchar)(value & 0xff);
+  dst[1] = (uchar)((value >> 8) & 0xff);
+}
+
+static void ww_zlib_write_uint32(uchar *dst, uint value)
+{
+  ww_zlib_write_uint16(dst, value & 0xffff);
+  ww_zlib_write_uint16(dst + 2, value >> 16);
+}
+
+static void ww_zlib_block_compress(void *__restrict userdata,
+                                   const int iter,
+                                   const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  WriteWrapZlibBlock *block = &((WriteWrapZlib *)userdata)->blocks[iter];
+  const uint data_out_len_max = BLEND_GZIP_BLOCK_HEADER_SIZE + compressBound(BLEND_GZIP_BLOCK_SIZE) +
+                                BLEND_GZIP_BLOCK_TRAILER_SIZE;
+  uchar *header = block->data_out;
+  z_stream strm;
+  int ret;
+
+  block->data_out_len = 0;
+
+  memset(&strm, 0, sizeof(strm));
+  /* Raw deflate, the gzip header and trailer are written here (same level as 'wb1'). */
+  if (deflateInit2(&strm, 1, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+    return;
+  }
+  strm.next_in = block->data_in;
+  strm.avail_in = block->data_in_len;
+  strm.next_out = block->data_out + BLEND_GZIP_BLOCK_HEADER_SIZE;
+  strm.avail_out = data_out_len_max - BLEND_GZIP_BLOCK_HEADER_SIZE - BLEND_GZIP_BLOCK_TRAILER_SIZE;
+  ret = deflate(&strm, Z_FINISH);
+  deflateEnd(&strm);
+
+  if (ret != Z_STREAM_END) {
+    return;
+  }
+
+  const uint member_len = BLEND_GZIP_BLOCK_HEADER_SIZE + (uint)strm.total_out +
+                          BLEND_GZIP_BLOCK_TRAILER_SIZE;
+
+  /* Magic, deflate method, FEXTRA flag, no time stamp, unknown OS. */
+  header[0] = 0x1f;
+  header[1] = 0x8b;
+  header[2] = Z_DEFLATED;
+  header[3] = 4;
+  ww_zlib_write_uint32(header + 4, 0);
+  header[8] = 0;
+  header[9] = 255;
+  /* Extra field, with the size of the whole member. */
+  ww_zlib_write_uint16(header + 10, 8);
+  header[12] = BLEND_GZIP_BLOCK_SI1;
+  header[13] = BLEND_GZIP_BLOCK_SI2;
+  ww_zlib_write_uint16(header + 14, 4);
+  ww_zlib_write_uint32(header + 16, member_len);
+
+  uchar *trailer = block->data_out + member_len - BLEND_GZIP_BLOCK_TRAILER_SIZE;
+  ww_zlib_write_uint32(trailer, (uint)crc32(0, block->data_in, block->data_in_len));
+  ww_zlib_write_uint32(trailer + 4, block->data_in_len);
+
+  block->data_out_len = member_len;
+}
+
+/* Compress the blocks in parallel and write them in order. */
+static void ww_zlib_flush(WriteWrapZlib *wwz, const int blocks_len)
+{
+  if (blocks_len == 0) {
+    return;
+  }
+
+  for (int i = 0; i < blocks_len; i++) {
+    WriteWrapZlibBlock *block = &wwz->blocks[i];
+    if (block->data_out == NULL) {
+      block->data_out = MEM_mallocN(BLEND_GZIP_BLOCK_HEADER_SIZE +
+                                        compressBound(BLEND_GZIP_BLOCK_SIZE) +
+                                        BLEND_GZIP_BLOCK_TRAILER_SIZE,
+                                    __func__);
+    }
+  }
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (blocks_len > 1);
+  settings.scheduling_mode = TASK_SCHEDULING_DYNAMIC;
+  settings.min_iter_per_thread = 1;
+  BLI_task_parallel_range(0, blocks_len, wwz, ww_zlib_block_compress, &settings);
+
+  for (int i = 0; i < blocks_len; i++) {
+    WriteWrapZlibBlock *block = &wwz->blocks[i];
+    if (block->data_out_len == 0 ||
+        write(wwz->file_handle, block->data_out, block->data_out_len) !=
+            (ssize_t)block->data_out_len) {
+      wwz->error = true;
+    }
+    block->data_in_len = 0;
+  }
+  wwz->blocks_used = 0;
+}
 
 static bool ww_open_zlib(WriteWrap *ww, const char *filepath)
 {
-  gzFile file;
+  int file;
 
-  file = BLI_gzopen(filepath, "wb1");
+  file = BLI_open(filepath, O_BINARY + O_WRONLY + O_CREAT + O_TRUNC, 0666);
 
-  if (file != Z_NULL) {
-    FILE_HANDLE(ww) = file;
+  if (file != -1) {
+    WriteWrapZlib *wwz = MEM_callocN(sizeof(*wwz), __func__);
+    wwz->file_handle = file;
+    /* Enough blocks to keep all threads busy, buffers are allocated on first use. */
+    wwz->blocks_len = MIN2(MAX2(BLI_system_thread_count() * 2, 2), 64);
+    wwz->blocks = MEM_callocN(sizeof(*wwz->blocks) * wwz->blocks_len, __func__);
+    FILE_HANDLE(ww) = wwz;
     return true;
   }
   else {
@@ -270,11 +397,47 @@ static bool ww_open_zlib(WriteWrap *ww, const char *filepath)
 }
 static bool ww_close_zlib(WriteWrap *ww)
 {
-  return (gzclose(FILE_HANDLE(ww)) == Z_OK);
+  WriteWrapZlib *wwz = FILE_HANDLE(ww);
+
+  if (!wwz->error) {
+    ww_zlib_flush(wwz, wwz->blocks_used + (wwz->blocks[wwz->blocks_used].data_in_len != 0));
+  }
+
+  for (int i = 0; i < wwz->blocks_len; i++) {
+    MEM_SAFE_FREE(wwz->blocks[i].data_in);
+    MEM_SAFE_FREE(wwz->blocks[i].data_out);
+  }
+  MEM_freeN(wwz->blocks);
+
+  const bool ok = (close(wwz->file_handle) != -1) && !wwz->error;
+  MEM_freeN(wwz);
+  return ok;
 }
 static size_t ww_write_zlib(WriteWrap *ww, const char *buf, size_t buf_len)
 {
-  return gzwrite(FILE_HANDLE(ww), buf, buf_len);
+  WriteWrapZlib *wwz = FILE_HANDLE(ww);
+  size_t written = 0;
+
+  while (written < buf_len && !wwz->error) {
+    WriteWrapZlibBlock *block = &wwz->blocks[wwz->blocks_used];
+    if (block->data_in == NULL) {
+      block->data_in = MEM_mallocN(BLEND_GZIP_BLOCK_SIZE, __func__);
+    }
+
+    const uint len = (uint)MIN2(buf_len - written, BLEND_GZIP_BLOCK_SIZE - block->data_in_len);
+    memcpy(block->data_in + block->data_in_len, buf + written, len);
+    block->data_in_len += len;
+    written += len;
+
+    if (block->data_in_len == BLEND_GZIP_BLOCK_SIZE) {
+      wwz->blocks_used++;
+      if (wwz->blocks_used == wwz->blocks_len) {
+        ww_zlib_flush(wwz, wwz->blocks_used);
+      }
+    }
+  }
+
+  return wwz->error ? 0 : written;
 }
 #undef FILE_HANDLE
 
@@ -4344,9 +4507,12 @@ bool BLO_write_file(Main *mainvar,
   }
 
   /* actual file writing */
-  const bool err = write_file_handle(mainvar, &ww, NULL, NULL, write_flags, thumb);
+  bool err = write_file_handle(mainvar, &ww, NULL, NULL, write_flags, thumb);
 
-  ww.close(&ww);
+  /* Closing may still write data (compressed blocks). */
+  if (ww.close(&ww) == false) {
+    err = true;
+  }
 
   if (UNLIKELY(path_list_backup)) {
     BKE_bpath_list_restore(mainvar, path_list_flag, path_list_backup);
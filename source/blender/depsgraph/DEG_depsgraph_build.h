@@ -93,6 +93,17 @@ void DEG_graph_relations_update(struct Depsgraph *graph,
 /* Tag all relations in the database for update.*/
 void DEG_relations_tag_update(struct Main *bmain);
 
+/* Inform all dependency graphs that an ID was added to or is about to be removed from the
+ * database. Unlike DEG_relations_tag_update() this allows the relations update to only insert
+ * or remove the nodes of the given ID instead of rebuilding the whole graph. IDs which can not
+ * be handled this way cause a full rebuild on the next relations update.
+ *
+ * The ID must be already linked to the scene when it's added (bases are synchronized), and is
+ * expected to be unlinked from the scene when it's removed. The removed ID can be freed right
+ * after this call. */
+void DEG_relations_tag_id_added(struct Main *bmain, struct ID *id);
+void DEG_relations_tag_id_removed(struct Main *bmain, struct ID *id);
+
 /* Add Dependencies  ----------------------------- */
 
 /* Handle for components to define their dependencies from callbacks.
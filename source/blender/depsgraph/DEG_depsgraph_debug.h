@@ -53,6 +53,11 @@ void DEG_stats_simple(const struct Depsgraph *graph,
                       size_t *r_operations,
                       size_t *r_relations);
 
+/* Number of times the relations were fully built and incrementally updated. */
+void DEG_stats_builds(const struct Depsgraph *graph,
+                      int *r_full_builds,
+                      int *r_incremental_updates);
+
 /* ************************************************ */
 /* Diagram-Based Graph Debugging */
 
@@ -206,6 +206,29 @@ void deg_graph_build_flush_visibility(Depsgraph *graph)
   BLI_stack_free(stack);
 }
 
+/* Recalc flags needed by an ID node after the relations were (re)built. */
+int deg_graph_build_id_node_recalc_flag(IDNode *id_node)
+{
+  int flag = 0;
+  /* Tag rebuild if special evaluation flags changed. */
+  if (id_node->eval_flags != id_node->previous_eval_flags) {
+    flag |= ID_RECALC_TRANSFORM | ID_RECALC_GEOMETRY;
+  }
+  /* Tag rebuild if the custom data mask changed. */
+  if (id_node->customdata_masks != id_node->previous_customdata_masks) {
+    flag |= ID_RECALC_GEOMETRY;
+  }
+  if (!deg_copy_on_write_is_expanded(id_node->id_cow)) {
+    flag |= ID_RECALC_COPY_ON_WRITE;
+    /* This means ID is being added to the dependency graph first
+     * time, which is similar to "ob-visible-change" */
+    if (GS(id_node->id_orig->name) == ID_OB) {
+      flag |= ID_RECALC_TRANSFORM | ID_RECALC_GEOMETRY;
+    }
+  }
+  return flag;
+}
+
 }  // namespace
 
 void deg_graph_build_finalize(Main *bmain, Depsgraph *graph)
@@ -215,28 +238,42 @@ void deg_graph_build_finalize(Main *bmain, Depsgraph *graph)
   /* Re-tag IDs for update if it was tagged before the relations
    * update tag. */
   for (IDNode *id_node : graph->id_nodes) {
-    ID *id_orig = id_node->id_orig;
     id_node->finalize_build(graph);
-    int flag = 0;
-    /* Tag rebuild if special evaluation flags changed. */
-    if (id_node->eval_flags != id_node->previous_eval_flags) {
-      flag |= ID_RECALC_TRANSFORM | ID_RECALC_GEOMETRY;
+    int flag = deg_graph_build_id_node_recalc_flag(id_node);
+    /* Restore recalc flags from original ID, which could possibly contain recalc flags set by
+     * an operator and then were carried on by the undo system. */
+    flag |= id_node->id_orig->recalc;
+    if (flag != 0) {
+      graph_id_tag_update(bmain, graph, id_node->id_orig, flag, DEG_UPDATE_SOURCE_RELATIONS);
     }
-    /* Tag rebuild if the custom data mask changed. */
-    if (id_node->customdata_masks != id_node->previous_customdata_masks) {
-      flag |= ID_RECALC_GEOMETRY;
+  }
+}
+
+void deg_graph_build_finalize_incremental(Main *bmain,
+                                          Depsgraph *graph,
+                                          const int num_finalized_id_nodes)
+{
+  deg_graph_build_flush_visibility(graph);
+  const int num_id_nodes = graph->id_nodes.size();
+  for (int i = 0; i < num_id_nodes; i++) {
+    IDNode *id_node = graph->id_nodes[i];
+    int flag;
+    if (i >= num_finalized_id_nodes) {
+      id_node->finalize_build(graph);
+      flag = deg_graph_build_id_node_recalc_flag(id_node) | id_node->id_orig->recalc;
     }
-    if (!deg_copy_on_write_is_expanded(id_node->id_cow)) {
-      flag |= ID_RECALC_COPY_ON_WRITE;
-      /* This means ID is being added to the dependency graph first
-       * time, which is similar to "ob-visible-change" */
-      if (GS(id_orig->name) == ID_OB) {
-        flag |= ID_RECALC_TRANSFORM | ID_RECALC_GEOMETRY;
+    else {
+      /* Existing nodes are already finalized, except for components added to them while
+       * building the new nodes. Their own recalc flags are still scheduled in the graph. */
+      GHASH_FOREACH_BEGIN (ComponentNode *, comp_node, id_node->components) {
+        if (comp_node->operations_map != nullptr) {
+          comp_node->finalize_build(graph);
+        }
       }
+      GHASH_FOREACH_END();
+      id_node->visible_components_mask = id_node->get_visible_components_mask();
+      flag = deg_graph_build_id_node_recalc_flag(id_node);
     }
-    /* Restore recalc flags from original ID, which could possibly contain recalc flags set by
-     * an operator and then were carried on by the undo system. */
-    flag |= id_orig->recalc;
     if (flag != 0) {
       graph_id_tag_update(bmain, graph, id_node->id_orig, flag, DEG_UPDATE_SOURCE_RELATIONS);
     }
@@ -58,4 +58,12 @@ bool deg_check_id_in_depsgraph(const Depsgraph *graph, ID *id_orig);
 bool deg_check_base_in_depsgraph(const Depsgraph *graph, Base *base);
 void deg_graph_build_finalize(Main *bmain, Depsgraph *graph);
 
+/* Finalize the graph after nodes were added to an already finalized graph, the new ID nodes are
+ * the ones following the first num_finalized_id_nodes. The previous evaluation flags and custom
+ * data masks of the finalized ID nodes are expected to be set to their values prior to the
+ * update. */
+void deg_graph_build_finalize_incremental(Main *bmain,
+                                          Depsgraph *graph,
+                                          const int num_finalized_id_nodes);
+
 }  // namespace DEG
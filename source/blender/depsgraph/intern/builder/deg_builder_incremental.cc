@@ -0,0 +1,332 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 Blender Foundation.
+ * All rights reserved.
+ */
+
+/** \file
+ * \ingroup depsgraph
+ *
+ * Incremental update of the graph when IDs are added to or removed from the database.
+ *
+ * Only objects are inserted. Objects which take part of relations which are not stored in
+ * the graph nodes (cached physics relations, instancing) can not be handled this way, as well
+ * as set scenes and the render pipeline graphs. The whole graph is rebuilt in these cases.
+ */
+
+#include "intern/builder/deg_builder_incremental.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_ghash.h"
+#include "BLI_listbase.h"
+#include "BLI_utildefines.h"
+
+extern "C" {
+#include "DNA_anim_types.h"
+#include "DNA_collection_types.h"
+#include "DNA_layer_types.h"
+#include "DNA_modifier_types.h"
+#include "DNA_object_force_types.h"
+#include "DNA_object_types.h"
+#include "DNA_particle_types.h"
+#include "DNA_scene_types.h"
+
+#include "BKE_collection.h"
+#include "BKE_object.h"
+} /* extern "C" */
+
+#include "DEG_depsgraph.h"
+
+#include "intern/builder/deg_builder.h"
+#include "intern/builder/deg_builder_cache.h"
+#include "intern/builder/deg_builder_cycle.h"
+#include "intern/builder/deg_builder_nodes.h"
+#include "intern/builder/deg_builder_relations.h"
+#include "intern/builder/deg_builder_remove_noop.h"
+
+#include "intern/node/deg_node.h"
+#include "intern/node/deg_node_component.h"
+#include "intern/node/deg_node_id.h"
+#include "intern/node/deg_node_operation.h"
+
+#include "intern/depsgraph.h"
+#include "intern/depsgraph_physics.h"
+#include "intern/depsgraph_relation.h"
+#include "intern/depsgraph_type.h"
+
+namespace DEG {
+
+namespace {
+
+class DepsgraphIncrementalNodeBuilder : public DepsgraphNodeBuilder {
+ public:
+  DepsgraphIncrementalNodeBuilder(Main *bmain, Depsgraph *graph, DepsgraphBuilderCache *cache)
+      : DepsgraphNodeBuilder(bmain, graph, cache)
+  {
+    scene_ = graph->scene;
+    view_layer_ = graph->view_layer;
+    /* NOTE: Same as build_view_layer(), there is only one view layer in the scene CoW. */
+    view_layer_index_ = 0;
+  }
+
+  /* Unlike for the full build, nodes of the graph are kept and are considered built. There are
+   * no copy-on-write datablocks to re-use either. */
+  virtual void begin_build() override
+  {
+    id_info_hash_ = BLI_ghash_ptr_new("Depsgraph id hash");
+    for (IDNode *id_node : graph_->id_nodes) {
+      built_map_.tagBuild(id_node->id_orig);
+    }
+  }
+
+  void build_base(int base_index, Base *base)
+  {
+    build_object(base_index, base->object, DEG_ID_LINKED_DIRECTLY, true);
+  }
+
+  /* Base indices of the objects shift when bases are added or removed, update them in the base
+   * flags operations. */
+  bool update_base_flags()
+  {
+    Scene *scene_cow = get_cow_datablock(scene_);
+    int base_index = 0;
+    LISTBASE_FOREACH (Base *, base, &view_layer_->object_bases) {
+      if (!need_pull_base_into_graph(base)) {
+        continue;
+      }
+      IDNode *id_node = find_id_node(&base->object->id);
+      if (id_node == nullptr) {
+        return false;
+      }
+      ComponentNode *comp_node = id_node->find_component(NodeType::OBJECT_FROM_LAYER);
+      OperationNode *op_node = (comp_node != nullptr) ?
+                                   comp_node->find_operation(
+                                       OperationCode::OBJECT_BASE_FLAGS, "", -1) :
+                                   nullptr;
+      if (op_node == nullptr) {
+        return false;
+      }
+      Object *object_cow = reinterpret_cast<Object *>(id_node->id_cow);
+      op_node->evaluate = function_bind(BKE_object_eval_eval_base_flags,
+                                        _1,
+                                        scene_cow,
+                                        view_layer_index_,
+                                        object_cow,
+                                        base_index,
+                                        false);
+      base_index++;
+    }
+    return true;
+  }
+};
+
+class DepsgraphIncrementalRelationBuilder : public DepsgraphRelationBuilder {
+ public:
+  DepsgraphIncrementalRelationBuilder(Main *bmain,
+                                      Depsgraph *graph,
+                                      DepsgraphBuilderCache *cache,
+                                      const int num_finalized_id_nodes)
+      : DepsgraphRelationBuilder(bmain, graph, cache),
+        num_finalized_id_nodes_(num_finalized_id_nodes)
+  {
+    scene_ = graph->scene;
+    /* Relations of the finalized nodes are already built. */
+    for (int i = 0; i < num_finalized_id_nodes; i++) {
+      built_map_.tagBuild(graph->id_nodes[i]->id_orig);
+    }
+  }
+
+  void build_base(Base *base)
+  {
+    build_object(base, base->object);
+  }
+
+  void build_new_id_nodes()
+  {
+    const int num_id_nodes = graph_->id_nodes.size();
+    for (int i = num_finalized_id_nodes_; i < num_id_nodes; i++) {
+      build_copy_on_write_relations(graph_->id_nodes[i]);
+      build_driver_relations(graph_->id_nodes[i]);
+    }
+  }
+
+ protected:
+  int num_finalized_id_nodes_;
+};
+
+/* Check whether relations of the object are stored outside of its nodes, or whether building
+ * it might add operations to existing nodes. */
+bool object_needs_full_rebuild(Object *object)
+{
+  if (object->rigidbody_object != nullptr || object->rigidbody_constraint != nullptr) {
+    return true;
+  }
+  if (object->pd != nullptr && object->pd->forcefield != PFIELD_NULL) {
+    return true;
+  }
+  LISTBASE_FOREACH (ModifierData *, md, &object->modifiers) {
+    if (ELEM(md->type, eModifierType_Collision, eModifierType_Fluid, eModifierType_DynamicPaint)) {
+      return true;
+    }
+  }
+  if (object->instance_collection != nullptr || object->particlesystem.first != nullptr) {
+    return true;
+  }
+  /* Drivers add property operations to the nodes of their targets. */
+  if (object->adt != nullptr && object->adt->drivers.first != nullptr) {
+    return true;
+  }
+  return false;
+}
+
+/* Check whether the object is instanced by one of the objects of the graph, the instancer
+ * has relations from all the instanced objects. */
+bool object_is_instanced(const Depsgraph *graph, Object *object)
+{
+  for (IDNode *id_node : graph->id_nodes) {
+    if (GS(id_node->id_orig->name) != ID_OB) {
+      continue;
+    }
+    Object *instancer = reinterpret_cast<Object *>(id_node->id_orig);
+    if (instancer->instance_collection != nullptr &&
+        BKE_collection_has_object_recursive(instancer->instance_collection, object)) {
+      return true;
+    }
+    LISTBASE_FOREACH (ParticleSystem *, psys, &instancer->particlesystem) {
+      ParticleSettings *part = psys->part;
+      if (part->instance_object == object) {
+        return true;
+      }
+      if (part->instance_collection != nullptr &&
+          BKE_collection_has_object(part->instance_collection, object)) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+/* Check whether the ID node can be removed without affecting the evaluation of other IDs.
+ * Only the pointer of the original ID is used, it might be freed already. */
+bool id_node_can_be_removed(const Depsgraph *graph, IDNode *id_node)
+{
+  bool can_be_removed = true;
+  GHASH_FOREACH_BEGIN (ComponentNode *, comp_node, id_node->components) {
+    for (OperationNode *op_node : comp_node->operations) {
+      for (Relation *rel : op_node->outlinks) {
+        OperationNode *op_to = reinterpret_cast<OperationNode *>(rel->to);
+        if (op_to->owner->owner != id_node) {
+          can_be_removed = false;
+        }
+      }
+    }
+  }
+  GHASH_FOREACH_END();
+  if (!can_be_removed) {
+    return false;
+  }
+  /* Name of the node is the name of the ID, which gives its type. */
+  if (GS(id_node->name.c_str()) == ID_OB &&
+      physics_relations_has_object(graph, reinterpret_cast<Object *>(id_node->id_orig))) {
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+bool deg_graph_build_incremental(Main *bmain, Depsgraph *graph)
+{
+  if (graph->is_render_pipeline_depsgraph || graph->scene->set != nullptr) {
+    return false;
+  }
+  DepsgraphBuilderCache builder_cache;
+  DepsgraphIncrementalNodeBuilder node_builder(bmain, graph, &builder_cache);
+  bool bases_changed = false;
+  /* Removed IDs first. A removal is never pending after the addition of the same ID since it
+   * cancels it, so an addition after a removal is a new ID allocated at the same address. */
+  set<ID *> added_ids;
+  for (const Depsgraph::PendingIDUpdate &update : graph->pending_id_updates) {
+    if (!update.is_removed) {
+      added_ids.insert(update.id);
+      continue;
+    }
+    IDNode *id_node = graph->find_id_node(update.id);
+    if (id_node == nullptr) {
+      continue;
+    }
+    if (!id_node_can_be_removed(graph, id_node)) {
+      return false;
+    }
+    bases_changed |= id_node->has_base;
+    graph->remove_id_node(id_node);
+  }
+  if (!added_ids.empty()) {
+    for (ID *id : added_ids) {
+      if (GS(id->name) != ID_OB || graph->find_id_node(id) != nullptr) {
+        return false;
+      }
+      Object *object = reinterpret_cast<Object *>(id);
+      if (object_needs_full_rebuild(object) || object_is_instanced(graph, object)) {
+        return false;
+      }
+    }
+    /* Flags and masks of the existing nodes are only compared to the ones added by the new
+     * relations. */
+    const int num_finalized_id_nodes = graph->id_nodes.size();
+    for (IDNode *id_node : graph->id_nodes) {
+      id_node->previous_eval_flags = id_node->eval_flags;
+      id_node->previous_customdata_masks = id_node->customdata_masks;
+    }
+    /* Generate nodes of the new objects, in the order of their bases. */
+    vector<Base *> added_bases;
+    node_builder.begin_build();
+    int base_index = 0;
+    LISTBASE_FOREACH (Base *, base, &graph->view_layer->object_bases) {
+      if (!node_builder.need_pull_base_into_graph(base)) {
+        continue;
+      }
+      if (added_ids.find(&base->object->id) != added_ids.end()) {
+        node_builder.build_base(base_index, base);
+        added_bases.push_back(base);
+      }
+      base_index++;
+    }
+    node_builder.end_build();
+    bases_changed |= !added_bases.empty();
+    /* Hook up their relationships. */
+    DepsgraphIncrementalRelationBuilder relation_builder(
+        bmain, graph, &builder_cache, num_finalized_id_nodes);
+    for (Base *base : added_bases) {
+      relation_builder.build_base(base);
+    }
+    relation_builder.build_new_id_nodes();
+    /* Same as graph_build_finalize_common(), only the new nodes are tagged for update. */
+    deg_graph_detect_cycles(graph);
+    deg_graph_remove_unused_noops(graph);
+    deg_graph_build_finalize_incremental(bmain, graph, num_finalized_id_nodes);
+    DEG_graph_on_visible_update(bmain, reinterpret_cast<::Depsgraph *>(graph), false);
+  }
+  if (bases_changed && !node_builder.update_base_flags()) {
+    return false;
+  }
+  graph->pending_id_updates.clear();
+  graph->debug.num_incremental_updates++;
+  return true;
+}
+
+}  // namespace DEG
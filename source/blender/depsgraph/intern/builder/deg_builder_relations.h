@@ -358,6 +358,7 @@ class DepsgraphRelationBuilder : public DepsgraphBuilder {
 
   static void constraint_walk(bConstraint *con, ID **idpoin, bool is_reference, void *user_data);
 
+ protected:
   /* State which demotes currently built entities. */
   Scene *scene_;
 
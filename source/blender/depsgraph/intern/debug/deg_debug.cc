@@ -35,7 +35,11 @@
 namespace DEG {
 
 DepsgraphDebug::DepsgraphDebug()
-    : flags(G.debug), is_ever_evaluated(false), graph_evaluation_start_time_(0)
+    : flags(G.debug),
+      is_ever_evaluated(false),
+      num_full_builds(0),
+      num_incremental_updates(0),
+      graph_evaluation_start_time_(0)
 {
 }
 
@@ -52,6 +52,11 @@ class DepsgraphDebug {
    * This is NOT an indication that depsgraph is at its evaluated state. */
   bool is_ever_evaluated;
 
+  /* Number of times the relations were built from scratch, and updated incrementally for added
+   * or removed IDs. */
+  int num_full_builds;
+  int num_incremental_updates;
+
  protected:
   /* Maximum number of counters used to calculate frame rate of depsgraph update. */
   static const constexpr int MAX_FPS_COUNTERS = 64;
@@ -140,6 +140,40 @@ IDNode *Depsgraph::add_id_node(ID *id, ID *id_cow_hint)
   return id_node;
 }
 
+void Depsgraph::remove_id_node(IDNode *id_node)
+{
+  /* Free all relations coming to the operations of this ID. Relations within the ID are freed
+   * here as well, since they are incoming relations of one of its operations. */
+  GHASH_FOREACH_BEGIN (ComponentNode *, comp_node, id_node->components) {
+    for (OperationNode *op_node : comp_node->operations) {
+      BLI_assert(std::all_of(op_node->outlinks.begin(),
+                             op_node->outlinks.end(),
+                             [id_node](Relation *rel) {
+                               return rel->to->type == NodeType::OPERATION &&
+                                      ((OperationNode *)rel->to)->owner->owner == id_node;
+                             }));
+      while (!op_node->inlinks.empty()) {
+        Relation *rel = op_node->inlinks[0];
+        rel->unlink();
+        OBJECT_GUARDED_DELETE(rel, Relation);
+      }
+      BLI_gset_remove(entry_tags, op_node, nullptr);
+    }
+  }
+  GHASH_FOREACH_END();
+  operations.erase(std::remove_if(operations.begin(),
+                                  operations.end(),
+                                  [id_node](OperationNode *op_node) {
+                                    return op_node->owner->owner == id_node;
+                                  }),
+                   operations.end());
+  /* Unregister and free the node. */
+  BLI_ghash_remove(id_hash, id_node->id_orig, nullptr, nullptr);
+  remove_from_vector(&id_nodes, id_node);
+  id_node->destroy();
+  OBJECT_GUARDED_DELETE(id_node, IDNode);
+}
+
 void Depsgraph::clear_id_nodes_conditional(const std::function<bool(ID_Type id_type)> &filter)
 {
   for (IDNode *id_node : id_nodes) {
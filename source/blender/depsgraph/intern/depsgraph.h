@@ -71,6 +71,9 @@ struct Depsgraph {
 
   IDNode *find_id_node(const ID *id) const;
   IDNode *add_id_node(ID *id, ID *id_cow_hint = nullptr);
+  /* Remove ID node with all its components, operations and relations from the graph.
+   * Relations going to other IDs are not expected to exist. */
+  void remove_id_node(IDNode *id_node);
   void clear_id_nodes();
   void clear_id_nodes_conditional(const std::function<bool(ID_Type id_type)> &filter);
 
@@ -110,6 +113,15 @@ struct Depsgraph {
   /* Indicates whether relations needs to be updated. */
   bool need_update;
 
+  /* IDs added to or removed from the database since the last relations update, in the order
+   * of the changes. They are applied without rebuilding the whole graph when possible, and are
+   * ignored when the relations are fully rebuilt. */
+  struct PendingIDUpdate {
+    ID *id;
+    bool is_removed;
+  };
+  vector<PendingIDUpdate> pending_id_updates;
+
   /* Indicates which ID types were updated. */
   char id_type_updated[MAX_LIBARRAY];
 
@@ -48,6 +48,7 @@ extern "C" {
 #include "builder/deg_builder.h"
 #include "builder/deg_builder_cache.h"
 #include "builder/deg_builder_cycle.h"
+#include "builder/deg_builder_incremental.h"
 #include "builder/deg_builder_nodes.h"
 #include "builder/deg_builder_relations.h"
 #include "builder/deg_builder_remove_noop.h"
@@ -225,6 +226,8 @@ static void graph_build_finalize_common(DEG::Depsgraph *deg_graph, Main *bmain)
 #endif
   /* Relations are up to date. */
   deg_graph->need_update = false;
+  deg_graph->pending_id_updates.clear();
+  deg_graph->debug.num_full_builds++;
 }
 
 /* Build depsgraph for the given scene layer, and dump results in given graph container. */
@@ -495,8 +498,24 @@ void DEG_graph_relations_update(Depsgraph *graph, Main *bmain, Scene *scene, Vie
 {
   DEG::Depsgraph *deg_graph = (DEG::Depsgraph *)graph;
   if (!deg_graph->need_update) {
-    /* Graph is up to date, nothing to do. */
-    return;
+    if (deg_graph->pending_id_updates.empty()) {
+      /* Graph is up to date, nothing to do. */
+      return;
+    }
+    /* Only IDs were added or removed, try to update their nodes only. */
+    double start_time = 0.0;
+    if (G.debug & (G_DEBUG_DEPSGRAPH_BUILD | G_DEBUG_DEPSGRAPH_TIME)) {
+      start_time = PIL_check_seconds_timer();
+    }
+    const bool is_updated = DEG::deg_graph_build_incremental(bmain, deg_graph);
+    if (G.debug & (G_DEBUG_DEPSGRAPH_BUILD | G_DEBUG_DEPSGRAPH_TIME)) {
+      printf("Depsgraph %s in %f seconds.\n",
+             is_updated ? "updated" : "failed to update",
+             PIL_check_seconds_timer() - start_time);
+    }
+    if (is_updated) {
+      return;
+    }
   }
   DEG_graph_build_from_view_layer(graph, bmain, scene, view_layer);
 }
@@ -509,3 +528,47 @@ void DEG_relations_tag_update(Main *bmain)
     DEG_graph_tag_relations_update(reinterpret_cast<Depsgraph *>(depsgraph));
   }
 }
+
+/* Tag an ID as added or removed for the given graph. */
+static void deg_graph_tag_id_added_or_removed(DEG::Depsgraph *deg_graph,
+                                              ID *id,
+                                              const bool is_removed)
+{
+  if (deg_graph->need_update) {
+    /* Relations are fully rebuilt anyway. */
+    return;
+  }
+  DEG::vector<DEG::Depsgraph::PendingIDUpdate> &updates = deg_graph->pending_id_updates;
+  if (is_removed) {
+    /* Removing an ID which addition is still pending cancels it. */
+    for (auto it = updates.begin(); it != updates.end(); ++it) {
+      if (it->id == id && !it->is_removed) {
+        updates.erase(it);
+        return;
+      }
+    }
+  }
+  DEG::Depsgraph::PendingIDUpdate update = {id, is_removed};
+  updates.push_back(update);
+  /* Bases of the view layer changed, same as DEG_graph_tag_relations_update(). */
+  DEG::IDNode *id_node = deg_graph->find_id_node(&deg_graph->scene->id);
+  if (id_node != nullptr) {
+    id_node->tag_update(deg_graph, DEG::DEG_UPDATE_SOURCE_RELATIONS);
+  }
+}
+
+void DEG_relations_tag_id_added(Main *bmain, ID *id)
+{
+  DEG_GLOBAL_DEBUG_PRINTF(TAG, "%s: Tagging %s as added.\n", __func__, id->name);
+  for (DEG::Depsgraph *depsgraph : DEG::get_all_registered_graphs(bmain)) {
+    deg_graph_tag_id_added_or_removed(depsgraph, id, false);
+  }
+}
+
+void DEG_relations_tag_id_removed(Main *bmain, ID *id)
+{
+  DEG_GLOBAL_DEBUG_PRINTF(TAG, "%s: Tagging %s as removed.\n", __func__, id->name);
+  for (DEG::Depsgraph *depsgraph : DEG::get_all_registered_graphs(bmain)) {
+    deg_graph_tag_id_added_or_removed(depsgraph, id, true);
+  }
+}
@@ -25,6 +25,7 @@
 
 #include "BLI_utildefines.h"
 #include "BLI_ghash.h"
+#include "BLI_string.h"
 
 extern "C" {
 #include "DNA_scene_types.h"
@@ -43,6 +44,7 @@ extern "C" {
 #include "intern/debug/deg_debug.h"
 #include "intern/node/deg_node_component.h"
 #include "intern/node/deg_node_id.h"
+#include "intern/node/deg_node_operation.h"
 #include "intern/node/deg_node_time.h"
 
 void DEG_debug_flags_set(Depsgraph *depsgraph, int flags)
@@ -69,22 +71,73 @@ const char *DEG_debug_name_get(struct Depsgraph *depsgraph)
   return deg_graph->debug.name.c_str();
 }
 
+/* Key of a node which is the same in all graphs built from the same main database. */
+static DEG::string depsgraph_debug_node_key(const DEG::Node *node)
+{
+  if (node->type != DEG::NodeType::OPERATION) {
+    return DEG::string(DEG::nodeTypeAsString(node->type)) + " : " + node->name;
+  }
+  const DEG::OperationNode *op_node = (const DEG::OperationNode *)node;
+  const DEG::ComponentNode *comp_node = op_node->owner;
+  char id_ptr[24];
+  BLI_snprintf(id_ptr, sizeof(id_ptr), "%p", comp_node->owner->id_orig);
+  return DEG::string(id_ptr) + "/" + DEG::to_string(static_cast<int>(comp_node->type)) + "(" +
+         comp_node->name + ")/" + op_node->identifier() + "/" +
+         DEG::to_string(op_node->name_tag);
+}
+
+static DEG::string depsgraph_debug_relation_key(const DEG::Relation *rel)
+{
+  return depsgraph_debug_node_key(rel->from) + " -> " + depsgraph_debug_node_key(rel->to) +
+         " (" + rel->name + ")";
+}
+
+/* Sorted keys of the ID nodes, operations and relations of the graph. */
+static void depsgraph_debug_graph_keys(const DEG::Depsgraph *deg_graph,
+                                       DEG::vector<const ID *> *r_ids,
+                                       DEG::vector<DEG::string> *r_operations,
+                                       DEG::vector<DEG::string> *r_relations)
+{
+  for (DEG::IDNode *id_node : deg_graph->id_nodes) {
+    r_ids->push_back(id_node->id_orig);
+  }
+  for (DEG::OperationNode *op_node : deg_graph->operations) {
+    r_operations->push_back(depsgraph_debug_node_key(op_node));
+    for (DEG::Relation *rel : op_node->outlinks) {
+      r_relations->push_back(depsgraph_debug_relation_key(rel));
+    }
+  }
+  /* Relations from the time source are not in the outgoing links of any operation. */
+  const DEG::TimeSourceNode *time_source = deg_graph->find_time_source();
+  if (time_source != nullptr) {
+    for (DEG::Relation *rel : time_source->outlinks) {
+      r_relations->push_back(depsgraph_debug_relation_key(rel));
+    }
+  }
+  std::sort(r_ids->begin(), r_ids->end());
+  std::sort(r_operations->begin(), r_operations->end());
+  std::sort(r_relations->begin(), r_relations->end());
+}
+
 bool DEG_debug_compare(const struct Depsgraph *graph1, const struct Depsgraph *graph2)
 {
   BLI_assert(graph1 != nullptr);
   BLI_assert(graph2 != nullptr);
   const DEG::Depsgraph *deg_graph1 = reinterpret_cast<const DEG::Depsgraph *>(graph1);
   const DEG::Depsgraph *deg_graph2 = reinterpret_cast<const DEG::Depsgraph *>(graph2);
-  if (deg_graph1->operations.size() != deg_graph2->operations.size()) {
+  if (deg_graph1->operations.size() != deg_graph2->operations.size() ||
+      deg_graph1->id_nodes.size() != deg_graph2->id_nodes.size()) {
     return false;
   }
-  /* TODO(sergey): Currently we only do real stupid check,
-   * which is fast but which isn't 100% reliable.
-   *
-   * Would be cool to make it more robust, but it's good enough
-   * for now. Also, proper graph check is actually NP-complex
-   * problem. */
-  return true;
+  /* The nodes are matched by the original ID and their own identifiers, the relations by the
+   * nodes they link. This doesn't prove the graphs are isomorphic, but catches missing or
+   * extra ID nodes, operations and relations. */
+  DEG::vector<const ID *> ids1, ids2;
+  DEG::vector<DEG::string> operations1, operations2;
+  DEG::vector<DEG::string> relations1, relations2;
+  depsgraph_debug_graph_keys(deg_graph1, &ids1, &operations1, &relations1);
+  depsgraph_debug_graph_keys(deg_graph2, &ids2, &operations2, &relations2);
+  return ids1 == ids2 && operations1 == operations2 && relations1 == relations2;
 }
 
 bool DEG_debug_graph_relations_validate(Depsgraph *graph,
@@ -247,6 +300,17 @@ void DEG_stats_simple(const Depsgraph *graph,
   }
 }
 
+void DEG_stats_builds(const Depsgraph *graph, int *r_full_builds, int *r_incremental_updates)
+{
+  const DEG::Depsgraph *deg_graph = reinterpret_cast<const DEG::Depsgraph *>(graph);
+  if (r_full_builds) {
+    *r_full_builds = deg_graph->debug.num_full_builds;
+  }
+  if (r_incremental_updates) {
+    *r_incremental_updates = deg_graph->debug.num_incremental_updates;
+  }
+}
+
 static DEG::string depsgraph_name_for_logging(struct Depsgraph *depsgraph)
 {
   const char *name = DEG_debug_name_get(depsgraph);
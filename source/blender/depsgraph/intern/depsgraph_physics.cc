@@ -199,6 +199,33 @@ ListBase *build_collision_relations(Depsgraph *graph,
   return relations;
 }
 
+bool physics_relations_has_object(const Depsgraph *graph, const Object *object)
+{
+  for (int i = 0; i < DEG_PHYSICS_RELATIONS_NUM; i++) {
+    if (graph->physics_relations[i] == nullptr) {
+      continue;
+    }
+    GHASH_FOREACH_BEGIN (ListBase *, relations, graph->physics_relations[i]) {
+      if (i == DEG_PHYSICS_EFFECTOR) {
+        LISTBASE_FOREACH (EffectorRelation *, relation, relations) {
+          if (relation->ob == object) {
+            return true;
+          }
+        }
+      }
+      else {
+        LISTBASE_FOREACH (CollisionRelation *, relation, relations) {
+          if (relation->ob == object) {
+            return true;
+          }
+        }
+      }
+    }
+    GHASH_FOREACH_END();
+  }
+  return false;
+}
+
 namespace {
 
 void free_effector_relations(void *value)
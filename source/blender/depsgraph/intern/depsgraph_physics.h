@@ -25,6 +25,7 @@
 
 struct Collection;
 struct ListBase;
+struct Object;
 
 namespace DEG {
 
@@ -36,4 +37,8 @@ ListBase *build_collision_relations(Depsgraph *graph,
                                     unsigned int modifier_type);
 void clear_physics_relations(Depsgraph *graph);
 
+/* Check whether the object is one of the cached effectors or colliders. The object is only
+ * compared by pointer, it can be already freed. */
+bool physics_relations_has_object(const Depsgraph *graph, const Object *object);
+
 }  // namespace DEG
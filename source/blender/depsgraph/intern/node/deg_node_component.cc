@@ -203,8 +203,14 @@ OperationNode *ComponentNode::add_operation(const DepsEvalOperationCb &op,
     op_node = (OperationNode *)factory->create_node(this->owner->id_orig, "", name);
 
     /* register opnode in this component's operation set */
-    OperationIDKey *key = OBJECT_GUARDED_NEW(OperationIDKey, opcode, name, name_tag);
-    BLI_ghash_insert(operations_map, key, op_node);
+    if (operations_map != nullptr) {
+      OperationIDKey *key = OBJECT_GUARDED_NEW(OperationIDKey, opcode, name, name_tag);
+      BLI_ghash_insert(operations_map, key, op_node);
+    }
+    else {
+      /* Component is already finalized, happens when nodes are added to an existing graph. */
+      operations.push_back(op_node);
+    }
 
     /* set backlink */
     op_node->owner = this;
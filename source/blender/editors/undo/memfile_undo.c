@@ -118,17 +118,8 @@ static void memfile_undosys_step_decode(
 
 static void memfile_undosys_step_free(UndoStep *us_p)
 {
-  /* To avoid unnecessary slow down, free backwards
-   * (so we don't need to merge when clearing all). */
+  /* Chunks are reference counted, no need to pass them to the next step. */
   MemFileUndoStep *us = (MemFileUndoStep *)us_p;
-  if (us_p->next != NULL) {
-    UndoStep *us_next_p = BKE_undosys_step_same_type_next(us_p);
-    if (us_next_p != NULL) {
-      MemFileUndoStep *us_next = (MemFileUndoStep *)us_next_p;
-      BLO_memfile_merge(&us->data->memfile, &us_next->data->memfile);
-    }
-  }
-
   BKE_memfile_undo_free(us->data);
 }
 
@@ -288,6 +288,9 @@ typedef struct PointCache {
   struct PTCacheEdit *edit;
   /** Free callback. */
   void (*free_edit)(struct PTCacheEdit *edit);
+
+  /** Frames stored in the file of a #PTCACHE_SINGLE_FILE disk cache (runtime only). */
+  struct PTCacheFrameIndex *frame_index;
 } PointCache;
 
 typedef struct SBVertex {
@@ -553,6 +556,8 @@ typedef struct SoftBody {
 #define PTCACHE_IGNORE_CLEAR (1 << 13)
 
 #define PTCACHE_FLAG_INFO_DIRTY (1 << 14)
+/** Store all frames of the disk cache in a single file instead of one file per frame. */
+#define PTCACHE_SINGLE_FILE (1 << 15)
 
 /* PTCACHE_OUTDATED + PTCACHE_FRAMES_SKIPPED */
 #define PTCACHE_REDO_NEEDED 258
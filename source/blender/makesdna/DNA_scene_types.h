@@ -942,6 +942,7 @@ typedef struct GameData {
 #define GAME_USE_UNDO (1 << 19)
 #define GAME_USE_UI_ANTI_FLICKER (1 << 20)
 #define GAME_USE_VIEWPORT_RENDER (1 << 21)
+#define GAME_MERGE_STATIC_COLLIDERS (1 << 22)
 /* Note: GameData.flag is now an int (max 32 flags). A short could only take 16 flags */
 
 /* GameData.playerflag */
@@ -5328,6 +5328,13 @@ static void rna_def_scene_game_data(BlenderRNA *brna)
       "threshold will deactivate (0.0 means no deactivation)");
   RNA_def_property_update(prop, NC_SCENE, NULL);
 
+  prop = RNA_def_property(srna, "use_merge_static_colliders", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_boolean_sdna(prop, NULL, "flag", GAME_MERGE_STATIC_COLLIDERS);
+  RNA_def_property_ui_text(prop,
+                           "Merge Static Colliders",
+                           "Merge the static triangle mesh colliders of a same region at game "
+                           "start to speed up the collision detection and the ray casts");
+
   /* not used  */ /* deprecated !!!!!!!!!!!!! */
   prop = RNA_def_property(srna, "activity_culling_box_radius", PROP_FLOAT, PROP_NONE);
   RNA_def_property_float_sdna(prop, NULL, "activityBoxRadius");
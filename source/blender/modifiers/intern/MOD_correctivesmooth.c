@@ -26,6 +26,7 @@
 #include "BLI_utildefines.h"
 
 #include "BLI_math.h"
+#include "BLI_task.h"
 
 #include "DNA_scene_types.h"
 #include "DNA_meshdata_types.h"
@@ -36,6 +37,7 @@
 
 #include "BKE_deform.h"
 #include "BKE_mesh.h"
+#include "BKE_mesh_mapping.h"
 #include "BKE_editmesh.h"
 #include "BKE_lib_id.h"
 
@@ -96,10 +98,17 @@ static void freeBind(CorrectiveSmoothModifierData *csmd)
   csmd->bind_coords_num = 0;
 }
 
+static void freeRuntimeData(void *runtime_data)
+{
+  MOD_vert_adjacency_free((ModVertAdjacency *)runtime_data);
+}
+
 static void freeData(ModifierData *md)
 {
   CorrectiveSmoothModifierData *csmd = (CorrectiveSmoothModifierData *)md;
   freeBind(csmd);
+  freeRuntimeData(md->runtime);
+  md->runtime = NULL;
 }
 
 static void requiredDataMask(Object *UNUSED(ob),
@@ -168,13 +177,81 @@ static void mesh_get_boundaries(Mesh *mesh, float *smooth_weights)
   MEM_freeN(boundaries);
 }
 
+/* -------------------------------------------------------------------- */
+/* Smoothing Iterations
+ *
+ * Each iteration only reads the coordinates of the previous one, so vertices are smoothed in
+ * parallel, gathering their neighbors from the vertex adjacency map.
+ */
+
+typedef struct SmoothIterData {
+  const MeshElemMap *vert_adjacency;
+  const float (*coords_src)[3];
+  float (*coords_dst)[3];
+  /* Simple smoothing: lambda and smoothing weight divided by the number of neighbors. */
+  const float *vertex_edge_count_div;
+  /* Edge-length weighted smoothing: optional smoothing weights. */
+  const float *smooth_weights;
+  float lambda;
+} SmoothIterData;
+
+static void smooth_iter_run(SmoothIterData *data,
+                            float (*vertexCos)[3],
+                            uint numVerts,
+                            uint iterations,
+                            TaskParallelRangeFunc iter_func)
+{
+  float(*coords_src)[3] = vertexCos;
+  float(*coords_dst)[3] = MEM_malloc_arrayN(numVerts, sizeof(*coords_dst), __func__);
+  float(*coords_tmp)[3] = coords_dst;
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (numVerts > 1024);
+
+  while (iterations--) {
+    float(*coords_swap)[3];
+
+    data->coords_src = (const float(*)[3])coords_src;
+    data->coords_dst = coords_dst;
+    BLI_task_parallel_range(0, (int)numVerts, data, iter_func, &settings);
+
+    coords_swap = coords_src;
+    coords_src = coords_dst;
+    coords_dst = coords_swap;
+  }
+
+  if (coords_src != vertexCos) {
+    memcpy(vertexCos, coords_src, sizeof(*vertexCos) * numVerts);
+  }
+  MEM_freeN(coords_tmp);
+}
+
 /* -------------------------------------------------------------------- */
 /* Simple Weighted Smoothing
  *
  * (average of surrounding verts)
  */
+static void smooth_iter__simple_task(void *__restrict userdata,
+                                     const int i,
+                                     const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const SmoothIterData *data = userdata;
+  const MeshElemMap *adjacency = &data->vert_adjacency[i];
+  const float *co = data->coords_src[i];
+  float delta[3] = {0.0f, 0.0f, 0.0f};
+
+  for (int j = 0; j < adjacency->count; j++) {
+    float edge_dir[3];
+    sub_v3_v3v3(edge_dir, data->coords_src[adjacency->indices[j]], co);
+    add_v3_v3(delta, edge_dir);
+  }
+
+  madd_v3_v3v3fl(data->coords_dst[i], co, delta, data->vertex_edge_count_div[i]);
+}
+
 static void smooth_iter__simple(CorrectiveSmoothModifierData *csmd,
-                                Mesh *mesh,
+                                const MeshElemMap *vert_adjacency,
                                 float (*vertexCos)[3],
                                 uint numVerts,
                                 const float *smooth_weights,
@@ -183,168 +260,93 @@ static void smooth_iter__simple(CorrectiveSmoothModifierData *csmd,
   const float lambda = csmd->lambda;
   uint i;
 
-  const uint numEdges = (uint)mesh->totedge;
-  const MEdge *edges = mesh->medge;
-  float *vertex_edge_count_div;
-
-  struct SmoothingData_Simple {
-    float delta[3];
-  } *smooth_data = MEM_calloc_arrayN(numVerts, sizeof(*smooth_data), __func__);
-
-  vertex_edge_count_div = MEM_calloc_arrayN(numVerts, sizeof(float), __func__);
-
-  /* calculate as floats to avoid int->float conversion in #smooth_iter */
-  for (i = 0; i < numEdges; i++) {
-    vertex_edge_count_div[edges[i].v1] += 1.0f;
-    vertex_edge_count_div[edges[i].v2] += 1.0f;
-  }
+  float *vertex_edge_count_div = MEM_malloc_arrayN(numVerts, sizeof(float), __func__);
 
   /* a little confusing, but we can include 'lambda' and smoothing weight
    * here to avoid multiplying for every iteration */
   if (smooth_weights == NULL) {
     for (i = 0; i < numVerts; i++) {
-      vertex_edge_count_div[i] = lambda * (vertex_edge_count_div[i] ?
-                                               (1.0f / vertex_edge_count_div[i]) :
-                                               1.0f);
+      const int count = vert_adjacency[i].count;
+      vertex_edge_count_div[i] = lambda * (count ? (1.0f / (float)count) : 1.0f);
     }
   }
   else {
     for (i = 0; i < numVerts; i++) {
+      const int count = vert_adjacency[i].count;
       vertex_edge_count_div[i] = smooth_weights[i] * lambda *
-                                 (vertex_edge_count_div[i] ? (1.0f / vertex_edge_count_div[i]) :
-                                                             1.0f);
+                                 (count ? (1.0f / (float)count) : 1.0f);
     }
   }
 
   /* -------------------------------------------------------------------- */
   /* Main Smoothing Loop */
 
-  while (iterations--) {
-    for (i = 0; i < numEdges; i++) {
-      struct SmoothingData_Simple *sd_v1;
-      struct SmoothingData_Simple *sd_v2;
-      float edge_dir[3];
-
-      sub_v3_v3v3(edge_dir, vertexCos[edges[i].v2], vertexCos[edges[i].v1]);
-
-      sd_v1 = &smooth_data[edges[i].v1];
-      sd_v2 = &smooth_data[edges[i].v2];
-
-      add_v3_v3(sd_v1->delta, edge_dir);
-      sub_v3_v3(sd_v2->delta, edge_dir);
-    }
-
-    for (i = 0; i < numVerts; i++) {
-      struct SmoothingData_Simple *sd = &smooth_data[i];
-      madd_v3_v3fl(vertexCos[i], sd->delta, vertex_edge_count_div[i]);
-      /* zero for the next iteration (saves memset on entire array) */
-      memset(sd, 0, sizeof(*sd));
-    }
-  }
+  SmoothIterData data = {
+      .vert_adjacency = vert_adjacency,
+      .vertex_edge_count_div = vertex_edge_count_div,
+  };
+  smooth_iter_run(&data, vertexCos, numVerts, iterations, smooth_iter__simple_task);
 
   MEM_freeN(vertex_edge_count_div);
-  MEM_freeN(smooth_data);
 }
 
 /* -------------------------------------------------------------------- */
 /* Edge-Length Weighted Smoothing
  */
+static void smooth_iter__length_weight_task(void *__restrict userdata,
+                                            const int i,
+                                            const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const float eps = FLT_EPSILON * 10.0f;
+  const SmoothIterData *data = userdata;
+  const MeshElemMap *adjacency = &data->vert_adjacency[i];
+  const float *co = data->coords_src[i];
+  float delta[3] = {0.0f, 0.0f, 0.0f};
+  float edge_length_sum = 0.0f;
+
+  for (int j = 0; j < adjacency->count; j++) {
+    float edge_dir[3];
+    sub_v3_v3v3(edge_dir, data->coords_src[adjacency->indices[j]], co);
+    const float edge_dist = len_v3(edge_dir);
+
+    /* weight by distance */
+    madd_v3_v3fl(delta, edge_dir, edge_dist);
+    edge_length_sum += edge_dist;
+  }
+
+  /* Divide by sum of all neighbor distances (weighted) and amount of neighbors,
+   * (mean average). */
+  const float div = edge_length_sum * (float)adjacency->count;
+  if (div > eps) {
+    const float lambda_w = (data->smooth_weights != NULL) ?
+                               data->lambda * data->smooth_weights[i] :
+                               data->lambda;
+    madd_v3_v3v3fl(data->coords_dst[i], co, delta, lambda_w / div);
+  }
+  else {
+    copy_v3_v3(data->coords_dst[i], co);
+  }
+}
+
 static void smooth_iter__length_weight(CorrectiveSmoothModifierData *csmd,
-                                       Mesh *mesh,
+                                       const MeshElemMap *vert_adjacency,
                                        float (*vertexCos)[3],
                                        uint numVerts,
                                        const float *smooth_weights,
                                        uint iterations)
 {
-  const float eps = FLT_EPSILON * 10.0f;
-  const uint numEdges = (uint)mesh->totedge;
   /* note: the way this smoothing method works, its approx half as strong as the simple-smooth,
    * and 2.0 rarely spikes, double the value for consistent behavior. */
-  const float lambda = csmd->lambda * 2.0f;
-  const MEdge *edges = mesh->medge;
-  float *vertex_edge_count;
-  uint i;
-
-  struct SmoothingData_Weighted {
-    float delta[3];
-    float edge_length_sum;
-  } *smooth_data = MEM_calloc_arrayN(numVerts, sizeof(*smooth_data), __func__);
-
-  /* calculate as floats to avoid int->float conversion in #smooth_iter */
-  vertex_edge_count = MEM_calloc_arrayN(numVerts, sizeof(float), __func__);
-  for (i = 0; i < numEdges; i++) {
-    vertex_edge_count[edges[i].v1] += 1.0f;
-    vertex_edge_count[edges[i].v2] += 1.0f;
-  }
-
-  /* -------------------------------------------------------------------- */
-  /* Main Smoothing Loop */
-
-  while (iterations--) {
-    for (i = 0; i < numEdges; i++) {
-      struct SmoothingData_Weighted *sd_v1;
-      struct SmoothingData_Weighted *sd_v2;
-      float edge_dir[3];
-      float edge_dist;
-
-      sub_v3_v3v3(edge_dir, vertexCos[edges[i].v2], vertexCos[edges[i].v1]);
-      edge_dist = len_v3(edge_dir);
-
-      /* weight by distance */
-      mul_v3_fl(edge_dir, edge_dist);
-
-      sd_v1 = &smooth_data[edges[i].v1];
-      sd_v2 = &smooth_data[edges[i].v2];
-
-      add_v3_v3(sd_v1->delta, edge_dir);
-      sub_v3_v3(sd_v2->delta, edge_dir);
-
-      sd_v1->edge_length_sum += edge_dist;
-      sd_v2->edge_length_sum += edge_dist;
-    }
-
-    if (smooth_weights == NULL) {
-      /* fast-path */
-      for (i = 0; i < numVerts; i++) {
-        struct SmoothingData_Weighted *sd = &smooth_data[i];
-        /* Divide by sum of all neighbor distances (weighted) and amount of neighbors,
-         * (mean average). */
-        const float div = sd->edge_length_sum * vertex_edge_count[i];
-        if (div > eps) {
-#if 0
-          /* first calculate the new location */
-          mul_v3_fl(sd->delta, 1.0f / div);
-          /* then interpolate */
-          madd_v3_v3fl(vertexCos[i], sd->delta, lambda);
-#else
-          /* do this in one step */
-          madd_v3_v3fl(vertexCos[i], sd->delta, lambda / div);
-#endif
-        }
-        /* zero for the next iteration (saves memset on entire array) */
-        memset(sd, 0, sizeof(*sd));
-      }
-    }
-    else {
-      for (i = 0; i < numVerts; i++) {
-        struct SmoothingData_Weighted *sd = &smooth_data[i];
-        const float div = sd->edge_length_sum * vertex_edge_count[i];
-        if (div > eps) {
-          const float lambda_w = lambda * smooth_weights[i];
-          madd_v3_v3fl(vertexCos[i], sd->delta, lambda_w / div);
-        }
-
-        memset(sd, 0, sizeof(*sd));
-      }
-    }
-  }
-
-  MEM_freeN(vertex_edge_count);
-  MEM_freeN(smooth_data);
+  SmoothIterData data = {
+      .vert_adjacency = vert_adjacency,
+      .smooth_weights = smooth_weights,
+      .lambda = csmd->lambda * 2.0f,
+  };
+  smooth_iter_run(&data, vertexCos, numVerts, iterations, smooth_iter__length_weight_task);
 }
 
 static void smooth_iter(CorrectiveSmoothModifierData *csmd,
-                        Mesh *mesh,
+                        const MeshElemMap *vert_adjacency,
                         float (*vertexCos)[3],
                         uint numVerts,
                         const float *smooth_weights,
@@ -352,12 +354,13 @@ static void smooth_iter(CorrectiveSmoothModifierData *csmd,
 {
   switch (csmd->smooth_type) {
     case MOD_CORRECTIVESMOOTH_SMOOTH_LENGTH_WEIGHT:
-      smooth_iter__length_weight(csmd, mesh, vertexCos, numVerts, smooth_weights, iterations);
+      smooth_iter__length_weight(
+          csmd, vert_adjacency, vertexCos, numVerts, smooth_weights, iterations);
       break;
 
     /* case MOD_CORRECTIVESMOOTH_SMOOTH_SIMPLE: */
     default:
-      smooth_iter__simple(csmd, mesh, vertexCos, numVerts, smooth_weights, iterations);
+      smooth_iter__simple(csmd, vert_adjacency, vertexCos, numVerts, smooth_weights, iterations);
       break;
   }
 }
@@ -391,7 +394,12 @@ static void smooth_verts(CorrectiveSmoothModifierData *csmd,
     }
   }
 
-  smooth_iter(csmd, mesh, vertexCos, numVerts, smooth_weights, (uint)csmd->repeat);
+  /* Topology doesn't change between the smoothing of the rest and deformed coordinates, nor
+   * usually between evaluations, the adjacency map is kept in the modifier runtime data. */
+  const MeshElemMap *vert_adjacency = MOD_vert_adjacency_ensure(
+      &csmd->modifier, mesh, (int)numVerts);
+
+  smooth_iter(csmd, vert_adjacency, vertexCos, numVerts, smooth_weights, (uint)csmd->repeat);
 
   if (smooth_weights) {
     MEM_freeN(smooth_weights);
@@ -787,5 +795,5 @@ ModifierTypeInfo modifierType_CorrectiveSmooth = {
     /* foreachObjectLink */ NULL,
     /* foreachIDLink */ NULL,
     /* foreachTexLink */ NULL,
-    /* freeRuntimeData */ NULL,
+    /* freeRuntimeData */ freeRuntimeData,
 };
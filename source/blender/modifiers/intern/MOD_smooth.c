@@ -26,6 +26,7 @@
 #include "BLI_utildefines.h"
 
 #include "BLI_math.h"
+#include "BLI_task.h"
 
 #include "DNA_mesh_types.h"
 #include "DNA_meshdata_types.h"
@@ -33,6 +34,7 @@
 #include "BKE_editmesh.h"
 #include "BKE_lib_id.h"
 #include "BKE_mesh.h"
+#include "BKE_mesh_mapping.h"
 #include "BKE_particle.h"
 #include "BKE_deform.h"
 
@@ -49,6 +51,17 @@ static void initData(ModifierData *md)
   smd->defgrp_name[0] = '\0';
 }
 
+static void freeRuntimeData(void *runtime_data)
+{
+  MOD_vert_adjacency_free((ModVertAdjacency *)runtime_data);
+}
+
+static void freeData(ModifierData *md)
+{
+  freeRuntimeData(md->runtime);
+  md->runtime = NULL;
+}
+
 static bool isDisabled(const struct Scene *UNUSED(scene),
                        ModifierData *md,
                        bool UNUSED(useRenderParams))
@@ -77,111 +90,111 @@ static void requiredDataMask(Object *UNUSED(ob),
   }
 }
 
-static void smoothModifier_do(
-    SmoothModifierData *smd, Object *ob, Mesh *mesh, float (*vertexCos)[3], int numVerts)
+typedef struct SmoothIterData {
+  const MeshElemMap *vert_adjacency;
+  const float (*coords_src)[3];
+  float (*coords_dst)[3];
+  /* Per vertex factor of the smoothed position, NULL when the same factor is used for all. */
+  const float *vert_factors;
+  float fac;
+  short flag;
+} SmoothIterData;
+
+static void smooth_iter_task(void *__restrict userdata,
+                             const int i,
+                             const TaskParallelTLS *__restrict UNUSED(tls))
 {
-  if (mesh == NULL) {
+  const SmoothIterData *data = userdata;
+  const MeshElemMap *adjacency = &data->vert_adjacency[i];
+  const float *vco_orig = data->coords_src[i];
+  float *vco_dst = data->coords_dst[i];
+
+  copy_v3_v3(vco_dst, vco_orig);
+
+  const float f_new = data->vert_factors ? data->vert_factors[i] : data->fac;
+  if (adjacency->count == 0 || (data->vert_factors && f_new <= 0.0f)) {
     return;
   }
+  const float f_orig = 1.0f - f_new;
 
-  float(*accumulated_vecs)[3] = MEM_calloc_arrayN(
-      (size_t)numVerts, sizeof(*accumulated_vecs), __func__);
-  if (!accumulated_vecs) {
-    return;
+  /* Average of the midpoints of the edges using the vertex. */
+  float vco_new[3] = {0.0f, 0.0f, 0.0f};
+  for (int j = 0; j < adjacency->count; j++) {
+    add_v3_v3(vco_new, data->coords_src[adjacency->indices[j]]);
   }
+  mul_v3_fl(vco_new, 0.5f / (float)adjacency->count);
+  madd_v3_v3fl(vco_new, vco_orig, 0.5f);
 
-  uint *num_accumulated_vecs = MEM_calloc_arrayN(
-      (size_t)numVerts, sizeof(*num_accumulated_vecs), __func__);
-  if (!num_accumulated_vecs) {
-    if (accumulated_vecs) {
-      MEM_freeN(accumulated_vecs);
-    }
+  const short flag = data->flag;
+  if (flag & MOD_SMOOTH_X) {
+    vco_dst[0] = f_orig * vco_orig[0] + f_new * vco_new[0];
+  }
+  if (flag & MOD_SMOOTH_Y) {
+    vco_dst[1] = f_orig * vco_orig[1] + f_new * vco_new[1];
+  }
+  if (flag & MOD_SMOOTH_Z) {
+    vco_dst[2] = f_orig * vco_orig[2] + f_new * vco_new[2];
+  }
+}
+
+static void smoothModifier_do(
+    SmoothModifierData *smd, Object *ob, Mesh *mesh, float (*vertexCos)[3], int numVerts)
+{
+  if (mesh == NULL) {
     return;
   }
 
   const float fac_new = smd->fac;
-  const float fac_orig = 1.0f - fac_new;
   const bool invert_vgroup = (smd->flag & MOD_SMOOTH_INVERT_VGROUP) != 0;
 
-  MEdge *medges = mesh->medge;
-  const int num_edges = mesh->totedge;
-
   MDeformVert *dvert;
   int defgrp_index;
   MOD_get_vgroup(ob, mesh, smd->defgrp_name, &dvert, &defgrp_index);
 
-  for (int j = 0; j < smd->repeat; j++) {
-    if (j != 0) {
-      memset(accumulated_vecs, 0, sizeof(*accumulated_vecs) * (size_t)numVerts);
-      memset(num_accumulated_vecs, 0, sizeof(*num_accumulated_vecs) * (size_t)numVerts);
+  float *vert_factors = NULL;
+  if (dvert) {
+    vert_factors = MEM_malloc_arrayN((size_t)numVerts, sizeof(*vert_factors), __func__);
+    MDeformVert *dv = dvert;
+    for (int i = 0; i < numVerts; i++, dv++) {
+      vert_factors[i] = invert_vgroup ?
+                            (1.0f - BKE_defvert_find_weight(dv, defgrp_index)) * fac_new :
+                            BKE_defvert_find_weight(dv, defgrp_index) * fac_new;
     }
+  }
 
-    for (int i = 0; i < num_edges; i++) {
-      float fvec[3];
-      const uint idx1 = medges[i].v1;
-      const uint idx2 = medges[i].v2;
+  /* Each iteration only reads the coordinates of the previous one, vertices are smoothed in
+   * parallel into a second buffer. */
+  float(*coords_src)[3] = vertexCos;
+  float(*coords_dst)[3] = MEM_malloc_arrayN((size_t)numVerts, sizeof(*coords_dst), __func__);
+  float(*coords_tmp)[3] = coords_dst;
 
-      mid_v3_v3v3(fvec, vertexCos[idx1], vertexCos[idx2]);
+  SmoothIterData data = {
+      .vert_adjacency = MOD_vert_adjacency_ensure(&smd->modifier, mesh, numVerts),
+      .vert_factors = vert_factors,
+      .fac = fac_new,
+      .flag = smd->flag,
+  };
 
-      num_accumulated_vecs[idx1]++;
-      add_v3_v3(accumulated_vecs[idx1], fvec);
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (numVerts > 1024);
 
-      num_accumulated_vecs[idx2]++;
-      add_v3_v3(accumulated_vecs[idx2], fvec);
-    }
+  for (int j = 0; j < smd->repeat; j++) {
+    data.coords_src = (const float(*)[3])coords_src;
+    data.coords_dst = coords_dst;
+    BLI_task_parallel_range(0, numVerts, &data, smooth_iter_task, &settings);
 
-    const short flag = smd->flag;
-    if (dvert) {
-      MDeformVert *dv = dvert;
-      for (int i = 0; i < numVerts; i++, dv++) {
-        float *vco_orig = vertexCos[i];
-        if (num_accumulated_vecs[0] > 0) {
-          mul_v3_fl(accumulated_vecs[i], 1.0f / (float)num_accumulated_vecs[i]);
-        }
-        float *vco_new = accumulated_vecs[i];
-
-        const float f_new = invert_vgroup ?
-                                (1.0f - BKE_defvert_find_weight(dv, defgrp_index)) * fac_new :
-                                BKE_defvert_find_weight(dv, defgrp_index) * fac_new;
-        if (f_new <= 0.0f) {
-          continue;
-        }
-        const float f_orig = 1.0f - f_new;
-
-        if (flag & MOD_SMOOTH_X) {
-          vco_orig[0] = f_orig * vco_orig[0] + f_new * vco_new[0];
-        }
-        if (flag & MOD_SMOOTH_Y) {
-          vco_orig[1] = f_orig * vco_orig[1] + f_new * vco_new[1];
-        }
-        if (flag & MOD_SMOOTH_Z) {
-          vco_orig[2] = f_orig * vco_orig[2] + f_new * vco_new[2];
-        }
-      }
-    }
-    else { /* no vertex group */
-      for (int i = 0; i < numVerts; i++) {
-        float *vco_orig = vertexCos[i];
-        if (num_accumulated_vecs[0] > 0) {
-          mul_v3_fl(accumulated_vecs[i], 1.0f / (float)num_accumulated_vecs[i]);
-        }
-        float *vco_new = accumulated_vecs[i];
-
-        if (flag & MOD_SMOOTH_X) {
-          vco_orig[0] = fac_orig * vco_orig[0] + fac_new * vco_new[0];
-        }
-        if (flag & MOD_SMOOTH_Y) {
-          vco_orig[1] = fac_orig * vco_orig[1] + fac_new * vco_new[1];
-        }
-        if (flag & MOD_SMOOTH_Z) {
-          vco_orig[2] = fac_orig * vco_orig[2] + fac_new * vco_new[2];
-        }
-      }
-    }
+    float(*coords_swap)[3] = coords_src;
+    coords_src = coords_dst;
+    coords_dst = coords_swap;
+  }
+
+  if (coords_src != vertexCos) {
+    memcpy(vertexCos, coords_src, sizeof(*vertexCos) * (size_t)numVerts);
   }
 
-  MEM_freeN(accumulated_vecs);
-  MEM_freeN(num_accumulated_vecs);
+  MEM_freeN(coords_tmp);
+  MEM_SAFE_FREE(vert_factors);
 }
 
 static void deformVerts(ModifierData *md,
@@ -241,7 +254,7 @@ ModifierTypeInfo modifierType_Smooth = {
 
     /* initData */ initData,
     /* requiredDataMask */ requiredDataMask,
-    /* freeData */ NULL,
+    /* freeData */ freeData,
     /* isDisabled */ isDisabled,
     /* updateDepsgraph */ NULL,
     /* dependsOnTime */ NULL,
@@ -249,5 +262,5 @@ ModifierTypeInfo modifierType_Smooth = {
     /* foreachObjectLink */ NULL,
     /* foreachIDLink */ NULL,
     /* foreachTexLink */ NULL,
-    /* freeRuntimeData */ NULL,
+    /* freeRuntimeData */ freeRuntimeData,
 };
@@ -42,6 +42,7 @@
 #include "BKE_lattice.h"
 #include "BKE_lib_id.h"
 #include "BKE_mesh.h"
+#include "BKE_mesh_mapping.h"
 #include "BKE_object.h"
 
 #include "BKE_modifier.h"
@@ -248,6 +249,65 @@ void MOD_get_vgroup(
   }
 }
 
+static bool vert_adjacency_matches_mesh(const ModVertAdjacency *adjacency,
+                                        const Mesh *mesh,
+                                        const int numVerts)
+{
+  if (adjacency->totvert != numVerts || adjacency->totedge != mesh->totedge) {
+    return false;
+  }
+  const MEdge *medge = mesh->medge;
+  for (int i = 0; i < mesh->totedge; i++) {
+    if (adjacency->edge_verts[i][0] != medge[i].v1 || adjacency->edge_verts[i][1] != medge[i].v2) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Get the vertex to vertex adjacency map of the mesh, stored in the runtime data of the modifier.
+ * It's only created again when the topology of the mesh changed since the last call.
+ */
+const MeshElemMap *MOD_vert_adjacency_ensure(ModifierData *md,
+                                             const Mesh *mesh,
+                                             const int numVerts)
+{
+  ModVertAdjacency *adjacency = (ModVertAdjacency *)md->runtime;
+  if (adjacency != NULL) {
+    if (vert_adjacency_matches_mesh(adjacency, mesh, numVerts)) {
+      return adjacency->map;
+    }
+    MOD_vert_adjacency_free(adjacency);
+  }
+
+  adjacency = MEM_callocN(sizeof(*adjacency), __func__);
+  BKE_mesh_vert_edge_vert_map_create(
+      &adjacency->map, &adjacency->mem, mesh->medge, numVerts, mesh->totedge);
+  adjacency->edge_verts = MEM_malloc_arrayN(
+      (size_t)mesh->totedge, sizeof(*adjacency->edge_verts), __func__);
+  for (int i = 0; i < mesh->totedge; i++) {
+    adjacency->edge_verts[i][0] = mesh->medge[i].v1;
+    adjacency->edge_verts[i][1] = mesh->medge[i].v2;
+  }
+  adjacency->totvert = numVerts;
+  adjacency->totedge = mesh->totedge;
+
+  md->runtime = adjacency;
+  return adjacency->map;
+}
+
+void MOD_vert_adjacency_free(ModVertAdjacency *adjacency)
+{
+  if (adjacency == NULL) {
+    return;
+  }
+  MEM_freeN(adjacency->map);
+  MEM_freeN(adjacency->mem);
+  MEM_SAFE_FREE(adjacency->edge_verts);
+  MEM_freeN(adjacency);
+}
+
 /* only called by BKE_modifier.h/modifier.c */
 void modifier_type_init(ModifierTypeInfo *types[])
 {
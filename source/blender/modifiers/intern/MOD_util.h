@@ -28,6 +28,7 @@
 
 struct MDeformVert;
 struct Mesh;
+struct MeshElemMap;
 struct ModifierData;
 struct ModifierEvalContext;
 struct Object;
@@ -56,4 +57,19 @@ void MOD_get_vgroup(struct Object *ob,
                     struct MDeformVert **dvert,
                     int *defgrp_index);
 
+/* Vertex to vertex adjacency of a mesh (one neighbor per edge), kept as the runtime data of
+ * smoothing modifiers while the topology of their input mesh doesn't change. */
+typedef struct ModVertAdjacency {
+  struct MeshElemMap *map;
+  int *mem;
+  /* Vertices of the edges the map was created from, to detect topology changes. */
+  unsigned int (*edge_verts)[2];
+  int totvert, totedge;
+} ModVertAdjacency;
+
+const struct MeshElemMap *MOD_vert_adjacency_ensure(struct ModifierData *md,
+                                                    const struct Mesh *mesh,
+                                                    const int numVerts);
+void MOD_vert_adjacency_free(ModVertAdjacency *adjacency);
+
 #endif /* __MOD_UTIL_H__ */
@@ -0,0 +1,347 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file gameengine/Common/CM_Profiler.cpp
+ *  \ingroup common
+ */
+
+#include "CM_Profiler.h"
+
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace {
+
+/// Number of zones kept per thread, a power of two.
+static const unsigned int zoneBufferSize = 1 << 16;
+/// Weight of the last frame in the running averages.
+static const double averageWeight = 0.1;
+
+struct ZoneData {
+  unsigned int m_id;
+  double m_start;
+  double m_end;
+};
+
+/// Slot of a ring buffer, read by the main thread while the owning thread may overwrite it.
+struct Zone {
+  /// Index of the zone plus one once written, 0 while the slot is overwritten.
+  std::atomic<unsigned int> m_sequence;
+  std::atomic<unsigned int> m_id;
+  std::atomic<double> m_start;
+  std::atomic<double> m_end;
+
+  Zone() : m_sequence(0), m_id(0), m_start(0.0), m_end(0.0)
+  {
+  }
+};
+
+struct ThreadBuffer {
+  /// Ring buffer allocated by the owning thread before publishing its first zone.
+  std::unique_ptr<Zone[]> m_zones;
+  /// Number of zones ever written, published by the writing thread.
+  std::atomic<unsigned int> m_head;
+  /// Number of zones already accumulated by NextFrame(), used by the main thread only.
+  unsigned int m_read;
+  /// Number of zones when Clear() was called, the previous zones are not exported.
+  unsigned int m_cleared;
+  /// Start time and name of the open zones, used by the owning thread only.
+  std::vector<std::pair<unsigned int, double> > m_stack;
+  unsigned int m_threadIndex;
+  std::string m_threadName;
+
+  ThreadBuffer(unsigned int threadIndex)
+      : m_head(0), m_read(0), m_cleared(0), m_threadIndex(threadIndex)
+  {
+  }
+};
+
+struct ProfilerData {
+  /// Protects the names and the list of buffers, never taken while recording a zone.
+  std::mutex m_mutex;
+  std::vector<std::string> m_names;
+  std::unordered_map<std::string, unsigned int> m_ids;
+  std::vector<std::unique_ptr<ThreadBuffer> > m_buffers;
+  std::vector<CM_Profiler::ZoneStats> m_stats;
+  std::chrono::steady_clock::time_point m_epoch;
+
+  ProfilerData() : m_epoch(std::chrono::steady_clock::now())
+  {
+  }
+};
+
+ProfilerData &GetData()
+{
+  static ProfilerData data;
+  return data;
+}
+
+thread_local ThreadBuffer *threadBuffer = nullptr;
+
+/// Copy the zone of an index, return false if it was overwritten or is being overwritten.
+bool ReadZone(const ThreadBuffer &buffer, unsigned int index, ZoneData &r_data)
+{
+  const Zone &zone = buffer.m_zones[index & (zoneBufferSize - 1)];
+  if (zone.m_sequence.load(std::memory_order_acquire) != index + 1) {
+    return false;
+  }
+  r_data.m_id = zone.m_id.load(std::memory_order_relaxed);
+  r_data.m_start = zone.m_start.load(std::memory_order_relaxed);
+  r_data.m_end = zone.m_end.load(std::memory_order_relaxed);
+  // Order the copy before checking the slot again.
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return zone.m_sequence.load(std::memory_order_relaxed) == index + 1;
+}
+
+ThreadBuffer *GetThreadBuffer()
+{
+  if (!threadBuffer) {
+    ProfilerData &data = GetData();
+    std::lock_guard<std::mutex> lock(data.m_mutex);
+    data.m_buffers.emplace_back(new ThreadBuffer(data.m_buffers.size()));
+    threadBuffer = data.m_buffers.back().get();
+  }
+  return threadBuffer;
+}
+
+double GetTime()
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - GetData().m_epoch)
+      .count();
+}
+
+/// Escape a name for a JSON string.
+std::string JsonEscape(const std::string &str)
+{
+  std::string result;
+  result.reserve(str.size());
+  for (const char c : str) {
+    if (c == '"' || c == '\\') {
+      result += '\\';
+      result += c;
+    }
+    else if ((unsigned char)c < 0x20) {
+      result += ' ';
+    }
+    else {
+      result += c;
+    }
+  }
+  return result;
+}
+
+}  // namespace
+
+std::atomic<bool> CM_Profiler::m_enabled(false);
+
+CM_Profiler::Scope::Scope(unsigned int id)
+    : m_active(id != NoZone && CM_Profiler::IsEnabled())
+{
+  if (m_active) {
+    CM_Profiler::Begin(id);
+  }
+}
+
+CM_Profiler::Scope::~Scope()
+{
+  if (m_active) {
+    CM_Profiler::End();
+  }
+}
+
+void CM_Profiler::SetEnabled(bool enabled)
+{
+  m_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool CM_Profiler::IsEnabled()
+{
+  return m_enabled.load(std::memory_order_relaxed);
+}
+
+unsigned int CM_Profiler::RegisterName(const std::string &name)
+{
+  ProfilerData &data = GetData();
+  std::lock_guard<std::mutex> lock(data.m_mutex);
+
+  const std::unordered_map<std::string, unsigned int>::const_iterator it = data.m_ids.find(name);
+  if (it != data.m_ids.end()) {
+    return it->second;
+  }
+
+  const unsigned int id = data.m_names.size();
+  data.m_names.push_back(name);
+  data.m_ids[name] = id;
+  return id;
+}
+
+std::string CM_Profiler::GetName(unsigned int id)
+{
+  ProfilerData &data = GetData();
+  std::lock_guard<std::mutex> lock(data.m_mutex);
+  return (id < data.m_names.size()) ? data.m_names[id] : std::string();
+}
+
+void CM_Profiler::SetThreadName(const std::string &name)
+{
+  ThreadBuffer *buffer = GetThreadBuffer();
+  std::lock_guard<std::mutex> lock(GetData().m_mutex);
+  buffer->m_threadName = name;
+}
+
+void CM_Profiler::Begin(unsigned int id)
+{
+  GetThreadBuffer()->m_stack.emplace_back(id, GetTime());
+}
+
+void CM_Profiler::End()
+{
+  ThreadBuffer *buffer = GetThreadBuffer();
+  if (buffer->m_stack.empty()) {
+    return;
+  }
+
+  // Allocate the ring buffer only for the threads recording zones.
+  if (!buffer->m_zones) {
+    buffer->m_zones.reset(new Zone[zoneBufferSize]);
+  }
+
+  const std::pair<unsigned int, double> &open = buffer->m_stack.back();
+  const unsigned int head = buffer->m_head.load(std::memory_order_relaxed);
+  Zone &zone = buffer->m_zones[head & (zoneBufferSize - 1)];
+  // Invalidate the slot for the readers before overwriting it.
+  zone.m_sequence.store(0, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  zone.m_id.store(open.first, std::memory_order_relaxed);
+  zone.m_start.store(open.second, std::memory_order_relaxed);
+  zone.m_end.store(GetTime(), std::memory_order_relaxed);
+  zone.m_sequence.store(head + 1, std::memory_order_release);
+  buffer->m_stack.pop_back();
+
+  // Publish the zone to the readers.
+  buffer->m_head.store(head + 1, std::memory_order_release);
+}
+
+void CM_Profiler::NextFrame()
+{
+  ProfilerData &data = GetData();
+  std::lock_guard<std::mutex> lock(data.m_mutex);
+
+  const unsigned int numNames = data.m_names.size();
+  std::vector<CM_Profiler::ZoneStats> &stats = data.m_stats;
+  if (stats.size() < numNames) {
+    stats.resize(numNames, {0.0, 0.0, 0});
+  }
+  for (CM_Profiler::ZoneStats &zoneStats : stats) {
+    zoneStats.m_time = 0.0;
+    zoneStats.m_calls = 0;
+  }
+
+  for (std::unique_ptr<ThreadBuffer> &buffer : data.m_buffers) {
+    const unsigned int head = buffer->m_head.load(std::memory_order_acquire);
+    // Zones overwritten since the last frame are lost.
+    unsigned int begin = buffer->m_read;
+    if (head - begin > zoneBufferSize) {
+      begin = head - zoneBufferSize;
+    }
+
+    for (unsigned int i = begin; i != head; ++i) {
+      // Zones overwritten while reading are lost too.
+      ZoneData zone;
+      if (!ReadZone(*buffer, i, zone) || zone.m_id >= numNames) {
+        continue;
+      }
+      CM_Profiler::ZoneStats &zoneStats = stats[zone.m_id];
+      zoneStats.m_time += zone.m_end - zone.m_start;
+      ++zoneStats.m_calls;
+    }
+    buffer->m_read = head;
+  }
+
+  for (CM_Profiler::ZoneStats &zoneStats : stats) {
+    zoneStats.m_average += (zoneStats.m_time - zoneStats.m_average) * averageWeight;
+  }
+}
+
+const std::vector<CM_Profiler::ZoneStats> &CM_Profiler::GetStats()
+{
+  return GetData().m_stats;
+}
+
+bool CM_Profiler::WriteChromeTrace(const std::string &filepath)
+{
+  std::ofstream file(filepath);
+  if (!file) {
+    return false;
+  }
+
+  ProfilerData &data = GetData();
+  std::lock_guard<std::mutex> lock(data.m_mutex);
+
+  file.setf(std::ios::fixed);
+  file.precision(3);
+
+  file << "{\"traceEvents\":[";
+  bool first = true;
+  for (std::unique_ptr<ThreadBuffer> &buffer : data.m_buffers) {
+    if (!buffer->m_threadName.empty()) {
+      file << (first ? "\n" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":"
+           << buffer->m_threadIndex << ",\"args\":{\"name\":\""
+           << JsonEscape(buffer->m_threadName) << "\"}}";
+      first = false;
+    }
+
+    const unsigned int head = buffer->m_head.load(std::memory_order_acquire);
+    unsigned int begin = buffer->m_cleared;
+    if (head - begin > zoneBufferSize) {
+      begin = head - zoneBufferSize;
+    }
+    for (unsigned int i = begin; i != head; ++i) {
+      ZoneData zone;
+      if (!ReadZone(*buffer, i, zone) || zone.m_id >= data.m_names.size()) {
+        continue;
+      }
+      // Times are in microseconds.
+      file << (first ? "\n" : ",\n") << "{\"name\":\"" << JsonEscape(data.m_names[zone.m_id])
+           << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << buffer->m_threadIndex
+           << ",\"ts\":" << zone.m_start * 1.0e6 << ",\"dur\":"
+           << (zone.m_end - zone.m_start) * 1.0e6 << "}";
+      first = false;
+    }
+  }
+  file << "\n]}\n";
+
+  return file.good();
+}
+
+void CM_Profiler::Clear()
+{
+  ProfilerData &data = GetData();
+  std::lock_guard<std::mutex> lock(data.m_mutex);
+
+  for (std::unique_ptr<ThreadBuffer> &buffer : data.m_buffers) {
+    buffer->m_read = buffer->m_head.load(std::memory_order_acquire);
+    buffer->m_cleared = buffer->m_read;
+  }
+  data.m_stats.clear();
+}
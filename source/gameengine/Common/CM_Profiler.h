@@ -0,0 +1,105 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file CM_Profiler.h
+ *  \ingroup common
+ */
+
+#ifndef __CM_PROFILER_H__
+#define __CM_PROFILER_H__
+
+#include <string>
+#include <vector>
+#include <atomic>
+
+/** Hierarchical zone profiler.
+ *
+ * Zones are identified by a name registered once with RegisterName(), and measured by a
+ * CM_Profiler::Scope living on the stack, scopes can be nested.
+ * Every thread records its finished zones in its own ring buffer, the thread writing the
+ * buffer is the only writer and publishes the zones with an atomic counter, no lock is taken
+ * while recording. Every slot holds the index of its zone, the readers discard the slots
+ * overwritten while they read them.
+ *
+ * The main thread calls NextFrame() between two frames to accumulate the zones finished
+ * during the frame into per name statistics, the last zones of all the threads can also be
+ * exported to the Chrome trace event format (chrome://tracing).
+ *
+ * When the profiler is disabled a scope costs a single test.
+ */
+class CM_Profiler {
+ public:
+  /// Statistics of a zone name.
+  struct ZoneStats {
+    /// Time spent in the zone during the last frame, including the nested zones.
+    double m_time;
+    /// Running average of m_time.
+    double m_average;
+    /// Number of zones during the last frame.
+    unsigned int m_calls;
+  };
+
+  /// Identifier not measured by a scope, used to avoid registering a name when disabled.
+  static const unsigned int NoZone = (unsigned int)-1;
+
+  class Scope {
+   private:
+    bool m_active;
+
+   public:
+    /// Measure a zone until the end of the scope, nothing is measured for NoZone.
+    explicit Scope(unsigned int id);
+    ~Scope();
+  };
+
+  static void SetEnabled(bool enabled);
+  static bool IsEnabled();
+
+  /// Return the identifier of a zone name, the same name always returns the same identifier.
+  static unsigned int RegisterName(const std::string &name);
+  static std::string GetName(unsigned int id);
+
+  /// Name the calling thread in the exported traces.
+  static void SetThreadName(const std::string &name);
+
+  /// Accumulate the zones of the last frame, must be called from the main thread.
+  static void NextFrame();
+  /// Return the statistics of all the names (indexed by identifier) updated by NextFrame().
+  static const std::vector<ZoneStats> &GetStats();
+
+  /// Write the zones still in the ring buffers to a Chrome trace file.
+  static bool WriteChromeTrace(const std::string &filepath);
+
+  /// Free all the recorded zones and statistics, the names are kept.
+  static void Clear();
+
+ private:
+  static std::atomic<bool> m_enabled;
+
+  static void Begin(unsigned int id);
+  static void End();
+};
+
+/// Measure the rest of the current block in a zone with a constant name.
+#define CM_PROFILE_SCOPE(name) \
+  static const unsigned int _cm_profile_id = CM_Profiler::RegisterName(name); \
+  CM_Profiler::Scope _cm_profile_scope(_cm_profile_id)
+
+#endif  // __CM_PROFILER_H__
@@ -1691,4 +1691,9 @@ void BL_ConvertBlenderObjects(struct Main *maggie,
       kxscene->DupliGroupRecurse(gameobj, 0);
     }
   }
+
+  // The colliders are merged once the collision sensors are registered.
+  if (!libloading && (blenderscene->gm.flag & GAME_MERGE_STATIC_COLLIDERS)) {
+    kxscene->GetPhysicsEnvironment()->MergeStaticColliders();
+  }
 }
@@ -625,10 +625,10 @@ bool KX_BlenderConverter::FreeBlendFile(Main *maggie)
     }
     else {
       // in case the mesh might be refered to later
-      std::map<std::string, void *> &mapStringToMeshes = scene->GetLogicManager()->GetMeshMap();
-      for (std::map<std::string, void *>::iterator it = mapStringToMeshes.begin(),
-                                                   end = mapStringToMeshes.end();
-           it != end;) {
+      std::unordered_map<std::string, void *> &mapStringToMeshes =
+          scene->GetLogicManager()->GetMeshMap();
+      for (std::unordered_map<std::string, void *>::iterator it = mapStringToMeshes.begin();
+           it != mapStringToMeshes.end();) {
         RAS_MeshObject *meshobj = (RAS_MeshObject *)it->second;
         if (meshobj && IS_TAGGED(meshobj->GetOrigMesh())) {
           it = mapStringToMeshes.erase(it);
@@ -639,10 +639,10 @@ bool KX_BlenderConverter::FreeBlendFile(Main *maggie)
       }
 
       // Now unregister actions.
-      std::map<std::string, void *> &mapStringToActions = scene->GetLogicManager()->GetActionMap();
-      for (std::map<std::string, void *>::iterator it = mapStringToActions.begin(),
-                                                   end = mapStringToActions.end();
-           it != end;) {
+      std::unordered_map<std::string, void *> &mapStringToActions =
+          scene->GetLogicManager()->GetActionMap();
+      for (std::unordered_map<std::string, void *>::iterator it = mapStringToActions.begin();
+           it != mapStringToActions.end();) {
         ID *action = (ID *)it->second;
         if (IS_TAGGED(action)) {
           it = mapStringToActions.erase(it);
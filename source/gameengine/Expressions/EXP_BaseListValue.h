@@ -21,6 +21,8 @@
 
 #include "EXP_Value.h"
 
+#include <unordered_map>
+
 class CBaseListValue : public CPropValue {
   Py_Header
 
@@ -33,6 +35,14 @@ class CBaseListValue : public CPropValue {
   VectorType m_pValueArray;
   bool m_bReleaseContents;
 
+  /** Items of each name in list order, built by the first FindValue() and then updated
+   * by Add() and RemoveValue(). Other modifications of the list invalidate the index.
+   * The indexed items are registered with CValue::AddNameIndexList() so that renaming one
+   * of them invalidates the index of this list only.
+   */
+  mutable std::unordered_map<std::string, VectorType> m_nameIndex;
+  mutable bool m_nameIndexValid;
+
   void SetValue(int i, CValue *val);
   CValue *GetValue(int i);
   CValue *FindValue(const std::string &name) const;
@@ -44,6 +54,7 @@ class CBaseListValue : public CPropValue {
 
  public:
   CBaseListValue();
+  CBaseListValue(const CBaseListValue &other);
   virtual ~CBaseListValue();
 
   virtual int GetValueType();
@@ -51,6 +62,8 @@ class CBaseListValue : public CPropValue {
   virtual std::string GetText();
 
   void SetReleaseOnDestruct(bool bReleaseContents);
+  /// Drop the name index and unregister it from its items.
+  void InvalidateNameIndex() const;
 
   void Remove(int i);
   void Resize(int num);
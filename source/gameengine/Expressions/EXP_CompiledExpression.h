@@ -0,0 +1,161 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file EXP_CompiledExpression.h
+ *  \ingroup expressions
+ */
+
+#ifndef __EXP_COMPILEDEXPRESSION_H__
+#define __EXP_COMPILEDEXPRESSION_H__
+
+#include "EXP_Value.h"
+#include "EXP_IntValue.h"
+#include "EXP_PropertyLayout.h"
+
+class CExpression;
+
+/** Flat, typed form of an expression tree.
+ *
+ * The tree is converted once into a postfix program working on scalars (bool, int, float).
+ * Identifiers are bound either to boolean inputs supplied at evaluation (e.g. sensor states)
+ * or to properties of an owner value, constant sub-expressions are folded.
+ * Evaluation doesn't allocate any CValue, when the result is an error the caller is
+ * expected to fall back to CExpression::Calculate() to retrieve the error message.
+ *
+ * Expressions using strings or unresolved identifiers can't be compiled, in this case
+ * Compile() returns false and the expression tree must be used.
+ */
+class CCompiledExpression {
+ public:
+  /// Typed scalar, the only value type handled by compiled expressions.
+  struct Scalar {
+    VALUE_DATA_TYPE m_type;
+    union {
+      bool m_bool;
+      cInt m_int;
+      float m_float;
+    };
+
+    Scalar();
+    explicit Scalar(bool value);
+    explicit Scalar(cInt value);
+    explicit Scalar(float value);
+
+    double GetNumber() const;
+    /// Convert a bool, int or float value, return false for any other type.
+    static bool FromValue(CValue *value, Scalar &scalar);
+  };
+
+  enum Result {
+    /// The expression was evaluated.
+    RESULT_OK,
+    /// The expression evaluates to an error value.
+    RESULT_ERROR,
+    /// A bound property was removed or is not a scalar, the program can't be used.
+    RESULT_INVALID
+  };
+
+ private:
+  enum OpCode {
+    OP_CONSTANT,
+    OP_INPUT,
+    OP_PROPERTY,
+    OP_UNARY,
+    OP_BINARY,
+    /// Pop the guard and jump if false, error if the guard is not a boolean.
+    OP_JUMP_IF_FALSE,
+    OP_JUMP
+  };
+
+  struct Instruction {
+    OpCode m_code;
+    VALUE_OPERATOR m_op;
+    /// Constant, input index, property index or jump target.
+    unsigned int m_index;
+    Scalar m_constant;
+  };
+
+  struct PropertyBinding {
+    std::string m_name;
+    CPropertyBinding m_binding;
+  };
+
+  std::vector<Instruction> m_instructions;
+  std::vector<PropertyBinding> m_properties;
+  /// Evaluation stack, sized at compilation.
+  std::vector<Scalar> m_stack;
+  unsigned int m_stackSize;
+  /// Last patched jump target, used to prevent constant folding across branches.
+  unsigned int m_jumpTarget;
+
+  /// Names of the boolean inputs, used only at compilation.
+  const std::vector<std::string> *m_inputNames;
+  /// Value owning the bound properties.
+  CValue *m_owner;
+
+  /// Compute the maximum stack depth and resize the evaluation stack.
+  void UpdateStackSize();
+  /// Return false if a bound property doesn't exist or is not a scalar.
+  bool CheckProperties();
+
+ public:
+  CCompiledExpression();
+  ~CCompiledExpression();
+
+  /** Compile an expression tree.
+   * \param expr The expression tree to compile.
+   * \param inputNames The names of the boolean inputs, an identifier matching the name
+   * at index i is read from inputs[i] in Evaluate().
+   * \param owner The value used to resolve the remaining identifiers as properties.
+   * \return False if the expression can't be compiled.
+   */
+  bool Compile(CExpression *expr, const std::vector<std::string> &inputNames, CValue *owner);
+  /// Return true if a program was succesfully compiled.
+  bool IsCompiled() const;
+  /// Release the program and all the bindings.
+  void Clear();
+
+  /** Evaluate the program.
+   * \param inputs The boolean inputs of the program, matching the input names used at compilation.
+   * \param result The result value, valid when RESULT_OK is returned.
+   */
+  Result Evaluate(const std::vector<bool> &inputs, Scalar &result);
+
+  /// Apply an unary operator, return false when the original value classes would raise an error.
+  static bool ApplyUnary(VALUE_OPERATOR op, const Scalar &value, Scalar &result);
+  /// Apply a binary operator, return false when the original value classes would raise an error.
+  static bool ApplyBinary(VALUE_OPERATOR op,
+                          const Scalar &left,
+                          const Scalar &right,
+                          Scalar &result);
+
+  /// Functions used by CExpression::Compile() implementations.
+  bool EmitConstant(CValue *value);
+  bool EmitIdentifier(const std::string &name);
+  void EmitUnary(VALUE_OPERATOR op);
+  void EmitBinary(VALUE_OPERATOR op);
+  /// Emit a conditional jump and return its index to be patched with PatchJump().
+  unsigned int EmitJumpIfFalse();
+  unsigned int EmitJump();
+  /// Set the target of a jump to the next emitted instruction.
+  void PatchJump(unsigned int jump);
+};
+
+#endif  // __EXP_COMPILEDEXPRESSION_H__
@@ -21,6 +21,8 @@
 
 #include "EXP_Value.h"
 
+class CCompiledExpression;
+
 class CExpression : public CM_RefCount<CExpression> {
  public:
   enum {
@@ -39,6 +41,8 @@ class CExpression : public CM_RefCount<CExpression> {
   CExpression();
 
   virtual CValue *Calculate() = 0;
+  /// Emit the instructions of this expression, return false if the expression can't be compiled.
+  virtual bool Compile(CCompiledExpression &compiled) = 0;
   virtual unsigned char GetExpressionID() = 0;
 };
 
@@ -44,6 +44,7 @@ class CIdentifierExpr : public CExpression {
   virtual ~CIdentifierExpr();
 
   virtual CValue *Calculate();
+  virtual bool Compile(CCompiledExpression &compiled);
   virtual unsigned char GetExpressionID();
 };
 
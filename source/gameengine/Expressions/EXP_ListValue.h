@@ -67,6 +67,7 @@ template<class ItemType> class CListValue : public CBaseListValue {
     for (unsigned int i = 0; i < numelements; i++) {
       replica->m_pValueArray[i] = m_pValueArray[i]->GetReplica();
     }
+    replica->InvalidateNameIndex();
 
     return replica;
   }
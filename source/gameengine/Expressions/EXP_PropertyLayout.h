@@ -0,0 +1,122 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file EXP_PropertyLayout.h
+ *  \ingroup expressions
+ */
+
+#ifndef __EXP_PROPERTYLAYOUT_H__
+#define __EXP_PROPERTYLAYOUT_H__
+
+#include "CM_RefCount.h"
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+class CValue;
+
+/** Name of a property looked up by many values of different layouts, e.g at each frame.
+ * Every layout caches the slot of the keys it is asked for, so that alternating between
+ * values of different layouts doesn't resolve the name again.
+ */
+class CPropertyKey {
+ private:
+  std::string m_name;
+  /// Index of the cached slot in the layouts, unique per key.
+  unsigned int m_index;
+
+ public:
+  explicit CPropertyKey(const std::string &name);
+
+  const std::string &GetName() const;
+  unsigned int GetIndex() const;
+};
+
+/** Table of property names to slot indices, shared between a value and its replicas.
+ *
+ * A layout is never modified once shared, adding a property to a value using a shared
+ * layout moves the value to a layout containing the new name. These layouts are cached
+ * per added name, so that all the replicas of a same object adding the same property
+ * (e.g "::timebomb") still share their layout.
+ * Removed properties keep their slot, so a slot index is valid as long as the layout is.
+ *
+ * To bound the memory used by values adding many different names (e.g generated names), a
+ * layout caches a limited number of transitions, past this the value gets its own layout.
+ * A value with more removed slots than properties moves to a new compacted layout.
+ */
+class CPropertyLayout : public CM_RefCount<CPropertyLayout> {
+ private:
+  std::vector<std::string> m_names;
+  std::unordered_map<std::string, unsigned int> m_slots;
+  /// Layouts with one more name, owned.
+  std::unordered_map<std::string, CPropertyLayout *> m_transitions;
+  /// Slots of the keys indexed by key index, resolved on first use.
+  mutable std::vector<int> m_keySlots;
+
+  /// Key slot not resolved yet.
+  static const int UnresolvedSlot = -2;
+
+  /// Maximum number of cached layouts with one more name.
+  static const unsigned int MaxTransitions = 64;
+
+ public:
+  CPropertyLayout();
+  CPropertyLayout(const CPropertyLayout &other);
+  /// Create a layout of the names in slot order.
+  CPropertyLayout(const std::vector<std::string> &names);
+  virtual ~CPropertyLayout();
+
+  /// Return the slot of a name or -1.
+  int GetSlot(const std::string &name) const;
+  /// Return the slot of a key or -1, cached in the layout.
+  int GetSlot(const CPropertyKey &key) const;
+  const std::string &GetName(unsigned int slot) const;
+  unsigned int GetSize() const;
+
+  /** Return a layout with the name added, the returned layout is referenced.
+   * \param slot Set to the slot of the added name.
+   */
+  CPropertyLayout *AddName(const std::string &name, unsigned int &slot);
+};
+
+/** Cached slot of a named property for users looking up a property at each frame.
+ * The slot is resolved again only when the layout of the owner changes, the layout
+ * is referenced to not be confused with a new layout allocated at the same address.
+ */
+class CPropertyBinding {
+ private:
+  CPropertyLayout *m_layout;
+  int m_slot;
+
+ public:
+  CPropertyBinding();
+  CPropertyBinding(const CPropertyBinding &other);
+  ~CPropertyBinding();
+
+  CPropertyBinding &operator=(const CPropertyBinding &other);
+
+  /// Return the property <name> of <owner> without reference or nullptr.
+  CValue *Get(CValue *owner, const std::string &name);
+  /// Force the resolution at the next call to Get(), used when the name changes.
+  void Reset();
+};
+
+#endif  // __EXP_PROPERTYLAYOUT_H__
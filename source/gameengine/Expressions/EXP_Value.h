@@ -25,7 +25,7 @@
 
 #include "CM_RefCount.h"
 
-#include <map>  // Array functionality for the property list.
+#include <map>
 #include <vector>
 #include <string>  // std::string class.
 
@@ -73,6 +73,9 @@ enum VALUE_DATA_TYPE {
 #  include "object.h"
 #endif
 
+class CPropertyLayout;
+class CBaseListValue;
+
 /**
  * Baseclass CValue
  *
@@ -95,6 +98,7 @@ enum VALUE_DATA_TYPE {
  */
 class CValue : public PyObjectPlus, public CM_RefCount<CValue> {
   Py_Header public : CValue();
+  CValue(const CValue &other);
   virtual ~CValue();
 
 #ifdef WITH_PYTHON
@@ -137,10 +141,12 @@ class CValue : public PyObjectPlus, public CM_RefCount<CValue> {
   /// Clear all properties.
   virtual void ClearProperties();
 
-  /// Get property number <inIndex>.
+  /// Get property in slot <inIndex> of the property layout, nullptr if the property was removed.
   virtual CValue *GetProperty(int inIndex);
-  /// Get the amount of properties assiocated with this value.
+  /// Get the amount of property slots assiocated with this value.
   virtual int GetPropertyCount();
+  /// Get the layout of the property slots, shared with the replicas, or nullptr.
+  CPropertyLayout *GetPropertyLayout() const;
 
   virtual CValue *FindIdentifier(const std::string &identifiername);
 
@@ -151,8 +157,11 @@ class CValue : public PyObjectPlus, public CM_RefCount<CValue> {
 
   /// Retrieve the name of the value.
   virtual std::string GetName() = 0;
-  /// Set the name of the value.
+  /// Set the name of the value, implementations must call NameChanged().
   virtual void SetName(const std::string &name);
+  /// Register a list indexing this value by name, its index is invalidated on renaming.
+  void AddNameIndexList(const CBaseListValue *list);
+  void RemoveNameIndexList(const CBaseListValue *list);
   /** Sets the value to this cvalue.
    * \attention this particular function should never be called. Why not abstract?
    */
@@ -174,10 +183,20 @@ class CValue : public PyObjectPlus, public CM_RefCount<CValue> {
  protected:
   virtual void DestructFromPython();
 
+  /// Invalidate the name index of the lists indexing this value.
+  void NameChanged();
+
  private:
-  /// Properties for user/game etc.
-  std::map<std::string, CValue *> *m_pNamedPropertyArray;
+  /// Name to slot table of the properties for user/game etc.
+  CPropertyLayout *m_propertyLayout;
+  /// Properties in slot order, nullptr for removed properties.
+  std::vector<CValue *> m_properties;
+  /// Lists indexing this value by name or nullptr, not copied to replicas.
+  std::vector<const CBaseListValue *> *m_nameIndexLists;
   bool m_error;
+
+  /// Move the properties to a new layout without the removed slots.
+  void CompactProperties();
 };
 
 /** CPropValue is a CValue derived class, that implements the identification (String name)
@@ -197,6 +216,7 @@ class CPropValue : public CValue {
   virtual void SetName(const std::string &name)
   {
     m_strNewName = name;
+    NameChanged();
   }
 
   virtual std::string GetName()
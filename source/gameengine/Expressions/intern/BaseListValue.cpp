@@ -27,12 +27,23 @@
 
 #include "BLI_sys_types.h"  // For intptr_t support.
 
-CBaseListValue::CBaseListValue() : m_bReleaseContents(true)
+CBaseListValue::CBaseListValue()
+    : m_bReleaseContents(true), m_nameIndexValid(false)
+{
+}
+
+CBaseListValue::CBaseListValue(const CBaseListValue &other)
+    : CPropValue(other),
+      m_pValueArray(other.m_pValueArray),
+      m_bReleaseContents(other.m_bReleaseContents),
+      m_nameIndexValid(false)
 {
 }
 
 CBaseListValue::~CBaseListValue()
 {
+  InvalidateNameIndex();
+
   if (m_bReleaseContents) {
     for (CValue *item : m_pValueArray) {
       item->Release();
@@ -40,9 +51,23 @@ CBaseListValue::~CBaseListValue()
   }
 }
 
+void CBaseListValue::InvalidateNameIndex() const
+{
+  if (m_nameIndexValid) {
+    for (const std::pair<const std::string, VectorType> &pair : m_nameIndex) {
+      for (CValue *item : pair.second) {
+        item->RemoveNameIndexList(this);
+      }
+    }
+    m_nameIndex.clear();
+    m_nameIndexValid = false;
+  }
+}
+
 void CBaseListValue::SetValue(int i, CValue *val)
 {
   m_pValueArray[i] = val;
+  InvalidateNameIndex();
 }
 
 CValue *CBaseListValue::GetValue(int i)
@@ -52,13 +77,17 @@ CValue *CBaseListValue::GetValue(int i)
 
 CValue *CBaseListValue::FindValue(const std::string &name) const
 {
-  const VectorTypeConstIterator it = std::find_if(
-      m_pValueArray.begin(), m_pValueArray.end(), [&name](CValue *item) {
-        return item->GetName() == name;
-      });
+  if (!m_nameIndexValid) {
+    for (CValue *item : m_pValueArray) {
+      m_nameIndex[item->GetName()].push_back(item);
+      item->AddNameIndexList(this);
+    }
+    m_nameIndexValid = true;
+  }
 
-  if (it != m_pValueArray.end()) {
-    return *it;
+  const std::unordered_map<std::string, VectorType>::const_iterator it = m_nameIndex.find(name);
+  if (it != m_nameIndex.end()) {
+    return it->second.front();
   }
   return NULL;
 }
@@ -75,11 +104,16 @@ bool CBaseListValue::SearchValue(CValue *val) const
 void CBaseListValue::Add(CValue *value)
 {
   m_pValueArray.push_back(value);
+  if (m_nameIndexValid) {
+    m_nameIndex[value->GetName()].push_back(value);
+    value->AddNameIndexList(this);
+  }
 }
 
 void CBaseListValue::Insert(unsigned int i, CValue *value)
 {
   m_pValueArray.insert(m_pValueArray.begin() + i, value);
+  InvalidateNameIndex();
 }
 
 bool CBaseListValue::RemoveValue(CValue *val)
@@ -94,6 +128,20 @@ bool CBaseListValue::RemoveValue(CValue *val)
       ++it;
     }
   }
+
+  if (result && m_nameIndexValid) {
+    val->RemoveNameIndexList(this);
+    const std::unordered_map<std::string, VectorType>::iterator it = m_nameIndex.find(
+        val->GetName());
+    if (it != m_nameIndex.end()) {
+      VectorType &items = it->second;
+      items.erase(std::remove(items.begin(), items.end(), val), items.end());
+      if (items.empty()) {
+        m_nameIndex.erase(it);
+      }
+    }
+  }
+
   return result;
 }
 
@@ -140,11 +188,13 @@ void CBaseListValue::SetReleaseOnDestruct(bool bReleaseContents)
 void CBaseListValue::Remove(int i)
 {
   m_pValueArray.erase(m_pValueArray.begin() + i);
+  InvalidateNameIndex();
 }
 
 void CBaseListValue::Resize(int num)
 {
   m_pValueArray.resize(num);
+  InvalidateNameIndex();
 }
 
 void CBaseListValue::ReleaseAndRemoveAll()
@@ -153,6 +203,7 @@ void CBaseListValue::ReleaseAndRemoveAll()
     item->Release();
   }
   m_pValueArray.clear();
+  InvalidateNameIndex();
 }
 
 int CBaseListValue::GetCount() const
@@ -477,6 +528,7 @@ PyObject *CBaseListValue::Pyreverse()
   }
 
   std::reverse(m_pValueArray.begin(), m_pValueArray.end());
+  InvalidateNameIndex();
   Py_RETURN_NONE;
 }
 
@@ -0,0 +1,568 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file gameengine/Expressions/intern/CompiledExpression.cpp
+ *  \ingroup expressions
+ */
+
+#include "EXP_CompiledExpression.h"
+#include "EXP_Expression.h"
+#include "EXP_BoolValue.h"
+#include "EXP_FloatValue.h"
+
+#include <algorithm>
+#include <cmath>
+
+CCompiledExpression::Scalar::Scalar() : m_type(VALUE_NO_TYPE), m_int(0)
+{
+}
+
+CCompiledExpression::Scalar::Scalar(bool value) : m_type(VALUE_BOOL_TYPE), m_int(0)
+{
+  m_bool = value;
+}
+
+CCompiledExpression::Scalar::Scalar(cInt value) : m_type(VALUE_INT_TYPE), m_int(value)
+{
+}
+
+CCompiledExpression::Scalar::Scalar(float value) : m_type(VALUE_FLOAT_TYPE), m_int(0)
+{
+  m_float = value;
+}
+
+double CCompiledExpression::Scalar::GetNumber() const
+{
+  switch (m_type) {
+    case VALUE_BOOL_TYPE: {
+      return (double)m_bool;
+    }
+    case VALUE_INT_TYPE: {
+      return (double)m_int;
+    }
+    case VALUE_FLOAT_TYPE: {
+      return m_float;
+    }
+    default: {
+      return -1.0;
+    }
+  }
+}
+
+bool CCompiledExpression::Scalar::FromValue(CValue *value, Scalar &scalar)
+{
+  switch (value->GetValueType()) {
+    case VALUE_BOOL_TYPE: {
+      scalar = Scalar(static_cast<CBoolValue *>(value)->GetBool());
+      return true;
+    }
+    case VALUE_INT_TYPE: {
+      scalar = Scalar(static_cast<CIntValue *>(value)->GetInt());
+      return true;
+    }
+    case VALUE_FLOAT_TYPE: {
+      scalar = Scalar(static_cast<CFloatValue *>(value)->GetFloat());
+      return true;
+    }
+    default: {
+      return false;
+    }
+  }
+}
+
+CCompiledExpression::CCompiledExpression()
+    : m_stackSize(0),
+      m_jumpTarget(0),
+      m_inputNames(nullptr),
+      m_owner(nullptr)
+{
+}
+
+CCompiledExpression::~CCompiledExpression()
+{
+}
+
+bool CCompiledExpression::Compile(CExpression *expr,
+                                  const std::vector<std::string> &inputNames,
+                                  CValue *owner)
+{
+  Clear();
+
+  m_inputNames = &inputNames;
+  m_owner = owner;
+
+  const bool success = expr->Compile(*this);
+  m_inputNames = nullptr;
+
+  if (!success || !CheckProperties()) {
+    Clear();
+    return false;
+  }
+
+  UpdateStackSize();
+
+  return true;
+}
+
+bool CCompiledExpression::IsCompiled() const
+{
+  return !m_instructions.empty();
+}
+
+void CCompiledExpression::Clear()
+{
+  m_instructions.clear();
+  m_properties.clear();
+  m_stack.clear();
+  m_stackSize = 0;
+  m_jumpTarget = 0;
+  m_owner = nullptr;
+}
+
+void CCompiledExpression::UpdateStackSize()
+{
+  // Both branches of a condition are counted, the depth can only be over-estimated.
+  int depth = 0;
+  int maxdepth = 0;
+  for (const Instruction &instruction : m_instructions) {
+    switch (instruction.m_code) {
+      case OP_CONSTANT:
+      case OP_INPUT:
+      case OP_PROPERTY: {
+        ++depth;
+        break;
+      }
+      case OP_BINARY:
+      case OP_JUMP_IF_FALSE: {
+        --depth;
+        break;
+      }
+      case OP_UNARY:
+      case OP_JUMP: {
+        break;
+      }
+    }
+    maxdepth = std::max(maxdepth, depth);
+  }
+
+  m_stackSize = maxdepth;
+  m_stack.resize(m_stackSize);
+}
+
+bool CCompiledExpression::CheckProperties()
+{
+  for (PropertyBinding &binding : m_properties) {
+    CValue *prop = binding.m_binding.Get(m_owner, binding.m_name);
+    Scalar scalar;
+    if (!prop || !Scalar::FromValue(prop, scalar)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+CCompiledExpression::Result CCompiledExpression::Evaluate(const std::vector<bool> &inputs,
+                                                          Scalar &result)
+{
+  Scalar *stack = m_stack.data();
+  unsigned int top = 0;
+
+  for (unsigned int i = 0, size = m_instructions.size(); i < size; ++i) {
+    const Instruction &instruction = m_instructions[i];
+    switch (instruction.m_code) {
+      case OP_CONSTANT: {
+        stack[top++] = instruction.m_constant;
+        break;
+      }
+      case OP_INPUT: {
+        stack[top++] = Scalar((bool)inputs[instruction.m_index]);
+        break;
+      }
+      case OP_PROPERTY: {
+        PropertyBinding &binding = m_properties[instruction.m_index];
+        CValue *prop = binding.m_binding.Get(m_owner, binding.m_name);
+        if (!prop || !Scalar::FromValue(prop, stack[top++])) {
+          return RESULT_INVALID;
+        }
+        break;
+      }
+      case OP_UNARY: {
+        Scalar &value = stack[top - 1];
+        if (!ApplyUnary(instruction.m_op, value, value)) {
+          return RESULT_ERROR;
+        }
+        break;
+      }
+      case OP_BINARY: {
+        --top;
+        Scalar &left = stack[top - 1];
+        if (!ApplyBinary(instruction.m_op, left, stack[top], left)) {
+          return RESULT_ERROR;
+        }
+        break;
+      }
+      case OP_JUMP_IF_FALSE: {
+        const Scalar &guard = stack[--top];
+        if (guard.m_type != VALUE_BOOL_TYPE) {
+          return RESULT_ERROR;
+        }
+        if (!guard.m_bool) {
+          // The loop increment moves to the target.
+          i = instruction.m_index - 1;
+        }
+        break;
+      }
+      case OP_JUMP: {
+        i = instruction.m_index - 1;
+        break;
+      }
+    }
+  }
+
+  result = stack[0];
+  return RESULT_OK;
+}
+
+bool CCompiledExpression::ApplyUnary(VALUE_OPERATOR op, const Scalar &value, Scalar &result)
+{
+  switch (value.m_type) {
+    case VALUE_BOOL_TYPE: {
+      if (op == VALUE_NOT_OPERATOR) {
+        result = Scalar(!value.m_bool);
+        return true;
+      }
+      return false;
+    }
+    case VALUE_INT_TYPE: {
+      switch (op) {
+        case VALUE_NEG_OPERATOR: {
+          result = Scalar(-value.m_int);
+          return true;
+        }
+        case VALUE_POS_OPERATOR: {
+          result = value;
+          return true;
+        }
+        case VALUE_NOT_OPERATOR: {
+          result = Scalar(value.m_int == 0);
+          return true;
+        }
+        default: {
+          return false;
+        }
+      }
+    }
+    case VALUE_FLOAT_TYPE: {
+      switch (op) {
+        case VALUE_NEG_OPERATOR: {
+          result = Scalar(-value.m_float);
+          return true;
+        }
+        case VALUE_POS_OPERATOR: {
+          result = value;
+          return true;
+        }
+        case VALUE_NOT_OPERATOR: {
+          result = Scalar(value.m_float == 0.0f);
+          return true;
+        }
+        default: {
+          return false;
+        }
+      }
+    }
+    default: {
+      return false;
+    }
+  }
+}
+
+bool CCompiledExpression::ApplyBinary(VALUE_OPERATOR op,
+                                      const Scalar &left,
+                                      const Scalar &right,
+                                      Scalar &result)
+{
+  // Booleans only operate with booleans.
+  if (left.m_type == VALUE_BOOL_TYPE || right.m_type == VALUE_BOOL_TYPE) {
+    if (left.m_type != right.m_type) {
+      return false;
+    }
+    switch (op) {
+      case VALUE_AND_OPERATOR: {
+        result = Scalar(left.m_bool && right.m_bool);
+        return true;
+      }
+      case VALUE_OR_OPERATOR: {
+        result = Scalar(left.m_bool || right.m_bool);
+        return true;
+      }
+      case VALUE_EQL_OPERATOR: {
+        result = Scalar(left.m_bool == right.m_bool);
+        return true;
+      }
+      case VALUE_NEQ_OPERATOR: {
+        result = Scalar(left.m_bool != right.m_bool);
+        return true;
+      }
+      default: {
+        return false;
+      }
+    }
+  }
+
+  if (left.m_type == VALUE_INT_TYPE && right.m_type == VALUE_INT_TYPE) {
+    const cInt l = left.m_int;
+    const cInt r = right.m_int;
+    switch (op) {
+      case VALUE_MOD_OPERATOR: {
+        if (r == 0) {
+          return false;
+        }
+        result = Scalar(l % r);
+        return true;
+      }
+      case VALUE_ADD_OPERATOR: {
+        result = Scalar(l + r);
+        return true;
+      }
+      case VALUE_SUB_OPERATOR: {
+        result = Scalar(l - r);
+        return true;
+      }
+      case VALUE_MUL_OPERATOR: {
+        result = Scalar(l * r);
+        return true;
+      }
+      case VALUE_DIV_OPERATOR: {
+        if (r == 0) {
+          return false;
+        }
+        result = Scalar(l / r);
+        return true;
+      }
+      case VALUE_EQL_OPERATOR: {
+        result = Scalar(l == r);
+        return true;
+      }
+      case VALUE_NEQ_OPERATOR: {
+        result = Scalar(l != r);
+        return true;
+      }
+      case VALUE_GRE_OPERATOR: {
+        result = Scalar(l > r);
+        return true;
+      }
+      case VALUE_LES_OPERATOR: {
+        result = Scalar(l < r);
+        return true;
+      }
+      case VALUE_GEQ_OPERATOR: {
+        result = Scalar(l >= r);
+        return true;
+      }
+      case VALUE_LEQ_OPERATOR: {
+        result = Scalar(l <= r);
+        return true;
+      }
+      default: {
+        return false;
+      }
+    }
+  }
+
+  // Mixed integer and float values are computed as float as CIntValue and CFloatValue do.
+  const float l = (left.m_type == VALUE_INT_TYPE) ? (float)left.m_int : left.m_float;
+  const float r = (right.m_type == VALUE_INT_TYPE) ? (float)right.m_int : right.m_float;
+  switch (op) {
+    case VALUE_MOD_OPERATOR: {
+      result = Scalar((float)fmod(l, r));
+      return true;
+    }
+    case VALUE_ADD_OPERATOR: {
+      result = Scalar(l + r);
+      return true;
+    }
+    case VALUE_SUB_OPERATOR: {
+      result = Scalar(l - r);
+      return true;
+    }
+    case VALUE_MUL_OPERATOR: {
+      result = Scalar(l * r);
+      return true;
+    }
+    case VALUE_DIV_OPERATOR: {
+      if (r == 0.0f) {
+        return false;
+      }
+      result = Scalar(l / r);
+      return true;
+    }
+    case VALUE_EQL_OPERATOR: {
+      result = Scalar(l == r);
+      return true;
+    }
+    case VALUE_NEQ_OPERATOR: {
+      result = Scalar(l != r);
+      return true;
+    }
+    case VALUE_GRE_OPERATOR: {
+      result = Scalar(l > r);
+      return true;
+    }
+    case VALUE_LES_OPERATOR: {
+      result = Scalar(l < r);
+      return true;
+    }
+    case VALUE_GEQ_OPERATOR: {
+      result = Scalar(l >= r);
+      return true;
+    }
+    case VALUE_LEQ_OPERATOR: {
+      result = Scalar(l <= r);
+      return true;
+    }
+    default: {
+      return false;
+    }
+  }
+}
+
+bool CCompiledExpression::EmitConstant(CValue *value)
+{
+  Instruction instruction;
+  instruction.m_code = OP_CONSTANT;
+  instruction.m_op = VALUE_NO_OPERATOR;
+  instruction.m_index = 0;
+  if (!Scalar::FromValue(value, instruction.m_constant)) {
+    return false;
+  }
+
+  m_instructions.push_back(instruction);
+  return true;
+}
+
+bool CCompiledExpression::EmitIdentifier(const std::string &name)
+{
+  Instruction instruction;
+  instruction.m_op = VALUE_NO_OPERATOR;
+
+  // Inputs have priority over properties.
+  const std::vector<std::string>::const_iterator it = std::find(
+      m_inputNames->begin(), m_inputNames->end(), name);
+  if (it != m_inputNames->end()) {
+    instruction.m_code = OP_INPUT;
+    instruction.m_index = it - m_inputNames->begin();
+  }
+  // Sub-context identifiers are not supported.
+  else if (m_owner && name.find('.') == std::string::npos) {
+    instruction.m_code = OP_PROPERTY;
+    instruction.m_index = m_properties.size();
+    for (unsigned int i = 0, size = m_properties.size(); i < size; ++i) {
+      if (m_properties[i].m_name == name) {
+        instruction.m_index = i;
+        break;
+      }
+    }
+    if (instruction.m_index == m_properties.size()) {
+      PropertyBinding binding;
+      binding.m_name = name;
+      m_properties.push_back(binding);
+    }
+  }
+  else {
+    return false;
+  }
+
+  m_instructions.push_back(instruction);
+  return true;
+}
+
+void CCompiledExpression::EmitUnary(VALUE_OPERATOR op)
+{
+  const unsigned int size = m_instructions.size();
+  // Constant folding, the operand must not be a jump target (e.g. the end of an if branch).
+  // Errors are kept to be raised at evaluation.
+  if (size >= 1 && m_jumpTarget <= (size - 1) &&
+      m_instructions[size - 1].m_code == OP_CONSTANT) {
+    Instruction &constant = m_instructions.back();
+    Scalar result;
+    if (ApplyUnary(op, constant.m_constant, result)) {
+      constant.m_constant = result;
+      return;
+    }
+  }
+
+  Instruction instruction;
+  instruction.m_code = OP_UNARY;
+  instruction.m_op = op;
+  instruction.m_index = 0;
+  m_instructions.push_back(instruction);
+}
+
+void CCompiledExpression::EmitBinary(VALUE_OPERATOR op)
+{
+  const unsigned int size = m_instructions.size();
+  // Constant folding, the right operand must not be a jump target.
+  if (size >= 2 && m_jumpTarget <= (size - 2) &&
+      m_instructions[size - 2].m_code == OP_CONSTANT &&
+      m_instructions[size - 1].m_code == OP_CONSTANT) {
+    Instruction &left = m_instructions[size - 2];
+    Scalar result;
+    if (ApplyBinary(op, left.m_constant, m_instructions[size - 1].m_constant, result)) {
+      left.m_constant = result;
+      m_instructions.pop_back();
+      return;
+    }
+  }
+
+  Instruction instruction;
+  instruction.m_code = OP_BINARY;
+  instruction.m_op = op;
+  instruction.m_index = 0;
+  m_instructions.push_back(instruction);
+}
+
+unsigned int CCompiledExpression::EmitJumpIfFalse()
+{
+  Instruction instruction;
+  instruction.m_code = OP_JUMP_IF_FALSE;
+  instruction.m_op = VALUE_NO_OPERATOR;
+  instruction.m_index = 0;
+  m_instructions.push_back(instruction);
+
+  return m_instructions.size() - 1;
+}
+
+unsigned int CCompiledExpression::EmitJump()
+{
+  Instruction instruction;
+  instruction.m_code = OP_JUMP;
+  instruction.m_op = VALUE_NO_OPERATOR;
+  instruction.m_index = 0;
+  m_instructions.push_back(instruction);
+
+  return m_instructions.size() - 1;
+}
+
+void CCompiledExpression::PatchJump(unsigned int jump)
+{
+  m_instructions[jump].m_index = m_jumpTarget = m_instructions.size();
+}
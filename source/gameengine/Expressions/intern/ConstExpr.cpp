@@ -18,6 +18,7 @@
 
 #include "EXP_Value.h"
 #include "EXP_ConstExpr.h"
+#include "EXP_CompiledExpression.h"
 
 CConstExpr::CConstExpr()
 {
@@ -45,6 +46,11 @@ CValue *CConstExpr::Calculate()
   return m_value->AddRef();
 }
 
+bool CConstExpr::Compile(CCompiledExpression &compiled)
+{
+  return compiled.EmitConstant(m_value);
+}
+
 double CConstExpr::GetNumber()
 {
   return -1.0;
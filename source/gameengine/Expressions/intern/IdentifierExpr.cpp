@@ -30,6 +30,7 @@
  */
 
 #include "EXP_IdentifierExpr.h"
+#include "EXP_CompiledExpression.h"
 
 CIdentifierExpr::CIdentifierExpr(const std::string &identifier, CValue *id_context)
     : m_identifier(identifier)
@@ -59,6 +60,11 @@ CValue *CIdentifierExpr::Calculate()
   return result;
 }
 
+bool CIdentifierExpr::Compile(CCompiledExpression &compiled)
+{
+  return compiled.EmitIdentifier(m_identifier);
+}
+
 unsigned char CIdentifierExpr::GetExpressionID()
 {
   return CIDENTIFIEREXPRESSIONID;
@@ -19,6 +19,7 @@
 #include "EXP_EmptyValue.h"
 #include "EXP_ErrorValue.h"
 #include "EXP_BoolValue.h"
+#include "EXP_CompiledExpression.h"
 
 CIfExpr::CIfExpr()
 {
@@ -61,6 +62,27 @@ CValue *CIfExpr::Calculate()
   }
 }
 
+bool CIfExpr::Compile(CCompiledExpression &compiled)
+{
+  if (!m_guard->Compile(compiled)) {
+    return false;
+  }
+
+  const unsigned int elsejump = compiled.EmitJumpIfFalse();
+  if (!m_e1->Compile(compiled)) {
+    return false;
+  }
+
+  const unsigned int endjump = compiled.EmitJump();
+  compiled.PatchJump(elsejump);
+  if (!m_e2->Compile(compiled)) {
+    return false;
+  }
+
+  compiled.PatchJump(endjump);
+  return true;
+}
+
 unsigned char CIfExpr::GetExpressionID()
 {
   return CIFEXPRESSIONID;
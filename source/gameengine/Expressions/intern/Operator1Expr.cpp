@@ -17,6 +17,7 @@
 
 #include "EXP_Operator1Expr.h"
 #include "EXP_EmptyValue.h"
+#include "EXP_CompiledExpression.h"
 
 COperator1Expr::COperator1Expr() : m_lhs(nullptr)
 {
@@ -49,3 +50,13 @@ CValue *COperator1Expr::Calculate()
 
   return ret;
 }
+
+bool COperator1Expr::Compile(CCompiledExpression &compiled)
+{
+  if (!m_lhs->Compile(compiled)) {
+    return false;
+  }
+
+  compiled.EmitUnary(m_op);
+  return true;
+}
@@ -17,6 +17,7 @@
 
 #include "EXP_Operator2Expr.h"
 #include "EXP_StringValue.h"
+#include "EXP_CompiledExpression.h"
 
 COperator2Expr::COperator2Expr(VALUE_OPERATOR op, CExpression *lhs, CExpression *rhs)
     : m_rhs(rhs), m_lhs(lhs), m_op(op)
@@ -55,3 +56,13 @@ CValue *COperator2Expr::Calculate()
 
   return calculate;
 }
+
+bool COperator2Expr::Compile(CCompiledExpression &compiled)
+{
+  if (!m_lhs->Compile(compiled) || !m_rhs->Compile(compiled)) {
+    return false;
+  }
+
+  compiled.EmitBinary(m_op);
+  return true;
+}
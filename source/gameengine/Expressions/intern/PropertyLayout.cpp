@@ -0,0 +1,198 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file gameengine/Expressions/intern/PropertyLayout.cpp
+ *  \ingroup expressions
+ */
+
+#include "EXP_PropertyLayout.h"
+#include "EXP_Value.h"
+
+#include <atomic>
+
+CPropertyKey::CPropertyKey(const std::string &name) : m_name(name)
+{
+  // Keys can be created by the conversion threads.
+  static std::atomic<unsigned int> lastIndex(0);
+  m_index = lastIndex++;
+}
+
+const std::string &CPropertyKey::GetName() const
+{
+  return m_name;
+}
+
+unsigned int CPropertyKey::GetIndex() const
+{
+  return m_index;
+}
+
+const int CPropertyLayout::UnresolvedSlot;
+
+CPropertyLayout::CPropertyLayout()
+{
+}
+
+CPropertyLayout::CPropertyLayout(const CPropertyLayout &other)
+    : CM_RefCount<CPropertyLayout>(), m_names(other.m_names), m_slots(other.m_slots)
+{
+}
+
+CPropertyLayout::CPropertyLayout(const std::vector<std::string> &names) : m_names(names)
+{
+  for (unsigned int i = 0, size = m_names.size(); i < size; ++i) {
+    m_slots[m_names[i]] = i;
+  }
+}
+
+CPropertyLayout::~CPropertyLayout()
+{
+  for (const auto &pair : m_transitions) {
+    pair.second->Release();
+  }
+}
+
+int CPropertyLayout::GetSlot(const std::string &name) const
+{
+  const std::unordered_map<std::string, unsigned int>::const_iterator it = m_slots.find(name);
+  if (it == m_slots.end()) {
+    return -1;
+  }
+  return it->second;
+}
+
+int CPropertyLayout::GetSlot(const CPropertyKey &key) const
+{
+  const unsigned int index = key.GetIndex();
+  if (index >= m_keySlots.size()) {
+    m_keySlots.resize(index + 1, UnresolvedSlot);
+  }
+
+  int &slot = m_keySlots[index];
+  if (slot == UnresolvedSlot) {
+    slot = GetSlot(key.GetName());
+  }
+  return slot;
+}
+
+const std::string &CPropertyLayout::GetName(unsigned int slot) const
+{
+  return m_names[slot];
+}
+
+unsigned int CPropertyLayout::GetSize() const
+{
+  return m_names.size();
+}
+
+CPropertyLayout *CPropertyLayout::AddName(const std::string &name, unsigned int &slot)
+{
+  slot = m_names.size();
+
+  // Nobody else is using this layout, it can be modified.
+  if (GetRefCount() == 1 && m_transitions.empty()) {
+    m_names.push_back(name);
+    m_slots[name] = slot;
+    // The key may have been cached as missing.
+    m_keySlots.clear();
+    return AddRef();
+  }
+
+  const std::unordered_map<std::string, CPropertyLayout *>::iterator it = m_transitions.find(
+      name);
+  if (it != m_transitions.end()) {
+    return it->second->AddRef();
+  }
+
+  CPropertyLayout *layout = new CPropertyLayout(*this);
+  layout->m_names.push_back(name);
+  layout->m_slots[name] = slot;
+
+  // Too many names were added to this layout, the new layout is only used by the caller.
+  if (m_transitions.size() >= MaxTransitions) {
+    return layout;
+  }
+
+  m_transitions[name] = layout;
+
+  return layout->AddRef();
+}
+
+CPropertyBinding::CPropertyBinding() : m_layout(nullptr), m_slot(-1)
+{
+}
+
+CPropertyBinding::CPropertyBinding(const CPropertyBinding &other)
+    : m_layout(other.m_layout), m_slot(other.m_slot)
+{
+  if (m_layout) {
+    m_layout->AddRef();
+  }
+}
+
+CPropertyBinding::~CPropertyBinding()
+{
+  if (m_layout) {
+    m_layout->Release();
+  }
+}
+
+CPropertyBinding &CPropertyBinding::operator=(const CPropertyBinding &other)
+{
+  if (other.m_layout) {
+    other.m_layout->AddRef();
+  }
+  if (m_layout) {
+    m_layout->Release();
+  }
+  m_layout = other.m_layout;
+  m_slot = other.m_slot;
+
+  return *this;
+}
+
+CValue *CPropertyBinding::Get(CValue *owner, const std::string &name)
+{
+  CPropertyLayout *layout = owner->GetPropertyLayout();
+  if (layout != m_layout) {
+    if (layout) {
+      layout->AddRef();
+    }
+    if (m_layout) {
+      m_layout->Release();
+    }
+    m_layout = layout;
+    m_slot = layout ? layout->GetSlot(name) : -1;
+  }
+
+  if (m_slot == -1) {
+    return nullptr;
+  }
+  return owner->GetProperty(m_slot);
+}
+
+void CPropertyBinding::Reset()
+{
+  if (m_layout) {
+    m_layout->Release();
+    m_layout = nullptr;
+  }
+  m_slot = -1;
+}
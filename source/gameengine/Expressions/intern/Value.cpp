@@ -18,6 +18,7 @@
  *
  */
 #include "EXP_Value.h"
+#include "EXP_PropertyLayout.h"
 #include "EXP_BoolValue.h"
 #include "EXP_FloatValue.h"
 #include "EXP_IntValue.h"
@@ -25,6 +26,8 @@
 #include "EXP_ErrorValue.h"
 #include "EXP_ListValue.h"
 
+#include <algorithm>
+
 #ifdef WITH_PYTHON
 
 PyTypeObject CValue::Type = {PyVarObject_HEAD_INIT(nullptr, 0) "CValue",
@@ -70,12 +73,24 @@ PyMethodDef CValue::Methods[] = {
 };
 #endif  // WITH_PYTHON
 
-CValue::CValue() : m_pNamedPropertyArray(nullptr), m_error(false)
+CValue::CValue() : m_propertyLayout(nullptr), m_nameIndexLists(nullptr), m_error(false)
+{
+}
+
+CValue::CValue(const CValue &other)
+    : PyObjectPlus(other),
+      CM_RefCount<CValue>(other),
+      m_propertyLayout(other.m_propertyLayout),
+      m_properties(other.m_properties),
+      m_nameIndexLists(nullptr),
+      m_error(other.m_error)
 {
 }
 
 CValue::~CValue()
 {
+  // The lists must not keep a destructed value in their index.
+  NameChanged();
   ClearProperties();
 }
 
@@ -154,29 +169,39 @@ void CValue::SetProperty(const std::string &name, CValue *ioProperty)
   }
 
   // Try to replace property (if so -> exit as soon as we replaced it).
-  if (m_pNamedPropertyArray) {
-    CValue *oldval = (*m_pNamedPropertyArray)[name];
+  const int slot = m_propertyLayout ? m_propertyLayout->GetSlot(name) : -1;
+  if (slot != -1) {
+    CValue *oldval = m_properties[slot];
     if (oldval) {
       oldval->Release();
     }
+    m_properties[slot] = ioProperty->AddRef();
+    return;
   }
-  // Make sure we have a property array.
-  else {
-    m_pNamedPropertyArray = new std::map<std::string, CValue *>;
+
+  // Make sure we have a property layout.
+  if (!m_propertyLayout) {
+    m_propertyLayout = new CPropertyLayout();
   }
 
-  // Add property at end of array.
-  (*m_pNamedPropertyArray)[name] = ioProperty->AddRef();
+  // Add property at end of array, the layout is changed if shared.
+  unsigned int newslot;
+  CPropertyLayout *layout = m_propertyLayout->AddName(name, newslot);
+  m_propertyLayout->Release();
+  m_propertyLayout = layout;
+
+  m_properties.resize(m_propertyLayout->GetSize(), nullptr);
+  m_properties[newslot] = ioProperty->AddRef();
 }
 
 /// Get pointer to a property with name <inName>, returns nullptr if there is no property named
 /// <inName>.
 CValue *CValue::GetProperty(const std::string &inName)
 {
-  if (m_pNamedPropertyArray) {
-    std::map<std::string, CValue *>::iterator it = m_pNamedPropertyArray->find(inName);
-    if (it != m_pNamedPropertyArray->end()) {
-      return (*it).second;
+  if (m_propertyLayout) {
+    const int slot = m_propertyLayout->GetSlot(inName);
+    if (slot != -1) {
+      return m_properties[slot];
     }
   }
   return nullptr;
@@ -211,11 +236,22 @@ float CValue::GetPropertyNumber(const std::string &inName, float defnumber)
 bool CValue::RemoveProperty(const std::string &inName)
 {
   // Check if there are properties at all which can be removed.
-  if (m_pNamedPropertyArray) {
-    std::map<std::string, CValue *>::iterator it = m_pNamedPropertyArray->find(inName);
-    if (it != m_pNamedPropertyArray->end()) {
-      ((*it).second)->Release();
-      m_pNamedPropertyArray->erase(it);
+  if (m_propertyLayout) {
+    const int slot = m_propertyLayout->GetSlot(inName);
+    // The slot is kept in the layout, only the value is released.
+    if (slot != -1 && m_properties[slot]) {
+      m_properties[slot]->Release();
+      m_properties[slot] = nullptr;
+
+      // Don't keep growing the layout when names are added and removed continuously.
+      const unsigned int count = m_properties.size();
+      if (count >= 8) {
+        const unsigned int removed = std::count(
+            m_properties.begin(), m_properties.end(), nullptr);
+        if (removed > count / 2) {
+          CompactProperties();
+        }
+      }
       return true;
     }
   }
@@ -223,19 +259,39 @@ bool CValue::RemoveProperty(const std::string &inName)
   return false;
 }
 
+void CValue::CompactProperties()
+{
+  std::vector<std::string> names;
+  std::vector<CValue *> properties;
+  for (unsigned int i = 0, size = m_properties.size(); i < size; ++i) {
+    if (m_properties[i]) {
+      names.push_back(m_propertyLayout->GetName(i));
+      properties.push_back(m_properties[i]);
+    }
+  }
+
+  // The new layout isn't shared, property bindings resolve their slot again.
+  m_propertyLayout->Release();
+  m_propertyLayout = new CPropertyLayout(names);
+  m_properties = properties;
+}
+
 /// Get Property Names.
 std::vector<std::string> CValue::GetPropertyNames()
 {
   std::vector<std::string> result;
-  if (!m_pNamedPropertyArray) {
+  if (!m_propertyLayout) {
     return result;
   }
-  result.reserve(m_pNamedPropertyArray->size());
+  result.reserve(m_properties.size());
 
-  std::map<std::string, CValue *>::iterator it;
-  for (it = m_pNamedPropertyArray->begin(); (it != m_pNamedPropertyArray->end()); it++) {
-    result.push_back((*it).first);
+  for (unsigned int i = 0, size = m_properties.size(); i < size; ++i) {
+    if (m_properties[i]) {
+      result.push_back(m_propertyLayout->GetName(i));
+    }
   }
+  // Sorted by name like before the slots, independently of the addition order.
+  std::sort(result.begin(), result.end());
   return result;
 }
 
@@ -243,49 +299,41 @@ std::vector<std::string> CValue::GetPropertyNames()
 void CValue::ClearProperties()
 {
   // Check if we have any properties.
-  if (m_pNamedPropertyArray == nullptr) {
+  if (m_propertyLayout == nullptr) {
     return;
   }
 
   // Remove all properties.
-  std::map<std::string, CValue *>::iterator it;
-  for (it = m_pNamedPropertyArray->begin(); (it != m_pNamedPropertyArray->end()); it++) {
-    CValue *tmpval = (*it).second;
-    tmpval->Release();
+  for (CValue *tmpval : m_properties) {
+    if (tmpval) {
+      tmpval->Release();
+    }
   }
 
-  // Delete property array.
-  delete m_pNamedPropertyArray;
-  m_pNamedPropertyArray = nullptr;
+  // Release property layout.
+  m_properties.clear();
+  m_propertyLayout->Release();
+  m_propertyLayout = nullptr;
 }
 
-/// Get property number <inIndex>.
+/// Get property in slot <inIndex>.
 CValue *CValue::GetProperty(int inIndex)
 {
-  int count = 0;
-  CValue *result = nullptr;
-
-  if (m_pNamedPropertyArray) {
-    std::map<std::string, CValue *>::iterator it;
-    for (it = m_pNamedPropertyArray->begin(); (it != m_pNamedPropertyArray->end()); it++) {
-      if (count++ == inIndex) {
-        result = (*it).second;
-        break;
-      }
-    }
+  if (inIndex < 0 || inIndex >= (int)m_properties.size()) {
+    return nullptr;
   }
-  return result;
+  return m_properties[inIndex];
 }
 
-/// Get the amount of properties assiocated with this value.
+/// Get the amount of property slots assiocated with this value.
 int CValue::GetPropertyCount()
 {
-  if (m_pNamedPropertyArray) {
-    return m_pNamedPropertyArray->size();
-  }
-  else {
-    return 0;
-  }
+  return m_properties.size();
+}
+
+CPropertyLayout *CValue::GetPropertyLayout() const
+{
+  return m_propertyLayout;
 }
 
 void CValue::DestructFromPython()
@@ -301,15 +349,13 @@ void CValue::ProcessReplica()
 {
   PyObjectPlus::ProcessReplica();
 
-  // Copy all props.
-  if (m_pNamedPropertyArray) {
-    std::map<std::string, CValue *> *pOldArray = m_pNamedPropertyArray;
-    m_pNamedPropertyArray = nullptr;
-    std::map<std::string, CValue *>::iterator it;
-    for (it = pOldArray->begin(); (it != pOldArray->end()); it++) {
-      CValue *val = (*it).second->GetReplica();
-      SetProperty((*it).first, val);
-      val->Release();
+  // Copy all props, the replica shares the same layout.
+  if (m_propertyLayout) {
+    m_propertyLayout->AddRef();
+    for (CValue *&val : m_properties) {
+      if (val) {
+        val = val->GetReplica();
+      }
     }
   }
 }
@@ -410,20 +456,18 @@ CValue *CValue::ConvertPythonToValue(PyObject *pyobj,
 
 PyObject *CValue::ConvertKeysToPython(void)
 {
-  if (m_pNamedPropertyArray) {
-    PyObject *pylist = PyList_New(m_pNamedPropertyArray->size());
-    Py_ssize_t i = 0;
-
-    std::map<std::string, CValue *>::iterator it;
-    for (it = m_pNamedPropertyArray->begin(); (it != m_pNamedPropertyArray->end()); it++) {
-      PyList_SET_ITEM(pylist, i++, PyUnicode_FromStdString((*it).first));
+  PyObject *pylist = PyList_New(0);
+  if (m_propertyLayout) {
+    for (unsigned int i = 0, size = m_properties.size(); i < size; ++i) {
+      if (m_properties[i]) {
+        PyObject *pyname = PyUnicode_FromStdString(m_propertyLayout->GetName(i));
+        PyList_Append(pylist, pyname);
+        Py_DECREF(pyname);
+      }
     }
-
-    return pylist;
-  }
-  else {
-    return PyList_New(0);
   }
+
+  return pylist;
 }
 
 #endif  // WITH_PYTHON
@@ -458,6 +502,43 @@ void CValue::SetName(const std::string &name)
 {
 }
 
+void CValue::AddNameIndexList(const CBaseListValue *list)
+{
+  if (!m_nameIndexLists) {
+    m_nameIndexLists = new std::vector<const CBaseListValue *>();
+  }
+  m_nameIndexLists->push_back(list);
+}
+
+void CValue::RemoveNameIndexList(const CBaseListValue *list)
+{
+  if (!m_nameIndexLists) {
+    return;
+  }
+
+  m_nameIndexLists->erase(std::remove(m_nameIndexLists->begin(), m_nameIndexLists->end(), list),
+                          m_nameIndexLists->end());
+  if (m_nameIndexLists->empty()) {
+    delete m_nameIndexLists;
+    m_nameIndexLists = nullptr;
+  }
+}
+
+void CValue::NameChanged()
+{
+  if (!m_nameIndexLists) {
+    return;
+  }
+
+  // Detach the lists first, invalidating an index unregisters it from all its values.
+  std::vector<const CBaseListValue *> *lists = m_nameIndexLists;
+  m_nameIndexLists = nullptr;
+  for (const CBaseListValue *list : *lists) {
+    list->InvalidateNameIndex();
+  }
+  delete lists;
+}
+
 CValue *CValue::GetReplica()
 {
   return nullptr;
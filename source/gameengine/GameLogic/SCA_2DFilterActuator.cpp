@@ -100,6 +100,10 @@ bool SCA_2DFilterActuator::Update()
       break;
     }
     default: {
+      // Filters are compiled shaders, they can't be created without rasterizer (headless player).
+      if (!m_rasterizer) {
+        break;
+      }
       if (!filter) {
         RAS_2DFilterData info;
         info.filterPassIndex = m_int_arg;
@@ -62,6 +62,8 @@ CValue *SCA_ExpressionController::GetReplica()
   SCA_ExpressionController *replica = new SCA_ExpressionController(*this);
   replica->m_exprText = m_exprText;
   replica->m_exprCache = nullptr;
+  replica->m_compiledExpr.Clear();
+  replica->m_compiledSensors.clear();
   // this will copy properties and so on...
   replica->ProcessReplica();
 
@@ -76,9 +78,25 @@ void SCA_ExpressionController::Delete()
     m_exprCache->Release();
     m_exprCache = nullptr;
   }
+  m_compiledExpr.Clear();
   Release();
 }
 
+void SCA_ExpressionController::CompileExpression()
+{
+  m_compiledSensors = m_linkedsensors;
+  m_sensorStates.resize(m_linkedsensors.size());
+
+  std::vector<std::string> sensorNames;
+  sensorNames.reserve(m_linkedsensors.size());
+  for (SCA_ISensor *sensor : m_linkedsensors) {
+    sensorNames.push_back(sensor->GetName());
+  }
+
+  // On failure the expression tree is evaluated as before.
+  m_compiledExpr.Compile(m_exprCache, sensorNames, GetParent());
+}
+
 void SCA_ExpressionController::Trigger(SCA_LogicManager *logicmgr)
 {
 
@@ -87,18 +105,41 @@ void SCA_ExpressionController::Trigger(SCA_LogicManager *logicmgr)
     CParser parser;
     parser.SetContext(this->AddRef());
     m_exprCache = parser.ProcessText(m_exprText);
+    if (m_exprCache) {
+      CompileExpression();
+    }
   }
+  else if (m_compiledSensors != m_linkedsensors) {
+    CompileExpression();
+  }
+
   if (m_exprCache) {
-    CValue *value = m_exprCache->Calculate();
-    if (value) {
-      if (value->IsError()) {
-        CM_LogicBrickError(this, value->GetText());
+    CCompiledExpression::Result result = CCompiledExpression::RESULT_INVALID;
+    if (m_compiledExpr.IsCompiled()) {
+      for (unsigned int i = 0, size = m_linkedsensors.size(); i < size; ++i) {
+        m_sensorStates[i] = m_linkedsensors[i]->GetState();
+      }
+
+      CCompiledExpression::Scalar scalar;
+      result = m_compiledExpr.Evaluate(m_sensorStates, scalar);
+      if (result == CCompiledExpression::RESULT_OK) {
+        expressionresult = !MT_fuzzyZero((float)scalar.GetNumber());
       }
-      else {
-        float num = (float)value->GetNumber();
-        expressionresult = !MT_fuzzyZero(num);
+    }
+
+    // Errors and expressions which can't be compiled use the expression tree.
+    if (result != CCompiledExpression::RESULT_OK) {
+      CValue *value = m_exprCache->Calculate();
+      if (value) {
+        if (value->IsError()) {
+          CM_LogicBrickError(this, value->GetText());
+        }
+        else {
+          float num = (float)value->GetNumber();
+          expressionresult = !MT_fuzzyZero(num);
+        }
+        value->Release();
       }
-      value->Release();
     }
   }
 
@@ -36,6 +36,7 @@
 #define __SCA_EXPRESSIONCONTROLLER_H__
 
 #include "SCA_IController.h"
+#include "EXP_CompiledExpression.h"
 
 class CExpression;
 
@@ -43,6 +44,14 @@ class SCA_ExpressionController : public SCA_IController {
   //	Py_Header
   std::string m_exprText;
   CExpression *m_exprCache;
+  /// Compiled form of m_exprCache, sensor states are its inputs.
+  CCompiledExpression m_compiledExpr;
+  /// Linked sensors at compilation, the expression is compiled again if they change.
+  std::vector<SCA_ISensor *> m_compiledSensors;
+  /// Sensor states passed to m_compiledExpr, kept to avoid allocations.
+  std::vector<bool> m_sensorStates;
+
+  void CompileExpression();
 
  public:
   SCA_ExpressionController(SCA_IObject *gameobj, const std::string &exprtext);
@@ -34,6 +34,8 @@
 #include "SCA_ILogicBrick.h"
 #include "EXP_PyObjectPlus.h"
 
+#include "CM_Profiler.h"
+
 SCA_ILogicBrick::SCA_ILogicBrick(SCA_IObject *gameobj)
     : CValue(),
       m_gameobj(gameobj),
@@ -41,7 +43,8 @@ SCA_ILogicBrick::SCA_ILogicBrick(SCA_IObject *gameobj)
       m_Execute_Priority(0),
       m_Execute_Ueber_Priority(0),
       m_bActive(false),
-      m_eventval(0)
+      m_eventval(0),
+      m_profileId(-1)
 {
 }
 
@@ -63,6 +66,7 @@ void SCA_ILogicBrick::SetUeberExecutePriority(int execute_Priority)
 void SCA_ILogicBrick::ReParent(SCA_IObject *parent)
 {
   m_gameobj = parent;
+  m_profileId = -1;
 }
 
 void SCA_ILogicBrick::Relink(std::map<SCA_IObject *, SCA_IObject *> &obj_map)
@@ -78,6 +82,21 @@ std::string SCA_ILogicBrick::GetName()
 void SCA_ILogicBrick::SetName(const std::string &name)
 {
   m_name = name;
+  m_profileId = -1;
+  NameChanged();
+}
+
+std::string SCA_ILogicBrick::GetProfileName()
+{
+  return m_gameobj->GetName() + "." + m_name;
+}
+
+unsigned int SCA_ILogicBrick::GetProfileId()
+{
+  if (m_profileId == -1) {
+    m_profileId = CM_Profiler::RegisterName(GetProfileName());
+  }
+  return m_profileId;
 }
 
 void SCA_ILogicBrick::SetLogicManager(SCA_LogicManager *logicmgr)
@@ -167,6 +186,7 @@ int SCA_ILogicBrick::CheckProperty(PyObjectPlus *self, const PyAttributeDef *att
     PyErr_SetString(PyExc_ValueError, "string does not correspond to a property");
     return 1;
   }
+  brick->PropertyNameChanged();
   return 0;
 }
 
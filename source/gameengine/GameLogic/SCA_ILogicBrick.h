@@ -49,6 +49,8 @@ class SCA_ILogicBrick : public CValue, public SG_QList {
   bool m_bActive;
   CValue *m_eventval;
   std::string m_name;
+  /// Profiler zone of the brick, -1 until first used.
+  int m_profileId;
   // unsigned long		m_drawcolor;
   void RemoveEvent();
 
@@ -74,6 +76,11 @@ class SCA_ILogicBrick : public CValue, public SG_QList {
   virtual std::string GetName();
   virtual void SetName(const std::string &name);
 
+  /// Return the name of the profiler zone measuring the brick.
+  virtual std::string GetProfileName();
+  /// Return the profiler zone identifier of the brick, the name is registered at first call.
+  unsigned int GetProfileId();
+
   bool IsActive()
   {
     return m_bActive;
@@ -132,6 +139,11 @@ class SCA_ILogicBrick : public CValue, public SG_QList {
   {
   }
 
+  /// Called when the property name of the brick is changed, used to reset cached property slots.
+  virtual void PropertyNameChanged()
+  {
+  }
+
 #ifdef WITH_PYTHON
   // python methods
 
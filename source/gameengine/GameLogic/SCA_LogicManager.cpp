@@ -37,6 +37,9 @@
 #include "SCA_IActuator.h"
 #include "SCA_EventManager.h"
 #include "SCA_PythonController.h"
+
+#include "CM_Profiler.h"
+
 #include <set>
 
 SCA_LogicManager::SCA_LogicManager()
@@ -83,27 +86,36 @@ void SCA_LogicManager::RegisterGameObj(void *blendobj, CValue *gameobj)
 
 void SCA_LogicManager::UnregisterGameObj(void *blendobj, CValue *gameobj)
 {
-  std::map<void *, CValue *>::iterator it = m_map_blendobj_to_gameobj.find(blendobj);
+  std::unordered_map<void *, CValue *>::iterator it = m_map_blendobj_to_gameobj.find(blendobj);
   if (it != m_map_blendobj_to_gameobj.end() && it->second == gameobj) {
     m_map_blendobj_to_gameobj.erase(it);
   }
 }
 
+/// Return the value of a key or nullptr, contrary to operator[] a missing key is not inserted.
+template<class Map>
+static typename Map::mapped_type find_or_null(const Map &map, const typename Map::key_type &key)
+{
+  const typename Map::const_iterator it = map.find(key);
+  if (it == map.end()) {
+    return nullptr;
+  }
+  return it->second;
+}
+
 CValue *SCA_LogicManager::GetGameObjectByName(const std::string &gameobjname)
 {
-  std::string mn = gameobjname;
-  return m_mapStringToGameObjects[mn];
+  return find_or_null(m_mapStringToGameObjects, gameobjname);
 }
 
 CValue *SCA_LogicManager::FindGameObjByBlendObj(void *blendobj)
 {
-  return m_map_blendobj_to_gameobj[blendobj];
+  return find_or_null(m_map_blendobj_to_gameobj, blendobj);
 }
 
 void *SCA_LogicManager::FindBlendObjByGameMeshName(const std::string &gamemeshname)
 {
-  std::string mn = gamemeshname;
-  return m_map_gamemeshname_to_blendobj[mn];
+  return find_or_null(m_map_gamemeshname_to_blendobj, gamemeshname);
 }
 
 void SCA_LogicManager::RemoveSensor(SCA_ISensor *sensor)
@@ -140,16 +152,25 @@ void SCA_LogicManager::RegisterToActuator(SCA_IController *controller, SCA_IActu
 
 void SCA_LogicManager::BeginFrame(double curtime, double fixedtime)
 {
-  for (std::vector<SCA_EventManager *>::const_iterator ie = m_eventmanagers.begin();
-       !(ie == m_eventmanagers.end());
-       ie++)
-    (*ie)->NextFrame(curtime, fixedtime);
+  {
+    CM_PROFILE_SCOPE("Sensors");
+    for (std::vector<SCA_EventManager *>::const_iterator ie = m_eventmanagers.begin();
+         !(ie == m_eventmanagers.end());
+         ie++)
+      (*ie)->NextFrame(curtime, fixedtime);
+  }
 
+  CM_PROFILE_SCOPE("Controllers");
   for (SG_QList *obj = (SG_QList *)m_triggeredControllerSet.Remove(); obj != nullptr;
        obj = (SG_QList *)m_triggeredControllerSet.Remove()) {
     for (SCA_IController *contr = (SCA_IController *)obj->QRemove(); contr != nullptr;
          contr = (SCA_IController *)obj->QRemove()) {
-      contr->Trigger(this);
+      {
+        // Register the zone name only when profiling.
+        CM_Profiler::Scope zone(CM_Profiler::IsEnabled() ? contr->GetProfileId() :
+                                                           CM_Profiler::NoZone);
+        contr->Trigger(this);
+      }
       contr->ClrJustActivated();
     }
   }
@@ -162,6 +183,7 @@ void SCA_LogicManager::UpdateFrame(double curtime)
        ie++)
     (*ie)->UpdateFrame();
 
+  CM_PROFILE_SCOPE("Actuators");
   SG_DList::iterator<SG_QList> io(m_activeActuators);
   for (io.begin(); !io.end();) {
     SG_QList *ahead = *io;
@@ -172,7 +194,13 @@ void SCA_LogicManager::UpdateFrame(double curtime)
       SCA_IActuator *actua = *ia;
       // increment first to allow removal of inactive actuators.
       ++ia;
-      if (!actua->Update(curtime)) {
+      bool active;
+      {
+        CM_Profiler::Scope zone(CM_Profiler::IsEnabled() ? actua->GetProfileId() :
+                                                           CM_Profiler::NoZone);
+        active = actua->Update(curtime);
+      }
+      if (!active) {
         // this actuator is not active anymore, remove
         actua->QDelink();
         actua->SetActive(false);
@@ -197,14 +225,12 @@ void SCA_LogicManager::UpdateFrame(double curtime)
 
 void *SCA_LogicManager::GetActionByName(const std::string &actname)
 {
-  std::string an = actname;
-  return m_mapStringToActions[an];
+  return find_or_null(m_mapStringToActions, actname);
 }
 
 void *SCA_LogicManager::GetMeshByName(const std::string &meshname)
 {
-  std::string mn = meshname;
-  return m_mapStringToMeshes[mn];
+  return find_or_null(m_mapStringToMeshes, meshname);
 }
 
 void SCA_LogicManager::RegisterMeshName(const std::string &meshname, void *mesh)
@@ -37,6 +37,7 @@
 
 #include <vector>
 #include <map>
+#include <unordered_map>
 #include <list>
 
 #include <string>
@@ -75,12 +76,12 @@ class SCA_LogicManager {
 
   // need to find better way for this
   // also known as FactoryManager...
-  std::map<std::string, CValue *> m_mapStringToGameObjects;
-  std::map<std::string, void *> m_mapStringToMeshes;
-  std::map<std::string, void *> m_mapStringToActions;
+  std::unordered_map<std::string, CValue *> m_mapStringToGameObjects;
+  std::unordered_map<std::string, void *> m_mapStringToMeshes;
+  std::unordered_map<std::string, void *> m_mapStringToActions;
 
-  std::map<std::string, void *> m_map_gamemeshname_to_blendobj;
-  std::map<void *, CValue *> m_map_blendobj_to_gameobj;
+  std::unordered_map<std::string, void *> m_map_gamemeshname_to_blendobj;
+  std::unordered_map<void *, CValue *> m_map_blendobj_to_gameobj;
 
  public:
   SCA_LogicManager();
@@ -118,11 +119,11 @@ class SCA_LogicManager {
   // for the scripting... needs a FactoryManager later (if we would have time... ;)
   void RegisterMeshName(const std::string &meshname, void *mesh);
   void UnregisterMeshName(const std::string &meshname, void *mesh);
-  std::map<std::string, void *> &GetMeshMap()
+  std::unordered_map<std::string, void *> &GetMeshMap()
   {
     return m_mapStringToMeshes;
   }
-  std::map<std::string, void *> &GetActionMap()
+  std::unordered_map<std::string, void *> &GetActionMap()
   {
     return m_mapStringToActions;
   }
@@ -45,6 +45,7 @@
 #include "KX_Scene.h"
 #include "KX_Camera.h"
 #include "SCA_MouseFocusSensor.h"
+#include "SCA_MouseManager.h"
 #include "KX_PyMath.h"
 
 #include "KX_RayCast.h"
@@ -146,59 +147,39 @@ bool SCA_MouseFocusSensor::Evaluate()
   return result;
 }
 
-bool SCA_MouseFocusSensor::RayHit(KX_ClientObjectInfo *client_info,
-                                  KX_RayCast *result,
-                                  void *UNUSED(data))
+/// Return true if one of the materials of the object is named <name> (without the MA prefix).
+static bool object_has_material(KX_GameObject *gameobj, const std::string &name)
 {
-  KX_GameObject *hitKXObj = client_info->m_gameobject;
-
-  /* Is this me? In the ray test, there are a lot of extra checks
-   * for aliasing artifacts from self-hits. That doesn't happen
-   * here, so a simple test suffices. Or does the camera also get
-   * self-hits? (No, and the raysensor shouldn't do it either, since
-   * self-hits are excluded by setting the correct ignore-object.)
-   * Hitspots now become valid. */
-  KX_GameObject *thisObj = (KX_GameObject *)GetParent();
-
-  bool bFound = false;
-
-  if ((m_focusmode == 2) || hitKXObj == thisObj) {
-    if (m_propertyname.size() == 0) {
-      bFound = true;
-    }
-    else {
-      if (m_bFindMaterial) {
-        for (unsigned int i = 0; i < hitKXObj->GetMeshCount(); ++i) {
-          RAS_MeshObject *meshObj = hitKXObj->GetMesh(i);
-          for (unsigned int j = 0; j < meshObj->NumMaterials(); ++j) {
-            bFound = (m_propertyname == std::string(meshObj->GetMaterialName(j), 2));
-            if (bFound)
-              break;
-          }
-        }
-      }
-      else {
-        bFound = hitKXObj->GetProperty(m_propertyname) != nullptr;
+  for (unsigned int i = 0, meshCount = gameobj->GetMeshCount(); i < meshCount; ++i) {
+    RAS_MeshObject *meshObj = gameobj->GetMesh(i);
+    for (unsigned int j = 0, matCount = meshObj->NumMaterials(); j < matCount; ++j) {
+      if (name == std::string(meshObj->GetMaterialName(j), 2)) {
+        return true;
       }
     }
-
-    if (bFound) {
-      m_hitObject = hitKXObj;
-      m_hitPosition = result->m_hitPoint;
-      m_hitNormal = result->m_hitNormal;
-      m_hitUV = result->m_hitUV;
-      return true;
-    }
   }
+  return false;
+}
+
+bool SCA_MouseFocusSensor::RayHit(KX_ClientObjectInfo *client_info,
+                                  KX_RayCast *result,
+                                  SCA_MousePick *pick)
+{
+  /* The first object accepted by NeedRayCast is kept whatever the sensor, the
+   * focus mode and the property are checked by each sensor on the shared pick.
+   * Object must be visible to trigger, occluded objects don't. */
+  pick->m_hitObject = client_info->m_gameobject;
+  pick->m_hitPosition = result->m_hitPoint;
+  pick->m_hitNormal = result->m_hitNormal;
+  pick->m_hitUV = result->m_hitUV;
 
-  return true;  // object must be visible to trigger
-                // return false;  // occluded objects can trigger
+  return true;
 }
 
 /* this function is used to pre-filter the object before casting the ray on them.
  * This is useful for "X-Ray" option when we want to see "through" unwanted object.
  */
-bool SCA_MouseFocusSensor::NeedRayCast(KX_ClientObjectInfo *client, void *UNUSED(data))
+bool SCA_MouseFocusSensor::NeedRayCast(KX_ClientObjectInfo *client, SCA_MousePick *pick)
 {
   KX_GameObject *hitKXObj = client->m_gameobject;
 
@@ -210,33 +191,20 @@ bool SCA_MouseFocusSensor::NeedRayCast(KX_ClientObjectInfo *client, void *UNUSED
   }
 
   // The current object is not in the proper layer.
-  if (!(hitKXObj->GetUserCollisionGroup() & m_mask)) {
+  if (!(hitKXObj->GetUserCollisionGroup() & pick->m_mask)) {
     return false;
   }
 
-  if (m_bXRay && m_propertyname.size() != 0) {
-    if (m_bFindMaterial) {
-      bool found = false;
-      for (unsigned int i = 0; i < hitKXObj->GetMeshCount(); ++i) {
-        RAS_MeshObject *meshObj = hitKXObj->GetMesh(i);
-        for (unsigned int j = 0; j < meshObj->NumMaterials(); ++j) {
-          found = (m_propertyname == std::string(meshObj->GetMaterialName(j), 2));
-          if (found)
-            break;
-        }
-      }
-      if (!found)
-        return false;
-    }
-    else {
-      if (hitKXObj->GetProperty(m_propertyname) == nullptr)
-        return false;
+  if (!pick->m_xrayName.empty()) {
+    if (pick->m_xrayMaterial) {
+      return object_has_material(hitKXObj, pick->m_xrayName);
     }
+    return (hitKXObj->GetProperty(pick->m_xrayName) != nullptr);
   }
   return true;
 }
 
-bool SCA_MouseFocusSensor::ParentObjectHasFocusCamera(KX_Camera *cam)
+void SCA_MouseFocusSensor::ComputePick(KX_Camera *cam, SCA_MousePick &pick)
 {
   /* All screen handling in the gameengine is done by GL,
    * specifically the model/view and projection parts. The viewport
@@ -278,6 +246,14 @@ bool SCA_MouseFocusSensor::ParentObjectHasFocusCamera(KX_Camera *cam)
    * calculations don't bomb. Maybe we should explicitly guard for
    * division by 0.0...*/
 
+  pick.m_inViewport = false;
+  pick.m_hitObject = nullptr;
+
+  // Without rasterizer (headless player) there's no render area the mouse could be over.
+  if (!m_kxengine->GetRasterizer()) {
+    return;
+  }
+
   RAS_Rect area, viewport;
   RAS_ICanvas *canvas = m_kxengine->GetCanvas();
   short m_y_inv = canvas->GetHeight() - m_y;
@@ -292,8 +268,9 @@ bool SCA_MouseFocusSensor::ParentObjectHasFocusCamera(KX_Camera *cam)
        m_y_inv < viewport.GetTop() &&         // below top
        m_y_inv > viewport.GetBottom()) == 0)  // above bottom
   {
-    return false;
+    return;
   }
+  pick.m_inViewport = true;
 
   float height = float(viewport.GetTop() - viewport.GetBottom() + 1);
   float width = float(viewport.GetRight() - viewport.GetLeft() + 1);
@@ -339,10 +316,10 @@ bool SCA_MouseFocusSensor::ParentObjectHasFocusCamera(KX_Camera *cam)
   topoint = camcs_wcs_matrix * topoint;
 
   /* from hom wcs to 3d wcs: */
-  m_prevSourcePoint.setValue(
+  pick.m_source.setValue(
       frompoint[0] / frompoint[3], frompoint[1] / frompoint[3], frompoint[2] / frompoint[3]);
 
-  m_prevTargetPoint.setValue(
+  pick.m_target.setValue(
       topoint[0] / topoint[3], topoint[1] / topoint[3], topoint[2] / topoint[3]);
 
   /* 2. Get the object from PhysicsEnvironment */
@@ -352,15 +329,60 @@ bool SCA_MouseFocusSensor::ParentObjectHasFocusCamera(KX_Camera *cam)
   PHY_IPhysicsEnvironment *physics_environment = m_kxscene->GetPhysicsEnvironment();
 
   // get UV mapping
-  KX_RayCast::Callback<SCA_MouseFocusSensor, void> callback(
-      this, physics_controller, nullptr, false, true);
+  KX_RayCast::Callback<SCA_MouseFocusSensor, SCA_MousePick> callback(
+      this, physics_controller, &pick, false, true);
 
-  KX_RayCast::RayTest(physics_environment, m_prevSourcePoint, m_prevTargetPoint, callback);
+  KX_RayCast::RayTest(physics_environment, pick.m_source, pick.m_target, callback);
+}
 
-  if (m_hitObject)
-    return true;
+bool SCA_MouseFocusSensor::ParentObjectHasFocusCamera(KX_Camera *cam)
+{
+  /* Only x-ray sensors filtering a property or a material cast a different ray,
+   * all the others share the first object in the collision groups. */
+  const bool xrayFilter = m_bXRay && !m_propertyname.empty();
+  const std::string xrayName = xrayFilter ? m_propertyname : std::string();
+  const bool xrayMaterial = xrayFilter && m_bFindMaterial;
+
+  SCA_MouseManager *mousemgr = static_cast<SCA_MouseManager *>(m_eventmgr);
+  const SCA_MousePick *pick = mousemgr->FindPick(cam, m_x, m_y, m_mask, xrayName, xrayMaterial);
+  if (!pick) {
+    SCA_MousePick newPick;
+    newPick.m_camera = cam;
+    newPick.m_x = m_x;
+    newPick.m_y = m_y;
+    newPick.m_mask = m_mask;
+    newPick.m_xrayName = xrayName;
+    newPick.m_xrayMaterial = xrayMaterial;
+    ComputePick(cam, newPick);
+    pick = &mousemgr->AddPick(newPick);
+  }
 
-  return false;
+  if (!pick->m_inViewport) {
+    return false;
+  }
+
+  m_prevSourcePoint = pick->m_source;
+  m_prevTargetPoint = pick->m_target;
+
+  KX_GameObject *hitKXObj = pick->m_hitObject;
+  if (!hitKXObj || (m_focusmode != 2 && hitKXObj != GetParent())) {
+    return false;
+  }
+
+  // The x-ray filter already checked the property or material.
+  if (!xrayFilter && !m_propertyname.empty()) {
+    if (m_bFindMaterial ? !object_has_material(hitKXObj, m_propertyname) :
+                          !hitKXObj->GetProperty(m_propertyname)) {
+      return false;
+    }
+  }
+
+  m_hitObject = hitKXObj;
+  m_hitPosition = pick->m_hitPosition;
+  m_hitNormal = pick->m_hitNormal;
+  m_hitUV = pick->m_hitUV;
+
+  return true;
 }
 
 bool SCA_MouseFocusSensor::ParentObjectHasFocus()
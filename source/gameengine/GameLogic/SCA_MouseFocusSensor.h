@@ -38,6 +38,7 @@
 #include "BLI_utildefines.h"
 
 class KX_RayCast;
+struct SCA_MousePick;
 
 /**
  * The mouse focus sensor extends the basic SCA_MouseSensor. It has
@@ -97,9 +98,9 @@ class SCA_MouseFocusSensor : public SCA_MouseSensor {
   };
 
   /// \see KX_RayCast
-  bool RayHit(KX_ClientObjectInfo *client, KX_RayCast *result, void *UNUSED(data));
+  bool RayHit(KX_ClientObjectInfo *client, KX_RayCast *result, SCA_MousePick *pick);
   /// \see KX_RayCast
-  bool NeedRayCast(KX_ClientObjectInfo *client, void *UNUSED(data));
+  bool NeedRayCast(KX_ClientObjectInfo *client, SCA_MousePick *pick);
 
   const MT_Vector3 &RaySource() const;
   const MT_Vector3 &RayTarget() const;
@@ -168,6 +169,12 @@ class SCA_MouseFocusSensor : public SCA_MouseSensor {
    */
   bool m_positive_event;
 
+  /**
+   * Computes the mouse ray of this camera and casts it, the result is
+   * shared with the other sensors through the mouse manager.
+   */
+  void ComputePick(KX_Camera *cam, SCA_MousePick &pick);
+
   /**
    * Tests whether the object is in mouse focus for this camera
    */
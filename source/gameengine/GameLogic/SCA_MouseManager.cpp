@@ -58,8 +58,33 @@ SCA_IInputDevice *SCA_MouseManager::GetInputDevice()
   return m_mousedevice;
 }
 
+const SCA_MousePick *SCA_MouseManager::FindPick(KX_Camera *camera,
+                                                 int x,
+                                                 int y,
+                                                 int mask,
+                                                 const std::string &xrayName,
+                                                 bool xrayMaterial) const
+{
+  for (const SCA_MousePick &pick : m_picks) {
+    if (pick.m_camera == camera && pick.m_x == x && pick.m_y == y && pick.m_mask == mask &&
+        pick.m_xrayMaterial == xrayMaterial && pick.m_xrayName == xrayName) {
+      return &pick;
+    }
+  }
+  return nullptr;
+}
+
+const SCA_MousePick &SCA_MouseManager::AddPick(const SCA_MousePick &pick)
+{
+  m_picks.push_back(pick);
+  return m_picks.back();
+}
+
 void SCA_MouseManager::NextFrame()
 {
+  // Objects and cameras may have moved since the last frame.
+  m_picks.clear();
+
   if (m_mousedevice) {
     for (SCA_ISensor *sensor : m_sensors) {
       SCA_MouseSensor *mousesensor = static_cast<SCA_MouseSensor *>(sensor);
@@ -37,8 +37,43 @@
 #include "SCA_EventManager.h"
 #include "SCA_IInputDevice.h"
 
+#include "MT_Vector2.h"
+#include "MT_Vector3.h"
+
+#include <string>
+#include <vector>
+
+class KX_Camera;
+class KX_GameObject;
+
+/** Mouse ray cast shared by all the mouse focus sensors using the same camera,
+ * mouse position and ray filter during a frame.
+ */
+struct SCA_MousePick {
+  KX_Camera *m_camera;
+  int m_x;
+  int m_y;
+  /// Collision groups of the objects tested.
+  int m_mask;
+  /// Property or material the objects must own to be tested, empty to stop at the first object.
+  std::string m_xrayName;
+  bool m_xrayMaterial;
+
+  /// False when the mouse is outside of the camera viewport, no ray is then cast.
+  bool m_inViewport;
+  MT_Vector3 m_source;
+  MT_Vector3 m_target;
+  /// First object hit by the ray or nullptr.
+  KX_GameObject *m_hitObject;
+  MT_Vector3 m_hitPosition;
+  MT_Vector3 m_hitNormal;
+  MT_Vector2 m_hitUV;
+};
+
 class SCA_MouseManager : public SCA_EventManager {
   class SCA_IInputDevice *m_mousedevice;
+  /// Ray casts of the current frame, cleared in NextFrame().
+  std::vector<SCA_MousePick> m_picks;
 
  public:
   SCA_MouseManager(class SCA_LogicManager *logicmgr, class SCA_IInputDevice *mousedev);
@@ -46,6 +81,16 @@ class SCA_MouseManager : public SCA_EventManager {
 
   virtual void NextFrame();
   SCA_IInputDevice *GetInputDevice();
+
+  /// Return the ray cast of the current frame matching the camera, position and filter or nullptr.
+  const SCA_MousePick *FindPick(KX_Camera *camera,
+                                int x,
+                                int y,
+                                int mask,
+                                const std::string &xrayName,
+                                bool xrayMaterial) const;
+  /// Register a ray cast for the rest of the frame.
+  const SCA_MousePick &AddPick(const SCA_MousePick &pick);
 };
 
 #endif /* __SCA_MOUSEMANAGER_H__ */
@@ -77,7 +77,7 @@ bool SCA_PropertyActuator::Update()
   if (bNegativeEvent) {
     if (m_type == KX_ACT_PROP_LEVEL) {
       CValue *newval = new CBoolValue(false);
-      CValue *oldprop = propowner->GetProperty(m_propname);
+      CValue *oldprop = m_prop.Get(propowner, m_propname);
       if (oldprop) {
         oldprop->SetValue(newval);
       }
@@ -94,7 +94,7 @@ bool SCA_PropertyActuator::Update()
   if (m_type == KX_ACT_PROP_TOGGLE) {
     /* don't use */
     CValue *newval;
-    CValue *oldprop = propowner->GetProperty(m_propname);
+    CValue *oldprop = m_prop.Get(propowner, m_propname);
     if (oldprop) {
       newval = new CBoolValue((oldprop->GetNumber() == 0.0) ? true : false);
       oldprop->SetValue(newval);
@@ -107,7 +107,7 @@ bool SCA_PropertyActuator::Update()
   }
   else if (m_type == KX_ACT_PROP_LEVEL) {
     CValue *newval = new CBoolValue(true);
-    CValue *oldprop = propowner->GetProperty(m_propname);
+    CValue *oldprop = m_prop.Get(propowner, m_propname);
     if (oldprop) {
       oldprop->SetValue(newval);
     }
@@ -122,7 +122,7 @@ bool SCA_PropertyActuator::Update()
       case KX_ACT_PROP_ASSIGN: {
 
         CValue *newval = userexpr->Calculate();
-        CValue *oldprop = propowner->GetProperty(m_propname);
+        CValue *oldprop = m_prop.Get(propowner, m_propname);
         if (oldprop) {
           oldprop->SetValue(newval);
         }
@@ -133,7 +133,7 @@ bool SCA_PropertyActuator::Update()
         break;
       }
       case KX_ACT_PROP_ADD: {
-        CValue *oldprop = propowner->GetProperty(m_propname);
+        CValue *oldprop = m_prop.Get(propowner, m_propname);
         if (oldprop) {
           // int waarde = (int)oldprop->GetNumber();  /*unused*/
           CExpression *expr = new COperator2Expr(
@@ -191,6 +191,11 @@ void SCA_PropertyActuator::ProcessReplica()
   SCA_IActuator::ProcessReplica();
 }
 
+void SCA_PropertyActuator::PropertyNameChanged()
+{
+  m_prop.Reset();
+}
+
 bool SCA_PropertyActuator::UnlinkObject(SCA_IObject *clientobj)
 {
   if (clientobj == m_sourceObj) {
@@ -33,6 +33,7 @@
 #define __SCA_PROPERTYACTUATOR_H__
 
 #include "SCA_IActuator.h"
+#include "EXP_PropertyLayout.h"
 
 class SCA_PropertyActuator : public SCA_IActuator {
   Py_Header
@@ -49,6 +50,8 @@ class SCA_PropertyActuator : public SCA_IActuator {
 
   int m_type;
   std::string m_propname;
+  /// Slot of the property to modify.
+  CPropertyBinding m_prop;
   std::string m_exprtxt;
   SCA_IObject *m_sourceObj;  // for copy property actuator
 
@@ -68,6 +71,7 @@ class SCA_PropertyActuator : public SCA_IActuator {
   virtual void Relink(std::map<SCA_IObject *, SCA_IObject *> &obj_map);
 
   virtual bool Update();
+  virtual void PropertyNameChanged();
 
   /* --------------------------------------------------------------------- */
   /* Python interface ---------------------------------------------------- */
@@ -36,12 +36,14 @@
 #include "EXP_StringValue.h"
 #include "EXP_BoolValue.h"
 #include "EXP_FloatValue.h"
+#include "EXP_IntValue.h"
 
 #include "BLI_compiler_attrs.h"
 
 #include "CM_Format.h"
 
 #include <boost/algorithm/string.hpp>
+#include <boost/format.hpp>
 
 SCA_PropertySensor::SCA_PropertySensor(SCA_EventManager *eventmgr,
                                        SCA_IObject *gameobj,
@@ -53,18 +55,20 @@ SCA_PropertySensor::SCA_PropertySensor(SCA_EventManager *eventmgr,
       m_checktype(checktype),
       m_checkpropval(propval),
       m_checkpropmaxval(propmaxval),
-      m_checkpropname(propname)
+      m_checkpropname(propname),
+      m_previousTextValid(true)
 {
   // CParser pars;
   // pars.SetContext(this->AddRef());
   // CValue* resultval = m_rightexpr->Calculate();
 
-  CValue *orgprop = GetParent()->FindIdentifier(m_checkpropname);
-  if (!orgprop->IsError()) {
+  CValue *orgprop = GetCheckedProperty();
+  if (orgprop) {
     m_previoustext = orgprop->GetText();
+    CCompiledExpression::Scalar::FromValue(orgprop, m_previousValue);
   }
-  orgprop->Release();
 
+  UpdateCheckValues();
   Init();
 }
 
@@ -98,6 +102,33 @@ SCA_PropertySensor::~SCA_PropertySensor()
 {
 }
 
+void SCA_PropertySensor::PropertyNameChanged()
+{
+  m_checkedProp.Reset();
+}
+
+CValue *SCA_PropertySensor::GetCheckedProperty()
+{
+  return m_checkedProp.Get(GetParent(), m_checkpropname);
+}
+
+void SCA_PropertySensor::UpdateCheckValues()
+{
+  // A failed conversion gives zero, as when the strings were converted at each evaluation.
+  m_checkFloatValid = CM_StringTo(m_checkpropval, m_checkFloat);
+  CM_StringTo(m_checkpropmaxval, m_checkMaxFloat);
+  m_checkFloatText = (std::to_string(m_checkFloat) == m_checkpropval);
+
+  // Only a string formatted as an integer property text can be equal to an integer property.
+  m_checkIntValid = CM_StringTo(m_checkpropval, m_checkInt) &&
+                    ((boost::format("%lld") % m_checkInt).str() == m_checkpropval);
+
+  // Force strings to upper case, to avoid confusion in bool tests.
+  m_checkpropvalUpper = boost::to_upper_copy(m_checkpropval);
+  m_checkBool = (m_checkpropvalUpper == CBoolValue::sTrueString);
+  m_checkBoolValid = m_checkBool || (m_checkpropvalUpper == CBoolValue::sFalseString);
+}
+
 bool SCA_PropertySensor::Evaluate()
 {
   bool result = CheckPropertyCondition();
@@ -111,40 +142,94 @@ bool SCA_PropertySensor::Evaluate()
   return (reset) ? true : false;
 }
 
+bool SCA_PropertySensor::CheckPropertyEqual(CValue *orgprop)
+{
+  switch (orgprop->GetValueType()) {
+    case VALUE_BOOL_TYPE: {
+      return m_checkBoolValid && (static_cast<CBoolValue *>(orgprop)->GetBool() == m_checkBool);
+    }
+    case VALUE_INT_TYPE: {
+      return m_checkIntValid && (static_cast<CIntValue *>(orgprop)->GetInt() == m_checkInt);
+    }
+    case VALUE_FLOAT_TYPE: {
+      /* Patch: floating point values cant use strings usefully since you can have "0.0" ==
+       * "0.0000", the text is compared only when the value is written as a float text.
+       */
+      if (m_checkFloatValid && (static_cast<CFloatValue *>(orgprop)->GetFloat() == m_checkFloat)) {
+        return true;
+      }
+      return m_checkFloatText && (orgprop->GetText() == m_checkpropval);
+    }
+    case VALUE_STRING_TYPE: {
+      CStringValue *strprop = static_cast<CStringValue *>(orgprop);
+      if (strprop->IsEqual(CBoolValue::sTrueString) ||
+          strprop->IsEqual(CBoolValue::sFalseString)) {
+        return strprop->IsEqual(m_checkpropvalUpper);
+      }
+      return strprop->IsEqual(m_checkpropval);
+    }
+    default: {
+      const std::string &testprop = orgprop->GetText();
+      if ((testprop == CBoolValue::sTrueString) || (testprop == CBoolValue::sFalseString)) {
+        return (testprop == m_checkpropvalUpper);
+      }
+      return (testprop == m_checkpropval);
+    }
+  }
+}
+
+bool SCA_PropertySensor::CheckPropertyChanged(CValue *orgprop)
+{
+  // Integer and boolean values are compared without converting them to text.
+  CCompiledExpression::Scalar value;
+  if (CCompiledExpression::Scalar::FromValue(orgprop, value) &&
+      value.m_type != VALUE_FLOAT_TYPE && value.m_type == m_previousValue.m_type) {
+    const bool changed = (value.m_type == VALUE_BOOL_TYPE) ?
+                             (value.m_bool != m_previousValue.m_bool) :
+                             (value.m_int != m_previousValue.m_int);
+    if (changed) {
+      m_previousValue = value;
+      m_previousTextValid = false;
+    }
+    return changed;
+  }
+
+  if (!m_previousTextValid) {
+    // Restore the text of the last value compared without text.
+    if (m_previousValue.m_type == VALUE_BOOL_TYPE) {
+      m_previoustext = m_previousValue.m_bool ? CBoolValue::sTrueString :
+                                                CBoolValue::sFalseString;
+    }
+    else {
+      m_previoustext = (boost::format("%lld") % m_previousValue.m_int).str();
+    }
+    m_previousTextValid = true;
+  }
+
+  m_previousValue = value;
+
+  const std::string text = orgprop->GetText();
+  if (m_previoustext != text) {
+    m_previoustext = text;
+    return true;
+  }
+  return false;
+}
+
 bool SCA_PropertySensor::CheckPropertyCondition()
 {
   m_recentresult = false;
   bool result = false;
   bool reverse = false;
+  CValue *orgprop = GetCheckedProperty();
   switch (m_checktype) {
     case KX_PROPSENSOR_NOTEQUAL:
       reverse = true;
       ATTR_FALLTHROUGH;
     case KX_PROPSENSOR_EQUAL: {
-      CValue *orgprop = GetParent()->FindIdentifier(m_checkpropname);
-      if (!orgprop->IsError()) {
-        const std::string &testprop = orgprop->GetText();
-        // Force strings to upper case, to avoid confusion in
-        // bool tests. It's stupid the prop's identity is lost
-        // on the way here...
-        if ((testprop == CBoolValue::sTrueString) || (testprop == CBoolValue::sFalseString)) {
-          boost::to_upper(m_checkpropval);
-        }
-        result = (testprop == m_checkpropval);
-
-        /* Patch: floating point values cant use strings usefully since you can have "0.0" ==
-         * "0.0000" this could be made into a generic Value class function for comparing values
-         * with a string.
-         */
-        if (result == false && (orgprop->GetValueType() == VALUE_FLOAT_TYPE)) {
-          float f;
-          if (CM_StringTo(m_checkpropval, f)) {
-            result = (f == ((CFloatValue *)orgprop)->GetFloat());
-          }
-        }
-        /* end patch */
+      if (orgprop) {
+        result = CheckPropertyEqual(orgprop);
       }
-      orgprop->Release();
 
       if (reverse)
         result = !result;
@@ -155,14 +240,8 @@ bool SCA_PropertySensor::CheckPropertyCondition()
       break;
     }
     case KX_PROPSENSOR_INTERVAL: {
-      CValue *orgprop = GetParent()->FindIdentifier(m_checkpropname);
-      if (!orgprop->IsError()) {
-        float min;
-        float max;
+      if (orgprop) {
         float val;
-        CM_StringTo(m_checkpropval, min);
-        CM_StringTo(m_checkpropmaxval, max);
-
         if (orgprop->GetValueType() == VALUE_STRING_TYPE) {
           CM_StringTo(orgprop->GetText(), val);
         }
@@ -170,22 +249,15 @@ bool SCA_PropertySensor::CheckPropertyCondition()
           val = orgprop->GetNumber();
         }
 
-        result = (min <= val) && (val <= max);
+        result = (m_checkFloat <= val) && (val <= m_checkMaxFloat);
       }
-      orgprop->Release();
 
       break;
     }
     case KX_PROPSENSOR_CHANGED: {
-      CValue *orgprop = GetParent()->FindIdentifier(m_checkpropname);
-
-      if (!orgprop->IsError()) {
-        if (m_previoustext != orgprop->GetText()) {
-          m_previoustext = orgprop->GetText();
-          result = true;
-        }
+      if (orgprop) {
+        result = CheckPropertyChanged(orgprop);
       }
-      orgprop->Release();
 
       break;
     }
@@ -193,12 +265,8 @@ bool SCA_PropertySensor::CheckPropertyCondition()
       reverse = true;
       ATTR_FALLTHROUGH;
     case KX_PROPSENSOR_GREATERTHAN: {
-      CValue *orgprop = GetParent()->FindIdentifier(m_checkpropname);
-      if (!orgprop->IsError()) {
-        float ref;
-        CM_StringTo(m_checkpropval, ref);
+      if (orgprop) {
         float val;
-
         if (orgprop->GetValueType() == VALUE_STRING_TYPE) {
           CM_StringTo(orgprop->GetText(), val);
         }
@@ -207,13 +275,12 @@ bool SCA_PropertySensor::CheckPropertyCondition()
         }
 
         if (reverse) {
-          result = val < ref;
+          result = val < m_checkFloat;
         }
         else {
-          result = val > ref;
+          result = val > m_checkFloat;
         }
       }
-      orgprop->Release();
 
       break;
     }
@@ -245,6 +312,7 @@ int SCA_PropertySensor::validValueForProperty(PyObjectPlus *self, const PyAttrib
    * function directly */
 
   /*  There is no type checking at this moment, unfortunately...           */
+  static_cast<SCA_PropertySensor *>(self)->UpdateCheckValues();
   return 0;
 }
 
@@ -34,6 +34,8 @@
 #define __SCA_PROPERTYSENSOR_H__
 
 #include "SCA_ISensor.h"
+#include "EXP_CompiledExpression.h"
+#include "EXP_PropertyLayout.h"
 
 class SCA_PropertySensor : public SCA_ISensor {
   Py_Header
@@ -46,6 +48,33 @@ class SCA_PropertySensor : public SCA_ISensor {
   bool m_lastresult;
   bool m_recentresult;
 
+  /// Slot of the checked property.
+  CPropertyBinding m_checkedProp;
+
+  /// Values of m_checkpropval and m_checkpropmaxval converted once.
+  std::string m_checkpropvalUpper;
+  float m_checkFloat;
+  float m_checkMaxFloat;
+  cInt m_checkInt;
+  bool m_checkFloatValid;
+  /// True when m_checkpropval is formatted as a float property text.
+  bool m_checkFloatText;
+  bool m_checkIntValid;
+  bool m_checkBool;
+  bool m_checkBoolValid;
+
+  /// Previous value of a bool or int property for KX_PROPSENSOR_CHANGED.
+  CCompiledExpression::Scalar m_previousValue;
+  /// False when m_previoustext is outdated because m_previousValue was used.
+  bool m_previousTextValid;
+
+  /// Return the checked property without reference or nullptr.
+  CValue *GetCheckedProperty();
+  /// Convert the check values once, called when they are modified.
+  void UpdateCheckValues();
+  bool CheckPropertyEqual(CValue *orgprop);
+  bool CheckPropertyChanged(CValue *orgprop);
+
  protected:
  public:
   enum KX_PROPSENSOR_TYPE {
@@ -76,6 +105,7 @@ class SCA_PropertySensor : public SCA_ISensor {
 
   virtual bool Evaluate();
   virtual bool IsPositiveTrigger();
+  virtual void PropertyNameChanged();
   virtual CValue *FindIdentifier(const std::string &identifiername);
 
 #ifdef WITH_PYTHON
@@ -119,11 +119,19 @@ void SCA_PythonController::SetScriptText(const std::string &text)
 {
   m_scriptText = text;
   m_bModified = true;
+  m_profileId = -1;
 }
 
 void SCA_PythonController::SetScriptName(const std::string &name)
 {
   m_scriptName = name;
+  m_profileId = -1;
+}
+
+std::string SCA_PythonController::GetProfileName()
+{
+  const std::string &script = (m_mode == SCA_PYEXEC_SCRIPT) ? m_scriptName : m_scriptText;
+  return SCA_IController::GetProfileName() + " (" + script + ")";
 }
 
 bool SCA_PythonController::IsTriggered(class SCA_ISensor *sensor)
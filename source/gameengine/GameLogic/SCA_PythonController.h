@@ -75,6 +75,8 @@ class SCA_PythonController : public SCA_IController {
 
   virtual CValue *GetReplica();
   virtual void Trigger(class SCA_LogicManager *logicmgr);
+  /// The profiler zone includes the script or module function name.
+  virtual std::string GetProfileName();
 
   void SetScriptText(const std::string &text);
   void SetScriptName(const std::string &name);
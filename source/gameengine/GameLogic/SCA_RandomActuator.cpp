@@ -84,6 +84,11 @@ void SCA_RandomActuator::ProcessReplica()
   m_base->AddRef();
 }
 
+void SCA_RandomActuator::PropertyNameChanged()
+{
+  m_prop.Reset();
+}
+
 bool SCA_RandomActuator::Update()
 {
   // bool result = false;	/*unused*/
@@ -227,7 +232,7 @@ bool SCA_RandomActuator::Update()
   }
 
   /* Round up: assign it */
-  CValue *prop = GetParent()->GetProperty(m_propname);
+  CValue *prop = m_prop.Get(GetParent(), m_propname);
   if (prop) {
     prop->SetValue(tmpval);
   }
@@ -35,11 +35,14 @@
 
 #include "SCA_IActuator.h"
 #include "SCA_RandomNumberGenerator.h"
+#include "EXP_PropertyLayout.h"
 
 class SCA_RandomActuator : public SCA_IActuator {
   Py_Header
       /** Property to assign to */
       std::string m_propname;
+  /// Slot of the property to set.
+  CPropertyBinding m_prop;
 
   /** First parameter. The meaning of the parameters depends on the
    *  distribution */
@@ -89,6 +92,7 @@ class SCA_RandomActuator : public SCA_IActuator {
 
   virtual CValue *GetReplica();
   virtual void ProcessReplica();
+  virtual void PropertyNameChanged();
 
 #ifdef WITH_PYTHON
 
@@ -33,6 +33,8 @@
 #include "KX_GameObject.h"
 #include "KX_NavMeshObject.h"
 #include "KX_ObstacleSimulation.h"
+#include "KX_PathQueryManager.h"
+#include "KX_Scene.h"
 #include "KX_Globals.h"
 #include "KX_PyMath.h"
 #include "Recast.h"
@@ -74,6 +76,7 @@ SCA_SteeringActuator::SCA_SteeringActuator(SCA_IObject *gameobj,
       m_facingMode(facingmode),
       m_normalUp(normalup),
       m_pathLen(0),
+      m_pathQuery(nullptr),
       m_pathUpdatePeriod(pathUpdatePeriod),
       m_lockzvel(lockzvel),
       m_wayPointIdx(-1),
@@ -97,6 +100,7 @@ SCA_SteeringActuator::SCA_SteeringActuator(SCA_IObject *gameobj,
 
 SCA_SteeringActuator::~SCA_SteeringActuator()
 {
+  ReleasePathQuery();
   if (m_navmesh)
     m_navmesh->UnregisterActuator(this);
   if (m_target)
@@ -113,6 +117,7 @@ CValue *SCA_SteeringActuator::GetReplica()
 
 void SCA_SteeringActuator::ProcessReplica()
 {
+  m_pathQuery = nullptr;
   if (m_target)
     m_target->RegisterActuator(this);
   if (m_navmesh)
@@ -134,6 +139,7 @@ bool SCA_SteeringActuator::UnlinkObject(SCA_IObject *clientobj)
     return true;
   }
   else if (clientobj == m_navmesh) {
+    ReleasePathQuery();
     m_navmesh = nullptr;
     return true;
   }
@@ -154,11 +160,20 @@ void SCA_SteeringActuator::Relink(std::map<SCA_IObject *, SCA_IObject *> &obj_ma
   if (navobj) {
     if (m_navmesh)
       m_navmesh->UnregisterActuator(this);
+    ReleasePathQuery();
     m_navmesh = navobj;
     m_navmesh->RegisterActuator(this);
   }
 }
 
+void SCA_SteeringActuator::ReleasePathQuery()
+{
+  if (m_pathQuery) {
+    m_pathQuery->Release();
+    m_pathQuery = nullptr;
+  }
+}
+
 bool SCA_SteeringActuator::Update(double curtime)
 {
   double delta = curtime - m_updateTime;
@@ -167,6 +182,8 @@ bool SCA_SteeringActuator::Update(double curtime)
   if (m_posevent && !m_isActive) {
     delta = 0.0;
     m_pathUpdateTime = -1.0;
+    m_wayPointIdx = -1;
+    ReleasePathQuery();
     m_updateTime = curtime;
     m_isActive = true;
   }
@@ -215,12 +232,23 @@ bool SCA_SteeringActuator::Update(double curtime)
 
         static const MT_Scalar WAYPOINT_RADIUS(0.25f);
 
-        if (m_pathUpdateTime < 0 ||
-            (m_pathUpdatePeriod >= 0 &&
-             curtime - m_pathUpdateTime > ((double)m_pathUpdatePeriod / 1000.0))) {
+        // the path is requested to the scene and received at the next frame
+        if (m_pathQuery && m_pathQuery->GetStatus() != KX_PathQuery::STATUS_PENDING) {
+          if (m_pathQuery->GetStatus() == KX_PathQuery::STATUS_DONE) {
+            m_pathLen = std::min((int)m_pathQuery->GetPathLength(), MAX_PATH_LENGTH);
+            memcpy(m_path, m_pathQuery->GetPath(), sizeof(float) * 3 * m_pathLen);
+            m_wayPointIdx = m_pathLen > 1 ? 1 : -1;
+          }
+          ReleasePathQuery();
+        }
+
+        if (!m_pathQuery &&
+            (m_pathUpdateTime < 0 ||
+             (m_pathUpdatePeriod >= 0 &&
+              curtime - m_pathUpdateTime > ((double)m_pathUpdatePeriod / 1000.0)))) {
           m_pathUpdateTime = curtime;
-          m_pathLen = m_navmesh->FindPath(mypos, targpos, m_path, MAX_PATH_LENGTH);
-          m_wayPointIdx = m_pathLen > 1 ? 1 : -1;
+          m_pathQuery = m_navmesh->GetScene()->GetPathQueryManager()->AddQuery(
+              m_navmesh, mypos, targpos);
         }
 
         if (m_wayPointIdx > 0) {
@@ -342,28 +370,31 @@ inline void flipAxes(float *vec)
   std::swap(vec[1], vec[2]);
 }
 
-static bool getNavmeshNormal(dtStatNavMesh *navmesh, const MT_Vector3 &pos, MT_Vector3 &normal)
+static bool getNavmeshNormal(dtTiledNavMesh *navmesh, const MT_Vector3 &pos, MT_Vector3 &normal)
 {
   static const float polyPickExt[3] = {2, 4, 2};
   float spos[3];
   pos.getValue(spos);
   flipAxes(spos);
-  dtStatPolyRef sPolyRef = navmesh->findNearestPoly(spos, polyPickExt);
+  dtTilePolyRef sPolyRef = navmesh->findNearestPoly(spos, polyPickExt);
   if (sPolyRef == 0)
     return false;
-  const dtStatPoly *p = navmesh->getPoly(sPolyRef - 1);
-  const dtStatPolyDetail *pd = navmesh->getPolyDetail(sPolyRef - 1);
+  unsigned int salt, it, ip;
+  dtDecodeTileId(sPolyRef, salt, it, ip);
+  const dtTileHeader *header = navmesh->getTile(it)->header;
+  const dtTilePoly *p = &header->polys[ip];
+  const dtTilePolyDetail *pd = &header->dmeshes[ip];
 
   float distMin = FLT_MAX;
   int idxMin = -1;
   for (int i = 0; i < pd->ntris; ++i) {
-    const unsigned char *t = navmesh->getDetailTri(pd->tbase + i);
+    const unsigned char *t = &header->dtris[(pd->tbase + i) * 4];
     const float *v[3];
     for (int j = 0; j < 3; ++j) {
       if (t[j] < p->nv)
-        v[j] = navmesh->getVertex(p->v[t[j]]);
+        v[j] = &header->verts[p->v[t[j]] * 3];
       else
-        v[j] = navmesh->getDetailVertex(pd->vbase + (t[j] - p->nv));
+        v[j] = &header->dverts[(pd->vbase + (t[j] - p->nv)) * 3];
     }
     float dist = barDistSqPointToTri(spos, v[0], v[1], v[2]);
     if (dist < distMin) {
@@ -373,13 +404,13 @@ static bool getNavmeshNormal(dtStatNavMesh *navmesh, const MT_Vector3 &pos, MT_V
   }
 
   if (idxMin >= 0) {
-    const unsigned char *t = navmesh->getDetailTri(pd->tbase + idxMin);
+    const unsigned char *t = &header->dtris[(pd->tbase + idxMin) * 4];
     const float *v[3];
     for (int j = 0; j < 3; ++j) {
       if (t[j] < p->nv)
-        v[j] = navmesh->getVertex(p->v[t[j]]);
+        v[j] = &header->verts[p->v[t[j]] * 3];
       else
-        v[j] = navmesh->getDetailVertex(pd->vbase + (t[j] - p->nv));
+        v[j] = &header->dverts[(pd->vbase + (t[j] - p->nv)) * 3];
     }
     MT_Vector3 tri[3];
     for (size_t j = 0; j < 3; j++)
@@ -408,10 +439,10 @@ void SCA_SteeringActuator::HandleActorFace(MT_Vector3 &velocity)
   MT_Matrix3x3 mat;
 
   if (m_navmesh && m_normalUp) {
-    dtStatNavMesh *navmesh = m_navmesh->GetNavMesh();
+    dtTiledNavMesh *navmesh = m_navmesh->GetNavMesh();
     MT_Vector3 normal;
     MT_Vector3 trpos = m_navmesh->TransformToLocalCoords(curobj->NodeGetWorldPosition());
-    if (getNavmeshNormal(navmesh, trpos, normal)) {
+    if (navmesh && getNavmeshNormal(navmesh, trpos, normal)) {
 
       left = (dir.cross(up)).safe_normalized();
       dir = (-left.cross(normal)).safe_normalized();
@@ -623,6 +654,7 @@ int SCA_SteeringActuator::pyattr_set_navmesh(PyObjectPlus *self,
 
   if (actuator->m_navmesh != nullptr)
     actuator->m_navmesh->UnregisterActuator(actuator);
+  actuator->ReleasePathQuery();
 
   actuator->m_navmesh = static_cast<KX_NavMeshObject *>(gameobj);
 
@@ -33,6 +33,7 @@
 
 class KX_GameObject;
 class KX_NavMeshObject;
+class KX_PathQuery;
 struct KX_Obstacle;
 class KX_ObstacleSimulation;
 const int MAX_PATH_LENGTH = 128;
@@ -59,6 +60,8 @@ class SCA_SteeringActuator : public SCA_IActuator {
   bool m_normalUp;
   float m_path[MAX_PATH_LENGTH * 3];
   int m_pathLen;
+  /// Pending path query, its result replaces the current path.
+  KX_PathQuery *m_pathQuery;
   int m_pathUpdatePeriod;
   double m_pathUpdateTime;
   bool m_lockzvel;
@@ -66,6 +69,8 @@ class SCA_SteeringActuator : public SCA_IActuator {
   MT_Matrix3x3 m_parentlocalmat;
   MT_Vector3 m_steerVec;
   void HandleActorFace(MT_Vector3 &velocity);
+  /// Drop the pending path query, used when the navigation mesh changes.
+  void ReleasePathQuery();
 
  public:
   enum KX_STEERINGACT_MODE {
@@ -43,6 +43,7 @@
 
 #include "BKE_image.h"
 #include "MEM_guardedalloc.h"
+#include "DNA_scene_types.h"
 #include "DNA_space_types.h"
 
 GPG_Canvas::GPG_Canvas(RAS_Rasterizer *rasty, GHOST_IWindow *window, Scene *startscene)
@@ -53,6 +54,10 @@ GPG_Canvas::GPG_Canvas(RAS_Rasterizer *rasty, GHOST_IWindow *window, Scene *star
     m_window->getClientBounds(bnds);
     this->Resize(bnds.getWidth(), bnds.getHeight());
   }
+  else {
+    // Without window (headless player) use the player size for the camera projections.
+    this->Resize(startscene->gm.xplay, startscene->gm.yplay);
+  }
 }
 
 GPG_Canvas::~GPG_Canvas()
@@ -83,6 +88,11 @@ void GPG_Canvas::Resize(int width, int height)
 
 void GPG_Canvas::MakeScreenShot(const std::string &filename)
 {
+  // Nothing is drawn without window.
+  if (!m_window) {
+    return;
+  }
+
   // copy image data
   unsigned int dumpsx = GetWidth();
   unsigned int dumpsy = GetHeight();
@@ -181,6 +191,11 @@ void GPG_Canvas::GetDisplayDimensions(int &width, int &height)
 
 void GPG_Canvas::ResizeWindow(int width, int height)
 {
+  if (!m_window) {
+    Resize(width, height);
+    return;
+  }
+
   if (m_window->getState() == GHOST_kWindowStateFullScreen) {
     GHOST_ISystem *system = GHOST_ISystem::getSystem();
     GHOST_DisplaySetting setting;
@@ -200,6 +215,10 @@ void GPG_Canvas::ResizeWindow(int width, int height)
 
 void GPG_Canvas::SetFullScreen(bool enable)
 {
+  if (!m_window) {
+    return;
+  }
+
   if (enable) {
     m_window->setState(GHOST_kWindowStateFullScreen);
   }
@@ -210,12 +229,18 @@ void GPG_Canvas::SetFullScreen(bool enable)
 
 bool GPG_Canvas::GetFullScreen()
 {
-  return (m_window->getState() == GHOST_kWindowStateFullScreen);
+  return (m_window && m_window->getState() == GHOST_kWindowStateFullScreen);
 }
 
 void GPG_Canvas::ConvertMousePosition(int x, int y, int &r_x, int &r_y, bool UNUSED(screen))
 {
-  m_window->screenToClient(x, y, r_x, r_y);
+  if (m_window) {
+    m_window->screenToClient(x, y, r_x, r_y);
+  }
+  else {
+    r_x = x;
+    r_y = y;
+  }
 }
 
 ARegion *GPG_Canvas::GetARegion()
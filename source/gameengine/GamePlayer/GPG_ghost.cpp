@@ -540,9 +540,20 @@ static void usage(const std::string &program, bool isBlenderPlayer)
   CM_Message("       show_camera_frustum            0         Show debug camera frustum volume");
   CM_Message(
       "       show_shadow_frustum            0         Show debug light shadow frustum volume");
-  CM_Message("       ignore_deprecation_warnings    1         Ignore deprecation warnings"
+  CM_Message("       ignore_deprecation_warnings    1         Ignore deprecation warnings");
+  CM_Message("       frame_pacing                   2         Wait for the next logic tick:");
+  CM_Message("                                                0 = poll continuously");
+  CM_Message("                                                1 = sleep");
+  CM_Message("                                                2 = sleep then spin");
+  CM_Message("                                                3 = as 2, sample inputs late");
+  CM_Message("       unthrottled                    0         Headless: run the logic ticks as "
+             "fast as possible");
+  CM_Message("       max_ticks                      0         Headless: quit after this number "
+             "of logic ticks"
              << std::endl);
-  CM_Message("  -p: override python main loop script");
+  CM_Message("  -p: override python main loop script" << std::endl);
+  CM_Message("  --headless: run logic, physics and animations without rendering,");
+  CM_Message("       print the logic ticks statistics at exit");
   CM_Message(std::endl);
   CM_Message(
       "  - : all arguments after this are ignored, allowing python to access them from sys.argv");
@@ -740,6 +751,7 @@ int main(int argc,
   int validArguments = 0;
   bool samplesParFound = false;
   std::string pythonControllerFile;
+  bool headless = false;
   GHOST_TUns16 aasamples = 0;
   int alphaBackground = 0;
 
@@ -1193,6 +1205,17 @@ int main(int argc,
           pythonControllerFile = argv[i++];
           break;
         }
+        case '-': {
+          if (strcmp(argv[i], "--headless") == 0) {
+            headless = true;
+            SYS_WriteCommandLineInt(syshandle, "headless", 1);
+          }
+          else {
+            CM_Warning("unknown argument: " << argv[i]);
+          }
+          ++i;
+          break;
+        }
         default:  // not recognized
         {
           CM_Warning("unknown argument: " << argv[i++]);
@@ -1219,8 +1242,10 @@ int main(int argc,
   if (scr_saver_mode != SCREEN_SAVER_MODE_CONFIGURATION)
 #endif
   {
-    // Create the system
-    if (GHOST_ISystem::createSystem() == GHOST_kSuccess) {
+    // Create the system, without display connection in headless mode.
+    const GHOST_TSuccess systemCreated = headless ? GHOST_ISystem::createSystemBackground() :
+                                                    GHOST_ISystem::createSystem();
+    if (systemCreated == GHOST_kSuccess) {
       system = GHOST_ISystem::getSystem();
       BLI_assert(system);
 
@@ -1395,7 +1420,10 @@ int main(int argc,
             if (firstTimeRunning) {
               firstTimeRunning = false;
 
-              if (fullScreen) {
+              if (headless) {
+                // Nothing is drawn, no window nor OpenGL context are created.
+              }
+              else if (fullScreen) {
 #ifdef WIN32
                 if (scr_saver_mode == SCREEN_SAVER_MODE_SAVER) {
                   window = startScreenSaverFullScreen(system,
@@ -1478,9 +1506,11 @@ int main(int argc,
               wmWindowManager *wm = (wmWindowManager *)CTX_data_main(C)->wm.first;
               CTX_wm_manager_set(C, wm);
               wm->message_bus = WM_msgbus_create();
-              WM_init_opengl_blenderplayer(G_MAIN, system);
-              wm_window_ghostwindow_blenderplayer_ensure(
-                  wm, (wmWindow *)wm->windows.first, window);
+              if (window) {
+                WM_init_opengl_blenderplayer(G_MAIN, system);
+                wm_window_ghostwindow_blenderplayer_ensure(
+                    wm, (wmWindow *)wm->windows.first, window);
+              }
             }
 
             // This argc cant be argc_py_clamped, since python uses it.
@@ -1568,7 +1598,9 @@ int main(int argc,
   BKE_vfont_clipboard_free();
   BKE_node_clipboard_free();
 
-  GPU_free_unused_buffers(G_MAIN);
+  if (!headless) {
+    GPU_free_unused_buffers(G_MAIN);
+  }
 
   BKE_blender_free(); /* blender.c, does entire library and spacetypes */
                       //  free_matcopybuf();
@@ -1590,11 +1622,13 @@ int main(int argc,
 
   BLF_exit();
 
-  DRW_opengl_context_enable_ex(false);
-  GPU_pass_cache_free();
-  GPU_exit();
-  DRW_opengl_context_disable_ex(false);
-  DRW_opengl_context_destroy();
+  if (!headless) {
+    DRW_opengl_context_enable_ex(false);
+    GPU_pass_cache_free();
+    GPU_exit();
+    DRW_opengl_context_disable_ex(false);
+    DRW_opengl_context_destroy();
+  }
 
   if (window) {
     system->disposeWindow(window);
@@ -62,7 +62,8 @@ KX_BlenderMaterial::KX_BlenderMaterial(RAS_Rasterizer *rasty,
 {
   m_alphablend = mat->blend_method;
 
-  if (m_material->use_nodes && m_material->nodetree) {
+  // Without rasterizer (headless player) there's no draw engine to create GPU materials.
+  if (m_rasterizer && m_material->use_nodes && m_material->nodetree) {
     RAS_ICanvas *canvas = KX_GetActiveEngine()->GetCanvas();
     ARegion *ar = canvas->GetARegion();  // if no ar, we are in blenderplayer
     if ((m_scene->GetBlenderScene()->gm.flag & GAME_USE_VIEWPORT_RENDER) == 0 || !ar) {
@@ -383,6 +384,11 @@ PyObject *KX_BlenderMaterial::pyattr_get_textures(PyObjectPlus *self_v,
 KX_PYMETHODDEF_DOC(KX_BlenderMaterial, getShader, "getShader()")
 {
   /* EEVEE: Any way to restore Custom shaders without bge rendering pipeline */
+  if (!m_rasterizer) {
+    PyErr_SetString(PyExc_RuntimeError, "material.getShader(), Rasterizer not available");
+    return nullptr;
+  }
+
   if (!m_shader) {
     m_shader.reset(new KX_MaterialShader());
     // Set the material to use custom shader.
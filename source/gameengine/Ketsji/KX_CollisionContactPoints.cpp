@@ -25,14 +25,19 @@
  */
 
 #include "KX_CollisionContactPoints.h"
-#include "PHY_DynamicTypes.h"
 #include "KX_PyMath.h"
 
-KX_CollisionContactPoint::KX_CollisionContactPoint(const PHY_CollData *collData,
-                                                   unsigned int index,
+#include <utility>
+
+KX_CollisionContactPoint::KX_CollisionContactPoint(const PHY_ContactPoint &point,
                                                    bool firstObject)
-    : m_collData(collData), m_index(index), m_firstObject(firstObject)
+    : m_point(point)
 {
+  // Express the point for the second object.
+  if (!firstObject) {
+    std::swap(m_point.m_localPointA, m_point.m_localPointB);
+    m_point.m_normal = -m_point.m_normal;
+  }
 }
 
 KX_CollisionContactPoint::~KX_CollisionContactPoint()
@@ -109,67 +114,64 @@ PyObject *KX_CollisionContactPoint::pyattr_get_local_point_a(PyObjectPlus *self_
                                                              const KX_PYATTRIBUTE_DEF *attrdef)
 {
   KX_CollisionContactPoint *self = static_cast<KX_CollisionContactPoint *>(self_v);
-  return PyObjectFrom(self->m_collData->GetLocalPointA(self->m_index, self->m_firstObject));
+  return PyObjectFrom(self->m_point.m_localPointA);
 }
 
 PyObject *KX_CollisionContactPoint::pyattr_get_local_point_b(PyObjectPlus *self_v,
                                                              const KX_PYATTRIBUTE_DEF *attrdef)
 {
   KX_CollisionContactPoint *self = static_cast<KX_CollisionContactPoint *>(self_v);
-  return PyObjectFrom(self->m_collData->GetLocalPointB(self->m_index, self->m_firstObject));
+  return PyObjectFrom(self->m_point.m_localPointB);
 }
 
 PyObject *KX_CollisionContactPoint::pyattr_get_world_point(PyObjectPlus *self_v,
                                                            const KX_PYATTRIBUTE_DEF *attrdef)
 {
   KX_CollisionContactPoint *self = static_cast<KX_CollisionContactPoint *>(self_v);
-  return PyObjectFrom(self->m_collData->GetWorldPoint(self->m_index, self->m_firstObject));
+  return PyObjectFrom(self->m_point.m_worldPoint);
 }
 
 PyObject *KX_CollisionContactPoint::pyattr_get_normal(PyObjectPlus *self_v,
                                                       const KX_PYATTRIBUTE_DEF *attrdef)
 {
   KX_CollisionContactPoint *self = static_cast<KX_CollisionContactPoint *>(self_v);
-  return PyObjectFrom(self->m_collData->GetNormal(self->m_index, self->m_firstObject));
+  return PyObjectFrom(self->m_point.m_normal);
 }
 
 PyObject *KX_CollisionContactPoint::pyattr_get_combined_friction(PyObjectPlus *self_v,
                                                                  const KX_PYATTRIBUTE_DEF *attrdef)
 {
   KX_CollisionContactPoint *self = static_cast<KX_CollisionContactPoint *>(self_v);
-  return PyFloat_FromDouble(
-      self->m_collData->GetCombinedFriction(self->m_index, self->m_firstObject));
+  return PyFloat_FromDouble(self->m_point.m_combinedFriction);
 }
 
 PyObject *KX_CollisionContactPoint::pyattr_get_combined_rolling_friction(
     PyObjectPlus *self_v, const KX_PYATTRIBUTE_DEF *attrdef)
 {
   KX_CollisionContactPoint *self = static_cast<KX_CollisionContactPoint *>(self_v);
-  return PyFloat_FromDouble(
-      self->m_collData->GetCombinedRollingFriction(self->m_index, self->m_firstObject));
+  return PyFloat_FromDouble(self->m_point.m_combinedRollingFriction);
 }
 
 PyObject *KX_CollisionContactPoint::pyattr_get_combined_restitution(
     PyObjectPlus *self_v, const KX_PYATTRIBUTE_DEF *attrdef)
 {
   KX_CollisionContactPoint *self = static_cast<KX_CollisionContactPoint *>(self_v);
-  return PyFloat_FromDouble(
-      self->m_collData->GetCombinedRestitution(self->m_index, self->m_firstObject));
+  return PyFloat_FromDouble(self->m_point.m_combinedRestitution);
 }
 
 PyObject *KX_CollisionContactPoint::pyattr_get_applied_impulse(PyObjectPlus *self_v,
                                                                const KX_PYATTRIBUTE_DEF *attrdef)
 {
   KX_CollisionContactPoint *self = static_cast<KX_CollisionContactPoint *>(self_v);
-  return PyFloat_FromDouble(
-      self->m_collData->GetAppliedImpulse(self->m_index, self->m_firstObject));
+  return PyFloat_FromDouble(self->m_point.m_appliedImpulse);
 }
 
 #endif  // WITH_PYTHON
 
-KX_CollisionContactPointList::KX_CollisionContactPointList(const PHY_CollData *collData,
+KX_CollisionContactPointList::KX_CollisionContactPointList(const PHY_ContactPoint *points,
+                                                           unsigned int numPoints,
                                                            bool firstObject)
-    : m_collData(collData), m_firstObject(firstObject)
+    : m_points(points), m_numPoints(numPoints), m_firstObject(firstObject)
 {
 }
 
@@ -206,17 +208,22 @@ KX_CollisionContactPoint *KX_CollisionContactPointList::GetCollisionContactPoint
     unsigned int index)
 {
   // All contact point infos.
-  return (new KX_CollisionContactPoint(m_collData, index, m_firstObject));
+  return (new KX_CollisionContactPoint(m_points[index], m_firstObject));
 }
 
 unsigned int KX_CollisionContactPointList::GetNumCollisionContactPoint()
 {
-  return m_collData->GetNumContacts();
+  return m_numPoints;
+}
+
+MT_Vector3 KX_CollisionContactPointList::GetWorldPoint(unsigned int index) const
+{
+  return m_points[index].m_worldPoint;
 }
 
-const PHY_CollData *KX_CollisionContactPointList::GetCollData()
+MT_Vector3 KX_CollisionContactPointList::GetNormal(unsigned int index) const
 {
-  return m_collData;
+  return m_firstObject ? m_points[index].m_normal : -m_points[index].m_normal;
 }
 
 bool KX_CollisionContactPointList::GetFirstObject()
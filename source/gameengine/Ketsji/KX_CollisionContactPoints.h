@@ -29,18 +29,19 @@
 
 #include "EXP_Value.h"
 #include "EXP_ListWrapper.h"
-
-class PHY_CollData;
+#include "PHY_DynamicTypes.h"
 
 class KX_CollisionContactPoint : public CValue {
   Py_Header protected :
-      /// All infos about contact position, normal, friction ect…
-      const PHY_CollData *m_collData;
-  const unsigned int m_index;
-  const bool m_firstObject;
+      /// All infos about contact position, normal, friction ect… expressed for the owner.
+      PHY_ContactPoint m_point;
 
  public:
-  KX_CollisionContactPoint(const PHY_CollData *collData, unsigned int index, bool firstObject);
+  /** Copy a contact point.
+   * \param point The contact point expressed for the first object of the pair.
+   * \param firstObject The owner of the contact point is the first object of the pair.
+   */
+  KX_CollisionContactPoint(const PHY_ContactPoint &point, bool firstObject);
   virtual ~KX_CollisionContactPoint();
 
   // stuff for cvalue related things
@@ -66,15 +67,22 @@ class KX_CollisionContactPoint : public CValue {
 #endif  // WITH_PYTHON
 };
 
+/** Read-only view of the contact points of a collision pair.
+ * The points are not owned and are expressed for the first object of the pair,
+ * contact point values are only created when an item is accessed.
+ */
 class KX_CollisionContactPointList {
  private:
   /// The list of contact points for a pair of rigid bodies.
-  const PHY_CollData *m_collData;
+  const PHY_ContactPoint *m_points;
+  unsigned int m_numPoints;
   /// The object is the first in the pair or the second ?
   bool m_firstObject;
 
  public:
-  KX_CollisionContactPointList(const PHY_CollData *collData, bool firstObject);
+  KX_CollisionContactPointList(const PHY_ContactPoint *points,
+                               unsigned int numPoints,
+                               bool firstObject);
   virtual ~KX_CollisionContactPointList();
 
 #ifdef WITH_PYTHON
@@ -83,7 +91,10 @@ class KX_CollisionContactPointList {
 
   KX_CollisionContactPoint *GetCollisionContactPoint(unsigned int index);
   unsigned int GetNumCollisionContactPoint();
-  const PHY_CollData *GetCollData();
+  /// Return the world position of a contact point.
+  MT_Vector3 GetWorldPoint(unsigned int index) const;
+  /// Return the normal of a contact point oriented for the owner of the list.
+  MT_Vector3 GetNormal(unsigned int index) const;
   bool GetFirstObject();
 };
 
@@ -37,6 +37,9 @@
 #include "PHY_IPhysicsEnvironment.h"
 #include "PHY_IPhysicsController.h"
 
+#include <algorithm>
+#include <cstdint>
+
 KX_CollisionEventManager::KX_CollisionEventManager(class SCA_LogicManager *logicmgr,
                                                    PHY_IPhysicsEnvironment *physEnv)
     : SCA_EventManager(logicmgr, TOUCH_EVENTMGR), m_physEnv(physEnv)
@@ -56,12 +59,22 @@ KX_CollisionEventManager::~KX_CollisionEventManager()
 
 void KX_CollisionEventManager::RemoveNewCollisions()
 {
-  for (std::set<NewCollision>::iterator it = m_newCollisions.begin(), end = m_newCollisions.end();
-       it != end;
-       ++it) {
-    delete it->colldata;
-  }
+  // Keep the memory for the next frame.
   m_newCollisions.clear();
+  m_contactPoints.clear();
+}
+
+/// Return true if the object of a controller has python collision callbacks.
+static bool hasCollisionCallbacks(PHY_IPhysicsController *ctrl)
+{
+#ifdef WITH_PYTHON
+  KX_GameObject *gameobj = KX_GameObject::GetClientObject(
+      static_cast<KX_ClientObjectInfo *>(ctrl->GetNewClientInfo()));
+  return (gameobj && gameobj->m_collisionCallbacks &&
+          PyList_GET_SIZE(gameobj->m_collisionCallbacks) > 0);
+#else
+  return false;
+#endif
 }
 
 bool KX_CollisionEventManager::NewHandleCollision(void *object1,
@@ -71,11 +84,81 @@ bool KX_CollisionEventManager::NewHandleCollision(void *object1,
   PHY_IPhysicsController *obj1 = static_cast<PHY_IPhysicsController *>(object1);
   PHY_IPhysicsController *obj2 = static_cast<PHY_IPhysicsController *>(object2);
 
-  m_newCollisions.insert(NewCollision(obj1, obj2, coll_data));
+  NewCollision collision;
+  collision.m_first = obj1;
+  collision.m_second = obj2;
+  collision.m_pointIndex = m_contactPoints.size();
+  collision.m_numPoints = 0;
+
+  // The contact points are only read by the python callbacks, the sensors need only the pair.
+  if (coll_data && (hasCollisionCallbacks(obj1) || hasCollisionCallbacks(obj2))) {
+    collision.m_numPoints = coll_data->GetNumContacts();
+    m_contactPoints.resize(collision.m_pointIndex + collision.m_numPoints);
+
+    for (unsigned int i = 0; i < collision.m_numPoints; ++i) {
+      PHY_ContactPoint &point = m_contactPoints[collision.m_pointIndex + i];
+      point.m_localPointA = coll_data->GetLocalPointA(i, true);
+      point.m_localPointB = coll_data->GetLocalPointB(i, true);
+      point.m_worldPoint = coll_data->GetWorldPoint(i, true);
+      point.m_normal = coll_data->GetNormal(i, true);
+      point.m_combinedFriction = coll_data->GetCombinedFriction(i, true);
+      point.m_combinedRollingFriction = coll_data->GetCombinedRollingFriction(i, true);
+      point.m_combinedRestitution = coll_data->GetCombinedRestitution(i, true);
+      point.m_appliedImpulse = coll_data->GetAppliedImpulse(i, true);
+    }
+  }
+
+  m_newCollisions.push_back(collision);
 
   return false;
 }
 
+void KX_CollisionEventManager::SortNewCollisions()
+{
+  const unsigned int size = m_newCollisions.size();
+  if (size < 2) {
+    return;
+  }
+
+  /* LSD radix sort of the controller addresses, one byte per pass, the second controller
+   * first. The passes on bytes shared by all the addresses (e.g the high bytes) are skipped.
+   * The sort is stable, the collisions of a same pair keep their reporting order. */
+  static const unsigned int keySize = sizeof(uintptr_t);
+  static const unsigned int numDigits = keySize * 2;
+
+  auto digit = [](const NewCollision &collision, unsigned int d) -> unsigned int {
+    const uintptr_t key = (uintptr_t)((d < keySize) ? collision.m_second : collision.m_first);
+    return (key >> ((d % keySize) * 8)) & 0xFF;
+  };
+
+  unsigned int histograms[numDigits][256] = {{0}};
+  for (const NewCollision &collision : m_newCollisions) {
+    for (unsigned int d = 0; d < numDigits; ++d) {
+      ++histograms[d][digit(collision, d)];
+    }
+  }
+
+  m_sortedCollisions.resize(size);
+  for (unsigned int d = 0; d < numDigits; ++d) {
+    unsigned int *histogram = histograms[d];
+    // All the keys share this digit.
+    if (histogram[digit(m_newCollisions.front(), d)] == size) {
+      continue;
+    }
+
+    for (unsigned int i = 0, offset = 0; i < 256; ++i) {
+      const unsigned int count = histogram[i];
+      histogram[i] = offset;
+      offset += count;
+    }
+
+    for (const NewCollision &collision : m_newCollisions) {
+      m_sortedCollisions[histogram[digit(collision, d)]++] = collision;
+    }
+    m_newCollisions.swap(m_sortedCollisions);
+  }
+}
+
 bool KX_CollisionEventManager::newCollisionResponse(void *client_data,
                                                     void *object1,
                                                     void *object2,
@@ -195,12 +278,43 @@ void KX_CollisionEventManager::NextFrame()
     static_cast<SCA_CollisionSensor *>(sensor)->SynchronizeTransform();
   }
 
-  for (std::set<NewCollision>::iterator cit = m_newCollisions.begin();
-       cit != m_newCollisions.end();
-       ++cit) {
+  SortNewCollisions();
+
+  for (unsigned int i = 0, size = m_newCollisions.size(); i < size;) {
+    const NewCollision &collision = m_newCollisions[i];
     // Controllers
-    PHY_IPhysicsController *ctrl1 = (*cit).first;
-    PHY_IPhysicsController *ctrl2 = (*cit).second;
+    PHY_IPhysicsController *ctrl1 = collision.m_first;
+    PHY_IPhysicsController *ctrl2 = collision.m_second;
+
+    /* A pair can be reported several times (e.g one manifold per child shape of a compound),
+     * the duplicates are consecutive after the sort and merged into a single event. */
+    unsigned int end = i + 1;
+    while (end < size && m_newCollisions[end].m_first == ctrl1 &&
+           m_newCollisions[end].m_second == ctrl2) {
+      ++end;
+    }
+
+    unsigned int pointIndex = collision.m_pointIndex;
+    unsigned int numPoints = collision.m_numPoints;
+    if (end - i > 1) {
+      numPoints = 0;
+      for (unsigned int j = i; j < end; ++j) {
+        numPoints += m_newCollisions[j].m_numPoints;
+      }
+
+      // Gather the contact points of the pair at the end of the buffer.
+      pointIndex = m_contactPoints.size();
+      m_contactPoints.resize(pointIndex + numPoints);
+      for (unsigned int j = i, dest = pointIndex; j < end; ++j) {
+        const NewCollision &duplicate = m_newCollisions[j];
+        std::copy_n(m_contactPoints.begin() + duplicate.m_pointIndex,
+                    duplicate.m_numPoints,
+                    m_contactPoints.begin() + dest);
+        dest += duplicate.m_numPoints;
+      }
+    }
+    i = end;
+
     // Sensor iterator
     std::list<SCA_ISensor *>::iterator sit;
 
@@ -226,9 +340,9 @@ void KX_CollisionEventManager::NextFrame()
       }
     }
     // Run python callbacks
-    const PHY_CollData *colldata = cit->colldata;
-    KX_CollisionContactPointList contactPointList0 = KX_CollisionContactPointList(colldata, true);
-    KX_CollisionContactPointList contactPointList1 = KX_CollisionContactPointList(colldata, false);
+    const PHY_ContactPoint *points = (numPoints > 0) ? &m_contactPoints[pointIndex] : nullptr;
+    KX_CollisionContactPointList contactPointList0(points, numPoints, true);
+    KX_CollisionContactPointList contactPointList1(points, numPoints, false);
     kxObj1->RunCollisionCallbacks(kxObj2, contactPointList0);
     kxObj2->RunCollisionCallbacks(kxObj1, contactPointList1);
   }
@@ -239,27 +353,3 @@ void KX_CollisionEventManager::NextFrame()
 
   RemoveNewCollisions();
 }
-
-KX_CollisionEventManager::NewCollision::NewCollision(PHY_IPhysicsController *first,
-                                                     PHY_IPhysicsController *second,
-                                                     const PHY_CollData *colldata)
-    : first(first), second(second), colldata(colldata)
-{
-}
-
-KX_CollisionEventManager::NewCollision::NewCollision(const NewCollision &to_copy)
-    : first(to_copy.first), second(to_copy.second), colldata(to_copy.colldata)
-{
-}
-
-bool KX_CollisionEventManager::NewCollision::operator<(const NewCollision &other) const
-{
-  // see strict weak ordering: https://support.microsoft.com/en-us/kb/949171
-  if (first == other.first) {
-    if (second == other.second) {
-      return colldata < other.colldata;
-    }
-    return second < other.second;
-  }
-  return first < other.first;
-}
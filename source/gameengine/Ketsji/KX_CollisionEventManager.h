@@ -35,40 +35,33 @@
 #include "SCA_EventManager.h"
 #include "SCA_CollisionSensor.h"
 #include "KX_GameObject.h"
+#include "PHY_DynamicTypes.h"
 
 #include <vector>
-#include <set>
 
 class SCA_ISensor;
 class PHY_IPhysicsEnvironment;
 
 class KX_CollisionEventManager : public SCA_EventManager {
   /**
-   * Contains two colliding objects and the first contact point.
+   * Contains two colliding objects and the range of their contact points.
    */
-  class NewCollision {
-   public:
-    PHY_IPhysicsController *first;
-    PHY_IPhysicsController *second;
-    const PHY_CollData *colldata;
-
-    /**
-     * Creates a copy of the given PHY_CollData; freeing that copy should be done by the owner of
-     * the NewCollision object.
-     *
-     * This allows us to efficiently store NewCollision objects in a std::set without creating more
-     * copies of colldata, as the NewCollision copy constructor reuses the pointer and doesn't
-     * clone it again. */
-    NewCollision(PHY_IPhysicsController *first,
-                 PHY_IPhysicsController *second,
-                 const PHY_CollData *colldata);
-    NewCollision(const NewCollision &to_copy);
-    bool operator<(const NewCollision &other) const;
+  struct NewCollision {
+    PHY_IPhysicsController *m_first;
+    PHY_IPhysicsController *m_second;
+    /// Range in m_contactPoints, empty when no python collision callbacks use the points.
+    unsigned int m_pointIndex;
+    unsigned int m_numPoints;
   };
 
   PHY_IPhysicsEnvironment *m_physEnv;
 
-  std::set<NewCollision> m_newCollisions;
+  /// Collisions of the physics step in reporting order, sorted by controllers in NextFrame().
+  std::vector<NewCollision> m_newCollisions;
+  /// Scratch buffer of the collision sort.
+  std::vector<NewCollision> m_sortedCollisions;
+  /// Contact points of all the collisions, reused between frames.
+  std::vector<PHY_ContactPoint> m_contactPoints;
 
   static bool newCollisionResponse(void *client_data,
                                    void *object1,
@@ -82,6 +75,8 @@ class KX_CollisionEventManager : public SCA_EventManager {
 
   virtual bool NewHandleCollision(void *obj1, void *obj2, const PHY_CollData *coll_data);
 
+  /// Stable radix sort of the collisions on the controller pair.
+  void SortNewCollisions();
   void RemoveNewCollisions();
 
  public:
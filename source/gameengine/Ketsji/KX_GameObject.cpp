@@ -364,7 +364,7 @@ void KX_GameObject::ReplicateBlenderObject()
       GetScene()->SetLastReplicatedParentObject(newob);
     }
 
-    DEG_relations_tag_update(bmain);
+    DEG_relations_tag_id_added(bmain, &newob->id);
 
     m_pBlenderObject = newob;
     m_isReplica = true;
@@ -376,10 +376,11 @@ void KX_GameObject::RemoveReplicaObject()
   if (ob && m_isReplica) {
     Main *bmain = KX_GetActiveEngine()->GetConverter()->GetMain();
     Scene *scene = GetScene()->GetBlenderScene();
+    /* Only the nodes of the replica are removed from the depsgraph, no full rebuild. */
+    DEG_relations_tag_id_removed(bmain, &ob->id);
     BKE_scene_collections_object_remove(bmain, scene, ob, true);
-    BKE_id_free(bmain, &ob->id);
+    BKE_id_free_ex(bmain, &ob->id, LIB_ID_FREE_NO_DEG_TAG, true);
     SetBlenderObject(nullptr);
-    DEG_relations_tag_update(bmain);
   }
 }
 
@@ -549,6 +550,7 @@ std::string KX_GameObject::GetName()
 void KX_GameObject::SetName(const std::string &name)
 {
   m_name = name;
+  NameChanged();
 }
 
 PHY_IPhysicsController *KX_GameObject::GetPhysicsController()
@@ -1643,16 +1645,15 @@ void KX_GameObject::RunCollisionCallbacks(KX_GameObject *collider,
                                           KX_CollisionContactPointList &contactPointList)
 {
 #ifdef WITH_PYTHON
-  if (!m_collisionCallbacks || PyList_GET_SIZE(m_collisionCallbacks) == 0) {
+  if (!m_collisionCallbacks || PyList_GET_SIZE(m_collisionCallbacks) == 0 ||
+      contactPointList.GetNumCollisionContactPoint() == 0) {
     return;
   }
 
   CListWrapper *listWrapper = contactPointList.GetListWrapper();
   PyObject *args[] = {collider->GetProxy(),
-                      PyObjectFrom(contactPointList.GetCollData()->GetWorldPoint(
-                          0, contactPointList.GetFirstObject())),
-                      PyObjectFrom(contactPointList.GetCollData()->GetNormal(
-                          0, contactPointList.GetFirstObject())),
+                      PyObjectFrom(contactPointList.GetWorldPoint(0)),
+                      PyObjectFrom(contactPointList.GetNormal(0)),
                       listWrapper->GetProxy()};
   RunPythonCallBackList(m_collisionCallbacks, args, 1, ARRAY_SIZE(args));
 
@@ -87,7 +87,11 @@ void KX_RasterizerDrawDebugLine(const MT_Vector3 &from,
                                 const MT_Vector3 &to,
                                 const MT_Vector4 &color)
 {
-  g_engine->GetRasterizer()->GetDebugDraw(nullptr).DrawLine(from, to, color);
+  RAS_Rasterizer *rasty = g_engine->GetRasterizer();
+  // Nothing is drawn without rasterizer (headless player).
+  if (rasty) {
+    rasty->GetDebugDraw(nullptr).DrawLine(from, to, color);
+  }
 }
 
 void KX_RasterizerDrawDebugCircle(const MT_Vector3 &center,
@@ -96,6 +100,8 @@ void KX_RasterizerDrawDebugCircle(const MT_Vector3 &center,
                                   const MT_Vector3 &normal,
                                   int nsector)
 {
-  g_engine->GetRasterizer()->GetDebugDraw(nullptr).DrawCircle(
-      center, radius, color, normal, nsector);
+  RAS_Rasterizer *rasty = g_engine->GetRasterizer();
+  if (rasty) {
+    rasty->GetDebugDraw(nullptr).DrawCircle(center, radius, color, normal, nsector);
+  }
 }
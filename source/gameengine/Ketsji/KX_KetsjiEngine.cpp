@@ -35,9 +35,13 @@
 #endif
 
 #include "CM_Message.h"
+#include "CM_Profiler.h"
 
 #include <boost/format.hpp>
 
+#include <algorithm>
+#include <functional>
+
 #include "BLI_task.h"
 
 #include "KX_KetsjiEngine.h"
@@ -250,6 +254,7 @@ void KX_KetsjiEngine::SetConverter(KX_BlenderConverter *converter)
 void KX_KetsjiEngine::StartEngine()
 {
   m_previousRealTime = m_kxsystem->GetTimeInSeconds();
+  m_tickStatistics.Clear();
 
   m_bInitialized = true;
 }
@@ -379,6 +384,8 @@ bool KX_KetsjiEngine::NextFrame()
   }
 
   while (frames) {
+    CM_PROFILE_SCOPE("Logic Frame");
+    const double tickStart = m_kxsystem->GetTimeInSeconds();
     m_frameTime += framestep;
 
     m_converter->MergeAsyncLoads();
@@ -398,6 +405,9 @@ bool KX_KetsjiEngine::NextFrame()
 
     // for each scene, call the proceed functions
     for (KX_Scene *scene : m_scenes) {
+      CM_Profiler::Scope sceneZone(CM_Profiler::IsEnabled() ? scene->GetProfileId() :
+                                                              CM_Profiler::NoZone);
+
       /* Suspension holds the physics and logic processing for an
        * entire scene. Objects can be suspended individually, and
        * the settings for that precede the logic and physics
@@ -442,8 +452,11 @@ bool KX_KetsjiEngine::NextFrame()
 
         // Perform physics calculations on the scene. This can involve
         // many iterations of the physics solver.
-        scene->GetPhysicsEnvironment()->ProceedDeltaTime(
-            m_frameTime, timestep, framestep);  // m_deltatimerealDeltaTime);
+        {
+          CM_PROFILE_SCOPE("Physics");
+          scene->GetPhysicsEnvironment()->ProceedDeltaTime(
+              m_frameTime, timestep, framestep);  // m_deltatimerealDeltaTime);
+        }
 
         m_logger.StartLog(tc_scenegraph, m_kxsystem->GetTimeInSeconds());
         scene->UpdateParents(m_frameTime);
@@ -467,9 +480,29 @@ bool KX_KetsjiEngine::NextFrame()
     // scene management
     ProcessScheduledScenes();
 
+    m_tickStatistics.AddTick(m_kxsystem->GetTimeInSeconds() - tickStart);
+
     frames--;
   }
 
+  if (m_flags & HEADLESS) {
+    /* Without rendering the animations are updated here and not in RenderCamera,
+     * and the profiling measurement is not advanced by EndFrame. */
+    if (doRender) {
+      m_logger.StartLog(tc_animations, m_kxsystem->GetTimeInSeconds());
+      for (KX_Scene *scene : m_scenes) {
+        UpdateAnimations(scene);
+      }
+
+      const double tottime = m_logger.GetAverage();
+      m_average_framerate = 1.0 / ((tottime < 1e-6) ? 1e-6 : tottime);
+      m_logger.NextMeasurement(m_kxsystem->GetTimeInSeconds());
+    }
+
+    m_logger.StartLog(tc_outside, m_kxsystem->GetTimeInSeconds());
+    return false;
+  }
+
   // Start logging time spent outside main loop
   m_logger.StartLog(tc_outside, m_kxsystem->GetTimeInSeconds());
 
@@ -659,6 +692,8 @@ bool KX_KetsjiEngine::GetFrameRenderData(std::vector<FrameRenderData> &frameData
 
 void KX_KetsjiEngine::Render()
 {
+  CM_PROFILE_SCOPE("Render");
+
   m_logger.StartLog(tc_rasterizer, m_kxsystem->GetTimeInSeconds());
 
   BeginFrame();
@@ -816,6 +851,8 @@ void KX_KetsjiEngine::UpdateAnimations(KX_Scene *scene)
     return;
   }
 
+  CM_PROFILE_SCOPE("Animations");
+
   // Handle the animations independently of the logic time step
   if (m_flags & RESTRICT_ANIMATION) {
     double anim_timestep = 1.0 / scene->GetAnimationFPS();
@@ -1018,7 +1055,9 @@ void KX_KetsjiEngine::StopEngine()
     }
 
     // cleanup all the stuff
-    m_rasterizer->Exit();
+    if (m_rasterizer) {
+      m_rasterizer->Exit();
+    }
   }
 }
 
@@ -1140,6 +1179,33 @@ void KX_KetsjiEngine::RenderDebugProperties()
           MT_Vector2(xcoord + (int)(2.2 * profile_indent), ycoord), boxSize, white);
       ycoord += const_ysize;
     }
+
+    // Most expensive profiler zones.
+    if (CM_Profiler::IsEnabled()) {
+      static const unsigned int maxZones = 10;
+
+      const std::vector<CM_Profiler::ZoneStats> &stats = CM_Profiler::GetStats();
+      std::vector<std::pair<double, unsigned int> > zones;
+      for (unsigned int i = 0, size = stats.size(); i < size; ++i) {
+        if (stats[i].m_average > 0.0) {
+          zones.emplace_back(stats[i].m_average, i);
+        }
+      }
+
+      const unsigned int numZones = std::min((unsigned int)zones.size(), maxZones);
+      std::partial_sort(zones.begin(),
+                        zones.begin() + numZones,
+                        zones.end(),
+                        std::greater<std::pair<double, unsigned int> >());
+
+      for (unsigned int i = 0; i < numZones; ++i) {
+        debugtxt = (boost::format("%5.2fms %s") % (zones[i].first * 1000.0) %
+                    CM_Profiler::GetName(zones[i].second))
+                       .str();
+        debugDraw.RenderText2D(debugtxt, MT_Vector2(xcoord + const_xindent, ycoord), white);
+        ycoord += const_ysize;
+      }
+    }
   }
   // Add the ymargin for titles below the other section of debug info
   ycoord += title_y_top_margin;
@@ -1468,6 +1534,22 @@ void KX_KetsjiEngine::SetClockTime(double externalClockTime)
   m_clockTime = externalClockTime;
 }
 
+double KX_KetsjiEngine::GetNextFrameRealTime() const
+{
+  if ((m_flags & USE_EXTERNAL_CLOCK) || !(m_flags & FIXED_FRAMERATE)) {
+    return m_previousRealTime;
+  }
+
+  // The clock doesn't advance, poll at the tic rate.
+  if (m_timescale <= 0.0) {
+    return m_previousRealTime + 1.0 / m_ticrate;
+  }
+
+  // NextFrame() computes a frame once the clock time reached the next frame time.
+  const double timestep = m_timescale / m_ticrate;
+  return m_previousRealTime + (m_frameTime + timestep - m_clockTime) / m_timescale;
+}
+
 double KX_KetsjiEngine::GetFrameTime(void) const
 {
   return m_frameTime;
@@ -1488,6 +1570,11 @@ double KX_KetsjiEngine::GetAverageFrameRate()
   return m_average_framerate;
 }
 
+const KX_TickStatistics &KX_KetsjiEngine::GetTickStatistics() const
+{
+  return m_tickStatistics;
+}
+
 void KX_KetsjiEngine::SetExitKey(short key)
 {
   m_exitkey = key;
@@ -38,6 +38,7 @@
 #include "KX_ISystem.h"
 #include "KX_Scene.h"
 #include "KX_TimeCategoryLogger.h"
+#include "KX_TickStatistics.h"
 #include "EXP_Python.h"
 #include "RAS_CameraData.h"
 #include "RAS_Rasterizer.h"
@@ -91,7 +92,9 @@ class KX_KetsjiEngine {
     /// Automatic add debug properties to the debug list.
     AUTO_ADD_DEBUG_PROPERTIES = (1 << 6),
     /// Use override camera?
-    CAMERA_OVERRIDE = (1 << 7)
+    CAMERA_OVERRIDE = (1 << 7),
+    /// Run without rendering, animations are then updated after the logic frames.
+    HEADLESS = (1 << 8)
   };
 
  private:
@@ -217,6 +220,8 @@ class KX_KetsjiEngine {
   static const std::string m_profileLabels[tc_numCategories];
   /// Last estimated framerate
   double m_average_framerate;
+  /// Duration of all the logic frames.
+  KX_TickStatistics m_tickStatistics;
 
   /// Enable debug draw of culling bounding boxes.
   KX_DebugOption m_showBoundingBox;
@@ -394,6 +399,12 @@ class KX_KetsjiEngine {
    */
   void SetClockTime(double externalClockTime);
 
+  /**
+   * Returns the real time at which the next logic frame is due, the current real time
+   * when a frame can be computed at any moment (no fixed framerate or external clock)
+   */
+  double GetNextFrameRealTime() const;
+
   /**
    * Returns current logic frame game time
    */
@@ -443,6 +454,11 @@ class KX_KetsjiEngine {
    */
   double GetAverageFrameRate();
 
+  /**
+   * Gets the duration statistics of all the logic frames since the engine start
+   */
+  const KX_TickStatistics &GetTickStatistics() const;
+
   /**
    * Gets the time scale multiplier
    */
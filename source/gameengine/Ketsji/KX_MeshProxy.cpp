@@ -51,6 +51,10 @@
 #  include "EXP_PyObjectPlus.h"
 #  include "EXP_ListWrapper.h"
 
+#  include "BLI_math_color.h"
+
+#  include <cstring>
+
 PyTypeObject KX_MeshProxy::Type = {PyVarObject_HEAD_INIT(nullptr, 0) "KX_MeshProxy",
                                    sizeof(PyObjectPlus_Proxy),
                                    0,
@@ -98,6 +102,15 @@ PyMethodDef KX_MeshProxy::Methods[] = {
     {"transform", (PyCFunction)KX_MeshProxy::sPyTransform, METH_VARARGS},
     {"transformUV", (PyCFunction)KX_MeshProxy::sPyTransformUV, METH_VARARGS},
     {"replaceMaterial", (PyCFunction)KX_MeshProxy::sPyReplaceMaterial, METH_VARARGS},
+    {"getVertexPositions", (PyCFunction)KX_MeshProxy::sPyGetVertexPositions, METH_VARARGS},
+    {"setVertexPositions", (PyCFunction)KX_MeshProxy::sPySetVertexPositions, METH_VARARGS},
+    {"getVertexNormals", (PyCFunction)KX_MeshProxy::sPyGetVertexNormals, METH_VARARGS},
+    {"setVertexNormals", (PyCFunction)KX_MeshProxy::sPySetVertexNormals, METH_VARARGS},
+    {"getVertexUVs", (PyCFunction)KX_MeshProxy::sPyGetVertexUVs, METH_VARARGS},
+    {"setVertexUVs", (PyCFunction)KX_MeshProxy::sPySetVertexUVs, METH_VARARGS},
+    {"getVertexColors", (PyCFunction)KX_MeshProxy::sPyGetVertexColors, METH_VARARGS},
+    {"setVertexColors", (PyCFunction)KX_MeshProxy::sPySetVertexColors, METH_VARARGS},
+    {"getIndices", (PyCFunction)KX_MeshProxy::sPyGetIndices, METH_VARARGS},
     {nullptr, nullptr}  // Sentinel
 };
 
@@ -385,6 +398,381 @@ PyObject *KX_MeshProxy::PyReplaceMaterial(PyObject *args, PyObject *kwds)
   Py_RETURN_NONE;
 }
 
+/// Layout of a vertex attribute in the display array vertices.
+struct KX_VertexAttribute {
+  /// Offset of the attribute in a vertex.
+  intptr_t offset;
+  /// Number of floats per vertex exchanged with python.
+  unsigned int size;
+  /// The attribute is stored as 4 bytes and exchanged as floats in [0, 1].
+  bool color;
+  /// The display array modified flag.
+  unsigned short flag;
+};
+
+/** Return the display array of a material and clamp the vertex range.
+ * \param count The number of vertices, -1 for all the vertices after start.
+ */
+static RAS_IDisplayArray *kx_mesh_proxy_get_array_range(RAS_MeshObject *meshobj,
+                                                        int matindex,
+                                                        int start,
+                                                        int &count,
+                                                        const char *error_prefix)
+{
+  RAS_IDisplayArray *array = (matindex < 0) ? nullptr : meshobj->GetDisplayArray(matindex);
+  if (!array) {
+    PyErr_Format(PyExc_ValueError, "%s: invalid material index %d", error_prefix, matindex);
+    return nullptr;
+  }
+
+  const int size = array->GetVertexCount();
+  if (start < 0 || start > size) {
+    PyErr_Format(PyExc_ValueError, "%s: invalid start vertex %d", error_prefix, start);
+    return nullptr;
+  }
+
+  if (count < 0 || count > (size - start)) {
+    count = size - start;
+  }
+
+  return array;
+}
+
+static bool kx_mesh_proxy_get_attribute(RAS_IDisplayArray *array,
+                                        int type,
+                                        int layer,
+                                        KX_VertexAttribute &attrib,
+                                        const char *error_prefix)
+{
+  switch (type) {
+    case RAS_IDisplayArray::POSITION_MODIFIED: {
+      attrib = {array->GetVertexXYZOffset(), 3, false, RAS_IDisplayArray::POSITION_MODIFIED};
+      return true;
+    }
+    case RAS_IDisplayArray::NORMAL_MODIFIED: {
+      attrib = {array->GetVertexNormalOffset(), 3, false, RAS_IDisplayArray::NORMAL_MODIFIED};
+      return true;
+    }
+    case RAS_IDisplayArray::UVS_MODIFIED: {
+      if (layer < 0 || layer >= array->GetVertexUvSize()) {
+        PyErr_Format(PyExc_ValueError, "%s: invalid uv layer %d", error_prefix, layer);
+        return false;
+      }
+      attrib = {array->GetVertexUVOffset() + (intptr_t)(layer * sizeof(float[2])),
+                2,
+                false,
+                RAS_IDisplayArray::UVS_MODIFIED};
+      return true;
+    }
+    case RAS_IDisplayArray::COLORS_MODIFIED: {
+      if (layer < 0 || layer >= array->GetVertexColorSize()) {
+        PyErr_Format(PyExc_ValueError, "%s: invalid color layer %d", error_prefix, layer);
+        return false;
+      }
+      attrib = {array->GetVertexColorOffset() + (intptr_t)(layer * sizeof(unsigned int)),
+                4,
+                true,
+                RAS_IDisplayArray::COLORS_MODIFIED};
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/// Copy a vertex attribute of a range of vertices into a float32 memoryview (count, size).
+static PyObject *kx_mesh_proxy_read_attribute(RAS_IDisplayArray *array,
+                                              const KX_VertexAttribute &attrib,
+                                              unsigned int start,
+                                              unsigned int count)
+{
+  PyObject *bytes = PyByteArray_FromStringAndSize(nullptr, count * attrib.size * sizeof(float));
+  if (!bytes) {
+    return nullptr;
+  }
+
+  const unsigned int stride = array->GetVertexMemorySize();
+  const char *src = (const char *)array->GetVertexPointer() + start * stride + attrib.offset;
+  float *dst = (float *)PyByteArray_AS_STRING(bytes);
+
+  for (unsigned int i = 0; i < count; ++i, src += stride, dst += attrib.size) {
+    if (attrib.color) {
+      rgba_uchar_to_float(dst, (const unsigned char *)src);
+    }
+    else {
+      memcpy(dst, src, attrib.size * sizeof(float));
+    }
+  }
+
+  const unsigned int shape[2] = {count, attrib.size};
+  return PyMemoryViewFromByteArray(bytes, "f", shape, 2);
+}
+
+/** Copy a float32 buffer (e.g a numpy array or a memoryview returned by the getters) into a
+ * vertex attribute starting at a vertex, the vertex range is marked modified once.
+ */
+static bool kx_mesh_proxy_write_attribute(RAS_IDisplayArray *array,
+                                          const KX_VertexAttribute &attrib,
+                                          unsigned int start,
+                                          PyObject *data,
+                                          const char *error_prefix)
+{
+  Py_buffer buffer;
+  if (!PyFloatBufferTo(data, buffer, error_prefix)) {
+    return false;
+  }
+
+  const unsigned int numFloats = buffer.len / sizeof(float);
+  const unsigned int count = numFloats / attrib.size;
+  if (count * attrib.size != numFloats || start + count > array->GetVertexCount()) {
+    PyErr_Format(PyExc_ValueError,
+                 "%s: expected a multiple of %u floats for at most %u vertices, got %u floats",
+                 error_prefix,
+                 attrib.size,
+                 array->GetVertexCount() - start,
+                 numFloats);
+    PyBuffer_Release(&buffer);
+    return false;
+  }
+
+  const unsigned int stride = array->GetVertexMemorySize();
+  char *dst = (char *)array->GetVertexPointer() + start * stride + attrib.offset;
+  const float *src = (const float *)buffer.buf;
+
+  for (unsigned int i = 0; i < count; ++i, dst += stride, src += attrib.size) {
+    if (attrib.color) {
+      rgba_float_to_uchar((unsigned char *)dst, src);
+    }
+    else {
+      memcpy(dst, src, attrib.size * sizeof(float));
+    }
+  }
+
+  PyBuffer_Release(&buffer);
+
+  array->AppendModifiedFlag(attrib.flag);
+
+  return true;
+}
+
+static PyObject *kx_mesh_proxy_get_vertex_data(RAS_MeshObject *meshobj,
+                                               int type,
+                                               int matindex,
+                                               int layer,
+                                               int start,
+                                               int count,
+                                               const char *error_prefix)
+{
+  RAS_IDisplayArray *array = kx_mesh_proxy_get_array_range(
+      meshobj, matindex, start, count, error_prefix);
+  KX_VertexAttribute attrib;
+  if (!array || !kx_mesh_proxy_get_attribute(array, type, layer, attrib, error_prefix)) {
+    return nullptr;
+  }
+
+  return kx_mesh_proxy_read_attribute(array, attrib, start, count);
+}
+
+static PyObject *kx_mesh_proxy_set_vertex_data(RAS_MeshObject *meshobj,
+                                               int type,
+                                               int matindex,
+                                               PyObject *data,
+                                               int layer,
+                                               int start,
+                                               const char *error_prefix)
+{
+  int count = -1;
+  RAS_IDisplayArray *array = kx_mesh_proxy_get_array_range(
+      meshobj, matindex, start, count, error_prefix);
+  KX_VertexAttribute attrib;
+  if (!array || !kx_mesh_proxy_get_attribute(array, type, layer, attrib, error_prefix) ||
+      !kx_mesh_proxy_write_attribute(array, attrib, start, data, error_prefix)) {
+    return nullptr;
+  }
+
+  Py_RETURN_NONE;
+}
+
+PyObject *KX_MeshProxy::PyGetVertexPositions(PyObject *args, PyObject *kwds)
+{
+  int matindex;
+  int start = 0;
+  int count = -1;
+
+  if (!PyArg_ParseTuple(args, "i|ii:getVertexPositions", &matindex, &start, &count)) {
+    return nullptr;
+  }
+
+  return kx_mesh_proxy_get_vertex_data(m_meshobj,
+                                       RAS_IDisplayArray::POSITION_MODIFIED,
+                                       matindex,
+                                       0,
+                                       start,
+                                       count,
+                                       "mesh.getVertexPositions(...)");
+}
+
+PyObject *KX_MeshProxy::PySetVertexPositions(PyObject *args, PyObject *kwds)
+{
+  int matindex;
+  PyObject *data;
+  int start = 0;
+
+  if (!PyArg_ParseTuple(args, "iO|i:setVertexPositions", &matindex, &data, &start)) {
+    return nullptr;
+  }
+
+  return kx_mesh_proxy_set_vertex_data(m_meshobj,
+                                       RAS_IDisplayArray::POSITION_MODIFIED,
+                                       matindex,
+                                       data,
+                                       0,
+                                       start,
+                                       "mesh.setVertexPositions(...)");
+}
+
+PyObject *KX_MeshProxy::PyGetVertexNormals(PyObject *args, PyObject *kwds)
+{
+  int matindex;
+  int start = 0;
+  int count = -1;
+
+  if (!PyArg_ParseTuple(args, "i|ii:getVertexNormals", &matindex, &start, &count)) {
+    return nullptr;
+  }
+
+  return kx_mesh_proxy_get_vertex_data(m_meshobj,
+                                       RAS_IDisplayArray::NORMAL_MODIFIED,
+                                       matindex,
+                                       0,
+                                       start,
+                                       count,
+                                       "mesh.getVertexNormals(...)");
+}
+
+PyObject *KX_MeshProxy::PySetVertexNormals(PyObject *args, PyObject *kwds)
+{
+  int matindex;
+  PyObject *data;
+  int start = 0;
+
+  if (!PyArg_ParseTuple(args, "iO|i:setVertexNormals", &matindex, &data, &start)) {
+    return nullptr;
+  }
+
+  return kx_mesh_proxy_set_vertex_data(m_meshobj,
+                                       RAS_IDisplayArray::NORMAL_MODIFIED,
+                                       matindex,
+                                       data,
+                                       0,
+                                       start,
+                                       "mesh.setVertexNormals(...)");
+}
+
+PyObject *KX_MeshProxy::PyGetVertexUVs(PyObject *args, PyObject *kwds)
+{
+  int matindex;
+  int layer = 0;
+  int start = 0;
+  int count = -1;
+
+  if (!PyArg_ParseTuple(args, "i|iii:getVertexUVs", &matindex, &layer, &start, &count)) {
+    return nullptr;
+  }
+
+  return kx_mesh_proxy_get_vertex_data(m_meshobj,
+                                       RAS_IDisplayArray::UVS_MODIFIED,
+                                       matindex,
+                                       layer,
+                                       start,
+                                       count,
+                                       "mesh.getVertexUVs(...)");
+}
+
+PyObject *KX_MeshProxy::PySetVertexUVs(PyObject *args, PyObject *kwds)
+{
+  int matindex;
+  PyObject *data;
+  int layer = 0;
+  int start = 0;
+
+  if (!PyArg_ParseTuple(args, "iO|ii:setVertexUVs", &matindex, &data, &layer, &start)) {
+    return nullptr;
+  }
+
+  return kx_mesh_proxy_set_vertex_data(m_meshobj,
+                                       RAS_IDisplayArray::UVS_MODIFIED,
+                                       matindex,
+                                       data,
+                                       layer,
+                                       start,
+                                       "mesh.setVertexUVs(...)");
+}
+
+PyObject *KX_MeshProxy::PyGetVertexColors(PyObject *args, PyObject *kwds)
+{
+  int matindex;
+  int layer = 0;
+  int start = 0;
+  int count = -1;
+
+  if (!PyArg_ParseTuple(args, "i|iii:getVertexColors", &matindex, &layer, &start, &count)) {
+    return nullptr;
+  }
+
+  return kx_mesh_proxy_get_vertex_data(m_meshobj,
+                                       RAS_IDisplayArray::COLORS_MODIFIED,
+                                       matindex,
+                                       layer,
+                                       start,
+                                       count,
+                                       "mesh.getVertexColors(...)");
+}
+
+PyObject *KX_MeshProxy::PySetVertexColors(PyObject *args, PyObject *kwds)
+{
+  int matindex;
+  PyObject *data;
+  int layer = 0;
+  int start = 0;
+
+  if (!PyArg_ParseTuple(args, "iO|ii:setVertexColors", &matindex, &data, &layer, &start)) {
+    return nullptr;
+  }
+
+  return kx_mesh_proxy_set_vertex_data(m_meshobj,
+                                       RAS_IDisplayArray::COLORS_MODIFIED,
+                                       matindex,
+                                       data,
+                                       layer,
+                                       start,
+                                       "mesh.setVertexColors(...)");
+}
+
+PyObject *KX_MeshProxy::PyGetIndices(PyObject *args, PyObject *kwds)
+{
+  int matindex;
+
+  if (!PyArg_ParseTuple(args, "i:getIndices", &matindex)) {
+    return nullptr;
+  }
+
+  RAS_IDisplayArray *array = (matindex < 0) ? nullptr : m_meshobj->GetDisplayArray(matindex);
+  if (!array) {
+    PyErr_Format(PyExc_ValueError, "mesh.getIndices(...): invalid material index %d", matindex);
+    return nullptr;
+  }
+
+  const unsigned int count = array->GetIndexCount();
+  PyObject *bytes = PyByteArray_FromStringAndSize((const char *)array->GetIndexPointer(),
+                                                  count * sizeof(unsigned int));
+  if (!bytes) {
+    return nullptr;
+  }
+
+  return PyMemoryViewFromByteArray(bytes, "I", &count, 1);
+}
+
 PyObject *KX_MeshProxy::pyattr_get_materials(PyObjectPlus *self_v,
                                              const KX_PYATTRIBUTE_DEF *attrdef)
 {
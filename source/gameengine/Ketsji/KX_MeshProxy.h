@@ -78,6 +78,17 @@ class KX_MeshProxy : public CValue {
   KX_PYMETHOD(KX_MeshProxy, TransformUV);
   KX_PYMETHOD(KX_MeshProxy, ReplaceMaterial);
 
+  // bulk vertex access, take materialid (int)
+  KX_PYMETHOD(KX_MeshProxy, GetVertexPositions);
+  KX_PYMETHOD(KX_MeshProxy, SetVertexPositions);
+  KX_PYMETHOD(KX_MeshProxy, GetVertexNormals);
+  KX_PYMETHOD(KX_MeshProxy, SetVertexNormals);
+  KX_PYMETHOD(KX_MeshProxy, GetVertexUVs);
+  KX_PYMETHOD(KX_MeshProxy, SetVertexUVs);
+  KX_PYMETHOD(KX_MeshProxy, GetVertexColors);
+  KX_PYMETHOD(KX_MeshProxy, SetVertexColors);
+  KX_PYMETHOD(KX_MeshProxy, GetIndices);
+
   static PyObject *pyattr_get_materials(PyObjectPlus *self_v, const KX_PYATTRIBUTE_DEF *attrdef);
   static PyObject *pyattr_get_numMaterials(PyObjectPlus *self_v,
                                            const KX_PYATTRIBUTE_DEF *attrdef);
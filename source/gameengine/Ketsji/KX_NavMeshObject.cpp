@@ -25,579 +25,491 @@
  * ***** END GPL LICENSE BLOCK *****
  */
 
-#include "MEM_guardedalloc.h"
-
 #include "BLI_utildefines.h"
 #include "BLI_math.h"
 #include "BLI_math_vector.h"
+#include "BLI_task.h"
 #include "KX_NavMeshObject.h"
 #include "RAS_MeshObject.h"
 #include "RAS_Polygon.h"
 #include "RAS_ITexVert.h"
 
-#include "DNA_mesh_types.h"
-#include "DNA_meshdata_types.h"
-
-extern "C" {
-#include "BKE_global.h"
-#include "BKE_main.h"
-#include "BKE_scene.h"
-#include "BKE_customdata.h"
-#include "BKE_cdderivedmesh.h"
-#include "BKE_DerivedMesh.h"
-#include "BKE_layer.h"
-
-#include "BLI_sort.h"
-}
+#include "DNA_scene_types.h"
 
-#include "KX_BlenderConverter.h"
 #include "KX_Globals.h"
 #include "KX_PyMath.h"
 #include "EXP_Value.h"
 #include "Recast.h"
-#include "DetourStatNavMeshBuilder.h"
+#include "DetourTileNavMeshBuilder.h"
 #include "KX_ObstacleSimulation.h"
+#include "KX_PathQueryManager.h"
 
 #include "CM_Message.h"
 
+#include <algorithm>
+
 #define MAX_PATH_LEN 256
 static const float polyPickExt[3] = {2, 4, 2};
-
-static void calcMeshBounds(const float *vert, int nverts, float *bmin, float *bmax)
-{
-  bmin[0] = bmax[0] = vert[0];
-  bmin[1] = bmax[1] = vert[1];
-  bmin[2] = bmax[2] = vert[2];
-  for (int i = 1; i < nverts; i++) {
-    if (bmin[0] > vert[3 * i + 0])
-      bmin[0] = vert[3 * i + 0];
-    if (bmin[1] > vert[3 * i + 1])
-      bmin[1] = vert[3 * i + 1];
-    if (bmin[2] > vert[3 * i + 2])
-      bmin[2] = vert[3 * i + 2];
-
-    if (bmax[0] < vert[3 * i + 0])
-      bmax[0] = vert[3 * i + 0];
-    if (bmax[1] < vert[3 * i + 1])
-      bmax[1] = vert[3 * i + 1];
-    if (bmax[2] < vert[3 * i + 2])
-      bmax[2] = vert[3 * i + 2];
-  }
-}
+/// Size of a tile in cells, doubled until the mesh fits in NAVMESH_MAX_TILES tiles.
+static const int NAVMESH_TILE_SIZE = 32;
+/// Maximum number of tiles of the object mesh, the other tiles are left for the chunks.
+static const int NAVMESH_MAX_TILES = DT_MAX_TILES / 4;
+/// Cells added around a tile to build it, the polygons are then clipped to the tile.
+static const int NAVMESH_TILE_BORDER = 3;
 
 inline void flipAxes(float *vec)
 {
   std::swap(vec[1], vec[2]);
 }
 
-BLI_INLINE float area2(const float *a, const float *b, const float *c)
-{
-  return (b[0] - a[0]) * (c[2] - a[2]) - (c[0] - a[0]) * (b[2] - a[2]);
-}
+/// Recast settings shared by all the tiles of a navigation mesh.
+struct KX_NavMeshConfig {
+  /// Settings of a tile, the bounds and the size are set per tile.
+  rcConfig m_recast;
+  char m_partitioning;
+  /// Origin of the tile grid.
+  float m_orig[3];
+  float m_tileWorldSize;
+  float m_borderWorldSize;
+  float m_agentRadius;
+  float m_agentClimb;
+};
 
-BLI_INLINE int left(const float *a, const float *b, const float *c)
-{
-  return area2(a, b, c) < 0;
-}
+/// Triangles a navigation mesh is built from, in navigation mesh space.
+class KX_NavMeshGeometry {
+ public:
+  std::vector<float> m_verts;
+  std::vector<int> m_tris;
+  float m_bmin[3];
+  float m_bmax[3];
+  /// Triangles overlapping each tile and its border.
+  std::map<KX_NavMeshObject::TileCoord, std::vector<int>> m_tileTris;
+
+  void ComputeBounds()
+  {
+    rcCalcBounds(m_verts.data(), m_verts.size() / 3, m_bmin, m_bmax);
+  }
 
-static int polyNumVerts(const unsigned short *p, const int vertsPerPoly)
-{
-  int i, nv = 0;
-  for (i = 0; i < vertsPerPoly; i++) {
-    if (p[i] == 0xffff)
-      break;
-    nv++;
+  void BinTriangles(const KX_NavMeshConfig &config)
+  {
+    m_tileTris.clear();
+    const float border = config.m_borderWorldSize;
+    const float itile = 1.0f / config.m_tileWorldSize;
+    for (int i = 0, ntris = m_tris.size() / 3; i < ntris; ++i) {
+      float bmin[3], bmax[3];
+      copy_v3_v3(bmin, &m_verts[m_tris[i * 3] * 3]);
+      copy_v3_v3(bmax, bmin);
+      for (unsigned short j = 1; j < 3; ++j) {
+        rcVmin(bmin, &m_verts[m_tris[i * 3 + j] * 3]);
+        rcVmax(bmax, &m_verts[m_tris[i * 3 + j] * 3]);
+      }
+
+      const int minx = floorf((bmin[0] - border - config.m_orig[0]) * itile);
+      const int maxx = floorf((bmax[0] + border - config.m_orig[0]) * itile);
+      const int miny = floorf((bmin[2] - border - config.m_orig[2]) * itile);
+      const int maxy = floorf((bmax[2] + border - config.m_orig[2]) * itile);
+      for (int y = miny; y <= maxy; ++y) {
+        for (int x = minx; x <= maxx; ++x) {
+          m_tileTris[KX_NavMeshObject::TileCoord(x, y)].push_back(i);
+        }
+      }
+    }
   }
-  return nv;
-}
+};
 
-static int polyIsConvex(const unsigned short *p, const int vertsPerPoly, const float *verts)
-{
-  int j, nv = polyNumVerts(p, vertsPerPoly);
-  if (nv < 3)
-    return 0;
-  for (j = 0; j < nv; j++) {
-    const float *v = &verts[3 * p[j]];
-    const float *v_next = &verts[3 * p[(j + 1) % nv]];
-    const float *v_prev = &verts[3 * p[(nv + j - 1) % nv]];
-    if (!left(v_prev, v, v_next))
-      return 0;
-  }
-  return 1;
-}
+/** Data built from the object mesh, shared by a navigation mesh object and its replicas.
+ * The tiles are never modified, they are copied when added to a navigation mesh.
+ */
+class KX_NavMeshData : public CM_RefCount<KX_NavMeshData> {
+ public:
+  KX_NavMeshConfig m_config;
+  KX_NavMeshGeometry m_geometry;
+  std::map<KX_NavMeshObject::TileCoord, KX_NavMeshObject::Tile> m_tiles;
+
+  virtual ~KX_NavMeshData()
+  {
+    for (const auto &pair : m_tiles) {
+      delete[] pair.second.m_data;
+    }
+  }
+};
 
-/* XXX, could replace with #dist_to_line_segment_v3(), or add a squared version */
-static float distPointToSegmentSq(const float point[3], const float a[3], const float b[3])
+static bool initNavMeshConfig(const RecastData &recastData,
+                              const KX_NavMeshGeometry &geometry,
+                              KX_NavMeshConfig &config)
 {
-  float abx[3], dx[3];
-  float d, t;
-
-  sub_v3_v3v3(abx, b, a);
-  sub_v3_v3v3(dx, point, a);
+  if (recastData.cellsize <= 0.0f || recastData.cellheight <= 0.0f) {
+    return false;
+  }
 
-  d = abx[0] * abx[0] + abx[2] * abx[2];
-  t = abx[0] * dx[0] + abx[2] * dx[2];
+  rcConfig &cfg = config.m_recast;
+  memset(&cfg, 0, sizeof(cfg));
+  cfg.cs = recastData.cellsize;
+  cfg.ch = recastData.cellheight;
+  cfg.walkableSlopeAngle = RAD2DEGF(recastData.agentmaxslope);
+  cfg.walkableHeight = (int)ceilf(recastData.agentheight / cfg.ch);
+  cfg.walkableClimb = (int)floorf(recastData.agentmaxclimb / cfg.ch);
+  // The object mesh is already the walkable surface, it isn't eroded again.
+  cfg.walkableRadius = 0;
+  cfg.maxEdgeLen = (int)(recastData.edgemaxlen / cfg.cs);
+  cfg.maxSimplificationError = recastData.edgemaxerror;
+  cfg.minRegionArea = (int)rcSqr(recastData.regionminsize);
+  cfg.mergeRegionArea = (int)rcSqr(recastData.regionmergesize);
+  // The tile format only supports this number of vertices per polygon.
+  cfg.maxVertsPerPoly = DT_TILE_VERTS_PER_POLYGON;
+  cfg.detailSampleDist = (recastData.detailsampledist < 0.9f) ?
+                             0.0f :
+                             cfg.cs * recastData.detailsampledist;
+  cfg.detailSampleMaxError = cfg.ch * recastData.detailsamplemaxerror;
+  cfg.borderSize = NAVMESH_TILE_BORDER;
+
+  int width, height;
+  rcCalcGridSize(geometry.m_bmin, geometry.m_bmax, cfg.cs, &width, &height);
+  cfg.tileSize = NAVMESH_TILE_SIZE;
+  while (((width + cfg.tileSize - 1) / cfg.tileSize) * ((height + cfg.tileSize - 1) / cfg.tileSize) >
+         NAVMESH_MAX_TILES) {
+    cfg.tileSize *= 2;
+  }
+  cfg.width = cfg.height = cfg.tileSize + cfg.borderSize * 2;
 
-  if (d > 0.0f)
-    t /= d;
-  if (t < 0.0f)
-    t = 0.0f;
-  else if (t > 1.0f)
-    t = 1.0f;
-  dx[0] = a[0] + t * abx[0] - point[0];
-  dx[2] = a[2] + t * abx[2] - point[2];
+  config.m_partitioning = recastData.partitioning;
+  copy_v3_v3(config.m_orig, geometry.m_bmin);
+  config.m_tileWorldSize = cfg.tileSize * cfg.cs;
+  config.m_borderWorldSize = cfg.borderSize * cfg.cs;
+  config.m_agentRadius = recastData.agentradius;
+  config.m_agentClimb = recastData.agentmaxclimb;
 
-  return dx[0] * dx[0] + dx[2] * dx[2];
+  return true;
 }
 
-static int buildRawVertIndicesData(DerivedMesh *dm,
-                                   int *nverts_r,
-                                   float **verts_r,
-                                   int *ntris_r,
-                                   unsigned short **tris_r,
-                                   int **trisToFacesMap_r,
-                                   int **recastData)
+/// Bounds of a tile and its border, the height isn't bounded.
+static void tileBounds(const KX_NavMeshConfig &config,
+                       const KX_NavMeshObject::TileCoord &coord,
+                       float bmin[3],
+                       float bmax[3])
 {
-  int vi, fi, triIdx;
-  int nverts, ntris;
-  int *trisToFacesMap;
-  float *verts;
-  unsigned short *tris, *tri;
-  int nfaces;
-  MFace *faces;
-
-  nverts = dm->getNumVerts(dm);
-  if (nverts >= 0xffff) {
-    printf("Converting navmesh: Error! Too many vertices. Max number of vertices %d\n", 0xffff);
-    return 0;
-  }
-  if (nverts == 0) {
-    printf("Converting navmesh: Error! There are no vertices!\n");
-    return 0;
-  }
+  bmin[0] = config.m_orig[0] + coord.first * config.m_tileWorldSize - config.m_borderWorldSize;
+  bmin[1] = -FLT_MAX;
+  bmin[2] = config.m_orig[2] + coord.second * config.m_tileWorldSize - config.m_borderWorldSize;
+  bmax[0] = bmin[0] + config.m_tileWorldSize + config.m_borderWorldSize * 2.0f;
+  bmax[1] = FLT_MAX;
+  bmax[2] = bmin[2] + config.m_tileWorldSize + config.m_borderWorldSize * 2.0f;
+}
 
-  verts = (float *)MEM_mallocN(sizeof(float[3]) * nverts, "buildRawVertIndicesData verts");
-  dm->getVertCos(dm, (float(*)[3])verts);
+/// Box carved by a blocker, widened by the agent radius.
+static void blockerBounds(const KX_NavMeshConfig &config,
+                          const KX_NavMeshObject::Blocker &blocker,
+                          float bmin[3],
+                          float bmax[3])
+{
+  sub_v3_v3v3(bmin, blocker.m_center, blocker.m_extents);
+  add_v3_v3v3(bmax, blocker.m_center, blocker.m_extents);
+  bmin[0] -= config.m_agentRadius;
+  bmin[2] -= config.m_agentRadius;
+  bmax[0] += config.m_agentRadius;
+  bmax[2] += config.m_agentRadius;
+}
 
-  /* flip coordinates */
-  for (vi = 0; vi < nverts; vi++) {
-    SWAP(float, verts[3 * vi + 1], verts[3 * vi + 2]);
-  }
+static bool boxOverlap(const float amin[3],
+                       const float amax[3],
+                       const float bmin[3],
+                       const float bmax[3])
+{
+  return amin[0] <= bmax[0] && amax[0] >= bmin[0] && amin[1] <= bmax[1] && amax[1] >= bmin[1] &&
+         amin[2] <= bmax[2] && amax[2] >= bmin[2];
+}
 
-  /* calculate number of tris */
-  dm->recalcTessellation(dm);
-  nfaces = dm->getNumTessFaces(dm);
-  if (nfaces == 0) {
-    printf("Converting navmesh: Error! There are %i vertices, but no faces!\n", nverts);
-    return 0;
+/// Recast data of a tile build, freed when the build ends.
+struct TileBuildData {
+  rcHeightfield *m_solid;
+  rcCompactHeightfield *m_chf;
+  rcContourSet *m_cset;
+  rcPolyMesh *m_pmesh;
+  rcPolyMeshDetail *m_dmesh;
+
+  TileBuildData()
+      : m_solid(rcAllocHeightfield()),
+        m_chf(rcAllocCompactHeightfield()),
+        m_cset(rcAllocContourSet()),
+        m_pmesh(rcAllocPolyMesh()),
+        m_dmesh(rcAllocPolyMeshDetail())
+  {
   }
 
-  faces = dm->getTessFaceArray(dm);
-  ntris = nfaces;
-  for (fi = 0; fi < nfaces; fi++) {
-    MFace *face = &faces[fi];
-    if (face->v4)
-      ntris++;
-  }
-
-  /* copy and transform to triangles (reorder on the run) */
-  trisToFacesMap = (int *)MEM_callocN(sizeof(int) * ntris,
-                                      "buildRawVertIndicesData trisToFacesMap");
-  tris = (unsigned short *)MEM_callocN(sizeof(unsigned short) * 3 * ntris,
-                                       "buildRawVertIndicesData tris");
-  tri = tris;
-  triIdx = 0;
-  for (fi = 0; fi < nfaces; fi++) {
-    MFace *face = &faces[fi];
-    tri[3 * triIdx + 0] = (unsigned short)face->v1;
-    tri[3 * triIdx + 1] = (unsigned short)face->v3;
-    tri[3 * triIdx + 2] = (unsigned short)face->v2;
-    trisToFacesMap[triIdx++] = fi;
-    if (face->v4) {
-      tri[3 * triIdx + 0] = (unsigned short)face->v1;
-      tri[3 * triIdx + 1] = (unsigned short)face->v4;
-      tri[3 * triIdx + 2] = (unsigned short)face->v3;
-      trisToFacesMap[triIdx++] = fi;
-    }
+  ~TileBuildData()
+  {
+    rcFreeHeightField(m_solid);
+    rcFreeCompactHeightfield(m_chf);
+    rcFreeContourSet(m_cset);
+    rcFreePolyMesh(m_pmesh);
+    rcFreePolyMeshDetail(m_dmesh);
   }
+};
 
-  /* carefully, recast data is just reference to data in derived mesh */
-  *recastData = (int *)CustomData_get_layer(&dm->polyData, CD_RECAST);
-
-  *nverts_r = nverts;
-  *verts_r = verts;
-  *ntris_r = ntris;
-  *tris_r = tris;
-  *trisToFacesMap_r = trisToFacesMap;
-
-  return 1;
-}
+/// Build of a tile run on a worker thread.
+struct TileBuildTask {
+  const KX_NavMeshConfig *m_config;
+  const std::vector<const KX_NavMeshGeometry *> *m_sources;
+  const std::vector<KX_NavMeshObject::Blocker> *m_blockers;
+  KX_NavMeshObject::TileCoord m_coord;
+  /// Built tile, nullptr if the tile has no polygon.
+  KX_NavMeshObject::Tile m_tile;
+  /// Reason of a failed build.
+  const char *m_error;
+};
 
-static int buildPolygonsByDetailedMeshes(const int vertsPerPoly,
-                                         const int npolys,
-                                         unsigned short *polys,
-                                         const unsigned short *dmeshes,
-                                         const float *verts,
-                                         const unsigned short *dtris,
-                                         const int *dtrisToPolysMap)
+/** Build a Detour tile from the triangles of the sources overlapping the tile.
+ * \return False and set the error if the build failed, an empty tile isn't an error.
+ */
+static bool buildTile(TileBuildTask &task)
 {
-  int polyidx;
-  int capacity = vertsPerPoly;
-  unsigned short *newPoly = (unsigned short *)MEM_callocN(sizeof(unsigned short) * capacity,
-                                                          "buildPolygonsByDetailedMeshes newPoly");
-  memset(newPoly, 0xff, sizeof(unsigned short) * capacity);
-
-  for (polyidx = 0; polyidx < npolys; polyidx++) {
-    size_t i;
-    int j, k;
-    int nv = 0;
-    /* search border */
-    int tri, btri = -1;
-    int edge, bedge = -1;
-    int dtrisNum = dmeshes[polyidx * 4 + 3];
-    int dtrisBase = dmeshes[polyidx * 4 + 2];
-    unsigned char *traversedTris = (unsigned char *)MEM_callocN(
-        sizeof(unsigned char) * dtrisNum, "buildPolygonsByDetailedMeshes traversedTris");
-    unsigned short *adjustedPoly;
-    int adjustedNv;
-    int allBorderTraversed;
-
-    for (j = 0; j < dtrisNum && btri == -1; j++) {
-      int curpolytri = dtrisBase + j;
-      for (k = 0; k < 3; k++) {
-        unsigned short neighbortri = dtris[curpolytri * 3 * 2 + 3 + k];
-        if (neighbortri == 0xffff || dtrisToPolysMap[neighbortri] != polyidx + 1) {
-          btri = curpolytri;
-          bedge = k;
-          break;
-        }
-      }
+  const KX_NavMeshConfig &config = *task.m_config;
+  task.m_tile.m_data = nullptr;
+  task.m_tile.m_dataSize = 0;
+  task.m_error = nullptr;
+
+  rcConfig cfg = config.m_recast;
+  tileBounds(config, task.m_coord, cfg.bmin, cfg.bmax);
+  cfg.bmin[1] = FLT_MAX;
+  cfg.bmax[1] = -FLT_MAX;
+  bool empty = true;
+  for (const KX_NavMeshGeometry *source : *task.m_sources) {
+    if (source->m_tileTris.find(task.m_coord) != source->m_tileTris.end()) {
+      cfg.bmin[1] = std::min(cfg.bmin[1], source->m_bmin[1]);
+      cfg.bmax[1] = std::max(cfg.bmax[1], source->m_bmax[1]);
+      empty = false;
     }
-    if (btri == -1 || bedge == -1) {
-      /* can't find triangle with border edge */
-      MEM_freeN(traversedTris);
-      MEM_freeN(newPoly);
+  }
+  if (empty) {
+    return true;
+  }
 
-      return 0;
-    }
+  rcContext ctx(false);
+  TileBuildData build;
+  if (!rcCreateHeightfield(
+          &ctx, *build.m_solid, cfg.width, cfg.height, cfg.bmin, cfg.bmax, cfg.cs, cfg.ch)) {
+    task.m_error = "unable to create the height field";
+    return false;
+  }
 
-    newPoly[nv++] = dtris[btri * 3 * 2 + bedge];
-    tri = btri;
-    edge = (bedge + 1) % 3;
-    traversedTris[tri - dtrisBase] = 1;
-    while (tri != btri || edge != bedge) {
-      int neighbortri = dtris[tri * 3 * 2 + 3 + edge];
-      if (neighbortri == 0xffff || dtrisToPolysMap[neighbortri] != polyidx + 1) {
-        if (nv == capacity) {
-          unsigned short *newPolyBig;
-          capacity += vertsPerPoly;
-          newPolyBig = (unsigned short *)MEM_callocN(sizeof(unsigned short) * capacity,
-                                                     "buildPolygonsByDetailedMeshes newPolyBig");
-          memset(newPolyBig, 0xff, sizeof(unsigned short) * capacity);
-          memcpy(newPolyBig, newPoly, sizeof(unsigned short) * nv);
-          MEM_freeN(newPoly);
-          newPoly = newPolyBig;
-        }
-        newPoly[nv++] = dtris[tri * 3 * 2 + edge];
-        /* move to next edge */
-        edge = (edge + 1) % 3;
-      }
-      else {
-        /* move to next tri */
-        int twinedge = -1;
-        for (k = 0; k < 3; k++) {
-          if (dtris[neighbortri * 3 * 2 + 3 + k] == tri) {
-            twinedge = k;
-            break;
-          }
-        }
-        if (twinedge == -1) {
-          printf("Converting navmesh: Error! Can't find neighbor edge - invalid adjacency info\n");
-          MEM_freeN(traversedTris);
-          goto returnLabel;
-        }
-        tri = neighbortri;
-        edge = (twinedge + 1) % 3;
-        traversedTris[tri - dtrisBase] = 1;
-      }
+  std::vector<int> tris;
+  std::vector<unsigned char> areas;
+  for (const KX_NavMeshGeometry *source : *task.m_sources) {
+    const auto it = source->m_tileTris.find(task.m_coord);
+    if (it == source->m_tileTris.end()) {
+      continue;
     }
 
-    adjustedPoly = (unsigned short *)MEM_callocN(sizeof(unsigned short) * nv,
-                                                 "buildPolygonsByDetailedMeshes adjustedPoly");
-    adjustedNv = 0;
-    for (i = 0; i < nv; i++) {
-      unsigned short prev = newPoly[(nv + i - 1) % nv];
-      unsigned short cur = newPoly[i];
-      unsigned short next = newPoly[(i + 1) % nv];
-      float distSq = distPointToSegmentSq(&verts[3 * cur], &verts[3 * prev], &verts[3 * next]);
-      static const float tolerance = 0.001f;
-      if (distSq > tolerance)
-        adjustedPoly[adjustedNv++] = cur;
-    }
-    memcpy(newPoly, adjustedPoly, adjustedNv * sizeof(unsigned short));
-    MEM_freeN(adjustedPoly);
-    nv = adjustedNv;
-
-    allBorderTraversed = 1;
-    for (i = 0; i < dtrisNum; i++) {
-      if (traversedTris[i] == 0) {
-        /* check whether it has border edges */
-        int curpolytri = dtrisBase + i;
-        for (k = 0; k < 3; k++) {
-          unsigned short neighbortri = dtris[curpolytri * 3 * 2 + 3 + k];
-          if (neighbortri == 0xffff || dtrisToPolysMap[neighbortri] != polyidx + 1) {
-            allBorderTraversed = 0;
-            break;
-          }
-        }
+    const std::vector<int> &indices = it->second;
+    const int ntris = indices.size();
+    tris.resize(ntris * 3);
+    for (int i = 0; i < ntris; ++i) {
+      for (unsigned short j = 0; j < 3; ++j) {
+        tris[i * 3 + j] = source->m_tris[indices[i] * 3 + j];
       }
     }
-
-    if (nv <= vertsPerPoly && allBorderTraversed) {
-      for (i = 0; i < nv; i++) {
-        polys[polyidx * vertsPerPoly * 2 + i] = newPoly[i];
-      }
+    areas.assign(ntris, RC_NULL_AREA);
+
+    const int nverts = source->m_verts.size() / 3;
+    rcMarkWalkableTriangles(
+        &ctx, cfg.walkableSlopeAngle, source->m_verts.data(), nverts, tris.data(), ntris, areas.data());
+    if (!rcRasterizeTriangles(&ctx,
+                              source->m_verts.data(),
+                              nverts,
+                              tris.data(),
+                              areas.data(),
+                              ntris,
+                              *build.m_solid,
+                              cfg.walkableClimb)) {
+      task.m_error = "unable to rasterize the triangles";
+      return false;
     }
-
-    MEM_freeN(traversedTris);
   }
 
-returnLabel:
-  MEM_freeN(newPoly);
-
-  return 1;
-}
-
-struct SortContext {
-  const int *recastData;
-  const int *trisToFacesMap;
-};
-
-static int compareByData(const void *a, const void *b, void *ctx)
-{
-  return (((struct SortContext *)ctx)
-              ->recastData[((struct SortContext *)ctx)->trisToFacesMap[*(int *)a]] -
-          ((struct SortContext *)ctx)
-              ->recastData[((struct SortContext *)ctx)->trisToFacesMap[*(int *)b]]);
-}
-
-static int buildNavMeshData(const int nverts,
-                            const float *verts,
-                            const int ntris,
-                            const unsigned short *tris,
-                            const int *recastData,
-                            const int *trisToFacesMap,
-                            int *ndtris_r,
-                            unsigned short **dtris_r,
-                            int *npolys_r,
-                            unsigned short **dmeshes_r,
-                            unsigned short **polys_r,
-                            int *vertsPerPoly_r,
-                            int **dtrisToPolysMap_r,
-                            int **dtrisToTrisMap_r)
+  // The edges of the object mesh are not ledges, only remove the spans under obstacles.
+  rcFilterLowHangingWalkableObstacles(&ctx, cfg.walkableClimb, *build.m_solid);
+  rcFilterWalkableLowHeightSpans(&ctx, cfg.walkableHeight, *build.m_solid);
 
-{
-  int *trisMapping;
-  int i;
-  struct SortContext context;
-  int validTriStart, prevPolyIdx, curPolyIdx, newPolyIdx, prevpolyidx;
-  unsigned short *dmesh;
-
-  int ndtris, npolys, vertsPerPoly;
-  unsigned short *dtris, *dmeshes, *polys;
-  int *dtrisToPolysMap, *dtrisToTrisMap;
-
-  if (!recastData) {
-    printf("Converting navmesh: Error! Can't find recast custom data\n");
-    return 0;
+  if (!rcBuildCompactHeightfield(
+          &ctx, cfg.walkableHeight, cfg.walkableClimb, *build.m_solid, *build.m_chf)) {
+    task.m_error = "unable to create the compact height field";
+    return false;
   }
 
-  trisMapping = (int *)MEM_callocN(sizeof(int) * ntris, "buildNavMeshData trisMapping");
-
-  /* sort the triangles by polygon idx */
-  for (i = 0; i < ntris; i++)
-    trisMapping[i] = i;
-  context.recastData = recastData;
-  context.trisToFacesMap = trisToFacesMap;
-  BLI_qsort_r(trisMapping, ntris, sizeof(int), compareByData, &context);
+  for (const KX_NavMeshObject::Blocker &blocker : *task.m_blockers) {
+    float bmin[3], bmax[3];
+    blockerBounds(config, blocker, bmin, bmax);
+    if (boxOverlap(bmin, bmax, cfg.bmin, cfg.bmax)) {
+      rcMarkBoxArea(&ctx, bmin, bmax, RC_NULL_AREA, *build.m_chf);
+    }
+  }
 
-  /* search first valid triangle - triangle of convex polygon */
-  validTriStart = -1;
-  for (i = 0; i < ntris; i++) {
-    if (recastData[trisToFacesMap[trisMapping[i]]] > 0) {
-      validTriStart = i;
+  bool partitioned;
+  switch (config.m_partitioning) {
+    case RC_PARTITION_MONOTONE: {
+      partitioned = rcBuildRegionsMonotone(
+          &ctx, *build.m_chf, cfg.borderSize, cfg.minRegionArea, cfg.mergeRegionArea);
+      break;
+    }
+    case RC_PARTITION_LAYERS: {
+      partitioned = rcBuildLayerRegions(&ctx, *build.m_chf, cfg.borderSize, cfg.minRegionArea);
+      break;
+    }
+    default: {
+      partitioned = rcBuildDistanceField(&ctx, *build.m_chf) &&
+                    rcBuildRegions(&ctx,
+                                   *build.m_chf,
+                                   cfg.borderSize,
+                                   cfg.minRegionArea,
+                                   cfg.mergeRegionArea);
       break;
     }
   }
-
-  if (validTriStart < 0) {
-    printf("Converting navmesh: Error! No valid polygons in mesh\n");
-    MEM_freeN(trisMapping);
-    return 0;
+  if (!partitioned) {
+    task.m_error = "unable to build the regions";
+    return false;
   }
 
-  ndtris = ntris - validTriStart;
-  /* fill dtris to faces mapping */
-  dtrisToTrisMap = (int *)MEM_callocN(sizeof(int) * ndtris, "buildNavMeshData dtrisToTrisMap");
-  memcpy(dtrisToTrisMap, &trisMapping[validTriStart], ndtris * sizeof(int));
-  MEM_freeN(trisMapping);
-
-  /* create detailed mesh triangles  - copy only valid triangles
-   * and reserve memory for adjacency info */
-  dtris = (unsigned short *)MEM_callocN(sizeof(unsigned short) * 3 * 2 * ndtris,
-                                        "buildNavMeshData dtris");
-  memset(dtris, 0xff, sizeof(unsigned short) * 3 * 2 * ndtris);
-  for (i = 0; i < ndtris; i++) {
-    memcpy(dtris + 3 * 2 * i, tris + 3 * dtrisToTrisMap[i], sizeof(unsigned short) * 3);
-  }
-
-  /* create new recast data corresponded to dtris and renumber for continuous indices */
-  prevPolyIdx = -1;
-  newPolyIdx = 0;
-  dtrisToPolysMap = (int *)MEM_callocN(sizeof(int) * ndtris, "buildNavMeshData dtrisToPolysMap");
-  for (i = 0; i < ndtris; i++) {
-    curPolyIdx = recastData[trisToFacesMap[dtrisToTrisMap[i]]];
-    if (curPolyIdx != prevPolyIdx) {
-      newPolyIdx++;
-      prevPolyIdx = curPolyIdx;
-    }
-    dtrisToPolysMap[i] = newPolyIdx;
+  if (!rcBuildContours(
+          &ctx, *build.m_chf, cfg.maxSimplificationError, cfg.maxEdgeLen, *build.m_cset)) {
+    task.m_error = "unable to build the contours";
+    return false;
   }
 
-  /* build adjacency info for detailed mesh triangles */
-  if (!buildMeshAdjacency(dtris, ndtris, nverts, 3)) {
-    printf("Converting navmesh: Error! Unable to build mesh adjacency information\n");
-    MEM_freeN(trisMapping);
-    MEM_freeN(dtrisToPolysMap);
-    return 0;
+  if (!rcBuildPolyMesh(&ctx, *build.m_cset, cfg.maxVertsPerPoly, *build.m_pmesh)) {
+    task.m_error = "unable to build the polygons";
+    return false;
   }
 
-  /* create detailed mesh description for each navigation polygon */
-  npolys = dtrisToPolysMap[ndtris - 1];
-  dmeshes = (unsigned short *)MEM_callocN(sizeof(unsigned short) * npolys * 4,
-                                          "buildNavMeshData dmeshes");
-  memset(dmeshes, 0, npolys * 4 * sizeof(unsigned short));
-  dmesh = NULL;
-  prevpolyidx = 0;
-  for (i = 0; i < ndtris; i++) {
-    int curpolyidx = dtrisToPolysMap[i];
-    if (curpolyidx != prevpolyidx) {
-      if (curpolyidx != prevpolyidx + 1) {
-        printf("Converting navmesh: Error! Wrong order of detailed mesh faces\n");
-        goto fail;
-      }
-      dmesh = dmesh == NULL ? dmeshes : dmesh + 4;
-      dmesh[2] = (unsigned short)i; /* tbase */
-      dmesh[3] = 0;                 /* tnum */
-      prevpolyidx = curpolyidx;
-    }
-    dmesh[3]++;
+  const rcPolyMesh &pmesh = *build.m_pmesh;
+  if (pmesh.npolys == 0) {
+    return true;
+  }
+  // The polygon index of a reference is stored on 8 bits.
+  if (pmesh.npolys > DT_MAX_POLYGONS) {
+    task.m_error = "too many polygons in the tile, increase the cell size";
+    return false;
   }
 
-  /* create navigation polygons */
-  vertsPerPoly = 6;
-  polys = (unsigned short *)MEM_callocN(sizeof(unsigned short) * npolys * vertsPerPoly * 2,
-                                        "buildNavMeshData polys");
-  memset(polys, 0xff, sizeof(unsigned short) * vertsPerPoly * 2 * npolys);
+  if (!rcBuildPolyMeshDetail(&ctx,
+                             pmesh,
+                             *build.m_chf,
+                             cfg.detailSampleDist,
+                             cfg.detailSampleMaxError,
+                             *build.m_dmesh)) {
+    task.m_error = "unable to build the detail mesh";
+    return false;
+  }
 
-  if (!buildPolygonsByDetailedMeshes(
-          vertsPerPoly, npolys, polys, dmeshes, verts, dtris, dtrisToPolysMap)) {
-    printf("Converting navmesh: Error! Unable to build polygons from detailed mesh\n");
-    goto fail;
+  const rcPolyMeshDetail &dmesh = *build.m_dmesh;
+  std::vector<unsigned short> dmeshes(dmesh.meshes, dmesh.meshes + dmesh.nmeshes * 4);
+  if (!dtCreateNavMeshTileData(pmesh.verts,
+                               pmesh.nverts,
+                               pmesh.polys,
+                               pmesh.npolys,
+                               pmesh.nvp,
+                               dmeshes.data(),
+                               dmesh.verts,
+                               dmesh.nverts,
+                               dmesh.tris,
+                               dmesh.ntris,
+                               pmesh.bmin,
+                               pmesh.bmax,
+                               cfg.cs,
+                               cfg.ch,
+                               cfg.tileSize,
+                               cfg.walkableClimb,
+                               &task.m_tile.m_data,
+                               &task.m_tile.m_dataSize)) {
+    task.m_error = "unable to create the tile data";
+    return false;
   }
 
-  *ndtris_r = ndtris;
-  *npolys_r = npolys;
-  *vertsPerPoly_r = vertsPerPoly;
-  *dtris_r = dtris;
-  *dmeshes_r = dmeshes;
-  *polys_r = polys;
-  *dtrisToPolysMap_r = dtrisToPolysMap;
-  *dtrisToTrisMap_r = dtrisToTrisMap;
+  return true;
+}
 
-  return 1;
+static void build_tile_task_func(void *__restrict userdata,
+                                 const int iter,
+                                 const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  buildTile(((TileBuildTask *)userdata)[iter]);
+}
 
-fail:
-  MEM_freeN(dmeshes);
-  MEM_freeN(dtrisToPolysMap);
-  MEM_freeN(dtrisToTrisMap);
-  return 0;
+/// Build the tiles in parallel and report the failed builds.
+static void buildTiles(std::vector<TileBuildTask> &tasks, const std::string &name)
+{
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (tasks.size() > 1);
+  settings.min_iter_per_thread = 1;
+  BLI_task_parallel_range(0, tasks.size(), tasks.data(), build_tile_task_func, &settings);
+
+  for (const TileBuildTask &task : tasks) {
+    if (task.m_error) {
+      CM_Warning("navigation mesh " << name << ", tile (" << task.m_coord.first << ", "
+                                    << task.m_coord.second << "): " << task.m_error);
+    }
+  }
 }
 
-static int buildNavMeshDataByDerivedMesh(DerivedMesh *dm,
-                                         int *vertsPerPoly,
-                                         int *nverts,
-                                         float **verts,
-                                         int *ndtris,
-                                         unsigned short **dtris,
-                                         int *npolys,
-                                         unsigned short **dmeshes,
-                                         unsigned short **polys,
-                                         int **dtrisToPolysMap,
-                                         int **dtrisToTrisMap,
-                                         int **trisToFacesMap)
+static dtTiledNavMesh *createNavMesh(const KX_NavMeshConfig &config)
 {
-  int res;
-  int ntris = 0, *recastData = NULL;
-  unsigned short *tris = NULL;
-
-  res = buildRawVertIndicesData(dm, nverts, verts, &ntris, &tris, trisToFacesMap, &recastData);
-  if (!res) {
-    printf("Converting navmesh: Error! Can't get raw vertices and indices from mesh\n");
-    goto exit;
-  }
-
-  res = buildNavMeshData(*nverts,
-                         *verts,
-                         ntris,
-                         tris,
-                         recastData,
-                         *trisToFacesMap,
-                         ndtris,
-                         dtris,
-                         npolys,
-                         dmeshes,
-                         polys,
-                         vertsPerPoly,
-                         dtrisToPolysMap,
-                         dtrisToTrisMap);
-  if (!res) {
-    printf("Converting navmesh: Error! Can't build navmesh data from mesh\n");
-    goto exit;
-  }
-
-exit:
-  if (tris)
-    MEM_freeN(tris);
-
-  return res;
+  dtTiledNavMesh *navmesh = new dtTiledNavMesh;
+  navmesh->init(config.m_orig, config.m_tileWorldSize, config.m_agentClimb);
+  return navmesh;
 }
 
-static int polyFindVertex(const unsigned short *p,
-                          const int vertsPerPoly,
-                          unsigned short vertexIdx)
+/// The navigation mesh destructor doesn't free the tiles it owns.
+static void freeNavMesh(dtTiledNavMesh *navmesh)
 {
-  int i, res = -1;
-  for (i = 0; i < vertsPerPoly; i++) {
-    if (p[i] == 0xffff)
-      break;
-    if (p[i] == vertexIdx) {
-      res = i;
-      break;
+  for (int i = 0; i < DT_MAX_TILES; ++i) {
+    dtTile *tile = navmesh->getTile(i);
+    if (tile->header && tile->ownsData) {
+      delete[] tile->data;
     }
   }
-  return res;
+  delete navmesh;
+}
+
+/// Replace a tile in a navigation mesh by a copy of the tile data.
+static bool setNavMeshTile(dtTiledNavMesh *navmesh,
+                           const KX_NavMeshObject::TileCoord &coord,
+                           const KX_NavMeshObject::Tile *tile)
+{
+  navmesh->removeTileAt(coord.first, coord.second, nullptr, nullptr);
+  if (!tile || !tile->m_data) {
+    return true;
+  }
+
+  // Adding a tile writes its links in the data.
+  unsigned char *data = new unsigned char[tile->m_dataSize];
+  memcpy(data, tile->m_data, tile->m_dataSize);
+  if (!navmesh->addTileAt(coord.first, coord.second, data, tile->m_dataSize, true)) {
+    delete[] data;
+    return false;
+  }
+  return true;
 }
 
 KX_NavMeshObject::KX_NavMeshObject(void *sgReplicationInfo, SG_Callbacks callbacks)
-    : KX_GameObject(sgReplicationInfo, callbacks), m_navMesh(nullptr)
+    : KX_GameObject(sgReplicationInfo, callbacks),
+      m_navMesh(nullptr),
+      m_navMeshData(nullptr),
+      m_version(0),
+      m_lastBlockerId(0),
+      m_chunkOwner(nullptr)
 {
 }
 
 KX_NavMeshObject::~KX_NavMeshObject()
 {
+  DetachChunks();
+  ClearQueryNavMeshes();
+  ClearLocalTiles();
   if (m_navMesh)
-    delete m_navMesh;
+    freeNavMesh(m_navMesh);
+  if (m_navMeshData)
+    m_navMeshData->Release();
 }
 
 CValue *KX_NavMeshObject::GetReplica()
@@ -611,7 +523,20 @@ void KX_NavMeshObject::ProcessReplica()
 {
   KX_GameObject::ProcessReplica();
   m_navMesh = nullptr; /* without this, building frees the navmesh we copied from */
-  if (!BuildNavMesh()) {
+  m_queryNavMeshes.clear();
+  /* blockers and chunks are owned by the object which added them */
+  m_blockers.clear();
+  m_chunks.clear();
+  m_chunkOwner = nullptr;
+  m_localTiles.clear();
+  m_dirtyTiles.clear();
+
+  /* the built tiles are shared with the original, only the navigation mesh is duplicated */
+  if (m_navMeshData) {
+    m_navMeshData->AddRef();
+    InitNavMesh();
+  }
+  else if (!BuildNavMesh()) {
     CM_FunctionError("unable to build navigation mesh");
     return;
   }
@@ -620,446 +545,492 @@ void KX_NavMeshObject::ProcessReplica()
     obssimulation->AddObstaclesForNavMesh(this);
 }
 
-bool KX_NavMeshObject::BuildVertIndArrays(float *&vertices,
-                                          int &nverts,
-                                          unsigned short *&polys,
-                                          int &npolys,
-                                          unsigned short *&dmeshes,
-                                          float *&dvertices,
-                                          int &ndvertsuniq,
-                                          unsigned short *&dtris,
-                                          int &ndtris,
-                                          int &vertsPerPoly)
+bool KX_NavMeshObject::BuildGeometry(KX_NavMeshGeometry &geometry)
 {
-  /* TODO: This doesn't work currently because of eval_ctx. */
-  Scene *scene = GetScene()->GetBlenderScene();
-  ViewLayer *view_layer = BKE_view_layer_default_view(scene);
-  Depsgraph *depsgraph = BKE_scene_get_depsgraph(G_MAIN, scene, view_layer, false);
-  DerivedMesh *dm = mesh_create_derived_no_virtual(
-      depsgraph, GetScene()->GetBlenderScene(), GetBlenderObject(), nullptr, &CD_MASK_MESH);
-  CustomData *pdata = dm->getPolyDataLayout(dm);
-  int *recastData = (int *)CustomData_get_layer(pdata, CD_RECAST);
-  if (recastData) {
-    int *dtrisToPolysMap = nullptr, *dtrisToTrisMap = nullptr, *trisToFacesMap = nullptr;
-    int nAllVerts = 0;
-    float *allVerts = nullptr;
-    buildNavMeshDataByDerivedMesh(dm,
-                                  &vertsPerPoly,
-                                  &nAllVerts,
-                                  &allVerts,
-                                  &ndtris,
-                                  &dtris,
-                                  &npolys,
-                                  &dmeshes,
-                                  &polys,
-                                  &dtrisToPolysMap,
-                                  &dtrisToTrisMap,
-                                  &trisToFacesMap);
-
-    MEM_SAFE_FREE(dtrisToPolysMap);
-    MEM_SAFE_FREE(dtrisToTrisMap);
-    MEM_SAFE_FREE(trisToFacesMap);
-
-    unsigned short *verticesMap = (unsigned short *)MEM_mallocN(sizeof(*verticesMap) * nAllVerts,
-                                                                __func__);
-    memset(verticesMap, 0xff, sizeof(*verticesMap) * nAllVerts);
-    int curIdx = 0;
-    // vertices - mesh verts
-    // iterate over all polys and create map for their vertices first...
-    for (int polyidx = 0; polyidx < npolys; polyidx++) {
-      unsigned short *poly = &polys[polyidx * vertsPerPoly * 2];
-      for (int i = 0; i < vertsPerPoly; i++) {
-        unsigned short idx = poly[i];
-        if (idx == 0xffff)
-          break;
-        if (verticesMap[idx] == 0xffff) {
-          verticesMap[idx] = curIdx++;
-        }
-        poly[i] = verticesMap[idx];
-      }
+  RAS_MeshObject *meshobj = GetMesh(0);
+  const int nverts = meshobj->m_sharedvertex_map.size();
+  geometry.m_verts.resize(nverts * 3);
+  for (int vi = 0; vi < nverts; vi++) {
+    float *vert = &geometry.m_verts[vi * 3];
+    if (!meshobj->m_sharedvertex_map[vi].empty()) {
+      copy_v3_v3(vert, meshobj->GetVertexLocation(vi));
+      flipAxes(vert);
     }
-    nverts = curIdx;
-    //...then iterate over detailed meshes
-    // transform indices to local ones (for each navigation polygon)
-    for (int polyidx = 0; polyidx < npolys; polyidx++) {
-      unsigned short *poly = &polys[polyidx * vertsPerPoly * 2];
-      int nv = polyNumVerts(poly, vertsPerPoly);
-      unsigned short *dmesh = &dmeshes[4 * polyidx];
-      unsigned short tribase = dmesh[2];
-      unsigned short trinum = dmesh[3];
-      unsigned short vbase = curIdx;
-      for (int j = 0; j < trinum; j++) {
-        unsigned short *dtri = &dtris[(tribase + j) * 3 * 2];
-        for (int k = 0; k < 3; k++) {
-          int newVertexIdx = verticesMap[dtri[k]];
-          if (newVertexIdx == 0xffff) {
-            newVertexIdx = curIdx++;
-            verticesMap[dtri[k]] = newVertexIdx;
-          }
-
-          if (newVertexIdx < nverts) {
-            // it's polygon vertex ("shared")
-            int idxInPoly = polyFindVertex(poly, vertsPerPoly, newVertexIdx);
-            if (idxInPoly == -1) {
-              CM_Error("building NavMeshObject, can't find vertex in polygon\n");
-              return false;
-            }
-            dtri[k] = idxInPoly;
-          }
-          else {
-            dtri[k] = newVertexIdx - vbase + nv;
-          }
-        }
-      }
-      dmesh[0] = vbase - nverts;  // verts base
-      dmesh[1] = curIdx - vbase;  // verts num
-    }
-
-    vertices = new float[nverts * 3];
-    ndvertsuniq = curIdx - nverts;
-    if (ndvertsuniq > 0) {
-      dvertices = new float[ndvertsuniq * 3];
+    else {
+      zero_v3(vert);  // vertex isn't in any poly, set dummy zero coordinates
     }
-    for (int vi = 0; vi < nAllVerts; vi++) {
-      int newIdx = verticesMap[vi];
-      if (newIdx != 0xffff) {
-        if (newIdx < nverts) {
-          // navigation mesh vertex
-          memcpy(vertices + 3 * newIdx, allVerts + 3 * vi, 3 * sizeof(float));
-        }
-        else {
-          // detailed mesh vertex
-          memcpy(dvertices + 3 * (newIdx - nverts), allVerts + 3 * vi, 3 * sizeof(float));
-        }
-      }
-    }
-
-    MEM_SAFE_FREE(allVerts);
-
-    MEM_freeN(verticesMap);
   }
-  else {
-    // create from RAS_MeshObject (detailed mesh is fake)
-    RAS_MeshObject *meshobj = GetMesh(0);
-    vertsPerPoly = 3;
-    nverts = meshobj->m_sharedvertex_map.size();
-    if (nverts >= 0xffff)
-      return false;
-    // calculate count of tris
-    int nmeshpolys = meshobj->NumPolygons();
-    npolys = nmeshpolys;
-    for (int p = 0; p < nmeshpolys; p++) {
-      int vertcount = meshobj->GetPolygon(p)->VertexCount();
-      npolys += vertcount - 3;
-    }
 
-    // create verts
-    vertices = new float[nverts * 3];
-    float *vert = vertices;
-    for (int vi = 0; vi < nverts; vi++) {
-      const float *pos = !meshobj->m_sharedvertex_map[vi].empty() ?
-                             meshobj->GetVertexLocation(vi) :
-                             nullptr;
-      if (pos)
-        copy_v3_v3(vert, pos);
-      else {
-        memset(vert, 0, 3 * sizeof(float));  // vertex isn't in any poly, set dummy zero
-                                             // coordinates
-      }
-      vert += 3;
+  // Triangulate the polygons, the winding is reversed by the axes flip.
+  geometry.m_tris.clear();
+  for (int p = 0, nmeshpolys = meshobj->NumPolygons(); p < nmeshpolys; p++) {
+    RAS_Polygon *raspoly = meshobj->GetPolygon(p);
+    for (int v = 0; v < raspoly->VertexCount() - 2; v++) {
+      geometry.m_tris.push_back(raspoly->GetVertexInfo(0).getOrigIndex());
+      geometry.m_tris.push_back(raspoly->GetVertexInfo(v + 2).getOrigIndex());
+      geometry.m_tris.push_back(raspoly->GetVertexInfo(v + 1).getOrigIndex());
     }
+  }
 
-    // create tris
-    polys = (unsigned short *)MEM_callocN(sizeof(unsigned short) * 3 * 2 * npolys,
-                                          "BuildVertIndArrays polys");
-    memset(polys, 0xff, sizeof(unsigned short) * 3 * 2 * npolys);
-    unsigned short *poly = polys;
-    RAS_Polygon *raspoly;
-    for (int p = 0; p < nmeshpolys; p++) {
-      raspoly = meshobj->GetPolygon(p);
-      for (int v = 0; v < raspoly->VertexCount() - 2; v++) {
-        poly[0] = raspoly->GetVertexInfo(0).getOrigIndex();
-        for (size_t i = 1; i < 3; i++) {
-          poly[i] = raspoly->GetVertexInfo(v + i).getOrigIndex();
-        }
-        poly += 6;
-      }
-    }
-    dmeshes = nullptr;
-    dvertices = nullptr;
-    ndvertsuniq = 0;
-    dtris = nullptr;
-    ndtris = npolys;
+  if (geometry.m_tris.empty()) {
+    return false;
   }
-  dm->release(dm);
 
+  geometry.ComputeBounds();
   return true;
 }
 
 bool KX_NavMeshObject::BuildNavMesh()
 {
+  ClearQueryNavMeshes();
+  ClearLocalTiles();
+  m_dirtyTiles.clear();
+  ++m_version;
   if (m_navMesh) {
-    delete m_navMesh;
+    freeNavMesh(m_navMesh);
     m_navMesh = nullptr;
   }
+  if (m_navMeshData) {
+    m_navMeshData->Release();
+    m_navMeshData = nullptr;
+  }
 
   if (GetMeshCount() == 0) {
     CM_Error("can't find mesh for navmesh object: " << m_name);
     return false;
   }
 
-  float *vertices = nullptr, *dvertices = nullptr;
-  unsigned short *polys = nullptr, *dtris = nullptr, *dmeshes = nullptr;
-  int nverts = 0, npolys = 0, ndvertsuniq = 0, ndtris = 0;
-  int vertsPerPoly = 0;
-  if (!BuildVertIndArrays(vertices,
-                          nverts,
-                          polys,
-                          npolys,
-                          dmeshes,
-                          dvertices,
-                          ndvertsuniq,
-                          dtris,
-                          ndtris,
-                          vertsPerPoly) ||
-      vertsPerPoly < 3) {
+  KX_NavMeshData *data = new KX_NavMeshData();
+  if (!BuildGeometry(data->m_geometry) ||
+      !initNavMeshConfig(
+          GetScene()->GetBlenderScene()->gm.recastData, data->m_geometry, data->m_config)) {
     CM_Error("can't build navigation mesh data for object: " << m_name);
-    if (vertices) {
-      delete[] vertices;
-    }
-    if (dvertices) {
-      delete[] dvertices;
-    }
+    data->Release();
     return false;
   }
+  data->m_geometry.BinTriangles(data->m_config);
+
+  const std::vector<const KX_NavMeshGeometry *> sources = {&data->m_geometry};
+  const std::vector<Blocker> blockers;
+  std::vector<TileBuildTask> tasks;
+  tasks.reserve(data->m_geometry.m_tileTris.size());
+  for (const auto &pair : data->m_geometry.m_tileTris) {
+    TileBuildTask task;
+    task.m_config = &data->m_config;
+    task.m_sources = &sources;
+    task.m_blockers = &blockers;
+    task.m_coord = pair.first;
+    tasks.push_back(task);
+  }
+  buildTiles(tasks, m_name);
 
-  MT_Vector3 pos;
-  if (dmeshes == nullptr) {
-    for (int i = 0; i < nverts; i++) {
-      flipAxes(&vertices[i * 3]);
+  for (const TileBuildTask &task : tasks) {
+    if (task.m_tile.m_data) {
+      data->m_tiles[task.m_coord] = task.m_tile;
     }
-    for (int i = 0; i < ndvertsuniq; i++) {
-      flipAxes(&dvertices[i * 3]);
+  }
+
+  m_navMeshData = data;
+  InitNavMesh();
+
+  return true;
+}
+
+dtTiledNavMesh *KX_NavMeshObject::GetNavMesh()
+{
+  UpdateTiles();
+  return m_navMesh;
+}
+
+void KX_NavMeshObject::InitNavMesh()
+{
+  ClearQueryNavMeshes();
+  ClearLocalTiles();
+  m_dirtyTiles.clear();
+  if (m_navMesh) {
+    freeNavMesh(m_navMesh);
+  }
+  ++m_version;
+
+  const KX_NavMeshConfig &config = m_navMeshData->m_config;
+  m_navMesh = createNavMesh(config);
+  for (const auto &pair : m_navMeshData->m_tiles) {
+    if (!setNavMeshTile(m_navMesh, pair.first, &pair.second)) {
+      CM_Warning("navigation mesh " << m_name << ": too many tiles");
+      break;
     }
   }
 
-  if (!buildMeshAdjacency(polys, npolys, nverts, vertsPerPoly)) {
-    CM_FunctionError("unable to build mesh adjacency information.");
-    delete[] vertices;
-    return false;
+  // The tiles under the blockers and the chunks are built on the next use.
+  for (const Blocker &blocker : m_blockers) {
+    InvalidateBlocker(blocker);
+  }
+  for (const Chunk &chunk : m_chunks) {
+    chunk.m_geometry->BinTriangles(config);
+    InvalidateChunk(chunk);
   }
+}
 
-  float cs = 0.2f;
+void KX_NavMeshObject::ClearQueryNavMeshes()
+{
+  for (dtTiledNavMesh *query : m_queryNavMeshes) {
+    freeNavMesh(query);
+  }
+  m_queryNavMeshes.clear();
+}
 
-  if (!nverts || !npolys) {
-    if (vertices)
-      delete[] vertices;
-    return false;
+void KX_NavMeshObject::ClearLocalTiles()
+{
+  for (const auto &pair : m_localTiles) {
+    delete[] pair.second.m_data;
   }
+  m_localTiles.clear();
+}
 
-  float bmin[3], bmax[3];
-  calcMeshBounds(vertices, nverts, bmin, bmax);
-  // quantize vertex pos
-  unsigned short *vertsi = new unsigned short[3 * nverts];
-  float ics = 1.f / cs;
-  for (int i = 0; i < nverts; i++) {
-    vertsi[3 * i + 0] = static_cast<unsigned short>((vertices[3 * i + 0] - bmin[0]) * ics);
-    vertsi[3 * i + 1] = static_cast<unsigned short>((vertices[3 * i + 1] - bmin[1]) * ics);
-    vertsi[3 * i + 2] = static_cast<unsigned short>((vertices[3 * i + 2] - bmin[2]) * ics);
-  }
-
-  // Calculate data size
-  const int headerSize = sizeof(dtStatNavMeshHeader);
-  const int vertsSize = sizeof(float) * 3 * nverts;
-  const int polysSize = sizeof(dtStatPoly) * npolys;
-  const int nodesSize = sizeof(dtStatBVNode) * npolys * 2;
-  const int detailMeshesSize = sizeof(dtStatPolyDetail) * npolys;
-  const int detailVertsSize = sizeof(float) * 3 * ndvertsuniq;
-  const int detailTrisSize = sizeof(unsigned char) * 4 * ndtris;
-
-  const int dataSize = headerSize + vertsSize + polysSize + nodesSize + detailMeshesSize +
-                       detailVertsSize + detailTrisSize;
-  unsigned char *data = new unsigned char[dataSize];
-
-  memset(data, 0, dataSize);
-
-  unsigned char *d = data;
-  dtStatNavMeshHeader *header = (dtStatNavMeshHeader *)d;
-  d += headerSize;
-  float *navVerts = (float *)d;
-  d += vertsSize;
-  dtStatPoly *navPolys = (dtStatPoly *)d;
-  d += polysSize;
-  dtStatBVNode *navNodes = (dtStatBVNode *)d;
-  d += nodesSize;
-  dtStatPolyDetail *navDMeshes = (dtStatPolyDetail *)d;
-  d += detailMeshesSize;
-  float *navDVerts = (float *)d;
-  d += detailVertsSize;
-  unsigned char *navDTris = (unsigned char *)d;
-  d += detailTrisSize;
-
-  // Store header
-  header->magic = DT_STAT_NAVMESH_MAGIC;
-  header->version = DT_STAT_NAVMESH_VERSION;
-  header->npolys = npolys;
-  header->nverts = nverts;
-  header->cs = cs;
-  header->bmin[0] = bmin[0];
-  header->bmin[1] = bmin[1];
-  header->bmin[2] = bmin[2];
-  header->bmax[0] = bmax[0];
-  header->bmax[1] = bmax[1];
-  header->bmax[2] = bmax[2];
-  header->ndmeshes = npolys;
-  header->ndverts = ndvertsuniq;
-  header->ndtris = ndtris;
-
-  // Store vertices
-  for (int i = 0; i < nverts; ++i) {
-    const unsigned short *iv = &vertsi[i * 3];
-    float *v = &navVerts[i * 3];
-    v[0] = bmin[0] + iv[0] * cs;
-    v[1] = bmin[1] + iv[1] * cs;
-    v[2] = bmin[2] + iv[2] * cs;
-  }
-  // memcpy(navVerts, vertices, nverts*3*sizeof(float));
-
-  // Store polygons
-  const unsigned short *src = polys;
-  for (int i = 0; i < npolys; ++i) {
-    dtStatPoly *p = &navPolys[i];
-    p->nv = 0;
-    for (int j = 0; j < vertsPerPoly; ++j) {
-      if (src[j] == 0xffff)
-        break;
-      p->v[j] = src[j];
-      p->n[j] = src[vertsPerPoly + j] + 1;
-      p->nv++;
+const KX_NavMeshObject::Tile *KX_NavMeshObject::GetSourceTile(const TileCoord &coord) const
+{
+  const auto localIt = m_localTiles.find(coord);
+  if (localIt != m_localTiles.end()) {
+    return &localIt->second;
+  }
+  const auto sharedIt = m_navMeshData->m_tiles.find(coord);
+  if (sharedIt != m_navMeshData->m_tiles.end()) {
+    return &sharedIt->second;
+  }
+  return nullptr;
+}
+
+void KX_NavMeshObject::SetTile(const TileCoord &coord, const Tile *tile)
+{
+  if (!setNavMeshTile(m_navMesh, coord, tile)) {
+    CM_Warning("navigation mesh " << m_name << ": too many tiles");
+  }
+  for (dtTiledNavMesh *query : m_queryNavMeshes) {
+    setNavMeshTile(query, coord, tile);
+  }
+}
+
+bool KX_NavMeshObject::NeedsLocalTile(const TileCoord &coord) const
+{
+  for (const Chunk &chunk : m_chunks) {
+    if (chunk.m_geometry->m_tileTris.find(coord) != chunk.m_geometry->m_tileTris.end()) {
+      return true;
+    }
+  }
+
+  const KX_NavMeshConfig &config = m_navMeshData->m_config;
+  float tmin[3], tmax[3];
+  tileBounds(config, coord, tmin, tmax);
+  for (const Blocker &blocker : m_blockers) {
+    float bmin[3], bmax[3];
+    blockerBounds(config, blocker, bmin, bmax);
+    if (boxOverlap(bmin, bmax, tmin, tmax)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void KX_NavMeshObject::InvalidateTiles(const float bmin[3], const float bmax[3])
+{
+  const KX_NavMeshConfig &config = m_navMeshData->m_config;
+  const float border = config.m_borderWorldSize;
+  const float itile = 1.0f / config.m_tileWorldSize;
+  const int minx = floorf((bmin[0] - border - config.m_orig[0]) * itile);
+  const int maxx = floorf((bmax[0] + border - config.m_orig[0]) * itile);
+  const int miny = floorf((bmin[2] - border - config.m_orig[2]) * itile);
+  const int maxy = floorf((bmax[2] + border - config.m_orig[2]) * itile);
+  for (int y = miny; y <= maxy; ++y) {
+    for (int x = minx; x <= maxx; ++x) {
+      m_dirtyTiles.insert(TileCoord(x, y));
     }
-    src += vertsPerPoly * 2;
   }
+}
+
+void KX_NavMeshObject::InvalidateBlocker(const Blocker &blocker)
+{
+  if (!m_navMeshData) {
+    return;
+  }
+
+  float bmin[3], bmax[3];
+  blockerBounds(m_navMeshData->m_config, blocker, bmin, bmax);
+  InvalidateTiles(bmin, bmax);
+}
+
+void KX_NavMeshObject::InvalidateChunk(const Chunk &chunk)
+{
+  for (const auto &pair : chunk.m_geometry->m_tileTris) {
+    m_dirtyTiles.insert(pair.first);
+  }
+}
 
-  header->nnodes = createBVTree(
-      vertsi, nverts, polys, npolys, vertsPerPoly, cs, cs, npolys * 2, navNodes);
+void KX_NavMeshObject::UpdateTiles()
+{
+  if (m_dirtyTiles.empty() || !m_navMesh) {
+    return;
+  }
 
-  if (dmeshes == nullptr) {
-    // create fake detail meshes
-    for (int i = 0; i < npolys; ++i) {
-      dtStatPolyDetail &dtl = navDMeshes[i];
-      dtl.vbase = 0;
-      dtl.nverts = 0;
-      dtl.tbase = i;
-      dtl.ntris = 1;
+  std::vector<const KX_NavMeshGeometry *> sources = {&m_navMeshData->m_geometry};
+  for (const Chunk &chunk : m_chunks) {
+    sources.push_back(chunk.m_geometry);
+  }
+
+  std::vector<TileBuildTask> tasks;
+  for (const TileCoord &coord : m_dirtyTiles) {
+    if (NeedsLocalTile(coord)) {
+      TileBuildTask task;
+      task.m_config = &m_navMeshData->m_config;
+      task.m_sources = &sources;
+      task.m_blockers = &m_blockers;
+      task.m_coord = coord;
+      tasks.push_back(task);
     }
-    // setup triangles.
-    unsigned char *tri = navDTris;
-    for (size_t i = 0; i < ndtris; i++) {
-      for (size_t j = 0; j < 3; j++)
-        tri[4 * i + j] = j;
+    else {
+      // Nothing overlaps the tile anymore, use the shared tile again.
+      const auto it = m_localTiles.find(coord);
+      if (it != m_localTiles.end()) {
+        delete[] it->second.m_data;
+        m_localTiles.erase(it);
+      }
+      SetTile(coord, GetSourceTile(coord));
     }
   }
-  else {
-    // verts
-    memcpy(navDVerts, dvertices, ndvertsuniq * 3 * sizeof(float));
-    // tris
-    unsigned char *tri = navDTris;
-    for (size_t i = 0; i < ndtris; i++) {
-      for (size_t j = 0; j < 3; j++)
-        tri[4 * i + j] = dtris[6 * i + j];
+  m_dirtyTiles.clear();
+
+  buildTiles(tasks, m_name);
+
+  for (const TileBuildTask &task : tasks) {
+    Tile &tile = m_localTiles[task.m_coord];
+    if (tile.m_data) {
+      delete[] tile.m_data;
     }
-    // detailed meshes
-    for (int i = 0; i < npolys; ++i) {
-      dtStatPolyDetail &dtl = navDMeshes[i];
-      dtl.vbase = dmeshes[i * 4 + 0];
-      dtl.nverts = dmeshes[i * 4 + 1];
-      dtl.tbase = dmeshes[i * 4 + 2];
-      dtl.ntris = dmeshes[i * 4 + 3];
+    // A failed or empty build removes the tile.
+    tile = task.m_tile;
+    SetTile(task.m_coord, &tile);
+  }
+
+  ++m_version;
+
+  // The navigation mesh walls are obstacles.
+  KX_ObstacleSimulation *obssimulation = GetScene()->GetObstacleSimulation();
+  if (obssimulation) {
+    obssimulation->AddObstaclesForNavMesh(this);
+  }
+}
+
+void KX_NavMeshObject::InitQueryNavMeshes(unsigned int count)
+{
+  UpdateTiles();
+  if (!m_navMesh || m_queryNavMeshes.size() >= count) {
+    return;
+  }
+
+  // The query navigation meshes use a copy of the tiles of the navigation mesh.
+  for (unsigned int i = m_queryNavMeshes.size(); i < count; ++i) {
+    dtTiledNavMesh *query = createNavMesh(m_navMeshData->m_config);
+    for (int ti = 0; ti < DT_MAX_TILES; ++ti) {
+      const dtTile *tile = m_navMesh->getTile(ti);
+      if (tile->header) {
+        const TileCoord coord(tile->x, tile->y);
+        setNavMeshTile(query, coord, GetSourceTile(coord));
+      }
     }
+    m_queryNavMeshes.push_back(query);
   }
+}
 
-  m_navMesh = new dtStatNavMesh;
-  m_navMesh->init(data, dataSize, true);
+dtTiledNavMesh *KX_NavMeshObject::GetQueryNavMesh(unsigned int thread) const
+{
+  return m_queryNavMeshes[thread];
+}
 
-  delete[] vertices;
+unsigned int KX_NavMeshObject::GetVersion() const
+{
+  return m_version;
+}
 
-  /* navmesh conversion is using C guarded alloc for memory allocaitons */
-  MEM_freeN(polys);
-  if (dmeshes)
-    MEM_freeN(dmeshes);
-  if (dtris)
-    MEM_freeN(dtris);
+int KX_NavMeshObject::AddBlocker(const MT_Vector3 &center, const MT_Vector3 &extents)
+{
+  // Bounds of the world box in the navigation mesh space.
+  MT_Vector3 min(MT_INFINITY, MT_INFINITY, MT_INFINITY);
+  MT_Vector3 max(-MT_INFINITY, -MT_INFINITY, -MT_INFINITY);
+  for (unsigned short i = 0; i < 8; ++i) {
+    const MT_Vector3 corner(center.x() + ((i & 1) ? extents.x() : -extents.x()),
+                            center.y() + ((i & 2) ? extents.y() : -extents.y()),
+                            center.z() + ((i & 4) ? extents.z() : -extents.z()));
+    const MT_Vector3 local = TransformToLocalCoords(corner);
+    for (unsigned short axis = 0; axis < 3; ++axis) {
+      min[axis] = std::min(min[axis], local[axis]);
+      max[axis] = std::max(max[axis], local[axis]);
+    }
+  }
 
-  if (dvertices)
-    delete[] dvertices;
+  Blocker blocker;
+  blocker.m_id = ++m_lastBlockerId;
+  ((max + min) * 0.5f).getValue(blocker.m_center);
+  ((max - min) * 0.5f).getValue(blocker.m_extents);
+  flipAxes(blocker.m_center);
+  flipAxes(blocker.m_extents);
 
-  if (vertsi)
-    delete[] vertsi;
+  m_blockers.push_back(blocker);
+  InvalidateBlocker(blocker);
+
+  return blocker.m_id;
+}
+
+bool KX_NavMeshObject::RemoveBlocker(int id)
+{
+  for (std::vector<Blocker>::iterator it = m_blockers.begin(), end = m_blockers.end(); it != end;
+       ++it) {
+    if (it->m_id == id) {
+      InvalidateBlocker(*it);
+      m_blockers.erase(it);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool KX_NavMeshObject::AddChunk(KX_NavMeshObject *chunk)
+{
+  if (chunk == this || chunk->m_chunkOwner || !m_navMeshData || !chunk->m_navMeshData) {
+    return false;
+  }
+
+  // Move the chunk triangles from its navigation mesh space to this one.
+  const KX_NavMeshGeometry &source = chunk->m_navMeshData->m_geometry;
+  KX_NavMeshGeometry *geometry = new KX_NavMeshGeometry();
+  geometry->m_verts.resize(source.m_verts.size());
+  for (unsigned int i = 0, size = source.m_verts.size(); i < size; i += 3) {
+    float pos[3];
+    copy_v3_v3(pos, &source.m_verts[i]);
+    flipAxes(pos);
+    const MT_Vector3 local = TransformToLocalCoords(
+        chunk->TransformToWorldCoords(MT_Vector3(pos)));
+    local.getValue(&geometry->m_verts[i]);
+    flipAxes(&geometry->m_verts[i]);
+  }
+  geometry->m_tris = source.m_tris;
+  geometry->ComputeBounds();
+  geometry->BinTriangles(m_navMeshData->m_config);
+
+  Chunk newChunk;
+  newChunk.m_navmesh = chunk;
+  newChunk.m_geometry = geometry;
+  m_chunks.push_back(newChunk);
+  chunk->m_chunkOwner = this;
+  InvalidateChunk(newChunk);
 
   return true;
 }
 
-dtStatNavMesh *KX_NavMeshObject::GetNavMesh()
+bool KX_NavMeshObject::RemoveChunk(KX_NavMeshObject *chunk)
 {
-  return m_navMesh;
+  for (std::vector<Chunk>::iterator it = m_chunks.begin(), end = m_chunks.end(); it != end;
+       ++it) {
+    if (it->m_navmesh == chunk) {
+      InvalidateChunk(*it);
+      delete it->m_geometry;
+      m_chunks.erase(it);
+      chunk->m_chunkOwner = nullptr;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void KX_NavMeshObject::DetachChunks()
+{
+  if (m_chunkOwner) {
+    m_chunkOwner->RemoveChunk(this);
+  }
+  for (const Chunk &chunk : m_chunks) {
+    InvalidateChunk(chunk);
+    chunk.m_navmesh->m_chunkOwner = nullptr;
+    delete chunk.m_geometry;
+  }
+  m_chunks.clear();
+}
+
+bool KX_NavMeshObject::IsPolyEdgeLinked(const dtTileHeader *header,
+                                        const dtTilePoly *poly,
+                                        int edge)
+{
+  for (int i = 0; i < poly->nlinks; ++i) {
+    if (header->links[poly->links + i].e == edge) {
+      return true;
+    }
+  }
+  return false;
 }
 
 void KX_NavMeshObject::DrawNavMesh(NavMeshRenderMode renderMode)
 {
-  if (!m_navMesh)
+  if (!GetNavMesh())
     return;
   MT_Vector4 color(0.0f, 0.0f, 0.0f, 1.0f);
 
-  switch (renderMode) {
-    case RM_POLYS:
-    case RM_WALLS:
-      for (int pi = 0; pi < m_navMesh->getPolyCount(); pi++) {
-        const dtStatPoly *poly = m_navMesh->getPoly(pi);
-
-        for (int i = 0, j = (int)poly->nv - 1; i < (int)poly->nv; j = i++) {
-          if (poly->n[j] && renderMode == RM_WALLS)
-            continue;
-          const float *vif = m_navMesh->getVertex(poly->v[i]);
-          const float *vjf = m_navMesh->getVertex(poly->v[j]);
-          MT_Vector3 vi(vif[0], vif[2], vif[1]);
-          MT_Vector3 vj(vjf[0], vjf[2], vjf[1]);
-          vi = TransformToWorldCoords(vi);
-          vj = TransformToWorldCoords(vj);
-          KX_RasterizerDrawDebugLine(vi, vj, color);
-        }
-      }
-      break;
-    case RM_TRIS:
-      for (int i = 0; i < m_navMesh->getPolyDetailCount(); ++i) {
-        const dtStatPoly *p = m_navMesh->getPoly(i);
-        const dtStatPolyDetail *pd = m_navMesh->getPolyDetail(i);
-
-        for (int j = 0; j < pd->ntris; ++j) {
-          const unsigned char *t = m_navMesh->getDetailTri(pd->tbase + j);
-          MT_Vector3 tri[3];
-          for (int k = 0; k < 3; ++k) {
-            const float *v;
-            if (t[k] < p->nv)
-              v = m_navMesh->getVertex(p->v[t[k]]);
-            else
-              v = m_navMesh->getDetailVertex(pd->vbase + (t[k] - p->nv));
-            float pos[3];
-            rcVcopy(pos, v);
-            flipAxes(pos);
-            tri[k].setValue(pos);
+  for (int ti = 0; ti < DT_MAX_TILES; ++ti) {
+    const dtTileHeader *header = m_navMesh->getTile(ti)->header;
+    if (!header) {
+      continue;
+    }
+
+    switch (renderMode) {
+      case RM_POLYS:
+      case RM_WALLS:
+        for (int pi = 0; pi < header->npolys; pi++) {
+          const dtTilePoly *poly = &header->polys[pi];
+
+          for (int i = 0, j = (int)poly->nv - 1; i < (int)poly->nv; j = i++) {
+            if (renderMode == RM_WALLS && IsPolyEdgeLinked(header, poly, j))
+              continue;
+            const float *vif = &header->verts[poly->v[i] * 3];
+            const float *vjf = &header->verts[poly->v[j] * 3];
+            MT_Vector3 vi(vif[0], vif[2], vif[1]);
+            MT_Vector3 vj(vjf[0], vjf[2], vjf[1]);
+            vi = TransformToWorldCoords(vi);
+            vj = TransformToWorldCoords(vj);
+            KX_RasterizerDrawDebugLine(vi, vj, color);
           }
+        }
+        break;
+      case RM_TRIS:
+        for (int i = 0; i < header->ndmeshes; ++i) {
+          const dtTilePoly *p = &header->polys[i];
+          const dtTilePolyDetail *pd = &header->dmeshes[i];
+
+          for (int j = 0; j < pd->ntris; ++j) {
+            const unsigned char *t = &header->dtris[(pd->tbase + j) * 4];
+            MT_Vector3 tri[3];
+            for (int k = 0; k < 3; ++k) {
+              const float *v;
+              if (t[k] < p->nv)
+                v = &header->verts[p->v[t[k]] * 3];
+              else
+                v = &header->dverts[(pd->vbase + (t[k] - p->nv)) * 3];
+              float pos[3];
+              rcVcopy(pos, v);
+              flipAxes(pos);
+              tri[k].setValue(pos);
+            }
 
-          for (int k = 0; k < 3; k++)
-            tri[k] = TransformToWorldCoords(tri[k]);
+            for (int k = 0; k < 3; k++)
+              tri[k] = TransformToWorldCoords(tri[k]);
 
-          for (int k = 0; k < 3; k++)
-            KX_RasterizerDrawDebugLine(tri[k], tri[(k + 1) % 3], color);
+            for (int k = 0; k < 3; k++)
+              KX_RasterizerDrawDebugLine(tri[k], tri[(k + 1) % 3], color);
+          }
         }
-      }
-      break;
-    default:
-      /* pass */
-      break;
+        break;
+      default:
+        /* pass */
+        break;
+    }
   }
 }
 
@@ -1090,31 +1061,19 @@ int KX_NavMeshObject::FindPath(const MT_Vector3 &from,
                                float *path,
                                int maxPathLen)
 {
-  if (!m_navMesh)
+  if (!GetNavMesh())
     return 0;
-  MT_Vector3 localfrom = TransformToLocalCoords(from);
-  MT_Vector3 localto = TransformToLocalCoords(to);
   float spos[3], epos[3];
-  localfrom.getValue(spos);
-  flipAxes(spos);
-  localto.getValue(epos);
-  flipAxes(epos);
-  dtStatPolyRef sPolyRef = m_navMesh->findNearestPoly(spos, polyPickExt);
-  dtStatPolyRef ePolyRef = m_navMesh->findNearestPoly(epos, polyPickExt);
+  dtTilePolyRef sPolyRef = FindNearestPoly(from, spos);
+  dtTilePolyRef ePolyRef = FindNearestPoly(to, epos);
 
   int pathLen = 0;
   if (sPolyRef && ePolyRef) {
-    dtStatPolyRef *polys = new dtStatPolyRef[maxPathLen];
+    dtTilePolyRef *polys = new dtTilePolyRef[maxPathLen];
     int npolys;
-    npolys = m_navMesh->findPath(sPolyRef, ePolyRef, spos, epos, polys, maxPathLen);
+    npolys = FindCorridor(m_navMesh, sPolyRef, ePolyRef, spos, epos, polys, maxPathLen);
     if (npolys) {
-      pathLen = m_navMesh->findStraightPath(spos, epos, polys, npolys, path, maxPathLen);
-      for (int i = 0; i < pathLen; i++) {
-        flipAxes(&path[i * 3]);
-        MT_Vector3 waypoint(&path[i * 3]);
-        waypoint = TransformToWorldCoords(waypoint);
-        waypoint.getValue(&path[i * 3]);
-      }
+      pathLen = FindStraightPath(spos, epos, polys, npolys, path, maxPathLen);
     }
 
     delete[] polys;
@@ -1123,9 +1082,47 @@ int KX_NavMeshObject::FindPath(const MT_Vector3 &from,
   return pathLen;
 }
 
+dtTilePolyRef KX_NavMeshObject::FindNearestPoly(const MT_Vector3 &wpos, float pos[3])
+{
+  if (!GetNavMesh())
+    return 0;
+  MT_Vector3 lpos = TransformToLocalCoords(wpos);
+  lpos.getValue(pos);
+  flipAxes(pos);
+  return m_navMesh->findNearestPoly(pos, polyPickExt);
+}
+
+int KX_NavMeshObject::FindCorridor(dtTiledNavMesh *query,
+                                   dtTilePolyRef startRef,
+                                   dtTilePolyRef endRef,
+                                   const float spos[3],
+                                   const float epos[3],
+                                   dtTilePolyRef *polys,
+                                   int maxPolys)
+{
+  return query->findPath(startRef, endRef, spos, epos, polys, maxPolys);
+}
+
+int KX_NavMeshObject::FindStraightPath(const float spos[3],
+                                       const float epos[3],
+                                       const dtTilePolyRef *polys,
+                                       int npolys,
+                                       float *path,
+                                       int maxPathLen)
+{
+  int pathLen = m_navMesh->findStraightPath(spos, epos, polys, npolys, path, maxPathLen);
+  for (int i = 0; i < pathLen; i++) {
+    flipAxes(&path[i * 3]);
+    MT_Vector3 waypoint(&path[i * 3]);
+    waypoint = TransformToWorldCoords(waypoint);
+    waypoint.getValue(&path[i * 3]);
+  }
+  return pathLen;
+}
+
 float KX_NavMeshObject::Raycast(const MT_Vector3 &from, const MT_Vector3 &to)
 {
-  if (!m_navMesh)
+  if (!GetNavMesh())
     return 0.f;
   MT_Vector3 localfrom = TransformToLocalCoords(from);
   MT_Vector3 localto = TransformToLocalCoords(to);
@@ -1134,9 +1131,9 @@ float KX_NavMeshObject::Raycast(const MT_Vector3 &from, const MT_Vector3 &to)
   flipAxes(spos);
   localto.getValue(epos);
   flipAxes(epos);
-  dtStatPolyRef sPolyRef = m_navMesh->findNearestPoly(spos, polyPickExt);
+  dtTilePolyRef sPolyRef = m_navMesh->findNearestPoly(spos, polyPickExt);
   float t = 0;
-  static dtStatPolyRef polys[MAX_PATH_LEN];
+  static dtTilePolyRef polys[MAX_PATH_LEN];
   m_navMesh->raycast(sPolyRef, spos, epos, t, polys, MAX_PATH_LEN);
   return t;
 }
@@ -1200,9 +1197,14 @@ PyAttributeDef KX_NavMeshObject::Attributes[] = {
 // KX_PYMETHODTABLE_NOARGS(KX_GameObject, getD),
 PyMethodDef KX_NavMeshObject::Methods[] = {
     KX_PYMETHODTABLE(KX_NavMeshObject, findPath),
+    KX_PYMETHODTABLE(KX_NavMeshObject, findPathAsync),
     KX_PYMETHODTABLE(KX_NavMeshObject, raycast),
     KX_PYMETHODTABLE(KX_NavMeshObject, draw),
     KX_PYMETHODTABLE(KX_NavMeshObject, rebuild),
+    KX_PYMETHODTABLE(KX_NavMeshObject, addBlocker),
+    KX_PYMETHODTABLE(KX_NavMeshObject, removeBlocker),
+    KX_PYMETHODTABLE_O(KX_NavMeshObject, addChunk),
+    KX_PYMETHODTABLE_O(KX_NavMeshObject, removeChunk),
     {nullptr, nullptr}  // Sentinel
 };
 
@@ -1229,6 +1231,31 @@ KX_PYMETHODDEF_DOC(KX_NavMeshObject,
   return pathList;
 }
 
+KX_PYMETHODDEF_DOC(KX_NavMeshObject,
+                   findPathAsync,
+                   "findPathAsync(start, goal, callback): find path from start to goal points\n"
+                   "at the end of the frame, callback is called with the path\n")
+{
+  PyObject *ob_from, *ob_to, *callback;
+  if (!PyArg_ParseTuple(args, "OOO:findPathAsync", &ob_from, &ob_to, &callback))
+    return nullptr;
+  MT_Vector3 from, to;
+  if (!PyVecTo(ob_from, from) || !PyVecTo(ob_to, to))
+    return nullptr;
+  if (!PyCallable_Check(callback)) {
+    PyErr_SetString(PyExc_TypeError,
+                    "navmesh.findPathAsync(start, goal, callback): callback must be callable");
+    return nullptr;
+  }
+
+  KX_PathQuery *query = GetScene()->GetPathQueryManager()->AddQuery(this, from, to);
+  query->SetCallback(callback);
+  /* the manager keeps its reference until the query is processed */
+  query->Release();
+
+  Py_RETURN_NONE;
+}
+
 KX_PYMETHODDEF_DOC(KX_NavMeshObject,
                    raycast,
                    "raycast(start, goal): raycast from start to goal points\n"
@@ -1263,4 +1290,82 @@ KX_PYMETHODDEF_DOC_NOARGS(KX_NavMeshObject, rebuild, "rebuild(): rebuild navigat
   Py_RETURN_NONE;
 }
 
+KX_PYMETHODDEF_DOC(KX_NavMeshObject,
+                   addBlocker,
+                   "addBlocker(center, extents): carve a box out of the navigation mesh\n"
+                   "Returns the blocker identifier\n")
+{
+  PyObject *ob_center, *ob_extents;
+  if (!PyArg_ParseTuple(args, "OO:addBlocker", &ob_center, &ob_extents))
+    return nullptr;
+  MT_Vector3 center, extents;
+  if (!PyVecTo(ob_center, center) || !PyVecTo(ob_extents, extents))
+    return nullptr;
+  return PyLong_FromLong(AddBlocker(center, extents.absolute()));
+}
+
+KX_PYMETHODDEF_DOC(KX_NavMeshObject,
+                   removeBlocker,
+                   "removeBlocker(id): remove a box carved by addBlocker\n")
+{
+  int id;
+  if (!PyArg_ParseTuple(args, "i:removeBlocker", &id))
+    return nullptr;
+  if (!RemoveBlocker(id)) {
+    PyErr_Format(PyExc_ValueError, "navmesh.removeBlocker(id): unknown blocker %d", id);
+    return nullptr;
+  }
+  Py_RETURN_NONE;
+}
+
+KX_PYMETHODDEF_DOC_O(KX_NavMeshObject,
+                     addChunk,
+                     "addChunk(navmesh): stream another navigation mesh in this one\n")
+{
+  KX_GameObject *gameobj;
+  if (!ConvertPythonToGameObject(GetScene()->GetLogicManager(),
+                                 value,
+                                 &gameobj,
+                                 false,
+                                 "navmesh.addChunk(navmesh): KX_NavMeshObject")) {
+    return nullptr;  // ConvertPythonToGameObject sets the error
+  }
+
+  KX_NavMeshObject *chunk = dynamic_cast<KX_NavMeshObject *>(gameobj);
+  if (!chunk) {
+    PyErr_SetString(PyExc_TypeError,
+                    "navmesh.addChunk(navmesh): KX_NavMeshObject is expected");
+    return nullptr;
+  }
+  if (!AddChunk(chunk)) {
+    PyErr_SetString(PyExc_ValueError,
+                    "navmesh.addChunk(navmesh): the navigation mesh is already streamed or "
+                    "can't be built");
+    return nullptr;
+  }
+  Py_RETURN_NONE;
+}
+
+KX_PYMETHODDEF_DOC_O(KX_NavMeshObject,
+                     removeChunk,
+                     "removeChunk(navmesh): remove a navigation mesh added by addChunk\n")
+{
+  KX_GameObject *gameobj;
+  if (!ConvertPythonToGameObject(GetScene()->GetLogicManager(),
+                                 value,
+                                 &gameobj,
+                                 false,
+                                 "navmesh.removeChunk(navmesh): KX_NavMeshObject")) {
+    return nullptr;  // ConvertPythonToGameObject sets the error
+  }
+
+  KX_NavMeshObject *chunk = dynamic_cast<KX_NavMeshObject *>(gameobj);
+  if (!chunk || !RemoveChunk(chunk)) {
+    PyErr_SetString(PyExc_ValueError,
+                    "navmesh.removeChunk(navmesh): the navigation mesh isn't streamed");
+    return nullptr;
+  }
+  Py_RETURN_NONE;
+}
+
 #endif  // WITH_PYTHON
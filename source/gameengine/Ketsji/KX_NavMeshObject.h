@@ -26,29 +26,91 @@
  */
 #ifndef __KX_NAVMESHOBJECT_H__
 #define __KX_NAVMESHOBJECT_H__
-#include "DetourStatNavMesh.h"
+#include "DetourTileNavMesh.h"
 #include "KX_GameObject.h"
 #include "EXP_PyObjectPlus.h"
 #include <vector>
+#include <map>
+#include <set>
 
 class RAS_MeshObject;
 class MT_Transform;
+class KX_NavMeshData;
+class KX_NavMeshGeometry;
 
+/** Navigation mesh object, the navigation mesh is built at runtime by Recast from the
+ * triangles of the object mesh and is split in Detour tiles.
+ *
+ * The tiles built from the mesh are shared by the object and its replicas. Blockers and
+ * streamed chunks only rebuild the tiles they overlap, the rebuilds are batched and run on
+ * worker threads the next time the navigation mesh is used.
+ */
 class KX_NavMeshObject : public KX_GameObject {
-  Py_Header
+  Py_Header public :
+      /// Location of a tile in the tile grid.
+      typedef std::pair<int, int> TileCoord;
+
+  /// Detour data of a tile, before it is added to a navigation mesh.
+  struct Tile {
+    unsigned char *m_data;
+    int m_dataSize;
+  };
+
+  /// Box carved out of the navigation mesh, in navigation mesh space.
+  struct Blocker {
+    int m_id;
+    float m_center[3];
+    float m_extents[3];
+  };
+
+ protected:
+  dtTiledNavMesh *m_navMesh;
+  /// Shared data the navigation mesh is built from.
+  KX_NavMeshData *m_navMeshData;
+
+  /// Navigation mesh object streamed in this navigation mesh.
+  struct Chunk {
+    KX_NavMeshObject *m_navmesh;
+    /// Triangles of the chunk in the navigation mesh space of this object.
+    KX_NavMeshGeometry *m_geometry;
+  };
+
+  /// Navigation meshes on the same tiles used by the path query worker threads.
+  std::vector<dtTiledNavMesh *> m_queryNavMeshes;
+  /// Incremented each time the polygons or their links change.
+  unsigned int m_version;
+
+  std::vector<Blocker> m_blockers;
+  int m_lastBlockerId;
 
-      protected : dtStatNavMesh *m_navMesh;
+  std::vector<Chunk> m_chunks;
+  /// Navigation mesh this object is streamed in as a chunk.
+  KX_NavMeshObject *m_chunkOwner;
 
-  bool BuildVertIndArrays(float *&vertices,
-                          int &nverts,
-                          unsigned short *&polys,
-                          int &npolys,
-                          unsigned short *&dmeshes,
-                          float *&dvertices,
-                          int &ndvertsuniq,
-                          unsigned short *&dtris,
-                          int &ndtris,
-                          int &vertsPerPoly);
+  /// Tiles rebuilt with the blockers or the chunks, they replace the shared tiles.
+  std::map<TileCoord, Tile> m_localTiles;
+  /// Tiles to rebuild the next time the navigation mesh is used.
+  std::set<TileCoord> m_dirtyTiles;
+
+  /// Create the navigation mesh from the shared tiles and invalidate the blocked tiles.
+  void InitNavMesh();
+  /// Free the query navigation meshes, they are created again on demand.
+  void ClearQueryNavMeshes();
+  /// Free the tiles rebuilt with the blockers or the chunks.
+  void ClearLocalTiles();
+  /// Return the tile used at a location, a local tile or a shared tile.
+  const Tile *GetSourceTile(const TileCoord &coord) const;
+  /// Replace a tile in the navigation mesh and the query navigation meshes.
+  void SetTile(const TileCoord &coord, const Tile *tile);
+  /// Return true if a tile must be rebuilt with the blockers or the chunks.
+  bool NeedsLocalTile(const TileCoord &coord) const;
+  /// Mark the tiles overlapping a box in navigation mesh space to be rebuilt.
+  void InvalidateTiles(const float bmin[3], const float bmax[3]);
+  void InvalidateBlocker(const Blocker &blocker);
+  void InvalidateChunk(const Chunk &chunk);
+
+  /// Read the triangles of the object mesh in navigation mesh space.
+  bool BuildGeometry(KX_NavMeshGeometry &geometry);
 
  public:
   KX_NavMeshObject(void *sgReplicationInfo, SG_Callbacks callbacks);
@@ -57,11 +119,69 @@ class KX_NavMeshObject : public KX_GameObject {
   virtual CValue *GetReplica();
   virtual void ProcessReplica();
 
+  /// Build all the tiles from the object mesh.
   bool BuildNavMesh();
-  dtStatNavMesh *GetNavMesh();
+  /// Rebuild the invalidated tiles on worker threads.
+  void UpdateTiles();
+  dtTiledNavMesh *GetNavMesh();
   int FindPath(const MT_Vector3 &from, const MT_Vector3 &to, float *path, int maxPathLen);
+
+  /** Convert a world position to the navigation mesh space and find its nearest polygon.
+   * \param pos Set to the position in navigation mesh space.
+   * \return The nearest polygon reference or 0.
+   */
+  dtTilePolyRef FindNearestPoly(const MT_Vector3 &wpos, float pos[3]);
+  /** Find the polygons to cross from a start polygon to a goal polygon.
+   * \param query The navigation mesh running the search, the main navigation mesh or
+   * a query navigation mesh when called from a worker thread.
+   */
+  int FindCorridor(dtTiledNavMesh *query,
+                   dtTilePolyRef startRef,
+                   dtTilePolyRef endRef,
+                   const float spos[3],
+                   const float epos[3],
+                   dtTilePolyRef *polys,
+                   int maxPolys);
+  /// Find the straight path along polygons and convert it to world space.
+  int FindStraightPath(const float spos[3],
+                       const float epos[3],
+                       const dtTilePolyRef *polys,
+                       int npolys,
+                       float *path,
+                       int maxPathLen);
+
+  /** Make sure a query navigation mesh exists for each thread, must be called from the
+   * main thread before running searches with GetQueryNavMesh().
+   */
+  void InitQueryNavMeshes(unsigned int count);
+  dtTiledNavMesh *GetQueryNavMesh(unsigned int thread) const;
+  unsigned int GetVersion() const;
   float Raycast(const MT_Vector3 &from, const MT_Vector3 &to);
 
+  /** Carve a box out of the navigation mesh until the blocker is removed, used for dynamic
+   * obstacles (doors, crates...). Only the tiles overlapping the box are rebuilt.
+   * \param center The center of the box in world space.
+   * \param extents The half size of the box along the world axes.
+   * \return The identifier of the blocker.
+   */
+  int AddBlocker(const MT_Vector3 &center, const MT_Vector3 &extents);
+  /// Remove a blocker, return false if the identifier is unknown.
+  bool RemoveBlocker(int id);
+
+  /** Stream the triangles of another navigation mesh object in this navigation mesh,
+   * used for the chunks of a level loaded with LibLoad. The chunk is placed with the
+   * transforms of both objects at the time it is added.
+   * \return False if the chunk is this object, has no mesh or is already streamed.
+   */
+  bool AddChunk(KX_NavMeshObject *chunk);
+  /// Remove a streamed chunk, return false if it isn't streamed in this navigation mesh.
+  bool RemoveChunk(KX_NavMeshObject *chunk);
+  /// Remove the object from the navigation mesh it is streamed in and remove its chunks.
+  void DetachChunks();
+
+  /// Return true if a polygon edge is linked to another polygon, in the same tile or not.
+  static bool IsPolyEdgeLinked(const dtTileHeader *header, const dtTilePoly *poly, int edge);
+
   enum NavMeshRenderMode { RM_WALLS, RM_POLYS, RM_TRIS, RM_MAX };
   void DrawNavMesh(NavMeshRenderMode mode);
   void DrawPath(const float *path, int pathLen, const MT_Vector4 &color);
@@ -74,9 +194,14 @@ class KX_NavMeshObject : public KX_GameObject {
   /* --------------------------------------------------------------------- */
 
   KX_PYMETHOD_DOC(KX_NavMeshObject, findPath);
+  KX_PYMETHOD_DOC(KX_NavMeshObject, findPathAsync);
   KX_PYMETHOD_DOC(KX_NavMeshObject, raycast);
   KX_PYMETHOD_DOC(KX_NavMeshObject, draw);
   KX_PYMETHOD_DOC_NOARGS(KX_NavMeshObject, rebuild);
+  KX_PYMETHOD_DOC(KX_NavMeshObject, addBlocker);
+  KX_PYMETHOD_DOC(KX_NavMeshObject, removeBlocker);
+  KX_PYMETHOD_DOC_O(KX_NavMeshObject, addChunk);
+  KX_PYMETHOD_DOC_O(KX_NavMeshObject, removeChunk);
 #endif /* WITH_PYTHON */
 };
 
@@ -228,24 +228,42 @@ void KX_ObstacleSimulation::AddObstacleForObj(KX_GameObject *gameobj)
 
 void KX_ObstacleSimulation::AddObstaclesForNavMesh(KX_NavMeshObject *navmeshobj)
 {
-  dtStatNavMesh *navmesh = navmeshobj->GetNavMesh();
+  // Getting the navigation mesh can rebuild tiles and add the walls again.
+  dtTiledNavMesh *navmesh = navmeshobj->GetNavMesh();
+
+  for (size_t i = 0; i < m_obstacles.size();) {
+    KX_Obstacle *obstacle = m_obstacles[i];
+    if (obstacle->m_gameObj == navmeshobj && obstacle->m_type == KX_OBSTACLE_NAV_MESH) {
+      m_obstacles[i] = m_obstacles.back();
+      m_obstacles.pop_back();
+      delete obstacle;
+    }
+    else
+      i++;
+  }
+
   if (navmesh) {
-    int npoly = navmesh->getPolyCount();
-    for (int pi = 0; pi < npoly; pi++) {
-      const dtStatPoly *poly = navmesh->getPoly(pi);
+    for (int ti = 0; ti < DT_MAX_TILES; ti++) {
+      const dtTileHeader *header = navmesh->getTile(ti)->header;
+      if (!header)
+        continue;
 
-      for (int i = 0, j = (int)poly->nv - 1; i < (int)poly->nv; j = i++) {
-        if (poly->n[j])
-          continue;
-        const float *vj = navmesh->getVertex(poly->v[j]);
-        const float *vi = navmesh->getVertex(poly->v[i]);
-
-        KX_Obstacle *obstacle = CreateObstacle(navmeshobj);
-        obstacle->m_type = KX_OBSTACLE_NAV_MESH;
-        obstacle->m_shape = KX_OBSTACLE_SEGMENT;
-        obstacle->m_pos = MT_Vector3(vj[0], vj[2], vj[1]);
-        obstacle->m_pos2 = MT_Vector3(vi[0], vi[2], vi[1]);
-        obstacle->m_rad = 0;
+      for (int pi = 0; pi < header->npolys; pi++) {
+        const dtTilePoly *poly = &header->polys[pi];
+
+        for (int i = 0, j = (int)poly->nv - 1; i < (int)poly->nv; j = i++) {
+          if (KX_NavMeshObject::IsPolyEdgeLinked(header, poly, j))
+            continue;
+          const float *vj = &header->verts[poly->v[j] * 3];
+          const float *vi = &header->verts[poly->v[i] * 3];
+
+          KX_Obstacle *obstacle = CreateObstacle(navmeshobj);
+          obstacle->m_type = KX_OBSTACLE_NAV_MESH;
+          obstacle->m_shape = KX_OBSTACLE_SEGMENT;
+          obstacle->m_pos = MT_Vector3(vj[0], vj[2], vj[1]);
+          obstacle->m_pos2 = MT_Vector3(vi[0], vi[2], vi[1]);
+          obstacle->m_rad = 0;
+        }
       }
     }
   }
@@ -80,6 +80,7 @@ class KX_ObstacleSimulation {
 
   void AddObstacleForObj(KX_GameObject *gameobj);
   void DestroyObstacleForObj(KX_GameObject *gameobj);
+  /// Add the walls of a navigation mesh as obstacles, replacing its previous walls.
   void AddObstaclesForNavMesh(KX_NavMeshObject *navmesh);
   KX_Obstacle *GetObstacle(KX_GameObject *gameobj);
   void UpdateObstacles();
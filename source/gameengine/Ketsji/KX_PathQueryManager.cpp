@@ -0,0 +1,312 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file gameengine/Ketsji/KX_PathQueryManager.cpp
+ *  \ingroup ketsji
+ */
+
+#include "KX_PathQueryManager.h"
+#include "KX_NavMeshObject.h"
+
+#ifdef WITH_PYTHON
+#  include "KX_PyMath.h"
+#endif
+
+#include "CM_Profiler.h"
+
+#include "BLI_math_vector.h"
+#include "BLI_task.h"
+
+#include <algorithm>
+
+/// Maximum number of polygons and points of a path.
+static const int MAX_PATH_LEN = 256;
+/// Number of frames an unused corridor stays in the cache.
+static const unsigned int CORRIDOR_LIFETIME = 30;
+
+KX_PathQuery::KX_PathQuery(KX_NavMeshObject *navmesh, const MT_Vector3 &from, const MT_Vector3 &to)
+    : m_navmesh(navmesh),
+      m_from(from),
+      m_to(to),
+      m_status(STATUS_PENDING)
+#ifdef WITH_PYTHON
+      ,
+      m_callback(nullptr)
+#endif
+{
+}
+
+KX_PathQuery::~KX_PathQuery()
+{
+#ifdef WITH_PYTHON
+  Py_XDECREF(m_callback);
+#endif
+}
+
+KX_PathQuery::Status KX_PathQuery::GetStatus() const
+{
+  return m_status;
+}
+
+unsigned int KX_PathQuery::GetPathLength() const
+{
+  return m_path.size() / 3;
+}
+
+const float *KX_PathQuery::GetPath() const
+{
+  return m_path.data();
+}
+
+bool KX_PathQuery::HasCallback() const
+{
+#ifdef WITH_PYTHON
+  return m_callback != nullptr;
+#else
+  return false;
+#endif
+}
+
+#ifdef WITH_PYTHON
+void KX_PathQuery::SetCallback(PyObject *callback)
+{
+  Py_XINCREF(callback);
+  Py_XDECREF(m_callback);
+  m_callback = callback;
+}
+#endif
+
+bool KX_PathQueryManager::CorridorKey::operator==(const CorridorKey &other) const
+{
+  return m_navmesh == other.m_navmesh && m_startRef == other.m_startRef &&
+         m_endRef == other.m_endRef;
+}
+
+size_t KX_PathQueryManager::CorridorKeyHash::operator()(const CorridorKey &key) const
+{
+  return std::hash<KX_NavMeshObject *>()(key.m_navmesh) ^
+         (((size_t)key.m_startRef << 16) | key.m_endRef) * 2654435761u;
+}
+
+KX_PathQueryManager::Corridor::Corridor() : m_version(0), m_lastFrame(0), m_valid(false)
+{
+}
+
+KX_PathQueryManager::KX_PathQueryManager() : m_frame(0)
+{
+}
+
+KX_PathQueryManager::~KX_PathQueryManager()
+{
+  for (KX_PathQuery *query : m_queries) {
+    query->Release();
+  }
+}
+
+KX_PathQuery *KX_PathQueryManager::AddQuery(KX_NavMeshObject *navmesh,
+                                            const MT_Vector3 &from,
+                                            const MT_Vector3 &to)
+{
+  KX_PathQuery *query = new KX_PathQuery(navmesh, from, to);
+  m_queries.push_back(query);
+  return query->AddRef();
+}
+
+void KX_PathQueryManager::RemoveNavMesh(KX_NavMeshObject *navmesh)
+{
+  for (std::vector<KX_PathQuery *>::iterator it = m_queries.begin(); it != m_queries.end();) {
+    KX_PathQuery *query = *it;
+    if (query->m_navmesh == navmesh) {
+      query->m_navmesh = nullptr;
+      query->m_status = KX_PathQuery::STATUS_CANCELED;
+      query->Release();
+      it = m_queries.erase(it);
+    }
+    else {
+      ++it;
+    }
+  }
+
+  for (auto it = m_corridors.begin(); it != m_corridors.end();) {
+    if (it->first.m_navmesh == navmesh) {
+      it = m_corridors.erase(it);
+    }
+    else {
+      ++it;
+    }
+  }
+}
+
+/// Corridor search run on a worker thread.
+struct CorridorTask {
+  KX_NavMeshObject *m_navmesh;
+  dtTilePolyRef m_startRef;
+  dtTilePolyRef m_endRef;
+  float m_spos[3];
+  float m_epos[3];
+  std::vector<dtTilePolyRef> *m_polys;
+};
+
+static void corridor_task_func(void *__restrict userdata,
+                               const int iter,
+                               const TaskParallelTLS *__restrict tls)
+{
+  CorridorTask &task = ((CorridorTask *)userdata)[iter];
+  dtTiledNavMesh *query = task.m_navmesh->GetQueryNavMesh(tls->thread_id);
+
+  std::vector<dtTilePolyRef> &polys = *task.m_polys;
+  polys.resize(MAX_PATH_LEN);
+  const int npolys = task.m_navmesh->FindCorridor(
+      query, task.m_startRef, task.m_endRef, task.m_spos, task.m_epos, polys.data(), MAX_PATH_LEN);
+  polys.resize(npolys);
+}
+
+void KX_PathQueryManager::Update()
+{
+  ++m_frame;
+
+  if (m_queries.empty()) {
+    return;
+  }
+
+  CM_PROFILE_SCOPE("Path Queries");
+
+  /// Query with its positions in navigation mesh space and its corridor.
+  struct QueryData {
+    KX_PathQuery *m_query;
+    float m_spos[3];
+    float m_epos[3];
+    Corridor *m_corridor;
+  };
+
+  std::vector<QueryData> queries;
+  queries.reserve(m_queries.size());
+  std::vector<CorridorTask> tasks;
+  std::vector<KX_NavMeshObject *> navmeshes;
+
+  for (KX_PathQuery *query : m_queries) {
+    // The requester doesn't need the query anymore.
+    if (query->GetRefCount() == 1 && !query->HasCallback()) {
+      query->Release();
+      continue;
+    }
+
+    KX_NavMeshObject *navmesh = query->m_navmesh;
+    QueryData data;
+    data.m_query = query;
+    data.m_corridor = nullptr;
+
+    const dtTilePolyRef startRef = navmesh->FindNearestPoly(query->m_from, data.m_spos);
+    const dtTilePolyRef endRef = navmesh->FindNearestPoly(query->m_to, data.m_epos);
+    if (startRef && endRef) {
+      const CorridorKey key = {navmesh, startRef, endRef};
+      Corridor &corridor = m_corridors[key];
+      if (!corridor.m_valid || corridor.m_version != navmesh->GetVersion()) {
+        corridor.m_valid = true;
+        corridor.m_version = navmesh->GetVersion();
+
+        CorridorTask task;
+        task.m_navmesh = navmesh;
+        task.m_startRef = startRef;
+        task.m_endRef = endRef;
+        copy_v3_v3(task.m_spos, data.m_spos);
+        copy_v3_v3(task.m_epos, data.m_epos);
+        task.m_polys = &corridor.m_polys;
+        tasks.push_back(task);
+
+        if (std::find(navmeshes.begin(), navmeshes.end(), navmesh) == navmeshes.end()) {
+          navmeshes.push_back(navmesh);
+        }
+      }
+      corridor.m_lastFrame = m_frame;
+      data.m_corridor = &corridor;
+    }
+
+    queries.push_back(data);
+  }
+  m_queries.clear();
+
+  if (!tasks.empty()) {
+    const unsigned int numThreads = BLI_task_scheduler_num_threads(BLI_task_scheduler_get());
+    for (KX_NavMeshObject *navmesh : navmeshes) {
+      navmesh->InitQueryNavMeshes(numThreads);
+    }
+
+    TaskParallelSettings settings;
+    BLI_parallel_range_settings_defaults(&settings);
+    settings.use_threading = (tasks.size() > 1);
+    settings.min_iter_per_thread = 1;
+    BLI_task_parallel_range(0, tasks.size(), tasks.data(), corridor_task_func, &settings);
+  }
+
+  float path[MAX_PATH_LEN * 3];
+  for (QueryData &data : queries) {
+    KX_PathQuery *query = data.m_query;
+    const Corridor *corridor = data.m_corridor;
+    if (corridor && !corridor->m_polys.empty()) {
+      const int pathLen = query->m_navmesh->FindStraightPath(data.m_spos,
+                                                             data.m_epos,
+                                                             corridor->m_polys.data(),
+                                                             corridor->m_polys.size(),
+                                                             path,
+                                                             MAX_PATH_LEN);
+      query->m_path.assign(path, path + pathLen * 3);
+    }
+    query->m_status = KX_PathQuery::STATUS_DONE;
+  }
+
+  // The callbacks are only run once all the paths are computed, a callback can rebuild or
+  // remove a navigation mesh which would invalidate the polygons of the following queries.
+  for (QueryData &data : queries) {
+    KX_PathQuery *query = data.m_query;
+
+#ifdef WITH_PYTHON
+    if (query->m_callback) {
+      const unsigned int pathLen = query->GetPathLength();
+      PyObject *pathList = PyList_New(pathLen);
+      for (unsigned int i = 0; i < pathLen; ++i) {
+        PyList_SET_ITEM(pathList, i, PyObjectFrom(MT_Vector3(&query->m_path[i * 3])));
+      }
+
+      PyObject *ret = PyObject_CallFunctionObjArgs(query->m_callback, pathList, nullptr);
+      if (ret) {
+        Py_DECREF(ret);
+      }
+      else {
+        PyErr_Print();
+        PyErr_Clear();
+      }
+      Py_DECREF(pathList);
+    }
+#endif
+
+    query->Release();
+  }
+
+  // Drop the corridors unused for a while.
+  for (auto it = m_corridors.begin(); it != m_corridors.end();) {
+    if (m_frame - it->second.m_lastFrame > CORRIDOR_LIFETIME) {
+      it = m_corridors.erase(it);
+    }
+    else {
+      ++it;
+    }
+  }
+}
@@ -0,0 +1,135 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file KX_PathQueryManager.h
+ *  \ingroup ketsji
+ */
+
+#ifndef __KX_PATHQUERYMANAGER_H__
+#define __KX_PATHQUERYMANAGER_H__
+
+#include "CM_RefCount.h"
+#include "DetourTileNavMesh.h"
+#include "MT_Vector3.h"
+
+#ifdef WITH_PYTHON
+#  include "EXP_Python.h"
+#endif
+
+#include <vector>
+#include <unordered_map>
+
+class KX_NavMeshObject;
+
+/// Path request between two world positions, referenced by the manager and the requester.
+class KX_PathQuery : public CM_RefCount<KX_PathQuery> {
+  friend class KX_PathQueryManager;
+
+ public:
+  enum Status {
+    STATUS_PENDING,
+    STATUS_DONE,
+    /// The navigation mesh was removed before the query was processed.
+    STATUS_CANCELED
+  };
+
+ private:
+  KX_NavMeshObject *m_navmesh;
+  MT_Vector3 m_from;
+  MT_Vector3 m_to;
+  Status m_status;
+  /// Points of the path in world space, 3 floats per point.
+  std::vector<float> m_path;
+
+#ifdef WITH_PYTHON
+  /// Function called with the path when the query is done.
+  PyObject *m_callback;
+#endif
+
+ public:
+  KX_PathQuery(KX_NavMeshObject *navmesh, const MT_Vector3 &from, const MT_Vector3 &to);
+  virtual ~KX_PathQuery();
+
+  Status GetStatus() const;
+  /// Return the number of points of the path, valid once the query is done.
+  unsigned int GetPathLength() const;
+  const float *GetPath() const;
+  /// Return true if a function is called when the query is done.
+  bool HasCallback() const;
+
+#ifdef WITH_PYTHON
+  void SetCallback(PyObject *callback);
+#endif
+};
+
+/** Per scene queue of path queries.
+ *
+ * Queries added during the logic frame are processed together at the end of the frame,
+ * the polygon searches are run in parallel with a query navigation mesh per thread.
+ * The polygons found between a start and a goal polygon are cached for a few frames and
+ * reused by other queries between the same polygons, until the navigation mesh changes.
+ */
+class KX_PathQueryManager {
+ private:
+  struct CorridorKey {
+    KX_NavMeshObject *m_navmesh;
+    dtTilePolyRef m_startRef;
+    dtTilePolyRef m_endRef;
+
+    bool operator==(const CorridorKey &other) const;
+  };
+
+  struct CorridorKeyHash {
+    size_t operator()(const CorridorKey &key) const;
+  };
+
+  /// Polygons between a start and a goal polygon.
+  struct Corridor {
+    /// Version of the navigation mesh used for the search.
+    unsigned int m_version;
+    /// Last frame the corridor was used.
+    unsigned int m_lastFrame;
+    bool m_valid;
+    std::vector<dtTilePolyRef> m_polys;
+
+    Corridor();
+  };
+
+  std::vector<KX_PathQuery *> m_queries;
+  std::unordered_map<CorridorKey, Corridor, CorridorKeyHash> m_corridors;
+  unsigned int m_frame;
+
+ public:
+  KX_PathQueryManager();
+  ~KX_PathQueryManager();
+
+  /** Add a query processed at the end of the frame.
+   * \return The query with a reference for the caller, releasing it before the end of
+   * the frame drops the query unless it has a callback.
+   */
+  KX_PathQuery *AddQuery(KX_NavMeshObject *navmesh, const MT_Vector3 &from, const MT_Vector3 &to);
+  /// Cancel the queries and drop the cached polygons of a removed navigation mesh.
+  void RemoveNavMesh(KX_NavMeshObject *navmesh);
+
+  /// Process all the pending queries.
+  void Update();
+};
+
+#endif  // __KX_PATHQUERYMANAGER_H__
@@ -131,6 +131,12 @@ PyDoc_STRVAR(gPyRemoveConstraint__doc__,
 PyDoc_STRVAR(gPyGetAppliedImpulse__doc__,
              "getAppliedImpulse(int constraintId)\n"
              "");
+PyDoc_STRVAR(gPySaveState__doc__,
+             "saveState()\n"
+             "Return the state of the physics simulation as bytes");
+PyDoc_STRVAR(gPyRestoreState__doc__,
+             "restoreState(bytes state)\n"
+             "Restore a state returned by saveState");
 
 static PyObject *gPySetGravity(PyObject *self, PyObject *args, PyObject *kwds)
 {
@@ -570,6 +576,36 @@ static PyObject *gPyExportBulletFile(PyObject *, PyObject *args)
   Py_RETURN_NONE;
 }
 
+static PyObject *gPySaveState(PyObject *, PyObject *)
+{
+  std::vector<char> buffer;
+  if (PHY_GetActiveEnvironment()) {
+    PHY_GetActiveEnvironment()->SaveState(buffer);
+  }
+
+  return PyBytes_FromStringAndSize(buffer.data(), buffer.size());
+}
+
+static PyObject *gPyRestoreState(PyObject *, PyObject *args)
+{
+  Py_buffer state;
+  if (!PyArg_ParseTuple(args, "y*:restoreState", &state)) {
+    return nullptr;
+  }
+
+  const bool valid = PHY_GetActiveEnvironment() &&
+                     PHY_GetActiveEnvironment()->RestoreState((const char *)state.buf, state.len);
+  PyBuffer_Release(&state);
+
+  if (!valid) {
+    PyErr_SetString(PyExc_ValueError,
+                    "restoreState(state): bge.constraints, invalid physics state");
+    return nullptr;
+  }
+
+  Py_RETURN_NONE;
+}
+
 static struct PyMethodDef physicsconstraints_methods[] = {
     {"setGravity", (PyCFunction)gPySetGravity, METH_VARARGS, (const char *)gPySetGravity__doc__},
     {"setDebugMode",
@@ -660,6 +696,12 @@ static struct PyMethodDef physicsconstraints_methods[] = {
 
     {"exportBulletFile", (PyCFunction)gPyExportBulletFile, METH_VARARGS, "export a .bullet file"},
 
+    {"saveState", (PyCFunction)gPySaveState, METH_NOARGS, (const char *)gPySaveState__doc__},
+    {"restoreState",
+     (PyCFunction)gPyRestoreState,
+     METH_VARARGS,
+     (const char *)gPyRestoreState__doc__},
+
     // sentinel
     {nullptr, (PyCFunction) nullptr, 0, nullptr}};
 
@@ -46,6 +46,8 @@
 #  include "EXP_Python.h"
 #  include "KX_PyMath.h"
 
+#  include <cstring>
+
 bool PyOrientationTo(PyObject *pyval, MT_Matrix3x3 &rot, const char *error_prefix)
 {
   int size = PySequence_Size(pyval);
@@ -209,4 +211,72 @@ PyObject *PyColorFromVector(const MT_Vector3 &vec)
 #  endif
 }
 
+PyObject *PyMemoryViewFromByteArray(PyObject *bytes,
+                                    const char *format,
+                                    const unsigned int *shape,
+                                    unsigned int ndim)
+{
+  PyObject *view = PyMemoryView_FromObject(bytes);
+  Py_DECREF(bytes);
+  if (!view) {
+    return nullptr;
+  }
+
+  bool empty = false;
+  for (unsigned int i = 0; i < ndim; ++i) {
+    empty |= (shape[i] == 0);
+  }
+
+  PyObject *result;
+  if (ndim > 1 && !empty) {
+    PyObject *pyshape = PyTuple_New(ndim);
+    if (!pyshape) {
+      Py_DECREF(view);
+      return nullptr;
+    }
+    for (unsigned int i = 0; i < ndim; ++i) {
+      PyObject *item = PyLong_FromUnsignedLong(shape[i]);
+      if (!item) {
+        Py_DECREF(pyshape);
+        Py_DECREF(view);
+        return nullptr;
+      }
+      PyTuple_SET_ITEM(pyshape, i, item);
+    }
+    result = PyObject_CallMethod(view, "cast", "sO", format, pyshape);
+    Py_DECREF(pyshape);
+  }
+  else {
+    result = PyObject_CallMethod(view, "cast", "s", format);
+  }
+  Py_DECREF(view);
+
+  return result;
+}
+
+bool PyFloatBufferTo(PyObject *pyval, Py_buffer &buffer, const char *error_prefix)
+{
+  if (PyObject_GetBuffer(pyval, &buffer, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) == -1) {
+    return false;
+  }
+
+  const char *format = buffer.format ? buffer.format : "B";
+  // Accept native float32 only, or explicitly little endian on little endian hosts.
+  const bool native = strcmp(format, "f") == 0 || strcmp(format, "@f") == 0 ||
+                      strcmp(format, "=f") == 0;
+#ifdef __BIG_ENDIAN__
+  const bool little_endian = false;
+#else
+  const bool little_endian = strcmp(format, "<f") == 0;
+#endif
+  if (buffer.itemsize != sizeof(float) || !(native || little_endian)) {
+    PyErr_Format(
+        PyExc_TypeError, "%s: expected a float32 buffer, got format \"%s\"", error_prefix, format);
+    PyBuffer_Release(&buffer);
+    return false;
+  }
+
+  return true;
+}
+
 #endif  // WITH_PYTHON
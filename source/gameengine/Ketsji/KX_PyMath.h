@@ -296,6 +296,21 @@ PyObject *PyObjectFrom(const MT_Vector4 &pos);
  */
 PyObject *PyColorFromVector(const MT_Vector3 &vec);
 
+/**
+ * Wraps a bytearray into a memoryview of the given format and shape, the bytearray is stolen.
+ * Python refuses to cast to a shape containing zeros, an empty view is kept flat.
+ */
+PyObject *PyMemoryViewFromByteArray(PyObject *bytes,
+                                    const char *format,
+                                    const unsigned int *shape,
+                                    unsigned int ndim);
+
+/**
+ * Gets a contiguous float32 buffer (e.g a numpy array or a float memoryview),
+ * the buffer must be released with PyBuffer_Release.
+ */
+bool PyFloatBufferTo(PyObject *pyval, Py_buffer &buffer, const char *error_prefix);
+
 #endif  // WITH_PYTHON
 
 #endif  // __KX_PYMATH_H__
@@ -26,13 +26,14 @@
 #  include "KX_GameObject.h"
 
 #  include "CM_Message.h"
+#  include "CM_Profiler.h"
 
 #  include "DNA_python_component_types.h"
 
 #  include "BKE_python_component.h"
 
 KX_PythonComponent::KX_PythonComponent(const std::string &name)
-    : m_pc(nullptr), m_gameobj(nullptr), m_name(name), m_init(false)
+    : m_pc(nullptr), m_gameobj(nullptr), m_name(name), m_init(false), m_profileId(-1)
 {
 }
 
@@ -76,6 +77,7 @@ KX_GameObject *KX_PythonComponent::GetGameObject() const
 void KX_PythonComponent::SetGameObject(KX_GameObject *gameobj)
 {
   m_gameobj = gameobj;
+  m_profileId = -1;
 }
 
 void KX_PythonComponent::SetBlenderPythonComponent(PythonComponent *pc)
@@ -97,8 +99,19 @@ void KX_PythonComponent::Start()
   Py_XDECREF(ret);
 }
 
+unsigned int KX_PythonComponent::GetProfileId()
+{
+  if (m_profileId == -1) {
+    m_profileId = CM_Profiler::RegisterName(m_gameobj->GetName() + "." + m_name);
+  }
+  return m_profileId;
+}
+
 void KX_PythonComponent::Update()
 {
+  // Register the zone name only when profiling.
+  CM_Profiler::Scope zone(CM_Profiler::IsEnabled() ? GetProfileId() : CM_Profiler::NoZone);
+
   if (!m_init) {
     Start();
     m_init = true;
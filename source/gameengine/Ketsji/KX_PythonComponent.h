@@ -37,6 +37,8 @@ class KX_PythonComponent : public CValue {
   KX_GameObject *m_gameobj;
   std::string m_name;
   bool m_init;
+  /// Profiler zone of the component, -1 until first used.
+  int m_profileId;
 
  public:
   KX_PythonComponent(const std::string &name);
@@ -56,6 +58,9 @@ class KX_PythonComponent : public CValue {
   void Start();
   void Update();
 
+  /// Return the profiler zone of the component, registered the first time.
+  unsigned int GetProfileId();
+
   static PyObject *py_component_new(PyTypeObject *type, PyObject *args, PyObject *kwds);
 
   // Attributes
@@ -125,6 +125,7 @@ extern "C" {
 #include "KX_PythonInitTypes.h"
 
 #include "CM_Message.h"
+#include "CM_Profiler.h"
 
 /* we only need this to get a list of libraries from the main struct */
 #include "DNA_ID.h"
@@ -302,6 +303,73 @@ static PyObject *gPyGetProfileInfo(PyObject *)
   return KX_GetActiveEngine()->GetPyProfileDict();
 }
 
+PyDoc_STRVAR(gPySetProfiling_doc,
+             "setProfiling(enable)\n"
+             "enables or disables the zone profiler");
+static PyObject *gPySetProfiling(PyObject *, PyObject *args)
+{
+  int enable;
+  if (!PyArg_ParseTuple(args, "i:setProfiling", &enable)) {
+    return nullptr;
+  }
+
+  CM_Profiler::SetEnabled(enable);
+  Py_RETURN_NONE;
+}
+
+PyDoc_STRVAR(gPyIsProfiling_doc,
+             "isProfiling()\n"
+             "returns True if the zone profiler is enabled");
+static PyObject *gPyIsProfiling(PyObject *)
+{
+  return PyBool_FromLong(CM_Profiler::IsEnabled());
+}
+
+PyDoc_STRVAR(gPyGetProfileZones_doc,
+             "getProfileZones()\n"
+             "returns a dictionary of the zone profiler timings, the values are tuples of the\n"
+             "last frame time in ms, the average time in ms and the last frame number of calls");
+static PyObject *gPyGetProfileZones(PyObject *)
+{
+  PyObject *dict = PyDict_New();
+
+  const std::vector<CM_Profiler::ZoneStats> &stats = CM_Profiler::GetStats();
+  for (unsigned int i = 0, size = stats.size(); i < size; ++i) {
+    const CM_Profiler::ZoneStats &zone = stats[i];
+    PyObject *val = PyTuple_New(3);
+    PyTuple_SET_ITEM(val, 0, PyFloat_FromDouble(zone.m_time * 1000.0));
+    PyTuple_SET_ITEM(val, 1, PyFloat_FromDouble(zone.m_average * 1000.0));
+    PyTuple_SET_ITEM(val, 2, PyLong_FromLong(zone.m_calls));
+
+    PyDict_SetItemString(dict, CM_Profiler::GetName(i).c_str(), val);
+    Py_DECREF(val);
+  }
+
+  return dict;
+}
+
+PyDoc_STRVAR(gPySaveProfileTrace_doc,
+             "saveProfileTrace(filepath)\n"
+             "writes the last recorded profiler zones to a Chrome trace file");
+static PyObject *gPySaveProfileTrace(PyObject *, PyObject *args)
+{
+  char *filepath;
+  if (!PyArg_ParseTuple(args, "s:saveProfileTrace", &filepath)) {
+    return nullptr;
+  }
+
+  char expanded[FILE_MAX];
+  BLI_strncpy(expanded, filepath, FILE_MAX);
+  BLI_path_abs(expanded, KX_GetMainPath().c_str());
+
+  if (!CM_Profiler::WriteChromeTrace(expanded)) {
+    PyErr_Format(PyExc_OSError, "saveProfileTrace(filepath): failed to write \"%s\"", expanded);
+    return nullptr;
+  }
+
+  Py_RETURN_NONE;
+}
+
 PyDoc_STRVAR(gPySendMessage_doc,
              "sendMessage(subject, [body, to, from])\n"
              "sends a message in same manner as a message actuator"
@@ -938,6 +1006,13 @@ static struct PyMethodDef game_methods[] = {
      METH_NOARGS,
      (const char *)"Render next frame (if Python has control)"},
     {"getProfileInfo", (PyCFunction)gPyGetProfileInfo, METH_NOARGS, gPyGetProfileInfo_doc},
+    {"setProfiling", (PyCFunction)gPySetProfiling, METH_VARARGS, gPySetProfiling_doc},
+    {"isProfiling", (PyCFunction)gPyIsProfiling, METH_NOARGS, gPyIsProfiling_doc},
+    {"getProfileZones", (PyCFunction)gPyGetProfileZones, METH_NOARGS, gPyGetProfileZones_doc},
+    {"saveProfileTrace",
+     (PyCFunction)gPySaveProfileTrace,
+     METH_VARARGS,
+     gPySaveProfileTrace_doc},
     /* library functions */
     {"LibLoad", (PyCFunction)gLibLoad, METH_VARARGS | METH_KEYWORDS, (const char *)""},
     {"LibNew", (PyCFunction)gLibNew, METH_VARARGS, (const char *)""},
@@ -1212,6 +1287,12 @@ static PyObject *gPySetAnisotropicFiltering(PyObject *, PyObject *args)
     return nullptr;
   }
 
+  if (!KX_GetActiveEngine()->GetRasterizer()) {
+    PyErr_SetString(PyExc_RuntimeError,
+                    "Rasterizer.setAnisotropicFiltering(level), Rasterizer not available");
+    return nullptr;
+  }
+
   KX_GetActiveEngine()->GetRasterizer()->SetAnisotropicFiltering(level);
 
   Py_RETURN_NONE;
@@ -1219,6 +1300,12 @@ static PyObject *gPySetAnisotropicFiltering(PyObject *, PyObject *args)
 
 static PyObject *gPyGetAnisotropicFiltering(PyObject *, PyObject *args)
 {
+  if (!KX_GetActiveEngine()->GetRasterizer()) {
+    PyErr_SetString(PyExc_RuntimeError,
+                    "Rasterizer.getAnisotropicFiltering(), Rasterizer not available");
+    return nullptr;
+  }
+
   return PyLong_FromLong(KX_GetActiveEngine()->GetRasterizer()->GetAnisotropicFiltering());
 }
 
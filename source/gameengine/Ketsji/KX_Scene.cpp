@@ -69,6 +69,7 @@
 #include "GPU_framebuffer.h"
 
 #include "EXP_FloatValue.h"
+#include "EXP_PropertyLayout.h"
 #include "SCA_IController.h"
 #include "SCA_IActuator.h"
 #include "SG_Node.h"
@@ -88,6 +89,8 @@
 #include "KX_BlenderConverter.h"
 #include "KX_MotionState.h"
 #include "KX_ObstacleSimulation.h"
+#include "KX_PathQueryManager.h"
+#include "KX_NavMeshObject.h"
 
 #include "KX_BlenderCanvas.h"
 
@@ -101,6 +104,7 @@
 #include "BLI_task.h"
 
 #include "CM_Message.h"
+#include "CM_Profiler.h"
 
 /**************************EEVEE INTEGRATION*****************************/
 #include "MEM_guardedalloc.h"
@@ -182,6 +186,7 @@ KX_Scene::KX_Scene(SCA_IInputDevice *inputDevice,
       m_mousemgr(nullptr),
       m_physicsEnvironment(0),
       m_sceneName(sceneName),
+      m_profileId(-1),
       m_active_camera(nullptr),
       m_overrideCullingCamera(nullptr),
       m_ueberExecutionPriority(0),
@@ -242,6 +247,8 @@ KX_Scene::KX_Scene(SCA_IInputDevice *inputDevice,
       m_obstacleSimulation = nullptr;
   }
 
+  m_pathQueryManager = new KX_PathQueryManager();
+
   m_animationPool = BLI_task_pool_create(KX_GetActiveEngine()->GetTaskScheduler(),
                                          &m_animationPoolData);
 
@@ -290,7 +297,10 @@ KX_Scene::KX_Scene(SCA_IInputDevice *inputDevice,
      * depsgraph code too later */
     scene->flag |= SCE_INTERACTIVE;
 
-    RenderAfterCameraSetup(nullptr, false);
+    // Without rasterizer (headless player) nothing is drawn and there's no OpenGL context.
+    if (KX_GetActiveEngine()->GetRasterizer()) {
+      RenderAfterCameraSetup(nullptr, false);
+    }
   }
   else {
     Depsgraph *depsgraph = BKE_scene_get_depsgraph(
@@ -334,7 +344,9 @@ KX_Scene::~KX_Scene()
       v3d->shading.flag = m_shadingFlagBackup;
     }
     /* This will free m_gpuViewport and m_gpuOffScreen */
-    DRW_game_render_loop_end();
+    if (KX_GetActiveEngine()->GetRasterizer()) {
+      DRW_game_render_loop_end();
+    }
   }
 
   for (Object *hiddenOb : m_hiddenObjectsDuringRuntime) {
@@ -369,6 +381,8 @@ KX_Scene::~KX_Scene()
   if (m_obstacleSimulation)
     delete m_obstacleSimulation;
 
+  delete m_pathQueryManager;
+
   if (m_animationPool) {
     BLI_task_pool_free(m_animationPool);
   }
@@ -843,6 +857,16 @@ std::string KX_Scene::GetName()
 void KX_Scene::SetName(const std::string &name)
 {
   m_sceneName = name;
+  m_profileId = -1;
+  NameChanged();
+}
+
+unsigned int KX_Scene::GetProfileId()
+{
+  if (m_profileId == -1) {
+    m_profileId = CM_Profiler::RegisterName("Scene " + m_sceneName);
+  }
+  return m_profileId;
 }
 
 RAS_BucketManager *KX_Scene::GetBucketManager() const
@@ -978,7 +1002,8 @@ KX_GameObject *KX_Scene::AddNodeReplicaObject(SG_Node *node, KX_GameObject *game
   for (int i = 0; i < numprops; i++) {
     CValue *prop = newobj->GetProperty(i);
 
-    if (prop->GetProperty("timer"))
+    // Slots of removed properties are empty.
+    if (prop && prop->GetProperty("timer"))
       this->m_timemgr->AddTimeProperty(prop);
   }
 
@@ -1494,7 +1519,7 @@ bool KX_Scene::NewRemoveObject(KX_GameObject *gameobj)
 
   for (int i = 0; i < numprops; i++) {
     CValue *propval = gameobj->GetProperty(i);
-    if (propval->GetProperty("timer")) {
+    if (propval && propval->GetProperty("timer")) {
       m_timemgr->RemoveTimeProperty(propval);
     }
   }
@@ -1516,6 +1541,13 @@ bool KX_Scene::NewRemoveObject(KX_GameObject *gameobj)
     m_obstacleSimulation->DestroyObstacleForObj(gameobj);
   }
 
+  KX_NavMeshObject *navmesh = dynamic_cast<KX_NavMeshObject *>(gameobj);
+  if (navmesh) {
+    m_pathQueryManager->RemoveNavMesh(navmesh);
+    // A removed chunk, for example freed by LibFree, leaves the navigation mesh it is in.
+    navmesh->DetachChunks();
+  }
+
   gameobj->RemoveMeshes();
 
   bool ret = true;
@@ -1704,8 +1736,13 @@ void KX_Scene::RenderDebugProperties(RAS_DebugDraw &debugDraw,
 void KX_Scene::LogicBeginFrame(double curtime, double framestep)
 {
   // have a look at temp objects ...
+  static const CPropertyKey timebombKey("::timebomb");
   for (KX_GameObject *gameobj : m_tempObjectList) {
-    CFloatValue *propval = (CFloatValue *)gameobj->GetProperty("::timebomb");
+    /* Temporary objects of a same original share the property layout, which caches
+     * the slot, the name is then resolved only once per original. */
+    CPropertyLayout *layout = gameobj->GetPropertyLayout();
+    CFloatValue *propval = static_cast<CFloatValue *>(
+        gameobj->GetProperty(layout ? layout->GetSlot(timebombKey) : -1));
 
     if (propval) {
       const float timeleft = propval->GetNumber() - framestep;
@@ -1814,9 +1851,13 @@ void KX_Scene::LogicUpdateFrame(double curtime)
     objects.push_back(gameobj);
   }
 
-  for (std::vector<KX_GameObject *>::iterator it = objects.begin(), end = objects.end(); it != end;
-       ++it) {
-    (*it)->UpdateComponents();
+  {
+    CM_PROFILE_SCOPE("Components");
+    for (std::vector<KX_GameObject *>::iterator it = objects.begin(), end = objects.end();
+         it != end;
+         ++it) {
+      (*it)->UpdateComponents();
+    }
   }
 
   m_logicmgr->UpdateFrame(curtime);
@@ -1836,6 +1877,9 @@ void KX_Scene::LogicEndFrame()
     RemoveObject(m_euthanasyobjects.front());
   }
 
+  // process the path queries of the frame, the results are used at the next frame
+  m_pathQueryManager->Update();
+
   // prepare obstacle simulation for new frame
   if (m_obstacleSimulation)
     m_obstacleSimulation->UpdateObstacles();
@@ -2262,6 +2306,8 @@ PyMethodDef KX_Scene::Methods[] = {
     KX_PYMETHODTABLE(KX_Scene, suspend),
     KX_PYMETHODTABLE(KX_Scene, resume),
     KX_PYMETHODTABLE(KX_Scene, drawObstacleSimulation),
+    KX_PYMETHODTABLE(KX_Scene, getObjectsAttribute),
+    KX_PYMETHODTABLE(KX_Scene, setObjectsAttribute),
 
     /* dict style access */
     KX_PYMETHODTABLE(KX_Scene, get),
@@ -2685,6 +2731,304 @@ KX_PYMETHODDEF_DOC(KX_Scene,
   Py_RETURN_NONE;
 }
 
+/// Object attributes exchanged in bulk as float arrays.
+enum KX_ObjectArrayAttribute {
+  OBJECT_WORLD_POSITION = 0,
+  OBJECT_LOCAL_POSITION,
+  OBJECT_WORLD_ORIENTATION,
+  OBJECT_LOCAL_ORIENTATION,
+  OBJECT_WORLD_SCALE,
+  OBJECT_LOCAL_SCALE,
+  OBJECT_WORLD_LINEAR_VELOCITY,
+  OBJECT_LOCAL_LINEAR_VELOCITY,
+  OBJECT_WORLD_ANGULAR_VELOCITY,
+  OBJECT_LOCAL_ANGULAR_VELOCITY,
+  OBJECT_NUM_ATTRIBUTES
+};
+
+static const char *kx_scene_object_attribute_names[OBJECT_NUM_ATTRIBUTES] = {
+    "worldPosition",
+    "localPosition",
+    "worldOrientation",
+    "localOrientation",
+    "worldScale",
+    "localScale",
+    "worldLinearVelocity",
+    "localLinearVelocity",
+    "worldAngularVelocity",
+    "localAngularVelocity"};
+
+static int kx_scene_find_object_attribute(const char *name, const char *error_prefix)
+{
+  for (int i = 0; i < OBJECT_NUM_ATTRIBUTES; ++i) {
+    if (STREQ(name, kx_scene_object_attribute_names[i])) {
+      return i;
+    }
+  }
+
+  PyErr_Format(PyExc_ValueError, "%s: unknown attribute \"%s\"", error_prefix, name);
+  return -1;
+}
+
+static bool kx_scene_object_attribute_is_orientation(int attrib)
+{
+  return (attrib == OBJECT_WORLD_ORIENTATION || attrib == OBJECT_LOCAL_ORIENTATION);
+}
+
+/// The attribute is part of the node transform and needs a scene graph update.
+static bool kx_scene_object_attribute_is_transform(int attrib)
+{
+  return (attrib <= OBJECT_LOCAL_SCALE);
+}
+
+/// Convert a sequence of game objects, names are accepted as in the other scene functions.
+static bool kx_scene_convert_objects(SCA_LogicManager *logicmgr,
+                                     PyObject *value,
+                                     std::vector<KX_GameObject *> &objects,
+                                     const char *error_prefix)
+{
+  PyObject *seq = PySequence_Fast(value, error_prefix);
+  if (!seq) {
+    return false;
+  }
+
+  const Py_ssize_t size = PySequence_Fast_GET_SIZE(seq);
+  PyObject **items = PySequence_Fast_ITEMS(seq);
+  objects.resize(size);
+
+  for (Py_ssize_t i = 0; i < size; ++i) {
+    if (!ConvertPythonToGameObject(logicmgr, items[i], &objects[i], false, error_prefix)) {
+      Py_DECREF(seq);
+      return false;
+    }
+  }
+
+  Py_DECREF(seq);
+  return true;
+}
+
+static void kx_scene_read_object_attribute(KX_GameObject *gameobj, int attrib, float *dst)
+{
+  switch (attrib) {
+    case OBJECT_WORLD_POSITION: {
+      gameobj->NodeGetWorldPosition().getValue(dst);
+      break;
+    }
+    case OBJECT_LOCAL_POSITION: {
+      gameobj->NodeGetLocalPosition().getValue(dst);
+      break;
+    }
+    case OBJECT_WORLD_ORIENTATION:
+    case OBJECT_LOCAL_ORIENTATION: {
+      const MT_Matrix3x3 &mat = (attrib == OBJECT_WORLD_ORIENTATION) ?
+                                    gameobj->NodeGetWorldOrientation() :
+                                    gameobj->NodeGetLocalOrientation();
+      // Row major as the mathutils matrices.
+      for (unsigned short i = 0; i < 3; ++i) {
+        for (unsigned short j = 0; j < 3; ++j) {
+          dst[i * 3 + j] = mat[i][j];
+        }
+      }
+      break;
+    }
+    case OBJECT_WORLD_SCALE: {
+      gameobj->NodeGetWorldScaling().getValue(dst);
+      break;
+    }
+    case OBJECT_LOCAL_SCALE: {
+      gameobj->NodeGetLocalScaling().getValue(dst);
+      break;
+    }
+    case OBJECT_WORLD_LINEAR_VELOCITY:
+    case OBJECT_LOCAL_LINEAR_VELOCITY: {
+      gameobj->GetLinearVelocity(attrib == OBJECT_LOCAL_LINEAR_VELOCITY).getValue(dst);
+      break;
+    }
+    case OBJECT_WORLD_ANGULAR_VELOCITY:
+    case OBJECT_LOCAL_ANGULAR_VELOCITY: {
+      gameobj->GetAngularVelocity(attrib == OBJECT_LOCAL_ANGULAR_VELOCITY).getValue(dst);
+      break;
+    }
+  }
+}
+
+/// Set an attribute without updating the scene graph.
+static void kx_scene_write_object_attribute(KX_GameObject *gameobj, int attrib, const float *src)
+{
+  switch (attrib) {
+    case OBJECT_WORLD_POSITION: {
+      gameobj->NodeSetWorldPosition(MT_Vector3(src));
+      break;
+    }
+    case OBJECT_LOCAL_POSITION: {
+      gameobj->NodeSetLocalPosition(MT_Vector3(src));
+      break;
+    }
+    case OBJECT_WORLD_ORIENTATION:
+    case OBJECT_LOCAL_ORIENTATION: {
+      const MT_Matrix3x3 mat(
+          src[0], src[1], src[2], src[3], src[4], src[5], src[6], src[7], src[8]);
+      if (attrib == OBJECT_WORLD_ORIENTATION) {
+        gameobj->NodeSetGlobalOrientation(mat);
+      }
+      else {
+        gameobj->NodeSetLocalOrientation(mat);
+      }
+      break;
+    }
+    case OBJECT_WORLD_SCALE: {
+      gameobj->NodeSetWorldScale(MT_Vector3(src));
+      break;
+    }
+    case OBJECT_LOCAL_SCALE: {
+      gameobj->NodeSetLocalScale(MT_Vector3(src));
+      break;
+    }
+    case OBJECT_WORLD_LINEAR_VELOCITY:
+    case OBJECT_LOCAL_LINEAR_VELOCITY: {
+      gameobj->setLinearVelocity(MT_Vector3(src), attrib == OBJECT_LOCAL_LINEAR_VELOCITY);
+      break;
+    }
+    case OBJECT_WORLD_ANGULAR_VELOCITY:
+    case OBJECT_LOCAL_ANGULAR_VELOCITY: {
+      gameobj->setAngularVelocity(MT_Vector3(src), attrib == OBJECT_LOCAL_ANGULAR_VELOCITY);
+      break;
+    }
+  }
+}
+
+KX_PYMETHODDEF_DOC(KX_Scene,
+                   getObjectsAttribute,
+                   "getObjectsAttribute(objects, attribute)\n"
+                   "Returns a float32 memoryview of shape (len(objects), 3) or\n"
+                   "(len(objects), 3, 3) for the orientations containing the attribute\n"
+                   "of each object.\n")
+{
+  const char *error_prefix = "scene.getObjectsAttribute(objects, attribute)";
+  PyObject *pyobjects;
+  const char *name;
+
+  if (!PyArg_ParseTuple(args, "Os:getObjectsAttribute", &pyobjects, &name)) {
+    return nullptr;
+  }
+
+  const int attrib = kx_scene_find_object_attribute(name, error_prefix);
+  std::vector<KX_GameObject *> objects;
+  if (attrib == -1 || !kx_scene_convert_objects(m_logicmgr, pyobjects, objects, error_prefix)) {
+    return nullptr;
+  }
+
+  const unsigned int count = objects.size();
+  const unsigned int size = kx_scene_object_attribute_is_orientation(attrib) ? 9 : 3;
+
+  PyObject *bytes = PyByteArray_FromStringAndSize(nullptr, count * size * sizeof(float));
+  if (!bytes) {
+    return nullptr;
+  }
+
+  float *dst = (float *)PyByteArray_AS_STRING(bytes);
+  for (KX_GameObject *gameobj : objects) {
+    kx_scene_read_object_attribute(gameobj, attrib, dst);
+    dst += size;
+  }
+
+  const unsigned int shape[3] = {count, 3, 3};
+  return PyMemoryViewFromByteArray(bytes, "f", shape, (size == 9) ? 3 : 2);
+}
+
+KX_PYMETHODDEF_DOC(KX_Scene,
+                   setObjectsAttribute,
+                   "setObjectsAttribute(objects, attribute, data)\n"
+                   "Sets the attribute of each object from a float32 buffer\n"
+                   "of 3 floats or 9 floats for the orientations per object.\n")
+{
+  const char *error_prefix = "scene.setObjectsAttribute(objects, attribute, data)";
+  PyObject *pyobjects;
+  const char *name;
+  PyObject *data;
+
+  if (!PyArg_ParseTuple(args, "OsO:setObjectsAttribute", &pyobjects, &name, &data)) {
+    return nullptr;
+  }
+
+  const int attrib = kx_scene_find_object_attribute(name, error_prefix);
+  std::vector<KX_GameObject *> objects;
+  if (attrib == -1 || !kx_scene_convert_objects(m_logicmgr, pyobjects, objects, error_prefix)) {
+    return nullptr;
+  }
+
+  Py_buffer buffer;
+  if (!PyFloatBufferTo(data, buffer, error_prefix)) {
+    return nullptr;
+  }
+
+  const unsigned int count = objects.size();
+  const unsigned int size = kx_scene_object_attribute_is_orientation(attrib) ? 9 : 3;
+  if (buffer.len != (Py_ssize_t)(count * size * sizeof(float))) {
+    PyErr_Format(PyExc_ValueError,
+                 "%s: expected %u floats, got %u",
+                 error_prefix,
+                 count * size,
+                 (unsigned int)(buffer.len / sizeof(float)));
+    PyBuffer_Release(&buffer);
+    return nullptr;
+  }
+
+  const float *values = (const float *)buffer.buf;
+
+  if (!kx_scene_object_attribute_is_transform(attrib)) {
+    for (unsigned int i = 0; i < count; ++i) {
+      kx_scene_write_object_attribute(objects[i], attrib, values + i * size);
+    }
+    PyBuffer_Release(&buffer);
+    Py_RETURN_NONE;
+  }
+
+  /* The parent objects are updated before their children, so that a world transform of a
+   * child is computed from the final transform of its parent, whatever the order of the list.
+   * The root objects are updated once after all of them are set, the others are sorted by depth
+   * and updated immediately as their descendants in the list depend on them. */
+  std::vector<std::pair<unsigned int, unsigned int>> children;
+  for (unsigned int i = 0; i < count; ++i) {
+    KX_GameObject *gameobj = objects[i];
+    unsigned int depth = 0;
+    for (SG_Node *parent = gameobj->GetSGNode()->GetSGParent(); parent;
+         parent = parent->GetSGParent()) {
+      ++depth;
+    }
+
+    if (depth == 0) {
+      kx_scene_write_object_attribute(gameobj, attrib, values + i * size);
+    }
+    else {
+      children.emplace_back(depth, i);
+    }
+  }
+
+  for (KX_GameObject *gameobj : objects) {
+    if (!gameobj->GetSGNode()->GetSGParent()) {
+      gameobj->NodeUpdateGS(0.0f);
+    }
+  }
+
+  std::stable_sort(children.begin(),
+                   children.end(),
+                   [](const std::pair<unsigned int, unsigned int> &a,
+                      const std::pair<unsigned int, unsigned int> &b) {
+                     return a.first < b.first;
+                   });
+
+  for (const std::pair<unsigned int, unsigned int> &child : children) {
+    KX_GameObject *gameobj = objects[child.second];
+    kx_scene_write_object_attribute(gameobj, attrib, values + child.second * size);
+    gameobj->NodeUpdateGS(0.0f);
+  }
+
+  PyBuffer_Release(&buffer);
+
+  Py_RETURN_NONE;
+}
+
 /* Matches python dict.get(key, [default]) */
 KX_PYMETHODDEF_DOC(KX_Scene, get, "")
 {
@@ -88,6 +88,7 @@ class btCollisionShape;
 class KX_BlenderSceneConverter;
 struct KX_ClientObjectInfo;
 class KX_ObstacleSimulation;
+class KX_PathQueryManager;
 struct TaskPool;
 
 /*********EEVEE INTEGRATION************/
@@ -187,6 +188,9 @@ class KX_Scene : public CValue, public SCA_IScene {
    */
   std::string m_sceneName;
 
+  /// Profiler zone of the scene, -1 until first used or after a rename.
+  int m_profileId;
+
   /**
    * \section Different scenes, linked to ketsji scene
    */
@@ -297,6 +301,7 @@ class KX_Scene : public CValue, public SCA_IScene {
   KX_2DFilterManager *m_filterManager;
 
   KX_ObstacleSimulation *m_obstacleSimulation;
+  KX_PathQueryManager *m_pathQueryManager;
 
   AnimationPoolData m_animationPoolData;
   TaskPool *m_animationPool;
@@ -547,12 +552,20 @@ class KX_Scene : public CValue, public SCA_IScene {
     return m_obstacleSimulation;
   }
 
+  KX_PathQueryManager *GetPathQueryManager()
+  {
+    return m_pathQueryManager;
+  }
+
   /**  Inherited from CValue -- returns the name of this object. */
   virtual std::string GetName();
 
   /** Inherited from CValue -- set the name of this object. */
   virtual void SetName(const std::string &name);
 
+  /// Return the profiler zone of the scene, registered on first use.
+  unsigned int GetProfileId();
+
 #ifdef WITH_PYTHON
   /* --------------------------------------------------------------------- */
   /* Python interface ---------------------------------------------------- */
@@ -566,6 +579,8 @@ class KX_Scene : public CValue, public SCA_IScene {
   KX_PYMETHOD_DOC(KX_Scene, resume);
   KX_PYMETHOD_DOC(KX_Scene, get);
   KX_PYMETHOD_DOC(KX_Scene, drawObstacleSimulation);
+  KX_PYMETHOD_DOC(KX_Scene, getObjectsAttribute);
+  KX_PYMETHOD_DOC(KX_Scene, setObjectsAttribute);
 
   /* attributes */
   static PyObject *pyattr_get_name(PyObjectPlus *self_v, const KX_PYATTRIBUTE_DEF *attrdef);
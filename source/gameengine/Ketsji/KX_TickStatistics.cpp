@@ -0,0 +1,125 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file gameengine/Ketsji/KX_TickStatistics.cpp
+ *  \ingroup ketsji
+ */
+
+#include "KX_TickStatistics.h"
+
+#include "CM_Message.h"
+
+#include <algorithm>
+
+const unsigned int KX_TickStatistics::NUM_BUCKETS;
+constexpr double KX_TickStatistics::BUCKET_SIZE;
+
+KX_TickStatistics::KX_TickStatistics()
+{
+  Clear();
+}
+
+void KX_TickStatistics::Clear()
+{
+  m_count = 0;
+  m_total = 0.0;
+  m_min = 0.0;
+  m_max = 0.0;
+  m_histogram.fill(0);
+}
+
+void KX_TickStatistics::AddTick(double duration)
+{
+  if (m_count == 0) {
+    m_min = duration;
+    m_max = duration;
+  }
+  else {
+    m_min = std::min(m_min, duration);
+    m_max = std::max(m_max, duration);
+  }
+
+  ++m_count;
+  m_total += duration;
+
+  const unsigned int bucket = (unsigned int)std::max(duration / BUCKET_SIZE, 0.0);
+  ++m_histogram[std::min(bucket, NUM_BUCKETS)];
+}
+
+unsigned int KX_TickStatistics::GetCount() const
+{
+  return m_count;
+}
+
+double KX_TickStatistics::GetTotal() const
+{
+  return m_total;
+}
+
+double KX_TickStatistics::GetAverage() const
+{
+  return (m_count > 0) ? m_total / m_count : 0.0;
+}
+
+double KX_TickStatistics::GetMin() const
+{
+  return m_min;
+}
+
+double KX_TickStatistics::GetMax() const
+{
+  return m_max;
+}
+
+double KX_TickStatistics::GetPercentile(double fraction) const
+{
+  if (m_count == 0) {
+    return 0.0;
+  }
+
+  const double threshold = fraction * m_count;
+  unsigned int sum = 0;
+  for (unsigned int i = 0; i < NUM_BUCKETS; ++i) {
+    sum += m_histogram[i];
+    if (sum >= threshold) {
+      // The maximum is more precise than the upper bound of the bucket.
+      return std::min((i + 1) * BUCKET_SIZE, m_max);
+    }
+  }
+
+  return m_max;
+}
+
+void KX_TickStatistics::Print() const
+{
+  CM_Message("Tick statistics:");
+  CM_Message("  ticks:   " << m_count);
+  if (m_count == 0) {
+    return;
+  }
+
+  CM_Message("  total:   " << m_total << " s");
+  CM_Message("  average: " << GetAverage() * 1000.0 << " ms");
+  CM_Message("  min:     " << m_min * 1000.0 << " ms");
+  CM_Message("  max:     " << m_max * 1000.0 << " ms");
+  CM_Message("  p50:     " << GetPercentile(0.5) * 1000.0 << " ms");
+  CM_Message("  p95:     " << GetPercentile(0.95) * 1000.0 << " ms");
+  CM_Message("  p99:     " << GetPercentile(0.99) * 1000.0 << " ms");
+}
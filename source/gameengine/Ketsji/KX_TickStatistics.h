@@ -0,0 +1,66 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file KX_TickStatistics.h
+ *  \ingroup ketsji
+ */
+
+#ifndef __KX_TICKSTATISTICS_H__
+#define __KX_TICKSTATISTICS_H__
+
+#include <array>
+
+/**
+ * Accumulates the duration of every logic tick over the whole game.
+ * Contrary to KX_TimeCategoryLogger no measurement is forgotten, durations are stored
+ * in a fixed histogram of 0.1ms buckets to estimate percentiles with a constant memory.
+ */
+class KX_TickStatistics {
+ private:
+  /// Number of 0.1ms buckets, the last bucket holds all the ticks longer than 100ms.
+  static const unsigned int NUM_BUCKETS = 1000;
+  static constexpr double BUCKET_SIZE = 1.0e-4;
+
+  unsigned int m_count;
+  double m_total;
+  double m_min;
+  double m_max;
+  std::array<unsigned int, NUM_BUCKETS + 1> m_histogram;
+
+ public:
+  KX_TickStatistics();
+
+  void Clear();
+  /// Register the duration of a tick in seconds.
+  void AddTick(double duration);
+
+  unsigned int GetCount() const;
+  double GetTotal() const;
+  double GetAverage() const;
+  double GetMin() const;
+  double GetMax() const;
+  /// Return the upper bound of the duration of the given fraction (0 to 1) of ticks.
+  double GetPercentile(double fraction) const;
+
+  /// Print a summary of all the registered ticks.
+  void Print() const;
+};
+
+#endif  // __KX_TICKSTATISTICS_H__
@@ -0,0 +1,144 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file gameengine/Launcher/LA_FramePacer.cpp
+ *  \ingroup launcher
+ */
+
+#include "LA_FramePacer.h"
+
+#include "KX_ISystem.h"
+
+#include "CM_Message.h"
+
+#include "PIL_time.h"
+
+#include <algorithm>
+#include <cmath>
+
+/// Bounds of the spin margin in seconds.
+static const double minSpinMargin = 0.0002;
+static const double maxSpinMargin = 0.004;
+/// Longest wait, keep the window responsive if the deadline is far (e.g time scale near 0).
+static const double maxWait = 0.1;
+
+LA_FramePacer::LA_FramePacer(KX_ISystem *system, Mode mode)
+    : m_system(system),
+      m_mode(mode),
+      m_spinMargin(0.001),
+      m_lastFrameTime(-1.0),
+      m_count(0),
+      m_mean(0.0),
+      m_m2(0.0),
+      m_waitCount(0),
+      m_totalLateness(0.0),
+      m_maxLateness(0.0)
+{
+}
+
+LA_FramePacer::Mode LA_FramePacer::GetMode() const
+{
+  return m_mode;
+}
+
+void LA_FramePacer::WaitUntil(double deadline)
+{
+  if (m_mode == MODE_SPIN) {
+    return;
+  }
+
+  double now = m_system->GetTimeInSeconds();
+  deadline = std::min(deadline, now + maxWait);
+  if (now >= deadline) {
+    return;
+  }
+
+  const double margin = (m_mode == MODE_SLEEP) ? 0.0 : m_spinMargin;
+  const int sleepms = int((deadline - now - margin) * 1000.0);
+  if (sleepms > 0) {
+    const double sleepStart = now;
+    PIL_sleep_ms(sleepms);
+    now = m_system->GetTimeInSeconds();
+
+    /* Follow the oversleep of the scheduler: grow quickly to not miss the next deadline,
+     * shrink slowly to reduce the spin time. */
+    const double oversleep = (now - sleepStart) - sleepms * 0.001;
+    const double target = std::max(oversleep * 1.5, minSpinMargin);
+    m_spinMargin = (target > m_spinMargin) ? target : (m_spinMargin * 0.95 + target * 0.05);
+    m_spinMargin = std::min(m_spinMargin, maxSpinMargin);
+  }
+
+  if (m_mode == MODE_SLEEP) {
+    // Less than a millisecond left, give the processor away instead of polling.
+    while (now < deadline) {
+      PIL_sleep_ms(0);
+      now = m_system->GetTimeInSeconds();
+    }
+  }
+  else {
+    while (now < deadline) {
+      now = m_system->GetTimeInSeconds();
+    }
+  }
+
+  const double lateness = now - deadline;
+  ++m_waitCount;
+  m_totalLateness += lateness;
+  m_maxLateness = std::max(m_maxLateness, lateness);
+}
+
+void LA_FramePacer::RegisterFrame(double time)
+{
+  if (m_lastFrameTime >= 0.0) {
+    // Welford's online variance.
+    const double interval = time - m_lastFrameTime;
+    ++m_count;
+    const double delta = interval - m_mean;
+    m_mean += delta / m_count;
+    m_m2 += delta * (interval - m_mean);
+  }
+  m_lastFrameTime = time;
+}
+
+double LA_FramePacer::GetFrameTimeMean() const
+{
+  return m_mean;
+}
+
+double LA_FramePacer::GetFrameTimeVariance() const
+{
+  return (m_count > 1) ? m_m2 / (m_count - 1) : 0.0;
+}
+
+void LA_FramePacer::Print() const
+{
+  CM_Message("Frame pacing:");
+  CM_Message("  frames:             " << m_count);
+  if (m_count == 0) {
+    return;
+  }
+
+  CM_Message("  average interval:   " << m_mean * 1000.0 << " ms");
+  CM_Message("  standard deviation: " << std::sqrt(GetFrameTimeVariance()) * 1000.0 << " ms");
+  if (m_waitCount > 0) {
+    CM_Message("  average lateness:   " << m_totalLateness / m_waitCount * 1000.0 << " ms");
+    CM_Message("  max lateness:       " << m_maxLateness * 1000.0 << " ms");
+  }
+}
@@ -0,0 +1,87 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file LA_FramePacer.h
+ *  \ingroup launcher
+ */
+
+#ifndef __LA_FRAMEPACER_H__
+#define __LA_FRAMEPACER_H__
+
+class KX_ISystem;
+
+/** Wait for the next logic tick of the engine without using a full core.
+ *
+ * The thread sleeps until shortly before the deadline and spins the remaining time,
+ * the spin margin follows the measured oversleep of the system scheduler.
+ * The interval between frames is tracked to report the frame pacing quality.
+ */
+class LA_FramePacer {
+ public:
+  enum Mode {
+    /// Poll the engine continuously, no waiting.
+    MODE_SPIN = 0,
+    /// Only sleep, use the least CPU but can wake up late. Under a millisecond before the
+    /// deadline the thread yields until it's reached.
+    MODE_SLEEP,
+    /// Sleep then spin until the deadline.
+    MODE_HYBRID,
+    /// As MODE_HYBRID but the launcher waits before polling the inputs instead of before the
+    /// logic frame, the inputs are then sampled just before being used.
+    MODE_LOW_LATENCY
+  };
+
+ private:
+  KX_ISystem *m_system;
+  Mode m_mode;
+
+  /// Estimated oversleep of the scheduler, time spent spinning before the deadline.
+  double m_spinMargin;
+
+  /// Time of the last frame, negative before the first frame.
+  double m_lastFrameTime;
+  /// Number of frame intervals.
+  unsigned int m_count;
+  /// Running mean and sum of squared differences of the frame intervals.
+  double m_mean;
+  double m_m2;
+  /// Number of waits and time between the deadline and the real wake up.
+  unsigned int m_waitCount;
+  double m_totalLateness;
+  double m_maxLateness;
+
+ public:
+  LA_FramePacer(KX_ISystem *system, Mode mode);
+
+  Mode GetMode() const;
+
+  /// Wait until the deadline expressed in system time.
+  void WaitUntil(double deadline);
+  /// Register the system time of a frame computing at least one logic tick.
+  void RegisterFrame(double time);
+
+  double GetFrameTimeMean() const;
+  double GetFrameTimeVariance() const;
+
+  /// Print a summary of the frame pacing.
+  void Print() const;
+};
+
+#endif  // __LA_FRAMEPACER_H__
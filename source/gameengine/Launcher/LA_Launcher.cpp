@@ -60,6 +60,7 @@
 #include "DEV_Joystick.h"
 
 #include "CM_Message.h"
+#include "CM_Profiler.h"
 
 #include "MEM_guardedalloc.h"
 
@@ -103,6 +104,7 @@ LA_Launcher::LA_Launcher(GHOST_ISystem *system,
       m_canvas(nullptr),
       m_rasterizer(nullptr),
       m_converter(nullptr),
+      m_framePacer(nullptr),
 #ifdef WITH_PYTHON
       m_globalDict(nullptr),
       m_gameLogic(nullptr),
@@ -114,6 +116,9 @@ LA_Launcher::LA_Launcher(GHOST_ISystem *system,
       m_context(C)
 {
   m_pythonConsole.use = false;
+  m_headless.use = false;
+  m_headless.unthrottled = false;
+  m_headless.maxTicks = 0;
 }
 
 LA_Launcher::~LA_Launcher()
@@ -160,24 +165,47 @@ void LA_Launcher::InitEngine()
   bool frameRate = (SYS_GetCommandLineInt(syshandle, "show_framerate", 0) != 0);
   bool nodepwarnings = (SYS_GetCommandLineInt(syshandle, "ignore_deprecation_warnings", 1) != 0);
   bool restrictAnimFPS = (gm.flag & GAME_RESTRICT_ANIM_UPDATES) != 0;
+  const int framePacing = SYS_GetCommandLineInt(
+      syshandle, "frame_pacing", LA_FramePacer::MODE_HYBRID);
+
+  m_headless.use = (SYS_GetCommandLineInt(syshandle, "headless", 0) != 0);
+  m_headless.unthrottled = m_headless.use &&
+                           (SYS_GetCommandLineInt(syshandle, "unthrottled", 0) != 0);
+  const int maxTicks = SYS_GetCommandLineInt(syshandle, "max_ticks", 0);
+  m_headless.maxTicks = (m_headless.use && maxTicks > 0) ? maxTicks : 0;
+  if (m_headless.use && !fixed_framerate) {
+    // Without rendering nor vsync a variable framerate would run frames continuously,
+    // with a fixed framerate the frame pacer waits for each logic tick.
+    CM_Warning("headless mode requires a fixed framerate, enabling fixed time");
+    fixed_framerate = true;
+  }
 
   const KX_KetsjiEngine::FlagType flags = (KX_KetsjiEngine::FlagType)(
       (fixed_framerate ? KX_KetsjiEngine::FIXED_FRAMERATE : 0) |
       (frameRate ? KX_KetsjiEngine::SHOW_FRAMERATE : 0) |
       (restrictAnimFPS ? KX_KetsjiEngine::RESTRICT_ANIMATION : 0) |
       (properties ? KX_KetsjiEngine::SHOW_DEBUG_PROPERTIES : 0) |
-      (profile ? KX_KetsjiEngine::SHOW_PROFILE : 0));
-
-  m_rasterizer = new RAS_Rasterizer();
-
-  // Stereo parameters - Eye Separation from the UI - stereomode from the command-line/UI
-  m_rasterizer->SetStereoMode(m_stereoMode);
-  m_rasterizer->SetEyeSeparation(m_startScene->gm.eyeseparation);
-
-  // Copy current anisotropic level to restore it at the game end.
-  m_savedData.anisotropic = m_rasterizer->GetAnisotropicFiltering();
-  // Copy current mipmap mode to restore at the game end.
-  m_savedData.mipmap = m_rasterizer->GetMipmapping();
+      (profile ? KX_KetsjiEngine::SHOW_PROFILE : 0) |
+      (m_headless.use ? KX_KetsjiEngine::HEADLESS : 0) |
+      (m_headless.unthrottled ? KX_KetsjiEngine::USE_EXTERNAL_CLOCK : 0));
+
+  // The zone profiler feeds the on screen profiler, it can be toggled from python too.
+  CM_Profiler::SetEnabled(profile);
+  CM_Profiler::SetThreadName("Main");
+
+  // Nothing is rendered in headless mode, there's no OpenGL context to use for a rasterizer.
+  if (!m_headless.use) {
+    m_rasterizer = new RAS_Rasterizer();
+
+    // Stereo parameters - Eye Separation from the UI - stereomode from the command-line/UI
+    m_rasterizer->SetStereoMode(m_stereoMode);
+    m_rasterizer->SetEyeSeparation(m_startScene->gm.eyeseparation);
+
+    // Copy current anisotropic level to restore it at the game end.
+    m_savedData.anisotropic = m_rasterizer->GetAnisotropicFiltering();
+    // Copy current mipmap mode to restore at the game end.
+    m_savedData.mipmap = m_rasterizer->GetMipmapping();
+  }
 
   // Create the canvas, rasterizer and rendertools.
   m_canvas = CreateCanvas(m_startScene);
@@ -211,6 +239,15 @@ void LA_Launcher::InitEngine()
   // Create a ketsjisystem (only needed for timing and stuff).
   m_kxsystem = new LA_System();
 
+  LA_FramePacer::Mode pacingMode = LA_FramePacer::MODE_HYBRID;
+  if (framePacing >= LA_FramePacer::MODE_SPIN && framePacing <= LA_FramePacer::MODE_LOW_LATENCY) {
+    pacingMode = (LA_FramePacer::Mode)framePacing;
+  }
+  else {
+    CM_Warning("invalid frame_pacing value " << framePacing << ", using default");
+  }
+  m_framePacer = new LA_FramePacer(m_kxsystem, pacingMode);
+
   m_networkMessageManager = new KX_NetworkMessageManager();
 
   // Create the ketsjiengine.
@@ -233,7 +270,7 @@ void LA_Launcher::InitEngine()
 #endif
 
   m_ketsjiEngine->SetFlag(flags, true);
-  m_ketsjiEngine->SetRender(true);
+  m_ketsjiEngine->SetRender(!m_headless.use);
 
   m_ketsjiEngine->SetTicRate(gm.ticrate);
   m_ketsjiEngine->SetMaxLogicFrame(gm.maxlogicstep);
@@ -242,7 +279,9 @@ void LA_Launcher::InitEngine()
   // Set the global settings (carried over if restart/load new files).
   m_ketsjiEngine->SetGlobalSettings(m_globalSettings);
 
-  m_rasterizer->Init(m_canvas);
+  if (m_rasterizer) {
+    m_rasterizer->Init(m_canvas);
+  }
   InitCamera();
 
 #ifdef WITH_PYTHON
@@ -292,6 +331,11 @@ void LA_Launcher::ExitEngine()
   DEV_Joystick::Close();
   m_ketsjiEngine->StopEngine();
 
+  if (m_headless.use) {
+    m_ketsjiEngine->GetTickStatistics().Print();
+    m_framePacer->Print();
+  }
+
 #ifdef WITH_PYTHON
 
   /* Clears the dictionary by hand:
@@ -313,11 +357,13 @@ void LA_Launcher::ExitEngine()
     m_canvas->SetMouseState(RAS_ICanvas::MOUSE_NORMAL);
   }
 
-  // Set anisotropic settign back to its original value.
-  m_rasterizer->SetAnisotropicFiltering(m_savedData.anisotropic);
+  if (m_rasterizer) {
+    // Set anisotropic settign back to its original value.
+    m_rasterizer->SetAnisotropicFiltering(m_savedData.anisotropic);
 
-  // Set mipmap setting back to its original value.
-  m_rasterizer->SetMipmapping(m_savedData.mipmap);
+    // Set mipmap setting back to its original value.
+    m_rasterizer->SetMipmapping(m_savedData.mipmap);
+  }
 
   // Set vsync mode back to original value.
   m_canvas->SetSwapInterval(m_savedData.vsync);
@@ -330,6 +376,13 @@ void LA_Launcher::ExitEngine()
     delete m_ketsjiEngine;
     m_ketsjiEngine = nullptr;
   }
+  if (m_framePacer) {
+    delete m_framePacer;
+    m_framePacer = nullptr;
+  }
+
+  CM_Profiler::SetEnabled(false);
+  CM_Profiler::Clear();
   if (m_kxsystem) {
     delete m_kxsystem;
     m_kxsystem = nullptr;
@@ -458,19 +511,52 @@ bool LA_Launcher::EngineNextFrame()
   // Check if we can create a python console debugging.
   HandlePythonConsole();
 #endif
+  if (m_headless.unthrottled) {
+    m_ketsjiEngine->SetClockTime(m_ketsjiEngine->GetClockTime() +
+                                 m_ketsjiEngine->GetTimeScale() / m_ketsjiEngine->GetTicRate());
+  }
+
+  const LA_FramePacer::Mode pacingMode = m_framePacer->GetMode();
+  if (pacingMode != LA_FramePacer::MODE_LOW_LATENCY) {
+    m_framePacer->WaitUntil(m_ketsjiEngine->GetNextFrameRealTime());
+  }
+
+  const unsigned int tickCount = m_ketsjiEngine->GetTickStatistics().GetCount();
+
   // Kick the engine.
   bool renderFrame = m_ketsjiEngine->NextFrame();
 
+  if (m_ketsjiEngine->GetTickStatistics().GetCount() != tickCount) {
+    m_framePacer->RegisterFrame(m_kxsystem->GetTimeInSeconds());
+  }
+
   // First check if we want to exit.
   m_exitRequested = m_ketsjiEngine->GetExitCode();
   m_exitString = m_ketsjiEngine->GetExitString();
 
+  if (m_exitRequested == KX_ExitRequest::NO_REQUEST && m_headless.maxTicks > 0 &&
+      m_ketsjiEngine->GetTickStatistics().GetCount() >= m_headless.maxTicks) {
+    m_exitRequested = KX_ExitRequest::QUIT_GAME;
+  }
+
   if (m_exitRequested == KX_ExitRequest::NO_REQUEST) {
     if (renderFrame) {
       RenderEngine();
     }
   }
 
+  // Accumulate the profiler zones once per logic or render frame.
+  if (CM_Profiler::IsEnabled() &&
+      (renderFrame || m_ketsjiEngine->GetTickStatistics().GetCount() != tickCount)) {
+    CM_Profiler::NextFrame();
+  }
+
+  // Wait as late as possible before sampling the inputs used by the next logic frame.
+  if (pacingMode == LA_FramePacer::MODE_LOW_LATENCY &&
+      m_exitRequested == KX_ExitRequest::NO_REQUEST) {
+    m_framePacer->WaitUntil(m_ketsjiEngine->GetNextFrameRealTime());
+  }
+
   m_system->processEvents(false);
   m_system->dispatchEvents();
 
@@ -34,6 +34,8 @@
 
 #include "SCA_IInputDevice.h"
 
+#include "LA_FramePacer.h"
+
 #include <string>
 
 class KX_Scene;
@@ -78,6 +80,8 @@ class LA_Launcher {
   KX_BlenderConverter *m_converter;
   /// Manage messages.
   KX_NetworkMessageManager *m_networkMessageManager;
+  /// Wait for the next logic frame.
+  LA_FramePacer *m_framePacer;
 
 #ifdef WITH_PYTHON
   PyObject *m_globalDict;
@@ -108,6 +112,15 @@ class LA_Launcher {
     std::vector<SCA_IInputDevice::SCA_EnumInputs> keys;
   } m_pythonConsole;
 
+  /// Settings of the game run without rendering.
+  struct Headless {
+    bool use;
+    /// Advance the engine clock of one logic tick per frame instead of following the real time.
+    bool unthrottled;
+    /// Number of logic ticks before exiting, 0 for no limit.
+    unsigned int maxTicks;
+  } m_headless;
+
 #ifdef WITH_PYTHON
   void HandlePythonConsole();
 #endif  // WITH_PYTHON
@@ -137,7 +137,9 @@ void LA_PlayerLauncher::InitEngine()
   BKE_sound_init(m_maggie);
   LA_Launcher::InitEngine();
 
-  m_rasterizer->PrintHardwareInfo();
+  if (m_rasterizer) {
+    m_rasterizer->PrintHardwareInfo();
+  }
 }
 
 void LA_PlayerLauncher::ExitEngine()
@@ -148,7 +150,8 @@ void LA_PlayerLauncher::ExitEngine()
 
 bool LA_PlayerLauncher::EngineNextFrame()
 {
-  if (m_inputDevice->GetInput(SCA_IInputDevice::WINRESIZE).Find(SCA_InputEvent::ACTIVE)) {
+  if (m_mainWindow &&
+      m_inputDevice->GetInput(SCA_IInputDevice::WINRESIZE).Find(SCA_InputEvent::ACTIVE)) {
     GHOST_Rect bnds;
     m_mainWindow->getClientBounds(bnds);
     m_canvas->Resize(bnds.getWidth(), bnds.getHeight());
@@ -220,6 +220,9 @@ CcdPhysicsController::CcdPhysicsController(const CcdConstructionInfo &ci) : m_cc
   m_savedMass = 0.0f;
   m_savedDyna = false;
   m_suspended = false;
+  m_stateId = 0;
+  m_staticBatch = nullptr;
+  m_staticBatchPart = -1;
 
   CreateRigidbody();
 }
@@ -701,6 +704,8 @@ bool CcdPhysicsController::DeleteControllerShape()
 
 bool CcdPhysicsController::ReplaceControllerShape(btCollisionShape *newShape)
 {
+  LeaveStaticBatch();
+
   if (m_collisionShape)
     DeleteControllerShape();
 
@@ -857,6 +862,9 @@ void CcdPhysicsController::PostProcessReplica(class PHY_IMotionState *motionstat
   m_softBodyTransformInitialized = false;
   m_MotionState = motionstate;
   m_registerCount = 0;
+  m_stateId = 0;
+  m_staticBatch = nullptr;
+  m_staticBatchPart = -1;
   m_collisionShape = nullptr;
 
   // Clear all old constraints.
@@ -947,6 +955,7 @@ void CcdPhysicsController::SetCenterOfMassTransform(btTransform &xform)
 void CcdPhysicsController::RelativeTranslate(const MT_Vector3 &dlocin, bool local)
 {
   if (m_object) {
+    LeaveStaticBatch();
     m_object->activate(true);
     if (m_object->isStaticObject()) {
       if (!m_cci.m_bSensor)
@@ -970,6 +979,7 @@ void CcdPhysicsController::RelativeTranslate(const MT_Vector3 &dlocin, bool loca
 void CcdPhysicsController::RelativeRotate(const MT_Matrix3x3 &rotval, bool local)
 {
   if (m_object) {
+    LeaveStaticBatch();
     m_object->activate(true);
     if (m_object->isStaticObject()) {
       if (!m_cci.m_bSensor)
@@ -1012,6 +1022,7 @@ void CcdPhysicsController::SetOrientation(const MT_Matrix3x3 &orn)
 void CcdPhysicsController::SetWorldOrientation(const btMatrix3x3 &orn)
 {
   if (m_object) {
+    LeaveStaticBatch();
     m_object->activate(true);
     if (m_object->isStaticObject() && !m_cci.m_bSensor) {
       m_object->setCollisionFlags(m_object->getCollisionFlags() |
@@ -1034,6 +1045,7 @@ void CcdPhysicsController::SetWorldOrientation(const btMatrix3x3 &orn)
 void CcdPhysicsController::SetPosition(const MT_Vector3 &pos)
 {
   if (m_object) {
+    LeaveStaticBatch();
     m_object->activate(true);
     if (m_object->isStaticObject()) {
       if (!m_cci.m_bSensor)
@@ -1074,6 +1086,8 @@ void CcdPhysicsController::RefreshCollisions()
   if (IsPhysicsSuspended())
     return;
 
+  LeaveStaticBatch();
+
   btSoftRigidDynamicsWorld *dw = GetPhysicsEnvironment()->GetDynamicsWorld();
   btBroadphaseProxy *proxy = m_object->getBroadphaseHandle();
   btDispatcher *dispatcher = dw->getDispatcher();
@@ -1105,6 +1119,7 @@ void CcdPhysicsController::SuspendDynamics(bool ghost)
 {
   btRigidBody *body = GetRigidBody();
   if (body && !m_suspended && !GetConstructionInfo().m_bSensor && !IsPhysicsSuspended()) {
+    LeaveStaticBatch();
     btBroadphaseProxy *handle = body->getBroadphaseHandle();
 
     m_savedCollisionFlags = body->getCollisionFlags();
@@ -1156,6 +1171,7 @@ void CcdPhysicsController::SetScaling(const MT_Vector3 &scale)
     m_cci.m_scaling = ToBullet(scale);
 
     if (m_object && m_object->getCollisionShape()) {
+      LeaveStaticBatch();
       m_object->activate(true);  // without this, sleeping objects scale wont be applied in bullet
                                  // if python changes the scale - Campbell.
       m_object->getCollisionShape()->setLocalScaling(m_cci.m_scaling);
@@ -1171,6 +1187,8 @@ void CcdPhysicsController::SetScaling(const MT_Vector3 &scale)
 
 void CcdPhysicsController::SetTransform()
 {
+  LeaveStaticBatch();
+
   const MT_Vector3 pos = m_MotionState->GetWorldPosition();
   const MT_Matrix3x3 rot = m_MotionState->GetWorldOrientation();
   ForceWorldTransform(ToBullet(rot), ToBullet(pos));
@@ -1285,6 +1303,7 @@ void CcdPhysicsController::SetAngularVelocity(const MT_Vector3 &ang_vel, bool lo
     angvel = btVector3(0.0f, 0.0f, 0.0f);
 
   if (m_object) {
+    LeaveStaticBatch();
     m_object->activate(true);
     if (m_object->isStaticObject()) {
       if (!m_cci.m_bSensor)
@@ -1311,6 +1330,7 @@ void CcdPhysicsController::SetLinearVelocity(const MT_Vector3 &lin_vel, bool loc
     linVel = btVector3(0.0f, 0.0f, 0.0f);
 
   if (m_object) {
+    LeaveStaticBatch();
     m_object->activate(true);
     if (m_object->isStaticObject()) {
       if (!m_cci.m_bSensor)
@@ -1689,6 +1709,13 @@ bool CcdPhysicsController::IsPhysicsSuspended()
   return !GetPhysicsEnvironment()->IsActiveCcdPhysicsController(this);
 }
 
+void CcdPhysicsController::LeaveStaticBatch()
+{
+  if (m_staticBatch) {
+    GetPhysicsEnvironment()->RemoveFromStaticBatch(this, true);
+  }
+}
+
 /* Refresh the physics object from either an object or a mesh.
  * from_gameobj and from_meshobj can be nullptr
  *
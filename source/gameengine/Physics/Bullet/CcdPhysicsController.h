@@ -577,6 +577,16 @@ class CcdPhysicsController : public PHY_IPhysicsController {
   bool m_savedDyna;
   bool m_suspended;
 
+  /// Identifier of the controller in the saved states of its environment, 0 if not assigned.
+  unsigned int m_stateId;
+
+  /// Batch merging the static collider of this controller or nullptr, see MergeStaticColliders.
+  class CcdStaticBatch *m_staticBatch;
+  int m_staticBatchPart;
+
+  /// Move the controller out of its static batch before modifying its collision object.
+  void LeaveStaticBatch();
+
   void GetWorldOrientation(btMatrix3x3 &mat);
 
   void CreateRigidbody();
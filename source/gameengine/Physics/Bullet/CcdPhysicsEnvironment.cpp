@@ -23,9 +23,13 @@
 #include "CcdPhysicsController.h"
 #include "CcdGraphicController.h"
 #include "CcdConstraint.h"
+#include "CcdStaticBatch.h"
 #include "CcdMathUtils.h"
 
 #include <algorithm>
+#include <cstring>
+#include <tuple>
+#include <unordered_map>
 #include "btBulletDynamicsCommon.h"
 #include "LinearMath/btIDebugDraw.h"
 #include "BulletCollision/CollisionDispatch/btGhostObject.h"
@@ -55,6 +59,7 @@
 
 extern "C" {
 #include "BLI_utildefines.h"
+#include "BLI_task.h"
 #include "BKE_object.h"
 }
 
@@ -92,6 +97,130 @@ void DrawRasterizerLine(const float *from, const float *to, int color);
 #  endif  //_MSC_VER
 #endif    // WIN32
 
+/** Return false if ray tests modify the shape, gimpact shapes lock and unlock their mesh
+ * data with a counter which is not thread safe.
+ */
+static bool IsRayTestReentrant(const btCollisionShape *shape)
+{
+  switch (shape->getShapeType()) {
+    case GIMPACT_SHAPE_PROXYTYPE: {
+      return false;
+    }
+    case COMPOUND_SHAPE_PROXYTYPE: {
+      const btCompoundShape *compound = static_cast<const btCompoundShape *>(shape);
+      for (int i = 0, size = compound->getNumChildShapes(); i < size; ++i) {
+        if (!IsRayTestReentrant(compound->getChildShape(i))) {
+          return false;
+        }
+      }
+      return true;
+    }
+    default: {
+      return true;
+    }
+  }
+}
+
+/** Broadphase policy doing the exact ray test of each proxy, see btSoftSingleRayCallback.
+ * Used with btDbvt::rayTest which uses a local stack unlike btCollisionWorld::rayTest,
+ * so several rays can be cast at the same time as long as the world is not modified.
+ * The ray tests of the shapes which are not reentrant are serialized with shapeLock.
+ */
+class ConcurrentRayTester : public btDbvt::ICollide {
+ private:
+  btTransform m_rayFromTrans;
+  btTransform m_rayToTrans;
+  btCollisionWorld::RayResultCallback &m_resultCallback;
+  CM_ThreadLock &m_shapeLock;
+
+ public:
+  ConcurrentRayTester(const btVector3 &rayFrom,
+                      const btVector3 &rayTo,
+                      btCollisionWorld::RayResultCallback &resultCallback,
+                      CM_ThreadLock &shapeLock)
+      : m_rayFromTrans(btMatrix3x3::getIdentity(), rayFrom),
+        m_rayToTrans(btMatrix3x3::getIdentity(), rayTo),
+        m_resultCallback(resultCallback),
+        m_shapeLock(shapeLock)
+  {
+  }
+
+  virtual void Process(const btDbvtNode *leaf)
+  {
+    // Terminate further ray tests once the closest hit fraction reached zero.
+    if (m_resultCallback.m_closestHitFraction == btScalar(0.0f)) {
+      return;
+    }
+
+    btBroadphaseProxy *proxy = (btBroadphaseProxy *)leaf->data;
+    btCollisionObject *object = (btCollisionObject *)proxy->m_clientObject;
+    if (m_resultCallback.needsCollision(object->getBroadphaseHandle())) {
+      const btCollisionShape *shape = object->getCollisionShape();
+      const bool reentrant = IsRayTestReentrant(shape);
+      if (!reentrant) {
+        m_shapeLock.Lock();
+      }
+
+      btSoftRigidDynamicsWorld::rayTestSingle(m_rayFromTrans,
+                                              m_rayToTrans,
+                                              object,
+                                              shape,
+                                              object->getWorldTransform(),
+                                              m_resultCallback);
+
+      if (!reentrant) {
+        m_shapeLock.Unlock();
+      }
+    }
+  }
+};
+
+/// A ray cast in a batch by RayTestParallel.
+struct ConcurrentRayTest {
+  btVector3 m_from;
+  btVector3 m_to;
+  btCollisionWorld::RayResultCallback *m_resultCallback;
+};
+
+struct ConcurrentRayTestData {
+  btDbvtBroadphase *m_broadphase;
+  CM_ThreadLock *m_shapeLock;
+  std::vector<ConcurrentRayTest> *m_tests;
+};
+
+static void ray_test_task_func(void *__restrict userdata,
+                               const int iter,
+                               const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  ConcurrentRayTestData *data = (ConcurrentRayTestData *)userdata;
+  const ConcurrentRayTest &test = (*data->m_tests)[iter];
+
+  ConcurrentRayTester tester(
+      test.m_from, test.m_to, *test.m_resultCallback, *data->m_shapeLock);
+  // Same traversal as btDbvtBroadphase::rayTest: dynamic set then static set.
+  for (unsigned short i = 0; i < 2; ++i) {
+    btDbvt::rayTest(data->m_broadphase->m_sets[i].m_root, test.m_from, test.m_to, tester);
+  }
+}
+
+/** Cast a batch of rays in parallel, the result callbacks must be thread safe and the
+ * collision world must not be modified until all the rays were cast.
+ * \param shapeLock Lock serializing the ray tests of the shapes which are not reentrant.
+ */
+static void RayTestParallel(btBroadphaseInterface *broadphase,
+                            CM_ThreadLock &shapeLock,
+                            std::vector<ConcurrentRayTest> &tests)
+{
+  ConcurrentRayTestData data = {static_cast<btDbvtBroadphase *>(broadphase), &shapeLock, &tests};
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  // A ray test is cheap, avoid scheduling threads for a few rays only.
+  settings.min_iter_per_thread = 8;
+  settings.use_threading = ((int)tests.size() > settings.min_iter_per_thread);
+  BLI_task_parallel_range(0, tests.size(), &data, ray_test_task_func, &settings);
+}
+
 class VehicleClosestRayResultCallback : public btCollisionWorld::ClosestRayResultCallback {
  private:
   const btCollisionShape *m_hitTriangleShape;
@@ -127,14 +256,49 @@ class VehicleClosestRayResultCallback : public btCollisionWorld::ClosestRayResul
 };
 
 class BlenderVehicleRaycaster : public btDefaultVehicleRaycaster {
+ public:
+  /// Wheel ray cast ahead by CcdPhysicsEnvironment::CastVehicleRays().
+  struct WheelRay {
+    btVector3 m_from;
+    btVector3 m_to;
+    VehicleClosestRayResultCallback m_callback;
+
+    WheelRay(const btVector3 &from, const btVector3 &to, short mask)
+        : m_from(from), m_to(to), m_callback(from, to, mask)
+    {
+      // We override btDefaultVehicleRaycaster so we can set this flag, otherwise our
+      // vehicles go crazy (http://bulletphysics.org/Bullet/phpBB3/viewtopic.php?t=9662)
+      m_callback.m_flags |= btTriangleRaycastCallback::kF_UseSubSimplexConvexCastRaytest;
+    }
+  };
+
  private:
   btDynamicsWorld *m_dynamicsWorld;
+  CcdPhysicsEnvironment *m_physEnv;
   short m_mask;
+  std::vector<WheelRay> m_wheelRays;
+
+  static void *GetResult(const VehicleClosestRayResultCallback &rayCallback,
+                         btVehicleRaycasterResult &result)
+  {
+    if (rayCallback.hasHit()) {
+      const btRigidBody *body = btRigidBody::upcast(rayCallback.m_collisionObject);
+      if (body && body->hasContactResponse()) {
+        result.m_hitPointInWorld = rayCallback.m_hitPointWorld;
+        result.m_hitNormalInWorld = rayCallback.m_hitNormalWorld;
+        result.m_hitNormalInWorld.normalize();
+        result.m_distFraction = rayCallback.m_closestHitFraction;
+        return (void *)body;
+      }
+    }
+    return nullptr;
+  }
 
  public:
-  BlenderVehicleRaycaster(btDynamicsWorld *world)
+  BlenderVehicleRaycaster(btDynamicsWorld *world, CcdPhysicsEnvironment *physEnv)
       : btDefaultVehicleRaycaster(world),
         m_dynamicsWorld(world),
+        m_physEnv(physEnv),
         m_mask((1 << OB_MAX_COL_MASKS) - 1)
   {
   }
@@ -143,27 +307,27 @@ class BlenderVehicleRaycaster : public btDefaultVehicleRaycaster {
                         const btVector3 &to,
                         btVehicleRaycasterResult &result)
   {
-    //	RayResultCallback& resultCallback;
+    if (!m_physEnv->m_vehicleRaysCast) {
+      m_physEnv->CastVehicleRays();
+    }
 
-    VehicleClosestRayResultCallback rayCallback(from, to, m_mask);
+    // Rays are computed the same way by the vehicle and CastVehicleRays().
+    for (const WheelRay &ray : m_wheelRays) {
+      if (ray.m_from == from && ray.m_to == to) {
+        return GetResult(ray.m_callback, result);
+      }
+    }
 
-    // We override btDefaultVehicleRaycaster so we can set this flag, otherwise our
-    // vehicles go crazy (http://bulletphysics.org/Bullet/phpBB3/viewtopic.php?t=9662)
-    rayCallback.m_flags |= btTriangleRaycastCallback::kF_UseSubSimplexConvexCastRaytest;
+    // Unexpected ray, cast it now.
+    WheelRay ray(from, to, m_mask);
+    m_dynamicsWorld->rayTest(from, to, ray.m_callback);
 
-    m_dynamicsWorld->rayTest(from, to, rayCallback);
+    return GetResult(ray.m_callback, result);
+  }
 
-    if (rayCallback.hasHit()) {
-      const btRigidBody *body = btRigidBody::upcast(rayCallback.m_collisionObject);
-      if (body && body->hasContactResponse()) {
-        result.m_hitPointInWorld = rayCallback.m_hitPointWorld;
-        result.m_hitNormalInWorld = rayCallback.m_hitNormalWorld;
-        result.m_hitNormalInWorld.normalize();
-        result.m_distFraction = rayCallback.m_closestHitFraction;
-        return (void *)body;
-      }
-    }
-    return nullptr;
+  std::vector<WheelRay> &GetWheelRays()
+  {
+    return m_wheelRays;
   }
 
   short GetRayCastMask() const
@@ -207,6 +371,11 @@ class WrapperVehicle : public PHY_IVehicle {
     return m_vehicle;
   }
 
+  BlenderVehicleRaycaster *GetRaycaster()
+  {
+    return m_raycaster;
+  }
+
   PHY_IPhysicsController *GetChassis()
   {
     return m_chassis;
@@ -401,6 +570,8 @@ CcdPhysicsEnvironment::CcdPhysicsEnvironment(bool useDbvtCulling,
       m_linearDeactivationThreshold(0.8f),
       m_angularDeactivationThreshold(1.0f),
       m_contactBreakingThreshold(0.02f),
+      m_vehicleRaysCast(false),
+      m_lastStateId(0),
       m_solver(nullptr),
       m_ownPairCache(nullptr),
       m_filterCallback(nullptr),
@@ -458,6 +629,10 @@ void CcdPhysicsEnvironment::AddCcdPhysicsController(CcdPhysicsController *ctrl)
     return;
   }
 
+  if (ctrl->m_stateId == 0) {
+    ctrl->m_stateId = ++m_lastStateId;
+  }
+
   btRigidBody *body = ctrl->GetRigidBody();
   btCollisionObject *obj = ctrl->GetCollisionObject();
 
@@ -582,6 +757,12 @@ bool CcdPhysicsEnvironment::RemoveCcdPhysicsController(CcdPhysicsController *ctr
     return false;
   }
 
+  // The body of a merged controller is not in the world, only its part must be removed.
+  if (ctrl->m_staticBatch) {
+    RemoveFromStaticBatch(ctrl, false);
+    return true;
+  }
+
   // also remove constraint
   btRigidBody *body = ctrl->GetRigidBody();
   if (body) {
@@ -630,6 +811,8 @@ void CcdPhysicsEnvironment::UpdateCcdPhysicsController(CcdPhysicsController *ctr
 {
   // this function is used when the collisionning group of a controller is changed
   // remove and add the collistioning object
+  ctrl->LeaveStaticBatch();
+
   btRigidBody *body = ctrl->GetRigidBody();
   btSoftBody *softBody = ctrl->GetSoftBody();
   btCollisionObject *obj = ctrl->GetCollisionObject();
@@ -743,6 +926,9 @@ void CcdPhysicsEnvironment::SimulationSubtickCallback(btScalar timeStep)
 {
   std::set<CcdPhysicsController *>::iterator it;
 
+  // The bodies moved, the wheel rays must be cast again at the next tick.
+  m_vehicleRaysCast = false;
+
   for (it = m_controllers.begin(); it != m_controllers.end(); it++) {
     (*it)->SimulationTick(timeStep);
   }
@@ -761,7 +947,10 @@ bool CcdPhysicsEnvironment::ProceedDeltaTime(double curTime, float timeStep, flo
     (*it)->SynchronizeMotionStates(timeStep);
   }
 
+  UpdateStaticBatches();
+
   float subStep = timeStep / float(m_numTimeSubSteps);
+  m_vehicleRaysCast = false;
   i = m_dynamicsWorld->stepSimulation(
       interval, 25, subStep);  // perform always a full simulation step
   // uncomment next line to see where Bullet spend its time (printf in console)
@@ -793,14 +982,42 @@ class ClosestRayResultCallbackNotMe : public btCollisionWorld::ClosestRayResultC
   btCollisionObject *m_parent;
 
  public:
+  /// Controller of the closest hit, the part controller for static batches.
+  CcdPhysicsController *m_hitController;
+
   ClosestRayResultCallbackNotMe(const btVector3 &rayFromWorld,
                                 const btVector3 &rayToWorld,
                                 btCollisionObject *owner,
                                 btCollisionObject *parent)
       : btCollisionWorld::ClosestRayResultCallback(rayFromWorld, rayToWorld),
         m_owner(owner),
-        m_parent(parent)
+        m_parent(parent),
+        m_hitController(nullptr)
+  {
+  }
+
+  virtual btScalar addSingleResult(btCollisionWorld::LocalRayResult &rayResult,
+                                   bool normalInWorldSpace)
   {
+    const btCollisionObject *object = rayResult.m_collisionObject;
+    if (CcdStaticBatch::IsStaticBatch(object)) {
+      const CcdStaticBatch *batch = static_cast<const CcdStaticBatch *>(object);
+      CcdPhysicsController *partCtrl = rayResult.m_localShapeInfo ?
+                                           batch->GetPartController(
+                                               rayResult.m_localShapeInfo->m_shapePart) :
+                                           nullptr;
+      // Removed parts stay in the batch tree until it is rebuilt.
+      if (!partCtrl) {
+        return m_closestHitFraction;
+      }
+      m_hitController = partCtrl;
+    }
+    else {
+      m_hitController = static_cast<CcdPhysicsController *>(object->getUserPointer());
+    }
+
+    return btCollisionWorld::ClosestRayResultCallback::addSingleResult(rayResult,
+                                                                      normalInWorldSpace);
   }
 
   virtual bool needsCollision(btBroadphaseProxy *proxy0) const
@@ -818,132 +1035,189 @@ class ClosestRayResultCallbackNotMe : public btCollisionWorld::ClosestRayResultC
 
 void CcdPhysicsEnvironment::ProcessFhSprings(double curTime, float interval)
 {
-  std::set<CcdPhysicsController *>::iterator it;
-
   const float step = interval * KX_GetActiveEngine()->GetTicRate();
 
-  for (it = m_controllers.begin(); it != m_controllers.end(); it++) {
-    CcdPhysicsController *ctrl = (*it);
+  // re-implement SM_FhObject.cpp using btCollisionWorld::rayTest and info from
+  // ctrl->getConstructionInfo() send a ray from {0.0, 0.0, 0.0} towards {0.0, 0.0, -10.0}, in
+  // local coordinates
+  btVector3 rayDirLocal(0.0f, 0.0f, -10.0f);
+
+  std::vector<CcdPhysicsController *> controllers;
+  std::vector<ClosestRayResultCallbackNotMe> callbacks;
+
+  /* The rays of all the objects are gathered and cast in parallel first,
+   * the world is then modified only while applying the spring forces. */
+  for (CcdPhysicsController *ctrl : m_controllers) {
     btRigidBody *body = ctrl->GetRigidBody();
 
     if (body && (ctrl->GetConstructionInfo().m_do_fh || ctrl->GetConstructionInfo().m_do_rot_fh)) {
-      // re-implement SM_FhObject.cpp using btCollisionWorld::rayTest and info from
-      // ctrl->getConstructionInfo() send a ray from {0.0, 0.0, 0.0} towards {0.0, 0.0, -10.0}, in
-      // local coordinates
-      CcdPhysicsController *parentCtrl = ctrl->GetParentCtrl();
-      btRigidBody *parentBody = parentCtrl ? parentCtrl->GetRigidBody() : nullptr;
-      btRigidBody *cl_object = parentBody ? parentBody : body;
-
       if (body->isStaticOrKinematicObject())
         continue;
 
-      btVector3 rayDirLocal(0.0f, 0.0f, -10.0f);
+      CcdPhysicsController *parentCtrl = ctrl->GetParentCtrl();
+      btRigidBody *parentBody = parentCtrl ? parentCtrl->GetRigidBody() : nullptr;
 
-      // m_dynamicsWorld
-      // ctrl->GetRigidBody();
       btVector3 rayFromWorld = body->getCenterOfMassPosition();
       // btVector3	rayToWorld = rayFromWorld + body->getCenterOfMassTransform().getBasis() *
       // rayDirLocal; ray always points down the z axis in world space...
       btVector3 rayToWorld = rayFromWorld + rayDirLocal;
 
-      ClosestRayResultCallbackNotMe resultCallback(rayFromWorld, rayToWorld, body, parentBody);
+      controllers.push_back(ctrl);
+      callbacks.emplace_back(rayFromWorld, rayToWorld, body, parentBody);
+    }
+  }
+
+  if (controllers.empty()) {
+    return;
+  }
 
-      m_dynamicsWorld->rayTest(rayFromWorld, rayToWorld, resultCallback);
-      if (resultCallback.hasHit()) {
-        // we hit this one: resultCallback.m_collisionObject;
-        CcdPhysicsController *controller = static_cast<CcdPhysicsController *>(
-            resultCallback.m_collisionObject->getUserPointer());
+  std::vector<ConcurrentRayTest> tests(callbacks.size());
+  for (unsigned int i = 0, size = callbacks.size(); i < size; ++i) {
+    tests[i] = {callbacks[i].m_rayFromWorld, callbacks[i].m_rayToWorld, &callbacks[i]};
+  }
+  RayTestParallel(m_broadphase, m_rayTestShapeMutex, tests);
 
-        if (controller) {
-          if (controller->GetConstructionInfo().m_fh_distance < SIMD_EPSILON)
-            continue;
+  for (unsigned int i = 0, size = controllers.size(); i < size; ++i) {
+    CcdPhysicsController *ctrl = controllers[i];
+    const ClosestRayResultCallbackNotMe &resultCallback = callbacks[i];
 
-          btRigidBody *hit_object = controller->GetRigidBody();
-          if (!hit_object)
-            continue;
+    CcdPhysicsController *parentCtrl = ctrl->GetParentCtrl();
+    btRigidBody *parentBody = parentCtrl ? parentCtrl->GetRigidBody() : nullptr;
+    btRigidBody *cl_object = parentBody ? parentBody : ctrl->GetRigidBody();
 
-          CcdConstructionInfo &hitObjShapeProps = controller->GetConstructionInfo();
+    if (resultCallback.hasHit()) {
+      // we hit this one: resultCallback.m_collisionObject;
+      CcdPhysicsController *controller = resultCallback.m_hitController;
 
-          float distance = resultCallback.m_closestHitFraction * rayDirLocal.length() -
-                           ctrl->GetConstructionInfo().m_radius;
-          if (distance >= hitObjShapeProps.m_fh_distance)
-            continue;
+      if (controller) {
+        if (controller->GetConstructionInfo().m_fh_distance < SIMD_EPSILON)
+          continue;
 
-          // btVector3 ray_dir = cl_object->getCenterOfMassTransform().getBasis()*
-          // rayDirLocal.normalized();
-          btVector3 ray_dir = rayDirLocal.normalized();
-          btVector3 normal = resultCallback.m_hitNormalWorld;
-          normal.normalize();
+        btRigidBody *hit_object = controller->GetRigidBody();
+        if (!hit_object)
+          continue;
 
-          if (ctrl->GetConstructionInfo().m_do_fh) {
-            btVector3 lspot = cl_object->getCenterOfMassPosition() +
-                              rayDirLocal * resultCallback.m_closestHitFraction;
+        CcdConstructionInfo &hitObjShapeProps = controller->GetConstructionInfo();
 
-            lspot -= hit_object->getCenterOfMassPosition();
-            btVector3 rel_vel = cl_object->getLinearVelocity() -
-                                hit_object->getVelocityInLocalPoint(lspot);
-            btScalar rel_vel_ray = ray_dir.dot(rel_vel);
-            btScalar spring_extent = 1.0f - distance / hitObjShapeProps.m_fh_distance;
+        float distance = resultCallback.m_closestHitFraction * rayDirLocal.length() -
+                         ctrl->GetConstructionInfo().m_radius;
+        if (distance >= hitObjShapeProps.m_fh_distance)
+          continue;
 
-            btScalar i_spring = spring_extent * hitObjShapeProps.m_fh_spring;
-            btScalar i_damp = rel_vel_ray * hitObjShapeProps.m_fh_damping;
+        // btVector3 ray_dir = cl_object->getCenterOfMassTransform().getBasis()*
+        // rayDirLocal.normalized();
+        btVector3 ray_dir = rayDirLocal.normalized();
+        btVector3 normal = resultCallback.m_hitNormalWorld;
+        normal.normalize();
 
+        if (ctrl->GetConstructionInfo().m_do_fh) {
+          btVector3 lspot = cl_object->getCenterOfMassPosition() +
+                            rayDirLocal * resultCallback.m_closestHitFraction;
+
+          lspot -= hit_object->getCenterOfMassPosition();
+          btVector3 rel_vel = cl_object->getLinearVelocity() -
+                              hit_object->getVelocityInLocalPoint(lspot);
+          btScalar rel_vel_ray = ray_dir.dot(rel_vel);
+          btScalar spring_extent = 1.0f - distance / hitObjShapeProps.m_fh_distance;
+
+          btScalar i_spring = spring_extent * hitObjShapeProps.m_fh_spring;
+          btScalar i_damp = rel_vel_ray * hitObjShapeProps.m_fh_damping;
+
+          cl_object->setLinearVelocity(cl_object->getLinearVelocity() +
+                                       (-(i_spring + i_damp) * ray_dir) * step);
+          if (hitObjShapeProps.m_fh_normal) {
             cl_object->setLinearVelocity(cl_object->getLinearVelocity() +
-                                         (-(i_spring + i_damp) * ray_dir) * step);
-            if (hitObjShapeProps.m_fh_normal) {
-              cl_object->setLinearVelocity(cl_object->getLinearVelocity() +
-                                           (i_spring + i_damp) *
-                                               (normal - normal.dot(ray_dir) * ray_dir) * step);
-            }
+                                         (i_spring + i_damp) *
+                                             (normal - normal.dot(ray_dir) * ray_dir) * step);
+          }
 
-            btVector3 lateral = rel_vel - rel_vel_ray * ray_dir;
+          btVector3 lateral = rel_vel - rel_vel_ray * ray_dir;
 
-            if (ctrl->GetConstructionInfo().m_do_anisotropic) {
-              // Bullet basis contains no scaling/shear etc.
-              const btMatrix3x3 &lcs = cl_object->getCenterOfMassTransform().getBasis();
-              btVector3 loc_lateral = lateral * lcs;
-              const btVector3 &friction_scaling = cl_object->getAnisotropicFriction();
-              loc_lateral *= friction_scaling;
-              lateral = lcs * loc_lateral;
-            }
+          if (ctrl->GetConstructionInfo().m_do_anisotropic) {
+            // Bullet basis contains no scaling/shear etc.
+            const btMatrix3x3 &lcs = cl_object->getCenterOfMassTransform().getBasis();
+            btVector3 loc_lateral = lateral * lcs;
+            const btVector3 &friction_scaling = cl_object->getAnisotropicFriction();
+            loc_lateral *= friction_scaling;
+            lateral = lcs * loc_lateral;
+          }
 
-            btScalar rel_vel_lateral = lateral.length();
+          btScalar rel_vel_lateral = lateral.length();
 
-            if (rel_vel_lateral > SIMD_EPSILON) {
-              btScalar friction_factor = hit_object->getFriction();  // cl_object->getFriction();
+          if (rel_vel_lateral > SIMD_EPSILON) {
+            btScalar friction_factor = hit_object->getFriction();  // cl_object->getFriction();
 
-              btScalar max_friction = friction_factor * btMax(btScalar(0.0), i_spring);
+            btScalar max_friction = friction_factor * btMax(btScalar(0.0), i_spring);
 
-              btScalar rel_mom_lateral = rel_vel_lateral / cl_object->getInvMass();
+            btScalar rel_mom_lateral = rel_vel_lateral / cl_object->getInvMass();
 
-              btVector3 friction = (rel_mom_lateral > max_friction) ?
-                                       -lateral * (max_friction / rel_vel_lateral) :
-                                       -lateral;
+            btVector3 friction = (rel_mom_lateral > max_friction) ?
+                                     -lateral * (max_friction / rel_vel_lateral) :
+                                     -lateral;
 
-              cl_object->applyCentralImpulse(friction * step);
-            }
+            cl_object->applyCentralImpulse(friction * step);
           }
+        }
 
-          if (ctrl->GetConstructionInfo().m_do_rot_fh) {
-            btVector3 up2 = cl_object->getWorldTransform().getBasis().getColumn(2);
+        if (ctrl->GetConstructionInfo().m_do_rot_fh) {
+          btVector3 up2 = cl_object->getWorldTransform().getBasis().getColumn(2);
 
-            btVector3 t_spring = up2.cross(normal) * hitObjShapeProps.m_fh_spring;
-            btVector3 ang_vel = cl_object->getAngularVelocity();
+          btVector3 t_spring = up2.cross(normal) * hitObjShapeProps.m_fh_spring;
+          btVector3 ang_vel = cl_object->getAngularVelocity();
 
-            // only rotations that tilt relative to the normal are damped
-            ang_vel -= ang_vel.dot(normal) * normal;
+          // only rotations that tilt relative to the normal are damped
+          ang_vel -= ang_vel.dot(normal) * normal;
 
-            btVector3 t_damp = ang_vel * hitObjShapeProps.m_fh_damping;
+          btVector3 t_damp = ang_vel * hitObjShapeProps.m_fh_damping;
 
-            cl_object->setAngularVelocity(cl_object->getAngularVelocity() +
-                                          (t_spring - t_damp) * step);
-          }
+          cl_object->setAngularVelocity(cl_object->getAngularVelocity() +
+                                        (t_spring - t_damp) * step);
         }
       }
     }
   }
 }
 
+void CcdPhysicsEnvironment::CastVehicleRays()
+{
+  std::vector<ConcurrentRayTest> tests;
+
+  for (WrapperVehicle *wrapperVehicle : m_wrapperVehicles) {
+    btRaycastVehicle *vehicle = wrapperVehicle->GetVehicle();
+    BlenderVehicleRaycaster *raycaster = wrapperVehicle->GetRaycaster();
+    std::vector<BlenderVehicleRaycaster::WheelRay> &wheelRays = raycaster->GetWheelRays();
+    wheelRays.clear();
+
+    // The vehicle is suspended, its wheels must not be modified.
+    if (!vehicle->getRigidBody()->isInWorld()) {
+      continue;
+    }
+
+    // Same rays as btRaycastVehicle::rayCast.
+    for (int i = 0, numWheels = vehicle->getNumWheels(); i < numWheels; ++i) {
+      btWheelInfo &wheel = vehicle->getWheelInfo(i);
+      vehicle->updateWheelTransformsWS(wheel, false);
+
+      const btScalar raylen = wheel.getSuspensionRestLength() + wheel.m_wheelsRadius;
+      const btVector3 rayvector = wheel.m_raycastInfo.m_wheelDirectionWS * raylen;
+      const btVector3 &source = wheel.m_raycastInfo.m_hardPointWS;
+      const btVector3 target = source + rayvector;
+
+      wheelRays.emplace_back(source, target, raycaster->GetRayCastMask());
+    }
+  }
+
+  for (WrapperVehicle *wrapperVehicle : m_wrapperVehicles) {
+    for (BlenderVehicleRaycaster::WheelRay &ray : wrapperVehicle->GetRaycaster()->GetWheelRays()) {
+      tests.push_back({ray.m_from, ray.m_to, &ray.m_callback});
+    }
+  }
+
+  RayTestParallel(m_broadphase, m_rayTestShapeMutex, tests);
+
+  m_vehicleRaysCast = true;
+}
+
 int CcdPhysicsEnvironment::GetDebugMode() const
 {
   if (m_debugDrawer) {
@@ -1113,6 +1387,10 @@ struct FilterClosestRayResultCallback : public btCollisionWorld::ClosestRayResul
     if (!(m_collisionFilterGroup & proxy0->m_collisionFilterMask))
       return false;
     btCollisionObject *object = (btCollisionObject *)proxy0->m_clientObject;
+    // The parts of a static batch are filtered per hit.
+    if (CcdStaticBatch::IsStaticBatch(object)) {
+      return true;
+    }
     CcdPhysicsController *phyCtrl = static_cast<CcdPhysicsController *>(object->getUserPointer());
     if (phyCtrl == m_phyRayFilter.m_ignoreController)
       return false;
@@ -1124,6 +1402,27 @@ struct FilterClosestRayResultCallback : public btCollisionWorld::ClosestRayResul
   {
     // CcdPhysicsController* curHit =
     // static_cast<CcdPhysicsController*>(rayResult.m_collisionObject->getUserPointer());
+    const btCollisionObject *object = rayResult.m_collisionObject;
+    if (CcdStaticBatch::IsStaticBatch(object)) {
+      if (!rayResult.m_localShapeInfo) {
+        return m_closestHitFraction;
+      }
+      const CcdStaticBatch *batch = static_cast<const CcdStaticBatch *>(object);
+      CcdPhysicsController *phyCtrl = batch->GetPartController(
+          rayResult.m_localShapeInfo->m_shapePart);
+      if (!phyCtrl || phyCtrl == m_phyRayFilter.m_ignoreController ||
+          !m_phyRayFilter.needBroadphaseRayCast(phyCtrl)) {
+        return m_closestHitFraction;
+      }
+      /* Report the hit on the merged object, its triangle indices are the same in the batch.
+       * The normal is converted before as the merged object has its own transform. */
+      if (!normalInWorldSpace) {
+        rayResult.m_hitNormalLocal = object->getWorldTransform().getBasis() *
+                                     rayResult.m_hitNormalLocal;
+        normalInWorldSpace = true;
+      }
+      rayResult.m_collisionObject = phyCtrl->GetCollisionObject();
+    }
     // save shape information as ClosestRayResultCallback::AddSingleResult() does not do it
     if (rayResult.m_localShapeInfo) {
       m_hitTriangleShape = rayResult.m_collisionObject->getCollisionShape();
@@ -2001,6 +2300,8 @@ void CcdPhysicsEnvironment::MergeEnvironment(PHY_IPhysicsEnvironment *other_env)
     CcdPhysicsController *ctrl = (*it);
 
     other->RemoveCcdPhysicsController(ctrl, true);
+    // The identifier is only unique in the other environment.
+    ctrl->m_stateId = 0;
     this->AddCcdPhysicsController(ctrl);
   }
 }
@@ -2016,6 +2317,10 @@ CcdPhysicsEnvironment::~CcdPhysicsEnvironment()
   // delete m_dispatcher;
   delete m_dynamicsWorld;
 
+  for (CcdStaticBatch *batch : m_staticBatches) {
+    delete batch;
+  }
+
   if (nullptr != m_ownPairCache)
     delete m_ownPairCache;
 
@@ -2091,6 +2396,8 @@ void CcdPhysicsEnvironment::AddCollisionCallback(int response_class,
 bool CcdPhysicsEnvironment::RequestCollisionCallback(PHY_IPhysicsController *ctrl)
 {
   CcdPhysicsController *ccdCtrl = static_cast<CcdPhysicsController *>(ctrl);
+  // The collisions of a merged controller are reported through its batch.
+  ccdCtrl->LeaveStaticBatch();
   return ccdCtrl->Register();
 }
 
@@ -2138,13 +2445,20 @@ void CcdPhysicsEnvironment::CallbackTriggers()
       usecallback = true;
     }
 
-    if (usecallback) {
-      const CcdCollData *coll_data = new CcdCollData(manifold);
+    const btCollisionObject *other = colliding_ctrl0 ? rb1 : rb0;
+    if (usecallback && CcdStaticBatch::IsStaticBatch(other)) {
+      CallbackStaticBatchTriggers(manifold,
+                                  colliding_ctrl0 ? ctrl0 : ctrl1,
+                                  static_cast<const CcdStaticBatch *>(other));
+    }
+    else if (usecallback) {
+      // The receiver copies the contact points it needs, nothing is kept after the call.
+      const CcdCollData coll_data(manifold);
 
       m_triggerCallbacks[PHY_OBJECT_RESPONSE](m_triggerCallbacksUserPtrs[PHY_OBJECT_RESPONSE],
                                               colliding_ctrl0 ? ctrl0 : ctrl1,
                                               colliding_ctrl0 ? ctrl1 : ctrl0,
-                                              coll_data);
+                                              &coll_data);
     }
     // Bullet does not refresh the manifold contact point for object without contact response
     // may need to remove this when a newer Bullet version is integrated
@@ -2158,6 +2472,217 @@ void CcdPhysicsEnvironment::CallbackTriggers()
   }
 }
 
+void CcdPhysicsEnvironment::CallbackStaticBatchTriggers(btPersistentManifold *manifold,
+                                                        CcdPhysicsController *ctrl,
+                                                        const CcdStaticBatch *batch)
+{
+  const bool batchFirst = (manifold->getBody0() == batch);
+  const bool isSensor = ctrl->GetConstructionInfo().m_bSensor;
+  PHY_ResponseCallback broadphaseCallback = m_triggerCallbacks[PHY_BROADPH_RESPONSE];
+
+  // Sort the contact points by part, most of the manifolds touch a single part.
+  std::vector<std::pair<int, int> > points;
+  for (int i = 0, size = manifold->getNumContacts(); i < size; ++i) {
+    const btManifoldPoint &point = manifold->getContactPoint(i);
+    points.emplace_back(batchFirst ? point.m_partId0 : point.m_partId1, i);
+  }
+  std::sort(points.begin(), points.end());
+
+  std::vector<int> indices;
+  for (unsigned int i = 0, size = points.size(); i < size;) {
+    const int part = points[i].first;
+    indices.clear();
+    for (; i < size && points[i].first == part; ++i) {
+      indices.push_back(points[i].second);
+    }
+
+    CcdPhysicsController *partCtrl = batch->GetPartController(part);
+    if (!partCtrl) {
+      continue;
+    }
+    // The broadphase filter of the sensors was only applied to the batch.
+    if (isSensor && broadphaseCallback &&
+        !broadphaseCallback(
+            m_triggerCallbacksUserPtrs[PHY_BROADPH_RESPONSE], ctrl, partCtrl, nullptr)) {
+      continue;
+    }
+
+    const CcdCollData coll_data(manifold, indices);
+    m_triggerCallbacks[PHY_OBJECT_RESPONSE](
+        m_triggerCallbacksUserPtrs[PHY_OBJECT_RESPONSE], ctrl, partCtrl, &coll_data);
+  }
+}
+
+/// Return true if the collider of a controller can be merged in a static batch.
+static bool static_batch_use_controller(CcdPhysicsController *ctrl)
+{
+  btRigidBody *body = ctrl->GetRigidBody();
+  const CcdConstructionInfo &cci = ctrl->GetConstructionInfo();
+  const CcdShapeConstructionInfo *shapeInfo = ctrl->GetShapeInfo();
+
+  if (!body || !body->isInWorld() || !body->isStaticObject() || body->isKinematicObject() ||
+      (body->getCollisionFlags() & btCollisionObject::CF_NO_CONTACT_RESPONSE)) {
+    return false;
+  }
+  if (cci.m_bSensor || cci.m_bSoft || cci.m_bCharacter || cci.m_bGimpact) {
+    return false;
+  }
+  if (!shapeInfo || shapeInfo->m_shapeType != PHY_SHAPE_MESH ||
+      shapeInfo->m_triFaceArray.empty() ||
+      body->getCollisionShape()->getShapeType() != SCALED_TRIANGLE_MESH_SHAPE_PROXYTYPE) {
+    return false;
+  }
+  // Compound children keep their own body.
+  return !ctrl->GetParentCtrl();
+}
+
+/// Colliders merged in a same batch, they share the region, the filters and the material.
+struct StaticBatchKey {
+  int m_cell[3];
+  short m_filterGroup;
+  short m_filterMask;
+  unsigned short m_userGroup;
+  unsigned short m_userMask;
+  float m_friction;
+  float m_rollingFriction;
+  float m_restitution;
+  float m_margin;
+
+  bool operator<(const StaticBatchKey &other) const
+  {
+    return std::tie(m_cell[0],
+                    m_cell[1],
+                    m_cell[2],
+                    m_filterGroup,
+                    m_filterMask,
+                    m_userGroup,
+                    m_userMask,
+                    m_friction,
+                    m_rollingFriction,
+                    m_restitution,
+                    m_margin) < std::tie(other.m_cell[0],
+                                         other.m_cell[1],
+                                         other.m_cell[2],
+                                         other.m_filterGroup,
+                                         other.m_filterMask,
+                                         other.m_userGroup,
+                                         other.m_userMask,
+                                         other.m_friction,
+                                         other.m_rollingFriction,
+                                         other.m_restitution,
+                                         other.m_margin);
+  }
+};
+
+/// Size of the regions merged in a same batch.
+static const float staticBatchCellSize = 64.0f;
+
+void CcdPhysicsEnvironment::MergeStaticColliders()
+{
+  std::map<StaticBatchKey, std::vector<CcdPhysicsController *> > groups;
+
+  for (CcdPhysicsController *ctrl : m_controllers) {
+    // Objects using collision callbacks or constraints keep their own body.
+    if (ctrl->m_staticBatch || ctrl->Registered() || ctrl->getNumCcdConstraintRefs() > 0 ||
+        !static_batch_use_controller(ctrl)) {
+      continue;
+    }
+
+    btRigidBody *body = ctrl->GetRigidBody();
+    btBroadphaseProxy *handle = body->getBroadphaseHandle();
+    const btVector3 center = (handle->m_aabbMin + handle->m_aabbMax) * 0.5f;
+
+    StaticBatchKey key;
+    for (unsigned short i = 0; i < 3; ++i) {
+      key.m_cell[i] = (int)floorf(center[i] / staticBatchCellSize);
+    }
+    key.m_filterGroup = handle->m_collisionFilterGroup;
+    key.m_filterMask = handle->m_collisionFilterMask;
+    key.m_friction = body->getFriction();
+    key.m_rollingFriction = body->getRollingFriction();
+    key.m_restitution = body->getRestitution();
+    key.m_margin = body->getCollisionShape()->getMargin();
+
+    KX_GameObject *gameobj = KX_GameObject::GetClientObject(
+        (KX_ClientObjectInfo *)ctrl->GetNewClientInfo());
+    key.m_userGroup = gameobj ? gameobj->GetUserCollisionGroup() : 0;
+    key.m_userMask = gameobj ? gameobj->GetUserCollisionMask() : 0;
+
+    groups[key].push_back(ctrl);
+  }
+
+  for (const auto &pair : groups) {
+    const StaticBatchKey &key = pair.first;
+    const std::vector<CcdPhysicsController *> &group = pair.second;
+
+    // Groups are split in batches of at most CcdStaticBatch::MaxParts parts.
+    for (unsigned int start = 0, size = group.size(); start < size;
+         start += CcdStaticBatch::MaxParts) {
+      const unsigned int end = std::min(start + CcdStaticBatch::MaxParts, size);
+      // Nothing to gain from a single collider.
+      if ((end - start) < 2) {
+        continue;
+      }
+
+      const std::vector<CcdPhysicsController *> controllers(group.begin() + start,
+                                                            group.begin() + end);
+      CcdStaticBatch *batch = new CcdStaticBatch(controllers, key.m_margin);
+      for (unsigned int i = 0, numParts = controllers.size(); i < numParts; ++i) {
+        CcdPhysicsController *ctrl = controllers[i];
+        ctrl->m_staticBatch = batch;
+        ctrl->m_staticBatchPart = i;
+        m_dynamicsWorld->removeRigidBody(ctrl->GetRigidBody());
+      }
+
+      m_dynamicsWorld->addRigidBody(batch, key.m_filterGroup, key.m_filterMask);
+      batch->setActivationState(ISLAND_SLEEPING);
+      m_staticBatches.push_back(batch);
+    }
+  }
+}
+
+void CcdPhysicsEnvironment::RemoveFromStaticBatch(CcdPhysicsController *ctrl, bool addBody)
+{
+  m_staticBatchMutex.Lock();
+
+  CcdStaticBatch *batch = ctrl->m_staticBatch;
+  if (batch) {
+    batch->RemovePart(ctrl->m_staticBatchPart);
+    ctrl->m_staticBatch = nullptr;
+    ctrl->m_staticBatchPart = -1;
+
+    // The tree of the remaining parts is rebuilt once before the next simulation step.
+    if (batch->GetNumActiveParts() == 0) {
+      m_dynamicsWorld->removeRigidBody(batch);
+      m_staticBatches.erase(std::find(m_staticBatches.begin(), m_staticBatches.end(), batch));
+      delete batch;
+    }
+
+    if (addBody) {
+      m_dynamicsWorld->addRigidBody(
+          ctrl->GetRigidBody(), ctrl->GetCollisionFilterGroup(), ctrl->GetCollisionFilterMask());
+    }
+  }
+
+  m_staticBatchMutex.Unlock();
+}
+
+void CcdPhysicsEnvironment::UpdateStaticBatches()
+{
+  m_staticBatchMutex.Lock();
+
+  for (CcdStaticBatch *batch : m_staticBatches) {
+    if (batch->Update()) {
+      // The contacts with the removed parts must not be kept.
+      m_dynamicsWorld->updateSingleAabb(batch);
+      m_dynamicsWorld->getPairCache()->cleanProxyFromPairs(batch->getBroadphaseHandle(),
+                                                           m_dynamicsWorld->getDispatcher());
+    }
+  }
+
+  m_staticBatchMutex.Unlock();
+}
+
 // This call back is called before a pair is added in the cache
 // Handy to remove objects that must be ignored by sensors
 bool CcdOverlapFilterCallBack::needBroadphaseCollision(btBroadphaseProxy *proxy0,
@@ -2165,6 +2690,7 @@ bool CcdOverlapFilterCallBack::needBroadphaseCollision(btBroadphaseProxy *proxy0
 {
   btCollisionObject *colObj0, *colObj1;
   CcdPhysicsController *sensorCtrl, *objCtrl;
+  btBroadphaseProxy *sensorProxy;
 
   KX_GameObject *kxObj0 = KX_GameObject::GetClientObject(
       (KX_ClientObjectInfo *)((CcdPhysicsController *)(((btCollisionObject *)
@@ -2198,10 +2724,12 @@ bool CcdOverlapFilterCallBack::needBroadphaseCollision(btBroadphaseProxy *proxy0
     BLI_assert(!(proxy1->m_collisionFilterGroup & btBroadphaseProxy::SensorTrigger));
     colObj0 = (btCollisionObject *)proxy0->m_clientObject;
     colObj1 = (btCollisionObject *)proxy1->m_clientObject;
+    sensorProxy = proxy0;
   }
   else if (proxy1->m_collisionFilterGroup & btBroadphaseProxy::SensorTrigger) {
     colObj0 = (btCollisionObject *)proxy1->m_clientObject;
     colObj1 = (btCollisionObject *)proxy0->m_clientObject;
+    sensorProxy = proxy1;
   }
   else {
     return true;
@@ -2209,6 +2737,23 @@ bool CcdOverlapFilterCallBack::needBroadphaseCollision(btBroadphaseProxy *proxy0
   if (!colObj0 || !colObj1)
     return false;
   sensorCtrl = static_cast<CcdPhysicsController *>(colObj0->getUserPointer());
+  if (m_physEnv->m_triggerCallbacks[PHY_BROADPH_RESPONSE] &&
+      CcdStaticBatch::IsStaticBatch(colObj1)) {
+    // Test the parts overlapping the sensor, the pair is kept if one is accepted.
+    const CcdStaticBatch *batch = static_cast<const CcdStaticBatch *>(colObj1);
+    bool accepted = false;
+    for (unsigned int i = 0, size = batch->GetNumParts(); i < size; ++i) {
+      if (batch->PartOverlaps(i, sensorProxy->m_aabbMin, sensorProxy->m_aabbMax) &&
+          m_physEnv->m_triggerCallbacks[PHY_BROADPH_RESPONSE](
+              m_physEnv->m_triggerCallbacksUserPtrs[PHY_BROADPH_RESPONSE],
+              sensorCtrl,
+              batch->GetPartController(i),
+              0)) {
+        accepted = true;
+      }
+    }
+    return accepted;
+  }
   objCtrl = static_cast<CcdPhysicsController *>(colObj1->getUserPointer());
   if (m_physEnv->m_triggerCallbacks[PHY_BROADPH_RESPONSE]) {
     return m_physEnv->m_triggerCallbacks[PHY_BROADPH_RESPONSE](
@@ -2310,6 +2855,14 @@ PHY_IConstraint *CcdPhysicsEnvironment::CreateConstraint(class PHY_IPhysicsContr
   CcdPhysicsController *c0 = (CcdPhysicsController *)ctrl0;
   CcdPhysicsController *c1 = (CcdPhysicsController *)ctrl1;
 
+  // The constrained bodies must be in the world.
+  if (c0) {
+    c0->LeaveStaticBatch();
+  }
+  if (c1) {
+    c1->LeaveStaticBatch();
+  }
+
   btRigidBody *rb0 = c0 ? c0->GetRigidBody() : nullptr;
   btRigidBody *rb1 = c1 ? c1->GetRigidBody() : nullptr;
 
@@ -2617,7 +3170,7 @@ PHY_IConstraint *CcdPhysicsEnvironment::CreateConstraint(class PHY_IPhysicsContr
 PHY_IVehicle *CcdPhysicsEnvironment::CreateVehicle(PHY_IPhysicsController *ctrl)
 {
   const btRaycastVehicle::btVehicleTuning tuning = btRaycastVehicle::btVehicleTuning();
-  BlenderVehicleRaycaster *raycaster = new BlenderVehicleRaycaster(m_dynamicsWorld);
+  BlenderVehicleRaycaster *raycaster = new BlenderVehicleRaycaster(m_dynamicsWorld, this);
   btRaycastVehicle *vehicle = new btRaycastVehicle(
       tuning, ((CcdPhysicsController *)ctrl)->GetRigidBody(), raycaster);
   WrapperVehicle *wrapperVehicle = new WrapperVehicle(vehicle, raycaster, ctrl);
@@ -2705,6 +3258,295 @@ void CcdPhysicsEnvironment::ExportFile(const std::string &filename)
   }
 }
 
+/** Layout of the buffers written by CcdPhysicsEnvironment::SaveState():
+ * the header, the bodies, the constraints and the vehicles each followed by its wheels.
+ * The buffer is meant to be restored by the same build on the same machine.
+ */
+struct CcdStateHeader {
+  char m_code[4];
+  unsigned int m_version;
+  unsigned int m_numBodies;
+  unsigned int m_numConstraints;
+  unsigned int m_numVehicles;
+};
+
+struct CcdBodyState {
+  unsigned int m_id;
+  int m_activationState;
+  float m_deactivationTime;
+  btTransformFloatData m_transform;
+  btVector3FloatData m_linearVelocity;
+  btVector3FloatData m_angularVelocity;
+  btVector3FloatData m_totalForce;
+  btVector3FloatData m_totalTorque;
+};
+
+struct CcdConstraintState {
+  int m_id;
+  int m_enabled;
+  float m_breakingImpulseThreshold;
+};
+
+struct CcdVehicleState {
+  int m_id;
+  unsigned int m_numWheels;
+};
+
+struct CcdWheelState {
+  float m_steering;
+  float m_rotation;
+  float m_deltaRotation;
+  float m_engineForce;
+  float m_brake;
+  float m_suspensionLength;
+  float m_suspensionRelativeVelocity;
+  float m_suspensionForce;
+  float m_skidInfo;
+};
+
+static const char ccd_state_code[4] = {'B', 'G', 'P', 'S'};
+static const unsigned int ccd_state_version = 1;
+
+/// Return true if a body is moved by the simulation and must be saved.
+static bool state_body_is_simulated(const btRigidBody *body)
+{
+  return (body && body->isInWorld() && !body->isStaticOrKinematicObject());
+}
+
+void CcdPhysicsEnvironment::SaveState(std::vector<char> &buffer)
+{
+  CcdStateHeader header;
+  memcpy(header.m_code, ccd_state_code, sizeof(header.m_code));
+  header.m_version = ccd_state_version;
+  header.m_numBodies = 0;
+  header.m_numConstraints = m_dynamicsWorld->getNumConstraints();
+  header.m_numVehicles = m_wrapperVehicles.size();
+
+  unsigned int numWheels = 0;
+  for (CcdPhysicsController *ctrl : m_controllers) {
+    if (state_body_is_simulated(ctrl->GetRigidBody())) {
+      ++header.m_numBodies;
+    }
+  }
+  for (WrapperVehicle *wrapperVehicle : m_wrapperVehicles) {
+    numWheels += wrapperVehicle->GetNumWheels();
+  }
+
+  // Compute the size first to write the buffer without any reallocation.
+  buffer.resize(sizeof(CcdStateHeader) + header.m_numBodies * sizeof(CcdBodyState) +
+                header.m_numConstraints * sizeof(CcdConstraintState) +
+                header.m_numVehicles * sizeof(CcdVehicleState) +
+                numWheels * sizeof(CcdWheelState));
+
+  char *data = buffer.data();
+  memcpy(data, &header, sizeof(CcdStateHeader));
+  data += sizeof(CcdStateHeader);
+
+  for (CcdPhysicsController *ctrl : m_controllers) {
+    const btRigidBody *body = ctrl->GetRigidBody();
+    if (!state_body_is_simulated(body)) {
+      continue;
+    }
+
+    CcdBodyState state;
+    state.m_id = ctrl->m_stateId;
+    state.m_activationState = body->getActivationState();
+    state.m_deactivationTime = body->getDeactivationTime();
+    body->getCenterOfMassTransform().serializeFloat(state.m_transform);
+    body->getLinearVelocity().serializeFloat(state.m_linearVelocity);
+    body->getAngularVelocity().serializeFloat(state.m_angularVelocity);
+    body->getTotalForce().serializeFloat(state.m_totalForce);
+    body->getTotalTorque().serializeFloat(state.m_totalTorque);
+
+    memcpy(data, &state, sizeof(CcdBodyState));
+    data += sizeof(CcdBodyState);
+  }
+
+  for (unsigned int i = 0; i < header.m_numConstraints; ++i) {
+    const btTypedConstraint *con = m_dynamicsWorld->getConstraint(i);
+
+    CcdConstraintState state;
+    state.m_id = con->getUserConstraintId();
+    state.m_enabled = con->isEnabled();
+    state.m_breakingImpulseThreshold = con->getBreakingImpulseThreshold();
+
+    memcpy(data, &state, sizeof(CcdConstraintState));
+    data += sizeof(CcdConstraintState);
+  }
+
+  for (WrapperVehicle *wrapperVehicle : m_wrapperVehicles) {
+    btRaycastVehicle *vehicle = wrapperVehicle->GetVehicle();
+
+    CcdVehicleState state;
+    state.m_id = vehicle->getUserConstraintId();
+    state.m_numWheels = vehicle->getNumWheels();
+
+    memcpy(data, &state, sizeof(CcdVehicleState));
+    data += sizeof(CcdVehicleState);
+
+    for (unsigned int i = 0; i < state.m_numWheels; ++i) {
+      const btWheelInfo &info = vehicle->getWheelInfo(i);
+
+      CcdWheelState wheel;
+      wheel.m_steering = info.m_steering;
+      wheel.m_rotation = info.m_rotation;
+      wheel.m_deltaRotation = info.m_deltaRotation;
+      wheel.m_engineForce = info.m_engineForce;
+      wheel.m_brake = info.m_brake;
+      wheel.m_suspensionLength = info.m_raycastInfo.m_suspensionLength;
+      wheel.m_suspensionRelativeVelocity = info.m_suspensionRelativeVelocity;
+      wheel.m_suspensionForce = info.m_wheelsSuspensionForce;
+      wheel.m_skidInfo = info.m_skidInfo;
+
+      memcpy(data, &wheel, sizeof(CcdWheelState));
+      data += sizeof(CcdWheelState);
+    }
+  }
+}
+
+bool CcdPhysicsEnvironment::RestoreState(const char *data, unsigned int size)
+{
+  const char *end = data + size;
+
+  CcdStateHeader header;
+  if (size < sizeof(CcdStateHeader)) {
+    return false;
+  }
+  memcpy(&header, data, sizeof(CcdStateHeader));
+  data += sizeof(CcdStateHeader);
+
+  if (memcmp(header.m_code, ccd_state_code, sizeof(header.m_code)) != 0 ||
+      header.m_version != ccd_state_version) {
+    return false;
+  }
+
+  // Check the fixed size part, the wheels are checked while reading the vehicles.
+  const size_t fixedSize = header.m_numBodies * sizeof(CcdBodyState) +
+                           header.m_numConstraints * sizeof(CcdConstraintState) +
+                           header.m_numVehicles * sizeof(CcdVehicleState);
+  if (fixedSize > (size_t)(end - data)) {
+    return false;
+  }
+
+  std::unordered_map<unsigned int, CcdPhysicsController *> controllers(m_controllers.size());
+  for (CcdPhysicsController *ctrl : m_controllers) {
+    controllers[ctrl->m_stateId] = ctrl;
+  }
+
+  btOverlappingPairCache *pairCache = m_dynamicsWorld->getBroadphase()->getOverlappingPairCache();
+  btDispatcher *dispatcher = m_dynamicsWorld->getDispatcher();
+
+  for (unsigned int i = 0; i < header.m_numBodies; ++i) {
+    CcdBodyState state;
+    memcpy(&state, data, sizeof(CcdBodyState));
+    data += sizeof(CcdBodyState);
+
+    const std::unordered_map<unsigned int, CcdPhysicsController *>::iterator it =
+        controllers.find(state.m_id);
+    if (it == controllers.end()) {
+      continue;
+    }
+
+    CcdPhysicsController *ctrl = it->second;
+    btRigidBody *body = ctrl->GetRigidBody();
+    if (!state_body_is_simulated(body)) {
+      continue;
+    }
+
+    btTransform trans;
+    btVector3 linearVelocity, angularVelocity, totalForce, totalTorque;
+    trans.deSerializeFloat(state.m_transform);
+    linearVelocity.deSerializeFloat(state.m_linearVelocity);
+    angularVelocity.deSerializeFloat(state.m_angularVelocity);
+    totalForce.deSerializeFloat(state.m_totalForce);
+    totalTorque.deSerializeFloat(state.m_totalTorque);
+
+    // Set the velocities first as they are used for the interpolation.
+    body->setLinearVelocity(linearVelocity);
+    body->setAngularVelocity(angularVelocity);
+    body->setCenterOfMassTransform(trans);
+    body->clearForces();
+    body->applyCentralForce(totalForce);
+    body->applyTorque(totalTorque);
+    body->forceActivationState(state.m_activationState);
+    body->setDeactivationTime(state.m_deactivationTime);
+
+    /* The contacts cached since the state was saved are invalid,
+     * remove them with the pairs, they will be found again at the next step. */
+    m_dynamicsWorld->updateSingleAabb(body);
+    pairCache->cleanProxyFromPairs(body->getBroadphaseHandle(), dispatcher);
+
+    ctrl->SynchronizeMotionStates(0.0f);
+  }
+
+  if (header.m_numConstraints > 0) {
+    std::unordered_map<int, btTypedConstraint *> constraints;
+    for (unsigned int i = 0, size = m_dynamicsWorld->getNumConstraints(); i < size; ++i) {
+      btTypedConstraint *con = m_dynamicsWorld->getConstraint(i);
+      constraints[con->getUserConstraintId()] = con;
+    }
+
+    for (unsigned int i = 0; i < header.m_numConstraints; ++i) {
+      CcdConstraintState state;
+      memcpy(&state, data, sizeof(CcdConstraintState));
+      data += sizeof(CcdConstraintState);
+
+      const std::unordered_map<int, btTypedConstraint *>::iterator it = constraints.find(
+          state.m_id);
+      if (it != constraints.end()) {
+        it->second->setEnabled(state.m_enabled);
+        it->second->setBreakingImpulseThreshold(state.m_breakingImpulseThreshold);
+      }
+    }
+  }
+
+  for (unsigned int i = 0; i < header.m_numVehicles; ++i) {
+    CcdVehicleState state;
+    if ((size_t)(end - data) < sizeof(CcdVehicleState)) {
+      return false;
+    }
+    memcpy(&state, data, sizeof(CcdVehicleState));
+    data += sizeof(CcdVehicleState);
+
+    if (state.m_numWheels * sizeof(CcdWheelState) > (size_t)(end - data)) {
+      return false;
+    }
+
+    const CcdWheelState *wheels = (const CcdWheelState *)data;
+    data += state.m_numWheels * sizeof(CcdWheelState);
+
+    WrapperVehicle *wrapperVehicle = static_cast<WrapperVehicle *>(
+        GetVehicleConstraint(state.m_id));
+    // The wheels changed since the state was saved.
+    if (!wrapperVehicle || wrapperVehicle->GetNumWheels() != (int)state.m_numWheels) {
+      continue;
+    }
+
+    btRaycastVehicle *vehicle = wrapperVehicle->GetVehicle();
+    for (unsigned int j = 0; j < state.m_numWheels; ++j) {
+      CcdWheelState wheel;
+      memcpy(&wheel, &wheels[j], sizeof(CcdWheelState));
+
+      btWheelInfo &info = vehicle->getWheelInfo(j);
+      info.m_steering = wheel.m_steering;
+      info.m_rotation = wheel.m_rotation;
+      info.m_deltaRotation = wheel.m_deltaRotation;
+      info.m_engineForce = wheel.m_engineForce;
+      info.m_brake = wheel.m_brake;
+      info.m_raycastInfo.m_suspensionLength = wheel.m_suspensionLength;
+      info.m_suspensionRelativeVelocity = wheel.m_suspensionRelativeVelocity;
+      info.m_wheelsSuspensionForce = wheel.m_suspensionForce;
+      info.m_skidInfo = wheel.m_skidInfo;
+    }
+
+    wrapperVehicle->SyncWheels();
+  }
+
+  m_vehicleRaysCast = false;
+
+  return true;
+}
+
 struct BlenderDebugDraw : public btIDebugDraw {
   BlenderDebugDraw() : m_debugMode(0)
   {
@@ -3310,59 +4152,70 @@ CcdCollData::CcdCollData(const btPersistentManifold *manifoldPoint)
 {
 }
 
+CcdCollData::CcdCollData(const btPersistentManifold *manifoldPoint,
+                         const std::vector<int> &indices)
+    : m_manifoldPoint(manifoldPoint), m_indices(indices)
+{
+}
+
 CcdCollData::~CcdCollData()
 {
 }
 
+const btManifoldPoint &CcdCollData::GetContactPoint(unsigned int index) const
+{
+  return m_manifoldPoint->getContactPoint(m_indices.empty() ? index : m_indices[index]);
+}
+
 unsigned int CcdCollData::GetNumContacts() const
 {
-  return m_manifoldPoint->getNumContacts();
+  return m_indices.empty() ? m_manifoldPoint->getNumContacts() : m_indices.size();
 }
 
 MT_Vector3 CcdCollData::GetLocalPointA(unsigned int index, bool first) const
 {
-  const btManifoldPoint &point = m_manifoldPoint->getContactPoint(index);
+  const btManifoldPoint &point = GetContactPoint(index);
   return MT_Vector3(first ? point.m_localPointA.m_floats : point.m_localPointB.m_floats);
 }
 
 MT_Vector3 CcdCollData::GetLocalPointB(unsigned int index, bool first) const
 {
-  const btManifoldPoint &point = m_manifoldPoint->getContactPoint(index);
+  const btManifoldPoint &point = GetContactPoint(index);
   return MT_Vector3(first ? point.m_localPointB.m_floats : point.m_localPointA.m_floats);
 }
 
 MT_Vector3 CcdCollData::GetWorldPoint(unsigned int index, bool first) const
 {
-  const btManifoldPoint &point = m_manifoldPoint->getContactPoint(index);
+  const btManifoldPoint &point = GetContactPoint(index);
   return MT_Vector3(point.m_positionWorldOnB.m_floats);
 }
 
 MT_Vector3 CcdCollData::GetNormal(unsigned int index, bool first) const
 {
-  const btManifoldPoint &point = m_manifoldPoint->getContactPoint(index);
+  const btManifoldPoint &point = GetContactPoint(index);
   return MT_Vector3(first ? (-point.m_normalWorldOnB).m_floats : point.m_normalWorldOnB.m_floats);
 }
 
 float CcdCollData::GetCombinedFriction(unsigned int index, bool first) const
 {
-  const btManifoldPoint &point = m_manifoldPoint->getContactPoint(index);
+  const btManifoldPoint &point = GetContactPoint(index);
   return point.m_combinedFriction;
 }
 
 float CcdCollData::GetCombinedRollingFriction(unsigned int index, bool first) const
 {
-  const btManifoldPoint &point = m_manifoldPoint->getContactPoint(index);
+  const btManifoldPoint &point = GetContactPoint(index);
   return point.m_combinedRollingFriction;
 }
 
 float CcdCollData::GetCombinedRestitution(unsigned int index, bool first) const
 {
-  const btManifoldPoint &point = m_manifoldPoint->getContactPoint(index);
+  const btManifoldPoint &point = GetContactPoint(index);
   return point.m_combinedRestitution;
 }
 
 float CcdCollData::GetAppliedImpulse(unsigned int index, bool first) const
 {
-  const btManifoldPoint &point = m_manifoldPoint->getContactPoint(index);
+  const btManifoldPoint &point = GetContactPoint(index);
   return point.m_appliedImpulse;
 }
@@ -30,6 +30,8 @@
 
 #include "CcdPhysicsController.h"
 
+#include "CM_Thread.h"
+
 #include <vector>
 #include <set>
 #include <map>
@@ -45,6 +47,7 @@ class btDispatcher;
 #include "BulletDynamics/ConstraintSolver/btContactSolverInfo.h"
 
 class WrapperVehicle;
+class BlenderVehicleRaycaster;
 class btPersistentManifold;
 class btBroadphaseInterface;
 struct btDbvtBroadphase;
@@ -54,6 +57,7 @@ class btDynamicsWorld;
 class PHY_IVehicle;
 class CcdOverlapFilterCallBack;
 class CcdShapeConstructionInfo;
+class CcdStaticBatch;
 
 /** CcdPhysicsEnvironment is an experimental mainloop for physics simulation using optional
  * continuous collision detection. Physics Environment takes care of stepping the simulation and is
@@ -62,6 +66,7 @@ class CcdShapeConstructionInfo;
  */
 class CcdPhysicsEnvironment : public PHY_IPhysicsEnvironment {
   friend class CcdOverlapFilterCallBack;
+  friend class BlenderVehicleRaycaster;
   btVector3 m_gravity;
 
   /// Removes the constraint and his references from the owner and the target.
@@ -96,7 +101,31 @@ class CcdPhysicsEnvironment : public PHY_IPhysicsEnvironment {
   float m_angularDeactivationThreshold;
   float m_contactBreakingThreshold;
 
+  /// True when the wheel rays of all the vehicles were cast for the current simulation tick.
+  bool m_vehicleRaysCast;
+  /// Serialize the ray tests of gimpact shapes in the parallel ray batches.
+  CM_ThreadMutex m_rayTestShapeMutex;
+  /// Last identifier given to a controller for the saved states.
+  unsigned int m_lastStateId;
+
+  /// Batches of merged static colliders, see MergeStaticColliders().
+  std::vector<CcdStaticBatch *> m_staticBatches;
+  /// Protect the batches, controllers can leave them during the threaded animation update.
+  CM_ThreadMutex m_staticBatchMutex;
+
   void ProcessFhSprings(double curTime, float timeStep);
+  /** Cast the rays of all the vehicle wheels in parallel, the results are read back by
+   * the vehicles raycasters during the update of the vehicles actions.
+   */
+  void CastVehicleRays();
+  /// Rebuild the batches whose parts were removed since the last simulation step.
+  void UpdateStaticBatches();
+  /** Call the collision callback for each part of a static batch colliding with a registered
+   * controller.
+   */
+  void CallbackStaticBatchTriggers(btPersistentManifold *manifold,
+                                   CcdPhysicsController *ctrl,
+                                   const CcdStaticBatch *batch);
 
  public:
   CcdPhysicsEnvironment(bool useDbvtCulling,
@@ -333,13 +362,28 @@ class CcdPhysicsEnvironment : public PHY_IPhysicsEnvironment {
   class btDispatcher *m_ownDispatcher;
 
   virtual void ExportFile(const std::string &filename);
+
+  virtual void SaveState(std::vector<char> &buffer);
+  virtual bool RestoreState(const char *data, unsigned int size);
+
+ public:
+  virtual void MergeStaticColliders();
+  /** Remove a controller from its static batch.
+   * \param addBody Add back the own rigid body of the controller in the world.
+   */
+  void RemoveFromStaticBatch(CcdPhysicsController *ctrl, bool addBody);
 };
 
 class CcdCollData : public PHY_CollData {
   const btPersistentManifold *m_manifoldPoint;
+  /// Indices of the used contact points, all the points are used if empty.
+  std::vector<int> m_indices;
+
+  const btManifoldPoint &GetContactPoint(unsigned int index) const;
 
  public:
   CcdCollData(const btPersistentManifold *manifoldPoint);
+  CcdCollData(const btPersistentManifold *manifoldPoint, const std::vector<int> &indices);
   virtual ~CcdCollData();
 
   virtual unsigned int GetNumContacts() const;
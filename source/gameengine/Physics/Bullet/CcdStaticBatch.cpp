@@ -0,0 +1,169 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file gameengine/Physics/Bullet/CcdStaticBatch.cpp
+ *  \ingroup physbullet
+ */
+
+#include "CcdStaticBatch.h"
+#include "CcdPhysicsController.h"
+
+#include "BLI_utildefines.h"
+
+CcdStaticBatch::CcdStaticBatch(const std::vector<CcdPhysicsController *> &controllers,
+                               btScalar margin)
+    : btRigidBody(btRigidBodyConstructionInfo(0.0f, nullptr, nullptr)),
+      m_numActiveParts(0),
+      m_dirty(false)
+{
+  BLI_assert(!controllers.empty() && controllers.size() <= MaxParts);
+
+  // The indexed meshes point in the arrays, they must not be reallocated.
+  int numVertices = 0;
+  unsigned int numIndices = 0;
+  for (CcdPhysicsController *ctrl : controllers) {
+    const CcdShapeConstructionInfo *shapeInfo = ctrl->GetShapeInfo();
+    numVertices += shapeInfo->m_vertexArray.size();
+    numIndices += shapeInfo->m_triFaceArray.size();
+  }
+  m_vertexArray.reserve(numVertices);
+  m_triFaceArray.reserve(numIndices);
+
+  m_meshInterface = new btTriangleIndexVertexArray();
+
+  for (CcdPhysicsController *ctrl : controllers) {
+    const CcdShapeConstructionInfo *shapeInfo = ctrl->GetShapeInfo();
+    const btCollisionObject *object = ctrl->GetCollisionObject();
+    const btTransform &xform = object->getWorldTransform();
+    const btVector3 &scaling = object->getCollisionShape()->getLocalScaling();
+
+    Part part;
+    part.m_ctrl = ctrl;
+    part.m_aabbMin.setValue(BT_LARGE_FLOAT, BT_LARGE_FLOAT, BT_LARGE_FLOAT);
+    part.m_aabbMax.setValue(-BT_LARGE_FLOAT, -BT_LARGE_FLOAT, -BT_LARGE_FLOAT);
+
+    const unsigned int firstVertex = m_vertexArray.size();
+    for (int i = 0, size = shapeInfo->m_vertexArray.size(); i < size; i += 3) {
+      const btScalar *co = &shapeInfo->m_vertexArray[i];
+      const btVector3 point = xform(btVector3(co[0], co[1], co[2]) * scaling);
+      part.m_aabbMin.setMin(point);
+      part.m_aabbMax.setMax(point);
+      m_vertexArray.push_back(point.x());
+      m_vertexArray.push_back(point.y());
+      m_vertexArray.push_back(point.z());
+    }
+
+    const unsigned int firstIndex = m_triFaceArray.size();
+    m_triFaceArray.insert(
+        m_triFaceArray.end(), shapeInfo->m_triFaceArray.begin(), shapeInfo->m_triFaceArray.end());
+
+    btIndexedMesh mesh;
+    mesh.m_numTriangles = shapeInfo->m_triFaceArray.size() / 3;
+    mesh.m_triangleIndexBase = (const unsigned char *)&m_triFaceArray[firstIndex];
+    mesh.m_triangleIndexStride = 3 * sizeof(int);
+    mesh.m_numVertices = (m_vertexArray.size() - firstVertex) / 3;
+    mesh.m_vertexBase = (const unsigned char *)&m_vertexArray[firstVertex];
+    mesh.m_vertexStride = 3 * sizeof(btScalar);
+    m_meshInterface->addIndexedMesh(mesh, PHY_INTEGER);
+
+    m_parts.push_back(part);
+    ++m_numActiveParts;
+  }
+
+  m_shape = new btBvhTriangleMeshShape(m_meshInterface, true);
+  m_shape->setMargin(margin);
+  setCollisionShape(m_shape);
+  setCollisionFlags(getCollisionFlags() | CF_STATIC_OBJECT);
+  setUserIndex(UserIndex);
+
+  // Use the material of the first part, all the parts share it.
+  const btCollisionObject *first = controllers.front()->GetCollisionObject();
+  setFriction(first->getFriction());
+  setRollingFriction(first->getRollingFriction());
+  setRestitution(first->getRestitution());
+  // Anything reading the user pointer without knowing about batches gets a valid controller.
+  setUserPointer(controllers.front());
+}
+
+CcdStaticBatch::~CcdStaticBatch()
+{
+  delete m_shape;
+  delete m_meshInterface;
+}
+
+unsigned int CcdStaticBatch::GetNumParts() const
+{
+  return m_parts.size();
+}
+
+unsigned int CcdStaticBatch::GetNumActiveParts() const
+{
+  return m_numActiveParts;
+}
+
+CcdPhysicsController *CcdStaticBatch::GetPartController(int part) const
+{
+  if (part < 0 || part >= (int)m_parts.size()) {
+    return nullptr;
+  }
+  return m_parts[part].m_ctrl;
+}
+
+bool CcdStaticBatch::PartOverlaps(int part,
+                                  const btVector3 &aabbMin,
+                                  const btVector3 &aabbMax) const
+{
+  const Part &data = m_parts[part];
+  return data.m_ctrl && TestAabbAgainstAabb2(aabbMin, aabbMax, data.m_aabbMin, data.m_aabbMax);
+}
+
+void CcdStaticBatch::RemovePart(int part)
+{
+  Part &data = m_parts[part];
+  if (!data.m_ctrl) {
+    return;
+  }
+
+  data.m_ctrl = nullptr;
+  --m_numActiveParts;
+
+  m_meshInterface->getIndexedMeshArray()[part].m_numTriangles = 0;
+  m_dirty = true;
+
+  // Keep a valid controller in the user pointer.
+  for (const Part &other : m_parts) {
+    if (other.m_ctrl) {
+      setUserPointer(other.m_ctrl);
+      break;
+    }
+  }
+}
+
+bool CcdStaticBatch::Update()
+{
+  if (!m_dirty || m_numActiveParts == 0) {
+    return false;
+  }
+
+  m_shape->recalcLocalAabb();
+  m_shape->buildOptimizedBvh();
+  m_dirty = false;
+  return true;
+}
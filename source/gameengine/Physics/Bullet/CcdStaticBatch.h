@@ -0,0 +1,100 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file gameengine/Physics/Bullet/CcdStaticBatch.h
+ *  \ingroup physbullet
+ */
+
+#ifndef __CCD_STATIC_BATCH_H__
+#define __CCD_STATIC_BATCH_H__
+
+#include "btBulletDynamicsCommon.h"
+#include "BulletCollision/BroadphaseCollision/btQuantizedBvh.h"
+
+#include <vector>
+
+class CcdPhysicsController;
+
+/** Static rigid body merging the triangle mesh colliders of several static controllers.
+ *
+ * Each merged controller is a part of the batch mesh, the part index is stored in the contact
+ * points and ray results (m_partId, m_shapePart) and is used to retrieve the original
+ * controller. The triangles of a part are kept in the order of its shape construction info so
+ * that the triangle indices remain valid for the original controller.
+ * The original rigid bodies are removed from the world but kept up to date, they are used again
+ * when a controller leaves the batch. The tree of the batch is rebuilt once by Update() after
+ * parts were removed.
+ */
+class CcdStaticBatch : public btRigidBody {
+ private:
+  struct Part {
+    CcdPhysicsController *m_ctrl;
+    btVector3 m_aabbMin;
+    btVector3 m_aabbMax;
+  };
+
+  std::vector<Part> m_parts;
+  unsigned int m_numActiveParts;
+  /// True when parts were removed since the last tree build.
+  bool m_dirty;
+
+  /// World space vertices and triangle indices of all the parts.
+  std::vector<btScalar> m_vertexArray;
+  std::vector<int> m_triFaceArray;
+
+  btTriangleIndexVertexArray *m_meshInterface;
+  btBvhTriangleMeshShape *m_shape;
+
+  static const int UserIndex = 0x42415443;
+
+ public:
+  /// Maximum number of parts, the part index is stored on MAX_NUM_PARTS_IN_BITS in the tree.
+  static const unsigned int MaxParts = (1 << MAX_NUM_PARTS_IN_BITS);
+
+  /** Create a batch from at most MaxParts controllers using a PHY_SHAPE_MESH shape, the
+   * controllers must have the same collision filter and material.
+   */
+  CcdStaticBatch(const std::vector<CcdPhysicsController *> &controllers, btScalar margin);
+  virtual ~CcdStaticBatch();
+
+  /// Return true if the collision object is a batch.
+  static bool IsStaticBatch(const btCollisionObject *object)
+  {
+    return object->getUserIndex() == UserIndex;
+  }
+
+  unsigned int GetNumParts() const;
+  unsigned int GetNumActiveParts() const;
+  /// Return the controller of a part or nullptr if the part was removed.
+  CcdPhysicsController *GetPartController(int part) const;
+  /// Return true if the part exists and its bounding box overlaps the box.
+  bool PartOverlaps(int part, const btVector3 &aabbMin, const btVector3 &aabbMax) const;
+
+  /** Remove a part, its triangles stay in the tree until the next Update() but the part
+   * controller is nullptr.
+   */
+  void RemovePart(int part);
+  /** Rebuild the tree if parts were removed, return true if it was rebuilt, in this case the
+   * caller must update the broadphase and the overlapping pairs.
+   */
+  bool Update();
+};
+
+#endif  // __CCD_STATIC_BATCH_H__
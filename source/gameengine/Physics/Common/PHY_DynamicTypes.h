@@ -38,6 +38,21 @@ enum {
   PHY_NUM_RESPONSE
 };
 
+/// Contact point of a collision pair, expressed for the first object of the pair.
+struct PHY_ContactPoint {
+  MT_Vector3 m_localPointA;
+  MT_Vector3 m_localPointB;
+  MT_Vector3 m_worldPoint;
+  MT_Vector3 m_normal;
+  float m_combinedFriction;
+  float m_combinedRollingFriction;
+  float m_combinedRestitution;
+  float m_appliedImpulse;
+};
+
+/** Contact points of a collision pair, only valid during the response callback.
+ * The receiver must copy the data it wants to keep.
+ */
 class PHY_CollData {
  public:
   PHY_CollData()
@@ -39,6 +39,7 @@
 #include "MT_Vector4.h"
 
 #include <array>
+#include <vector>
 
 class PHY_IConstraint;
 class PHY_IVehicle;
@@ -257,6 +258,26 @@ class PHY_IPhysicsEnvironment {
 
   virtual void ExportFile(const std::string &filename){};
 
+  /// Write the state of the simulated objects into a buffer, see RestoreState().
+  virtual void SaveState(std::vector<char> &buffer)
+  {
+  }
+  /** Restore the state of the objects saved by SaveState(), the objects
+   * created or removed since are ignored.
+   * \return False if the buffer is not a valid state.
+   */
+  virtual bool RestoreState(const char *data, unsigned int size)
+  {
+    return false;
+  }
+
+  /** Merge the static triangle mesh colliders of a same region into shared colliders,
+   * called once the scene is converted and the collision sensors are registered.
+   */
+  virtual void MergeStaticColliders()
+  {
+  }
+
   virtual void MergeEnvironment(PHY_IPhysicsEnvironment *other_env) = 0;
 
   virtual void ConvertObject(KX_BlenderSceneConverter &converter,
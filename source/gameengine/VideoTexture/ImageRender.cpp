@@ -387,6 +387,12 @@ static int ImageRender_init(PyObject *pySelf, PyObject *args, PyObject *kwds)
   // camera object
   PyObject *camera;
 
+  // Rendering to a texture requires the rasterizer, missing in the headless player.
+  if (!KX_GetActiveEngine()->GetRasterizer()) {
+    PyErr_SetString(PyExc_RuntimeError, "ImageRender: Rasterizer not available");
+    return -1;
+  }
+
   RAS_ICanvas *canvas = KX_GetActiveEngine()->GetCanvas();
   int width = canvas->GetWidth();
   int height = canvas->GetHeight();
@@ -611,6 +617,11 @@ static int ImageMirror_init(PyObject *pySelf, PyObject *args, PyObject *kwds)
   // material of the mirror
   short materialID = 0;
 
+  if (!KX_GetActiveEngine()->GetRasterizer()) {
+    PyErr_SetString(PyExc_RuntimeError, "ImageMirror: Rasterizer not available");
+    return -1;
+  }
+
   RAS_ICanvas *canvas = KX_GetActiveEngine()->GetCanvas();
   int width = canvas->GetWidth();
   int height = canvas->GetHeight();
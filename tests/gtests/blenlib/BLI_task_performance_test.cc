@@ -122,6 +122,98 @@ TEST(task, RangeIter1000k)
   task_parallel_range_test_do("Range parallel iteration - Threaded - 1000K items", 1000000, true);
 }
 
+/* *** Throughput of the scheduler with small tasks. *** */
+
+static void task_pool_small_func(TaskPool *__restrict pool, void *taskdata, int thread_id)
+{
+  const int depth = POINTER_AS_INT(taskdata);
+  if (depth > 0) {
+    /* Tasks spawning tasks, pushed from the worker thread like the depsgraph does. */
+    for (int i = 0; i < 4; i++) {
+      BLI_task_pool_push_from_thread(pool,
+                                     task_pool_small_func,
+                                     POINTER_FROM_INT(depth - 1),
+                                     false,
+                                     TASK_PRIORITY_HIGH,
+                                     thread_id);
+    }
+  }
+  uint *num_done = (uint *)BLI_task_pool_userdata(pool);
+  atomic_add_and_fetch_u(num_done, 1);
+}
+
+static void task_pool_small_test_do(const int num_threads)
+{
+  /* Number of tasks: 4^0 + 4^1 + ... + 4^7 per root task. */
+  const int depth = 7;
+  const int num_roots = 16;
+  uint num_tasks_per_root = 0;
+  for (int i = 0, num = 1; i <= depth; i++, num *= 4) {
+    num_tasks_per_root += num;
+  }
+  const uint num_tasks = num_tasks_per_root * num_roots;
+
+  BLI_threadapi_init();
+  TaskScheduler *scheduler = BLI_task_scheduler_create(num_threads);
+
+  double averaged_timing = 0.0;
+  for (int i = 0; i < NUM_RUN_AVERAGED; i++) {
+    uint num_done = 0;
+    TaskPool *pool = BLI_task_pool_create(scheduler, &num_done);
+
+    const double init_time = PIL_check_seconds_timer();
+    for (int j = 0; j < num_roots; j++) {
+      BLI_task_pool_push(
+          pool, task_pool_small_func, POINTER_FROM_INT(depth), false, TASK_PRIORITY_HIGH);
+    }
+    BLI_task_pool_work_and_wait(pool);
+    averaged_timing += PIL_check_seconds_timer() - init_time;
+
+    EXPECT_EQ(num_done, num_tasks);
+    BLI_task_pool_free(pool);
+  }
+
+  printf("\t%d threads: %u tasks done in %fs on average over %d runs (%.1f Mtasks/s)\n",
+         num_threads,
+         num_tasks,
+         averaged_timing / NUM_RUN_AVERAGED,
+         NUM_RUN_AVERAGED,
+         num_tasks * NUM_RUN_AVERAGED / averaged_timing * 1e-6);
+
+  BLI_task_scheduler_free(scheduler);
+  BLI_threadapi_exit();
+}
+
+TEST(task, PoolSmallTasks2Threads)
+{
+  task_pool_small_test_do(2);
+}
+
+TEST(task, PoolSmallTasks4Threads)
+{
+  task_pool_small_test_do(4);
+}
+
+TEST(task, PoolSmallTasks8Threads)
+{
+  task_pool_small_test_do(8);
+}
+
+TEST(task, PoolSmallTasks16Threads)
+{
+  task_pool_small_test_do(16);
+}
+
+TEST(task, PoolSmallTasks32Threads)
+{
+  task_pool_small_test_do(32);
+}
+
+TEST(task, PoolSmallTasks64Threads)
+{
+  task_pool_small_test_do(64);
+}
+
 /* *** Parallel iterations over double-linked list items. *** */
 
 static void task_listbase_light_iter_func(void *UNUSED(userdata),
@@ -253,3 +253,69 @@ TEST(task, ListBaseIter)
   MEM_freeN(items_buffer);
   BLI_threadapi_exit();
 }
+
+/* *** Task pools sharing the queue of a thread. *** */
+
+static void task_pool_count_func(TaskPool *__restrict pool,
+                                 void *UNUSED(taskdata),
+                                 int UNUSED(tid))
+{
+  int *count = (int *)BLI_task_pool_userdata(pool);
+  atomic_add_and_fetch_int32((int32_t *)count, 1);
+}
+
+static void task_pool_block_func(TaskPool *__restrict pool, void *taskdata, int UNUSED(tid))
+{
+  int *started = (int *)BLI_task_pool_userdata(pool);
+  int *release = (int *)taskdata;
+  atomic_add_and_fetch_int32((int32_t *)started, 1);
+  while (atomic_add_and_fetch_int32((int32_t *)release, 0) == 0) {
+    /* Keep the worker thread busy. */
+  }
+}
+
+TEST(task, InterleavedPools)
+{
+  const int num_tasks = 100;
+  int count_a = 0, count_b = 0, started = 0, release = 0;
+
+  BLI_threadapi_init();
+
+  /* Main thread and a single worker thread. */
+  TaskScheduler *scheduler = BLI_task_scheduler_create(2);
+  TaskPool *pool_block = BLI_task_pool_create(scheduler, &started);
+  TaskPool *pool_a = BLI_task_pool_create(scheduler, &count_a);
+  TaskPool *pool_b = BLI_task_pool_create(scheduler, &count_b);
+
+  /* Occupy the worker thread, so nobody else runs the tasks of the main thread's queue. */
+  BLI_task_pool_push_from_thread(
+      pool_block, task_pool_block_func, &release, false, TASK_PRIORITY_HIGH, 0);
+  while (atomic_add_and_fetch_int32((int32_t *)&started, 0) == 0) {
+  }
+
+  /* The tasks of both pools are interleaved in the queue of the main thread, waiting for one
+   * pool must find its tasks under the tasks of the other pool. */
+  for (int i = 0; i < num_tasks; i++) {
+    BLI_task_pool_push_from_thread(
+        pool_a, task_pool_count_func, NULL, false, TASK_PRIORITY_HIGH, 0);
+    BLI_task_pool_push_from_thread(
+        pool_b, task_pool_count_func, NULL, false, TASK_PRIORITY_HIGH, 0);
+  }
+
+  BLI_task_pool_work_and_wait(pool_a);
+  EXPECT_EQ(count_a, num_tasks);
+  /* Waiting for a pool never runs the tasks of another pool. */
+  EXPECT_EQ(count_b, 0);
+
+  atomic_add_and_fetch_int32((int32_t *)&release, 1);
+
+  BLI_task_pool_work_and_wait(pool_b);
+  EXPECT_EQ(count_b, num_tasks);
+  BLI_task_pool_work_and_wait(pool_block);
+
+  BLI_task_pool_free(pool_a);
+  BLI_task_pool_free(pool_b);
+  BLI_task_pool_free(pool_block);
+  BLI_task_scheduler_free(scheduler);
+  BLI_threadapi_exit();
+}
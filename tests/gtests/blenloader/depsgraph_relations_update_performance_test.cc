@@ -0,0 +1,126 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 by Blender Foundation.
+ */
+#include "blendfile_loading_base_test.h"
+
+extern "C" {
+#include "BKE_collection.h"
+#include "BKE_lib_id.h"
+#include "BKE_object.h"
+#include "BKE_scene.h"
+
+#include "BLO_readfile.h"
+
+#include "DEG_depsgraph_build.h"
+#include "DEG_depsgraph_debug.h"
+
+#include "DNA_collection_types.h"
+#include "DNA_object_types.h"
+#include "DNA_scene_types.h"
+
+#include "PIL_time.h"
+}
+
+#define NUM_RUN_AVERAGED 20
+
+/* Compares the relations update of a graph after adding or removing an object, done
+ * incrementally, with a full rebuild of the relations, for several scene sizes. */
+class DepsgraphRelationsUpdatePerformanceTest : public BlendfileLoadingBaseTest {
+ protected:
+  Object *object_add(const char *name)
+  {
+    Main *bmain = bfile->main;
+    Object *object = BKE_object_add_only_object(bmain, OB_EMPTY, name);
+    BKE_collection_object_add(bmain, bfile->curscene->master_collection, object);
+    id_us_min(&object->id);
+    return object;
+  }
+
+  void object_remove(Object *object)
+  {
+    Main *bmain = bfile->main;
+    DEG_relations_tag_id_removed(bmain, &object->id);
+    BKE_collection_object_remove(bmain, bfile->curscene->master_collection, object, false);
+    relations_update();
+    BKE_id_free_ex(bmain, &object->id, LIB_ID_FREE_NO_DEG_TAG, true);
+  }
+
+  void relations_update()
+  {
+    BKE_scene_graph_update_tagged(depsgraph, bfile->main);
+  }
+
+  void relations_update_test_do(const int num_objects)
+  {
+    if (!blendfile_load("modifier_stack/array_test.blend")) {
+      return;
+    }
+    Main *bmain = bfile->main;
+    for (int i = 0; i < num_objects; i++) {
+      object_add("SceneObject");
+    }
+    depsgraph_create(DAG_EVAL_VIEWPORT);
+
+    double full_timing = 0.0;
+    double add_timing = 0.0;
+    double remove_timing = 0.0;
+    for (int i = 0; i < NUM_RUN_AVERAGED; i++) {
+      double init_time = PIL_check_seconds_timer();
+      DEG_graph_tag_relations_update(depsgraph);
+      relations_update();
+      full_timing += PIL_check_seconds_timer() - init_time;
+
+      init_time = PIL_check_seconds_timer();
+      Object *object = object_add("IncrementalObject");
+      DEG_relations_tag_id_added(bmain, &object->id);
+      relations_update();
+      add_timing += PIL_check_seconds_timer() - init_time;
+
+      init_time = PIL_check_seconds_timer();
+      object_remove(object);
+      remove_timing += PIL_check_seconds_timer() - init_time;
+    }
+
+    /* Make sure the incremental path was measured, not a rebuild. */
+    int num_full_builds, num_incremental_updates;
+    DEG_stats_builds(depsgraph, &num_full_builds, &num_incremental_updates);
+    EXPECT_EQ(num_full_builds, NUM_RUN_AVERAGED + 1);
+    EXPECT_EQ(num_incremental_updates, NUM_RUN_AVERAGED * 2);
+
+    printf("\t%d objects: full rebuild %fs, add %fs, remove %fs on average over %d runs\n",
+           num_objects,
+           full_timing / NUM_RUN_AVERAGED,
+           add_timing / NUM_RUN_AVERAGED,
+           remove_timing / NUM_RUN_AVERAGED,
+           NUM_RUN_AVERAGED);
+  }
+};
+
+TEST_F(DepsgraphRelationsUpdatePerformanceTest, AddRemoveObject100)
+{
+  relations_update_test_do(100);
+}
+
+TEST_F(DepsgraphRelationsUpdatePerformanceTest, AddRemoveObject1000)
+{
+  relations_update_test_do(1000);
+}
+
+TEST_F(DepsgraphRelationsUpdatePerformanceTest, AddRemoveObject10000)
+{
+  relations_update_test_do(10000);
+}
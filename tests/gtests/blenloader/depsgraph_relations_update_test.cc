@@ -0,0 +1,162 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 by Blender Foundation.
+ */
+#include "blendfile_loading_base_test.h"
+
+extern "C" {
+#include "BKE_collection.h"
+#include "BKE_lib_id.h"
+#include "BKE_object.h"
+#include "BKE_scene.h"
+
+#include "BLO_readfile.h"
+
+#include "DEG_depsgraph_build.h"
+#include "DEG_depsgraph_debug.h"
+#include "DEG_depsgraph_query.h"
+
+#include "DNA_collection_types.h"
+#include "DNA_object_types.h"
+#include "DNA_scene_types.h"
+}
+
+#define NUM_SCENE_OBJECTS 1000
+
+class DepsgraphRelationsUpdateTest : public BlendfileLoadingBaseTest {
+ protected:
+  Object *object_add(const char *name)
+  {
+    Main *bmain = bfile->main;
+    Object *object = BKE_object_add_only_object(bmain, OB_EMPTY, name);
+    BKE_collection_object_add(bmain, bfile->curscene->master_collection, object);
+    /* The collection holds the user now. */
+    id_us_min(&object->id);
+    return object;
+  }
+
+  void relations_update()
+  {
+    BKE_scene_graph_update_tagged(depsgraph, bfile->main);
+  }
+
+  bool object_is_in_depsgraph(Object *object)
+  {
+    return DEG_get_evaluated_id(depsgraph, &object->id) != &object->id;
+  }
+
+  void expect_builds(int full_builds, int incremental_updates)
+  {
+    int num_full_builds, num_incremental_updates;
+    DEG_stats_builds(depsgraph, &num_full_builds, &num_incremental_updates);
+    EXPECT_EQ(num_full_builds, full_builds);
+    EXPECT_EQ(num_incremental_updates, incremental_updates);
+  }
+
+  /* Compare the graph with one built from scratch: same ID nodes, operations and relations. */
+  void expect_depsgraph_matches_full_build()
+  {
+    EXPECT_TRUE(DEG_debug_consistency_check(depsgraph));
+
+    Depsgraph *full_depsgraph = DEG_graph_new(
+        bfile->main, bfile->curscene, bfile->cur_view_layer, DAG_EVAL_VIEWPORT);
+    DEG_graph_build_from_view_layer(
+        full_depsgraph, bfile->main, bfile->curscene, bfile->cur_view_layer);
+
+    size_t num_outer, num_operations, num_relations;
+    size_t full_num_outer, full_num_operations, full_num_relations;
+    DEG_stats_simple(depsgraph, &num_outer, &num_operations, &num_relations);
+    DEG_stats_simple(full_depsgraph, &full_num_outer, &full_num_operations, &full_num_relations);
+    EXPECT_EQ(num_outer, full_num_outer);
+    EXPECT_EQ(num_operations, full_num_operations);
+    EXPECT_EQ(num_relations, full_num_relations);
+    EXPECT_TRUE(DEG_debug_compare(depsgraph, full_depsgraph));
+
+    DEG_graph_free(full_depsgraph);
+  }
+};
+
+TEST_F(DepsgraphRelationsUpdateTest, AddRemoveObject)
+{
+  if (!blendfile_load("modifier_stack/array_test.blend")) {
+    return;
+  }
+  Main *bmain = bfile->main;
+  Scene *scene = bfile->curscene;
+  depsgraph_create(DAG_EVAL_VIEWPORT);
+  expect_builds(1, 0);
+
+  Object *object = object_add("IncrementalAdd");
+  DEG_relations_tag_id_added(bmain, &object->id);
+  relations_update();
+  EXPECT_TRUE(object_is_in_depsgraph(object));
+  expect_builds(1, 1);
+  expect_depsgraph_matches_full_build();
+
+  /* Removal is applied before the object is freed, to be able to query the graph. */
+  DEG_relations_tag_id_removed(bmain, &object->id);
+  BKE_collection_object_remove(bmain, scene->master_collection, object, false);
+  relations_update();
+  EXPECT_FALSE(object_is_in_depsgraph(object));
+  BKE_id_free_ex(bmain, &object->id, LIB_ID_FREE_NO_DEG_TAG, true);
+  expect_builds(1, 2);
+  expect_depsgraph_matches_full_build();
+
+  /* Adding and removing an object before the update is a no-op. */
+  object = object_add("IncrementalAddRemove");
+  DEG_relations_tag_id_added(bmain, &object->id);
+  DEG_relations_tag_id_removed(bmain, &object->id);
+  BKE_collection_object_remove(bmain, scene->master_collection, object, false);
+  relations_update();
+  EXPECT_FALSE(object_is_in_depsgraph(object));
+  BKE_id_free_ex(bmain, &object->id, LIB_ID_FREE_NO_DEG_TAG, true);
+  expect_builds(1, 2);
+
+  /* A full relations update still rebuilds the graph. */
+  DEG_graph_tag_relations_update(depsgraph);
+  relations_update();
+  expect_builds(2, 2);
+}
+
+TEST_F(DepsgraphRelationsUpdateTest, AddRemoveObjectLargeScene)
+{
+  if (!blendfile_load("modifier_stack/array_test.blend")) {
+    return;
+  }
+  Main *bmain = bfile->main;
+  Scene *scene = bfile->curscene;
+  for (int i = 0; i < NUM_SCENE_OBJECTS; i++) {
+    object_add("SceneObject");
+  }
+  depsgraph_create(DAG_EVAL_VIEWPORT);
+
+  Object *object = object_add("IncrementalAdd");
+  DEG_relations_tag_id_added(bmain, &object->id);
+  relations_update();
+  EXPECT_TRUE(object_is_in_depsgraph(object));
+  expect_depsgraph_matches_full_build();
+
+  DEG_relations_tag_id_removed(bmain, &object->id);
+  BKE_collection_object_remove(bmain, scene->master_collection, object, false);
+  relations_update();
+  EXPECT_FALSE(object_is_in_depsgraph(object));
+  BKE_id_free_ex(bmain, &object->id, LIB_ID_FREE_NO_DEG_TAG, true);
+
+  expect_depsgraph_matches_full_build();
+
+  /* Neither update rebuilt the graph. */
+  expect_builds(1, 2);
+}
@@ -0,0 +1,85 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "EXP_BoolValue.h"
+#include "EXP_CompiledExpression.h"
+#include "EXP_ConstExpr.h"
+#include "EXP_IdentifierExpr.h"
+#include "EXP_IfExpr.h"
+#include "EXP_IntValue.h"
+#include "EXP_Operator1Expr.h"
+#include "EXP_Operator2Expr.h"
+
+/* if(c, then, else) with c a boolean input. */
+static CExpression *if_expr(CValue *then_value, CValue *else_value)
+{
+  return new CIfExpr(new CIdentifierExpr("c", nullptr),
+                     new CConstExpr(then_value),
+                     new CConstExpr(else_value));
+}
+
+/* Compile the expression and evaluate it for both values of the input c. */
+static void compiled_expression_test(CExpression *expr,
+                                     CCompiledExpression::Scalar &result_true,
+                                     CCompiledExpression::Scalar &result_false)
+{
+  const std::vector<std::string> input_names = {"c"};
+  CCompiledExpression compiled;
+  ASSERT_TRUE(compiled.Compile(expr, input_names, nullptr));
+
+  EXPECT_EQ(compiled.Evaluate({true}, result_true), CCompiledExpression::RESULT_OK);
+  EXPECT_EQ(compiled.Evaluate({false}, result_false), CCompiledExpression::RESULT_OK);
+
+  expr->Release();
+}
+
+TEST(compiled_expression, NegateConstant)
+{
+  CCompiledExpression::Scalar result_true, result_false;
+  compiled_expression_test(
+      new COperator1Expr(VALUE_NEG_OPERATOR, new CConstExpr(new CIntValue(3))),
+      result_true,
+      result_false);
+  EXPECT_EQ(result_true.m_type, VALUE_INT_TYPE);
+  EXPECT_EQ(result_true.m_int, -3);
+  EXPECT_EQ(result_false.m_int, -3);
+}
+
+TEST(compiled_expression, NegateIf)
+{
+  CCompiledExpression::Scalar result_true, result_false;
+  compiled_expression_test(
+      new COperator1Expr(VALUE_NEG_OPERATOR, if_expr(new CIntValue(1), new CIntValue(2))),
+      result_true,
+      result_false);
+  EXPECT_EQ(result_true.m_type, VALUE_INT_TYPE);
+  EXPECT_EQ(result_true.m_int, -1);
+  EXPECT_EQ(result_false.m_type, VALUE_INT_TYPE);
+  EXPECT_EQ(result_false.m_int, -2);
+}
+
+TEST(compiled_expression, NotIf)
+{
+  CCompiledExpression::Scalar result_true, result_false;
+  compiled_expression_test(
+      new COperator1Expr(VALUE_NOT_OPERATOR, if_expr(new CBoolValue(true), new CBoolValue(false))),
+      result_true,
+      result_false);
+  EXPECT_EQ(result_true.m_type, VALUE_BOOL_TYPE);
+  EXPECT_FALSE(result_true.m_bool);
+  EXPECT_EQ(result_false.m_type, VALUE_BOOL_TYPE);
+  EXPECT_TRUE(result_false.m_bool);
+}
+
+TEST(compiled_expression, AddIf)
+{
+  CCompiledExpression::Scalar result_true, result_false;
+  compiled_expression_test(new COperator2Expr(VALUE_ADD_OPERATOR,
+                                              if_expr(new CIntValue(1), new CIntValue(2)),
+                                              new CConstExpr(new CIntValue(10))),
+                           result_true,
+                           result_false);
+  EXPECT_EQ(result_true.m_int, 11);
+  EXPECT_EQ(result_false.m_int, 12);
+}
@@ -0,0 +1,122 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "EXP_IntValue.h"
+#include "EXP_PropertyLayout.h"
+
+#include <string>
+
+TEST(property_layout, GetPropertyOutOfRange)
+{
+  CIntValue *value = new CIntValue(0);
+  EXPECT_EQ(value->GetProperty(0), nullptr);
+
+  CIntValue *prop = new CIntValue(1);
+  value->SetProperty("a", prop);
+  prop->Release();
+  EXPECT_NE(value->GetProperty(0), nullptr);
+  EXPECT_EQ(value->GetProperty(1), nullptr);
+  EXPECT_EQ(value->GetProperty(-1), nullptr);
+
+  value->Release();
+}
+
+/* Adding and removing generated names must not grow the slots of a value. */
+TEST(property_layout, RemovedSlotsCompacted)
+{
+  CIntValue *value = new CIntValue(0);
+  CIntValue *kept_prop = new CIntValue(1);
+  value->SetProperty("kept", kept_prop);
+  kept_prop->Release();
+
+  for (unsigned int i = 0; i < 1000; ++i) {
+    const std::string name = "tmp" + std::to_string(i);
+    CIntValue *prop = new CIntValue(i);
+    value->SetProperty(name, prop);
+    prop->Release();
+    EXPECT_TRUE(value->RemoveProperty(name));
+  }
+
+  EXPECT_LT(value->GetPropertyCount(), 16);
+  CValue *kept = value->GetProperty("kept");
+  ASSERT_NE(kept, nullptr);
+  EXPECT_EQ(kept->GetNumber(), 1.0);
+
+  value->Release();
+}
+
+/* Replicas adding many different names must not grow the cached layouts without bound. */
+TEST(property_layout, SharedLayoutTransitions)
+{
+  CIntValue *value = new CIntValue(0);
+  CIntValue *prop = new CIntValue(1);
+  value->SetProperty("a", prop);
+
+  for (unsigned int i = 0; i < 1000; ++i) {
+    CValue *replica = value->GetReplica();
+    const std::string name = "name" + std::to_string(i);
+    replica->SetProperty(name, prop);
+    EXPECT_NE(replica->GetPropertyLayout(), value->GetPropertyLayout());
+    EXPECT_EQ(replica->GetProperty(name), prop);
+    EXPECT_NE(replica->GetProperty("a"), nullptr);
+    replica->Release();
+  }
+
+  /* Replicas adding the same name still share their layout. */
+  CValue *replica1 = value->GetReplica();
+  CValue *replica2 = value->GetReplica();
+  replica1->SetProperty("name0", prop);
+  replica2->SetProperty("name0", prop);
+  EXPECT_EQ(replica1->GetPropertyLayout(), replica2->GetPropertyLayout());
+  replica1->Release();
+  replica2->Release();
+
+  prop->Release();
+  value->Release();
+}
+
+/* Every layout caches the slot of a key, a key missing from a layout is found once added. */
+TEST(property_layout, KeySlots)
+{
+  const CPropertyKey key("b");
+  CIntValue *value1 = new CIntValue(0);
+  CIntValue *value2 = new CIntValue(0);
+  CIntValue *prop = new CIntValue(1);
+  value1->SetProperty("a", prop);
+  value1->SetProperty("b", prop);
+  value2->SetProperty("b", prop);
+
+  for (unsigned int i = 0; i < 2; ++i) {
+    EXPECT_EQ(value1->GetPropertyLayout()->GetSlot(key), 1);
+    EXPECT_EQ(value2->GetPropertyLayout()->GetSlot(key), 0);
+  }
+
+  /* The layout isn't shared and grows in place. */
+  const CPropertyKey missingKey("c");
+  EXPECT_EQ(value2->GetPropertyLayout()->GetSlot(missingKey), -1);
+  value2->SetProperty("c", prop);
+  EXPECT_EQ(value2->GetPropertyLayout()->GetSlot(missingKey), 1);
+
+  prop->Release();
+  value1->Release();
+  value2->Release();
+}
+
+TEST(property_layout, PropertyNamesSorted)
+{
+  CIntValue *value = new CIntValue(0);
+  CIntValue *prop = new CIntValue(1);
+  value->SetProperty("c", prop);
+  value->SetProperty("a", prop);
+  value->SetProperty("b", prop);
+  prop->Release();
+
+  const std::vector<std::string> names = value->GetPropertyNames();
+  ASSERT_EQ(names.size(), 3u);
+  EXPECT_EQ(names[0], "a");
+  EXPECT_EQ(names[1], "b");
+  EXPECT_EQ(names[2], "c");
+
+  value->Release();
+}